@@ -0,0 +1,235 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Metadata operations per second on the 9pfs root file system: stat() of
+ * an existing and of a missing file, fstat() of an open file, and
+ * open()/close(). Each is run for CONFIG_APP9PFSBMK_DURATION ms. Compare
+ * runs with CONFIG_LIB9PFS_CACHE enabled and disabled to see how many host
+ * round trips the cache saves.
+ *
+ * Then sequential write and read throughput of a
+ * CONFIG_APP9PFSBMK_FILE_SIZE MiB file, with small and large requests.
+ *
+ * Run under QEMU with a local share, e.g.:
+ *   mkdir fs0
+ *   qemu-system-x86_64 ... \
+ *     -fsdev local,id=fs0,path=fs0,security_model=none \
+ *     -device virtio-9p-pci,fsdev=fs0,mount_tag=fs0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <uk/essentials.h>
+#include <uk/plat/time.h>
+
+#define FILE_PATH	"/9pfs-bmk.db"
+#define MISSING_PATH	"/9pfs-bmk.db-journal"
+#define SEQ_PATH	"/9pfs-bmk.seq"
+#define FILE_SIZE	((size_t) CONFIG_APP9PFSBMK_FILE_SIZE << 20)
+
+static int fd;
+
+static int op_stat(void)
+{
+	struct stat st;
+
+	return stat(FILE_PATH, &st);
+}
+
+static int op_stat_missing(void)
+{
+	struct stat st;
+
+	if (!stat(MISSING_PATH, &st) || errno != ENOENT)
+		return -1;
+	return 0;
+}
+
+static int op_fstat(void)
+{
+	struct stat st;
+
+	return fstat(fd, &st);
+}
+
+static int op_open_close(void)
+{
+	int f = open(FILE_PATH, O_RDONLY);
+
+	if (f < 0)
+		return -1;
+	return close(f);
+}
+
+static const struct {
+	const char *name;
+	int (*fn)(void);
+} ops[] = {
+	{ "stat", op_stat },
+	{ "stat (ENOENT)", op_stat_missing },
+	{ "fstat", op_fstat },
+	{ "open+close", op_open_close },
+};
+
+static int run(int (*fn)(void), uint64_t *ops_per_sec)
+{
+	__nsec start, deadline, now;
+	uint64_t n = 0;
+
+	start = ukplat_monotonic_clock();
+	deadline = start + ukarch_time_msec_to_nsec(CONFIG_APP9PFSBMK_DURATION);
+	do {
+		if (fn())
+			return -1;
+		n++;
+		now = ukplat_monotonic_clock();
+	} while (now < deadline);
+
+	*ops_per_sec = n * ukarch_time_sec_to_nsec(1) / (now - start);
+	return 0;
+}
+
+/* Local changes have to show through the cache right away */
+static int check_coherence(void)
+{
+	struct stat st;
+	int f;
+
+	if (op_stat_missing())
+		return -1;
+
+	f = open(MISSING_PATH, O_CREAT | O_WRONLY, 0644);
+	if (f < 0)
+		return -1;
+	if (write(f, "x", 1) != 1 || fstat(f, &st) || st.st_size != 1) {
+		close(f);
+		return -1;
+	}
+	close(f);
+
+	if (stat(MISSING_PATH, &st) || unlink(MISSING_PATH))
+		return -1;
+	return op_stat_missing();
+}
+
+/* Returns MiB/s of writing or reading FILE_SIZE bytes in `bs` requests */
+static int seq(int write_file, size_t bs, char *buf, uint64_t *mibps)
+{
+	__nsec start, elapsed;
+	size_t done;
+	ssize_t rc;
+	int f;
+
+	f = open(SEQ_PATH, write_file ? O_CREAT | O_TRUNC | O_WRONLY
+				      : O_RDONLY, 0644);
+	if (f < 0)
+		return -1;
+
+	start = ukplat_monotonic_clock();
+	for (done = 0; done < FILE_SIZE; done += rc) {
+		if (write_file)
+			rc = write(f, buf, bs);
+		else
+			rc = read(f, buf, bs);
+		if (rc <= 0) {
+			close(f);
+			return -1;
+		}
+	}
+	/* Buffered writes only count once they reached the host */
+	if (close(f))
+		return -1;
+	elapsed = ukplat_monotonic_clock() - start;
+
+	*mibps = (uint64_t) CONFIG_APP9PFSBMK_FILE_SIZE
+		 * ukarch_time_sec_to_nsec(1) / elapsed;
+	return 0;
+}
+
+int main(int argc __unused, char *argv[] __unused)
+{
+	static const size_t bss[] = { 4096, 1 << 20 };
+	uint64_t wr, rd;
+	char *buf;
+	uint64_t result;
+	unsigned int i;
+
+	fd = open(FILE_PATH, O_CREAT | O_RDWR, 0644);
+	if (fd < 0) {
+		printf("Could not create %s: %d\n", FILE_PATH, errno);
+		return 1;
+	}
+
+	if (check_coherence()) {
+		printf("Stale metadata after a local change\n");
+		return 1;
+	}
+
+	printf("%-16s %12s\n", "operation", "ops/s");
+	for (i = 0; i < ARRAY_SIZE(ops); i++) {
+		if (run(ops[i].fn, &result)) {
+			printf("%s failed: %d\n", ops[i].name, errno);
+			return 1;
+		}
+		printf("%-16s %12"PRIu64"\n", ops[i].name, result);
+	}
+
+	close(fd);
+	unlink(FILE_PATH);
+
+	buf = malloc(bss[ARRAY_SIZE(bss) - 1]);
+	if (!buf)
+		return 1;
+	memset(buf, 0x5a, bss[ARRAY_SIZE(bss) - 1]);
+
+	printf("\n%d MiB sequential\n", CONFIG_APP9PFSBMK_FILE_SIZE);
+	printf("%-16s %12s %12s\n", "block size", "write MiB/s",
+	       "read MiB/s");
+	for (i = 0; i < ARRAY_SIZE(bss); i++) {
+		if (seq(1, bss[i], buf, &wr) || seq(0, bss[i], buf, &rd)) {
+			printf("I/O error with %zu byte blocks: %d\n",
+			       bss[i], errno);
+			return 1;
+		}
+		printf("%-16zu %12"PRIu64" %12"PRIu64"\n", bss[i], wr, rd);
+	}
+
+	unlink(SEQ_PATH);
+	free(buf);
+	return 0;
+}
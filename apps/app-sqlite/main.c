@@ -12,6 +12,13 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <flexos/impl/morello.h>
+#if CONFIG_LIBSQLITE_VFS
+#include "sqlite3_flexos.h"
+#endif
+#if CONFIG_LIBUKALLOCSLAB
+#include <uk/allocslab.h>
+#endif
+#include <uk/bench.h>
 
 #define ISSPACE(X) isspace((unsigned char)(X))
 #define ISDIGIT(X) isdigit((unsigned char)(X))
@@ -331,70 +338,6 @@ void testset_main(void){
   speedtest1_end_test();
 }
 
-uint64_t read_cntvct()
-{
-    uint64_t val;
-    asm volatile("mrs %0, cntvct_el0" : "=r" (val));
-
-    return val;
-}
-
-uint64_t read_cntfrq()
-{
-    uint64_t val;
-    asm volatile("mrs %0, cntfrq_el0" : "=r" (val));
-
-    return val;
-}
-
-uint64_t read_counter0()
-{
-    uint64_t val;
-    asm volatile("mrs %0, pmevcntr0_el0" : "=r" (val));
-
-    return val;
-}
-
-uint64_t read_counter1()
-{
-    uint64_t val;
-    asm volatile("mrs %0, pmevcntr1_el0" : "=r" (val));
-
-    return val;
-}
-
-uint64_t read_counter2()
-{
-    uint64_t val;
-    asm volatile("mrs %0, pmevcntr2_el0" : "=r" (val));
-
-    return val;
-}
-
-uint64_t read_counter3()
-{
-    uint64_t val;
-    asm volatile("mrs %0, pmevcntr3_el0" : "=r" (val));
-
-    return val;
-}
-
-uint64_t read_counter4()
-{
-    uint64_t val;
-    asm volatile("mrs %0, pmevcntr4_el0" : "=r" (val));
-
-    return val;
-}
-
-uint64_t read_counter5()
-{
-    uint64_t val;
-    asm volatile("mrs %0, pmevcntr5_el0" : "=r" (val));
-
-    return val;
-}
-
 #if SQLITE_VERSION_NUMBER<3006018
 #  define sqlite3_sourceid(X) "(before 3.6.18)"
 #endif
@@ -436,20 +379,31 @@ int main(int argc, char **argv){
   }
   switch_to_comp0 = 0;
   switch_to_comp1 = 0;
-  uint64_t c0s, c1s, c2s, c3s, c4s, c5s, c0e, c1e, c2e, c3e, c4e, c5e;
-for (int doit = 0; doit < 10; doit++) {
-  c0s = c1s = c2s = c3s = c4s = c5s = c0e = c1e = c2e = c3e = c4e = c5e = 0;
-  c0s = read_counter0();
-  c1s = read_counter1();
-  // c2s = read_counter2();
-  // c3s = read_counter3();
-  // c4s = read_counter4();
-  // c5s = read_counter5();
-  //uint64_t start = read_cntvct();
+  uint64_t gates;
+  struct uk_bench b;
+#if CONFIG_LIBSQLITE_VFS
+  struct sqlite3_flexos_vfs_stats vfs_stats;
+#endif
+  /* Each trial runs the whole test set on a fresh database. Timings and
+   * PMU event counts come out as one CSV/JSON line, see lib/ukbench. */
+  if( uk_bench_init(&b, "speedtest1", CONFIG_APPSQLITE_WARMUP,
+                    CONFIG_APPSQLITE_TRIALS, 0) ){
+    fatal_error("Cannot allocate %d trials\n", CONFIG_APPSQLITE_TRIALS);
+  }
+#if CONFIG_LIBUKBENCH_PMU_COMPARTMENTS
+  /* Count events per compartment from here on: main runs in 0 */
+  uk_pmu_comp_reset();
+#endif
+uk_bench_foreach(&b) {
+  gates = switch_to_comp0 + switch_to_comp1;
+  uk_bench_start(&b);
   if( zDbName!=0 ) 
   __flexos_morello_gate1_i(0, 1, unlink, zDbName);
   //unlink(zDbName);
   sqlite3_initialize(); 
+#if CONFIG_LIBSQLITE_VFS
+  sqlite3_flexos_vfs_stats(&vfs_stats, 1);
+#endif
 
   int fd;
   __flexos_morello_gate2_r_word_ii(0, 1, fd, open, zDbName, O_CREAT);
@@ -476,22 +430,40 @@ for (int doit = 0; doit < 10; doit++) {
   }
 //  speedtest1_final();
   sqlite3_close(g.db);
+  uk_bench_stop(&b);
+
+  /* Every INSERT runs in its own transaction. "requests" is what the unix
+   * VFS alone would have sent to vfscore, "forwarded" what the flexos VFS
+   * actually sent. */
+  gates = switch_to_comp0 + switch_to_comp1 - gates;
+#if CONFIG_LIBSQLITE_VFS
+  sqlite3_flexos_vfs_stats(&vfs_stats, 1);
+  if (vfs_stats.transactions)
+    uk_pr_crit("vfs: %llu transactions, %llu requests/txn, %llu forwarded/txn, %llu gates/txn\n",
+               vfs_stats.transactions,
+               vfs_stats.requests / vfs_stats.transactions,
+               vfs_stats.forwarded / vfs_stats.transactions,
+               (unsigned long long) gates / vfs_stats.transactions);
+#else
+  uk_pr_crit("vfs: %llu gates\n", (unsigned long long) gates);
+#endif
+#if CONFIG_LIBUKALLOCSLAB
+  /* Heap footprint with the slab front-end: live small objects vs. the
+   * pages that hold them. Compare the run time with the option off. */
+  struct uk_allocslab_stats slab_stats;
+  if (!uk_allocslab_stats(uk_alloc_get_default(), &slab_stats) && slab_stats.mallocs)
+    uk_pr_crit("slab: %lu objects, %lu KiB in %lu pages, %lu/%lu mallocs large, %lu%% via magazines\n",
+               slab_stats.objs, (unsigned long) (slab_stats.obj_bytes / 1024),
+               slab_stats.slab_pages, slab_stats.large_allocs, slab_stats.mallocs,
+               slab_stats.magazine_hits * 100 / (slab_stats.mallocs + slab_stats.frees));
+#endif
 
-    c0e = read_counter0();
-  c1e = read_counter1();
-  // c2e = read_counter2();
-  // c3e = read_counter3();
-  // c4e = read_counter4();
-  // c5e = read_counter5();
-//uint64_t end = read_cntvct();
-//uint64_t frq = read_cntfrq();
-// uk_pr_crit("cycles: %d executed, frequency %d\n", end - start, frq);
 uk_pr_crit("done\n");
-//printf("L1I: %d, L1I_REFILL: %d\n", c0e-c0s, c1e-c1s);
-//printf("L1D: %d, L1D_REFILL: %d\n", c0e-c0s, c1e-c1s);
-//printf("BR_RET: %d, BR_RET_MISPRED: %d\n", c0e-c0s, c1e-c1s);
-//printf("INST_RET: %d, MEM_ACC: %d\n", c0e-c0s, c1e-c1s);
 }
+  uk_bench_finish(&b);
+#if CONFIG_LIBUKBENCH_PMU_COMPARTMENTS
+  uk_pmu_comp_report(0);
+#endif
 
   /* Release memory */
   return 0;
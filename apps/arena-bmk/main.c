@@ -0,0 +1,187 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Short-lived allocation bursts, the pattern of request-scoped work such
+ * as per-statement scratch space or per-packet parsing: every round
+ * allocates a burst of objects of random size and then drops all of
+ * them. General-purpose allocators free the objects one by one, an arena
+ * releases them at once by going back to a mark. Prints the average cost
+ * per object, allocation and deallocation included.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <uk/alloc.h>
+#include <uk/arena.h>
+#include <uk/allocbbuddy.h>
+#if CONFIG_LIBTLSF
+#include <uk/tlsf.h>
+#endif
+#if CONFIG_LIBUKALLOCSLAB
+#include <uk/allocslab.h>
+#endif
+#include <uk/plat/time.h>
+
+#define BURST		CONFIG_APPARENABMK_BURST
+#define ROUNDS		CONFIG_APPARENABMK_ROUNDS
+#define MAX_SIZE	CONFIG_APPARENABMK_MAX_SIZE
+#define HEAP_PAGES	(CONFIG_APPARENABMK_HEAP * 1024 / 4096)
+
+static void *objs[BURST];
+static size_t sizes[BURST];
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15ULL;
+
+static inline uint64_t rnd_next(void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 7;
+	rnd_state ^= rnd_state << 17;
+	return rnd_state;
+}
+
+/* Same sizes for every allocator */
+static void init_sizes(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < BURST; i++)
+		sizes[i] = 1 + rnd_next() % MAX_SIZE;
+}
+
+static void report(const char *name, __nsec ns)
+{
+	printf("%-12s %8" PRIu64 " ns/object\n", name,
+	       (uint64_t) ns / ((uint64_t) ROUNDS * BURST));
+}
+
+static int bench_ukalloc(const char *name, struct uk_alloc *a)
+{
+	unsigned int r, i;
+	__nsec start;
+
+	if (!a) {
+		printf("%-12s could not be initialized\n", name);
+		return -1;
+	}
+
+	start = ukplat_monotonic_clock();
+	for (r = 0; r < ROUNDS; r++) {
+		for (i = 0; i < BURST; i++) {
+			objs[i] = uk_malloc(a, sizes[i]);
+			if (!objs[i]) {
+				printf("%-12s out of memory\n", name);
+				return -1;
+			}
+			/* Touch the object like a user would */
+			*(volatile char *) objs[i] = (char) i;
+		}
+		for (i = 0; i < BURST; i++)
+			uk_free(a, objs[i]);
+	}
+	report(name, ukplat_monotonic_clock() - start);
+	return 0;
+}
+
+static int bench_arena(struct uk_alloc *parent)
+{
+	struct uk_arena_mark m;
+	struct uk_arena *ar;
+	unsigned int r, i;
+	__nsec start;
+
+	ar = uk_arena_create(parent, 64 * 1024);
+	if (!ar) {
+		printf("%-12s could not be initialized\n", "arena");
+		return -1;
+	}
+
+	start = ukplat_monotonic_clock();
+	for (r = 0; r < ROUNDS; r++) {
+		m = uk_arena_mark(ar);
+		for (i = 0; i < BURST; i++) {
+			objs[i] = uk_arena_alloc(ar, sizes[i]);
+			if (!objs[i]) {
+				printf("%-12s out of memory\n", "arena");
+				return -1;
+			}
+			*(volatile char *) objs[i] = (char) i;
+		}
+		uk_arena_release(ar, m);
+	}
+	report("arena", ukplat_monotonic_clock() - start);
+
+	uk_arena_destroy(ar);
+	return 0;
+}
+
+/* Each allocator under test gets its own heap carved out of the default
+ * allocator, so that they all start from the same state
+ */
+static void *heap(void)
+{
+	void *base = uk_palloc(uk_alloc_get_default(), HEAP_PAGES);
+
+	if (!base)
+		printf("Cannot allocate a %d KiB heap\n",
+		       CONFIG_APPARENABMK_HEAP);
+	return base;
+}
+
+int main(int argc __unused, char *argv[] __unused)
+{
+	struct uk_alloc *bbuddy;
+	void *base;
+
+	printf("%d bursts of %d objects of 1-%d bytes\n",
+	       ROUNDS, BURST, MAX_SIZE);
+	init_sizes();
+
+	base = heap();
+	if (!base)
+		return 1;
+	bbuddy = uk_allocbbuddy_init(base, HEAP_PAGES * 4096);
+	bench_arena(bbuddy);
+	bench_ukalloc("bbuddy", bbuddy);
+#if CONFIG_LIBUKALLOCSLAB
+	bench_ukalloc("slab+bbuddy", uk_allocslab_init(bbuddy));
+#endif
+
+#if CONFIG_LIBTLSF
+	base = heap();
+	if (!base)
+		return 1;
+	bench_ukalloc("tlsf", uk_tlsf_init(base, HEAP_PAGES * 4096));
+#endif
+	return 0;
+}
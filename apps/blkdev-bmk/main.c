@@ -0,0 +1,246 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Random-read IOPS of the first block device at queue depths 1 to 64, in
+ * the spirit of `fio --rw=randread --ioengine=libaio --iodepth=N`. Each depth
+ * is measured twice: once submitting requests one by one (one device
+ * notification per request) and once with the batched, plugged submit API.
+ * Completions are polled, so no interrupt or dispatcher thread is involved.
+ *
+ * Run under QEMU with a file-backed virtio-blk disk, e.g.:
+ *   qemu-img create -f raw disk.img 1G
+ *   qemu-system-x86_64 ... -drive file=disk.img,if=virtio,cache=none
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <errno.h>
+#include <uk/alloc.h>
+#include <uk/blkdev.h>
+#include <uk/plat/time.h>
+
+#define MAX_QD		64
+
+static struct uk_blkreq reqs[MAX_QD];
+static struct uk_blkreq *ready[MAX_QD];
+static int inflight[MAX_QD];
+static void *bufs[MAX_QD];
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15ULL;
+
+static inline uint64_t rnd_next(void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 7;
+	rnd_state ^= rnd_state << 17;
+	return rnd_state;
+}
+
+static void prep_req(struct uk_blkdev *dev, struct uk_blkreq *req)
+{
+	__sector nb_sectors = CONFIG_APPBLKDEVBMK_BLOCK_SIZE /
+			      uk_blkdev_ssize(dev);
+	__sector nb_blocks = uk_blkdev_sectors(dev) / nb_sectors;
+	__sector sector = (rnd_next() % nb_blocks) * nb_sectors;
+
+	uk_blkreq_init(req, UK_BLKREQ_READ, sector, nb_sectors,
+		       bufs[req - reqs], NULL, NULL);
+}
+
+/*
+ * Submits the first `cnt` requests of `ready`. Returns the number of
+ * requests that were put to the queue or a negative error code.
+ */
+static int submit(struct uk_blkdev *dev, unsigned int cnt, int batched)
+{
+	unsigned int i;
+	int rc;
+
+	if (batched) {
+		uk_blkdev_queue_plug(dev, 0);
+		rc = uk_blkdev_queue_submit_batch(dev, 0, ready, cnt);
+		uk_blkdev_queue_unplug(dev, 0);
+		return (rc == -ENOSPC) ? 0 : rc;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		rc = uk_blkdev_queue_submit_one(dev, 0, ready[i]);
+		if (!uk_blkdev_status_successful(rc))
+			return (i || rc == -ENOSPC || rc >= 0) ? (int) i : rc;
+	}
+	return cnt;
+}
+
+/*
+ * Keeps `qd` requests in flight for the configured duration and returns
+ * the number of requests completed, or a negative error code.
+ */
+static int64_t run(struct uk_blkdev *dev, unsigned int qd, int batched,
+		   __nsec *elapsed)
+{
+	__nsec start, deadline;
+	int64_t done = 0;
+	unsigned int i, nb_ready, nb_sent;
+	int rc;
+
+	for (i = 0; i < qd; i++) {
+		ready[i] = &reqs[i];
+		inflight[i] = 0;
+	}
+	nb_ready = qd;
+
+	start = ukplat_monotonic_clock();
+	deadline = start + ukarch_time_msec_to_nsec(
+					CONFIG_APPBLKDEVBMK_DURATION);
+
+	while (ukplat_monotonic_clock() < deadline) {
+		for (i = 0; i < nb_ready; i++)
+			prep_req(dev, ready[i]);
+
+		rc = submit(dev, nb_ready, batched);
+		if (rc < 0)
+			goto out;
+		nb_sent = rc;
+		for (i = 0; i < nb_sent; i++)
+			inflight[ready[i] - reqs] = 1;
+		for (i = nb_sent; i < nb_ready; i++)
+			ready[i - nb_sent] = ready[i];
+		nb_ready -= nb_sent;
+
+		/* Reap whatever has completed, at least one request */
+		do {
+			rc = uk_blkdev_queue_finish_reqs(dev, 0);
+			if (rc < 0)
+				goto out;
+
+			for (i = 0; i < qd; i++) {
+				if (!inflight[i] ||
+				    !uk_blkreq_is_done(&reqs[i]))
+					continue;
+				if (reqs[i].result < 0) {
+					rc = reqs[i].result;
+					goto out;
+				}
+				inflight[i] = 0;
+				ready[nb_ready++] = &reqs[i];
+				done++;
+			}
+		} while (!nb_ready);
+	}
+	rc = 0;
+
+out:
+	/* Drain the requests that are still in flight */
+	nb_ready = 0;
+	for (i = 0; i < qd; i++)
+		if (inflight[i])
+			ready[nb_ready++] = &reqs[i];
+	uk_blkdev_queue_poll_reqs(dev, 0, ready, nb_ready);
+
+	*elapsed = ukplat_monotonic_clock() - start;
+	return rc ? rc : done;
+}
+
+int main(int argc __unused, char *argv[] __unused)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+	struct uk_blkdev *dev;
+	struct uk_blkdev_queue_info qinfo;
+	struct uk_blkdev_conf conf = { .nb_queues = 1 };
+	struct uk_blkdev_queue_conf qconf = { .a = a };
+	unsigned int qd, max_qd, i;
+	uint64_t iops[2];
+	int64_t done;
+	__nsec elapsed;
+	int batched, rc;
+
+	if (uk_blkdev_count() == 0) {
+		printf("No block device found\n");
+		return -ENODEV;
+	}
+
+	dev = uk_blkdev_get(0);
+	rc = uk_blkdev_configure(dev, &conf);
+	if (rc < 0)
+		goto err;
+	rc = uk_blkdev_queue_get_info(dev, 0, &qinfo);
+	if (rc < 0)
+		goto err;
+	/* No event callback: completions are polled */
+	rc = uk_blkdev_queue_configure(dev, 0, qinfo.nb_max, &qconf);
+	if (rc < 0)
+		goto err;
+	rc = uk_blkdev_start(dev);
+	if (rc < 0)
+		goto err;
+
+	if (uk_blkdev_size(dev) < CONFIG_APPBLKDEVBMK_BLOCK_SIZE) {
+		printf("Block device is too small\n");
+		return -EINVAL;
+	}
+
+	/* Every request takes a header, a data and a status descriptor */
+	max_qd = MIN(MAX_QD, qinfo.nb_max / 3);
+	for (i = 0; i < max_qd; i++) {
+		bufs[i] = uk_memalign(a, MAX(uk_blkdev_ioalign(dev), 8),
+				      CONFIG_APPBLKDEVBMK_BLOCK_SIZE);
+		if (!bufs[i]) {
+			rc = -ENOMEM;
+			goto err;
+		}
+	}
+
+	printf("randread, bs=%d, %d ms per run, %"__PRIsctr" sectors\n",
+	       CONFIG_APPBLKDEVBMK_BLOCK_SIZE, CONFIG_APPBLKDEVBMK_DURATION,
+	       uk_blkdev_sectors(dev));
+	printf("%8s %12s %12s\n", "iodepth", "single", "batched");
+	for (qd = 1; qd <= max_qd; qd <<= 1) {
+		for (batched = 0; batched < 2; batched++) {
+			done = run(dev, qd, batched, &elapsed);
+			if (done < 0) {
+				printf("I/O error at iodepth %u: %"PRId64"\n",
+				       qd, done);
+				return (int) done;
+			}
+			iops[batched] = (uint64_t) done *
+					ukarch_time_sec_to_nsec(1) / elapsed;
+		}
+		printf("%8u %12"PRIu64" %12"PRIu64"\n", qd, iops[0], iops[1]);
+	}
+
+	return 0;
+
+err:
+	printf("Failed to set up block device: %d\n", rc);
+	return rc;
+}
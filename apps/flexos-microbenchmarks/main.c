@@ -32,8 +32,6 @@
 #include <flexos/microbenchmarks/isolated.h>
 #include <flexos/isolation.h>
 #include <uk/alloc.h>
-#else
-#include <inttypes.h>
 #endif
 
 #if CONFIG_LIBFLEXOS_VMEPT
@@ -44,69 +42,14 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <inttypes.h>
+#include <uk/bench.h>
 
 // some config checks here...
 #if !LINUX_USERLAND && CONFIG_LIBFLEXOS_INTELPKU && !CONFIG_LIBFLEXOS_GATE_INTELPKU_NO_INSTRUMENT
 #error "Microbenchmarks should not be executed with gate instrumentation!"
 #endif
 
-// bench_start returns a timestamp for use to measure the start of a benchmark
-// run.
-//__attribute__ ((always_inline)) static inline uint64_t bench_start(void)
-//{
-//  unsigned  cycles_low, cycles_high;
-//  asm volatile( "CPUID\n\t" // serialize
-//                "RDTSC\n\t" // read clock
-//                "MOV %%edx, %0\n\t"
-//                "MOV %%eax, %1\n\t"
-//                : "=r" (cycles_high), "=r" (cycles_low)
-//                :: "%rax", "%rbx", "%rcx", "%rdx" );
-//  return ((uint64_t) cycles_high << 32) | cycles_low;
-//}
-
-__attribute__ ((always_inline)) static inline uint64_t bench_start_morello(void)
-{
-  uint64_t val;
-    asm volatile(
-        "isb\n"
-        "mrs %0, PMCCNTR_EL0" : "=r" (val));
-
-    return val;
-}
-
-// bench_end returns a timestamp for use to measure the end of a benchmark run.
-//__attribute__ ((always_inline)) static inline uint64_t bench_end(void)
-//{
-//  unsigned  cycles_low, cycles_high;
-//  asm volatile( "RDTSCP\n\t" // read clock + serialize
-//                "MOV %%edx, %0\n\t"
-//                "MOV %%eax, %1\n\t"
-//                "CPUID\n\t" // serialize -- but outside clock region!
-//                : "=r" (cycles_high), "=r" (cycles_low)
-//                :: "%rax", "%rbx", "%rcx", "%rdx" );
-//  return ((uint64_t) cycles_high << 32) | cycles_low;
-//}
-
-__attribute__ ((always_inline)) static inline uint64_t bench_end_morello(void)
-{
-  uint64_t val;
-    asm volatile(
-        "isb\n"
-        "mrs %0, PMCCNTR_EL0" : "=r" (val));
-
-    return val;
-}
-
-__attribute__ ((always_inline)) static inline uint64_t l1d_cache_refill(void)
-{
-  uint64_t val;
-    asm volatile(
-        "isb\n"
-        "mrs %0, pmevcntr0_el0" : "=r" (val));
-
-    return val;
-}
-
 #if !LINUX_USERLAND
 /*
  * make sure function does not get inlined
@@ -186,9 +129,13 @@ void empty_fcall_4xBs(void) {
 }
 #endif
 
-#define REPS 50
+#define WARMUP 50
+#define REPS 1000
 
-#define SERIAL 0
+/* Set to 1 to print where the cycles of a Morello gate go, from the
+ * timestamps that the instrumented gate leaves in cycles[]
+ */
+#define GATE_BREAKDOWN 0
 
 static inline void RUN_ISOLATED_FCALL(void)
 {
@@ -207,7 +154,6 @@ __attribute__ ((noinline)) void RUN_FCALL(void)
 
 int main(int argc, char *argv[])
 {
-    uint64_t overhead_tsc, overhead_gate, overhead_fcall, t0, t1, l1d_end, l1d_start, l1d_total;
 //    test_things();
     // uint64_t thing = 67;
     // uint64_t *__capability cap_to_pass;
@@ -218,135 +164,71 @@ int main(int argc, char *argv[])
     //uk_pr_crit("hello\n");
     //printf("result %d\n", ret_val);
 
+#if GATE_BREAKDOWN && !LINUX_USERLAND
+    uint64_t t0, t1;
 
-#if !SERIAL
-//    printf("> serial\n");
-//    printf("TSC\tgate\tfcall\n");
     for(int i = 0; i < REPS; i++) {
-        t0 = bench_start_morello();
-        asm volatile("");
-        t1 = bench_end_morello();
-        overhead_tsc = t1 - t0;
-
-        //t0 = bench_start_morello();
-        //l1d_start = l1d_cache_refill();
+        t0 = uk_bench_clock_begin();
 	RUN_ISOLATED_FCALL();
-        //l1d_end = l1d_cache_refill();
-        //l1d_total = l1d_end-l1d_start;
-
-        //t1 = bench_end_morello();
-        //overhead_gate = t1 - t0;
-
-//         t0 = bench_start_morello();
-// 	//RUN_FCALL();
-// //    getpid();
-// //  __asm__ volatile (
-// //           //  "ldr x26, [%0]\n"
-// //             "ldp c26, c27, [%0]\n"
-// //             "blr c27\n"
-// //             :
-// //             : "r"((uintptr_t *)(&(unsealed)))
-// //             : "c29", "c26", "c27"
-// //         );
-//         t1 = bench_end_morello();
-//         overhead_fcall = t1 - t0;
-
-        // printf("%lld\t%lld\t%lld\n", overhead_tsc,
-		// 			overhead_gate, overhead_fcall);
-
-        printf("Timing 0: %d, Timing1: %d, Timing2: %d, Timing3: %d, Timing4: %d (unimportant), Timing5: %d, Timing6: %d, internal total: %d, total: %d, total 2: %d\n", cycles[7]-t0,cycles[1]-cycles[0], cycles[2]-cycles[1], cycles[3]-cycles[2], cycles[4]-cycles[3], cycles[5]-cycles[4], cycles[6]-cycles[5], cycles[6]-cycles[0], overhead_gate, cycles[0]-t0);
-        printf("L1 cache refill events: %d\n", l1d_total);
+        t1 = uk_bench_clock_end();
+
+        printf("Timing 0: %" PRIu64 ", Timing1: %" PRIu64 ", Timing2: %" PRIu64
+               ", Timing3: %" PRIu64 ", Timing4: %" PRIu64 " (unimportant), Timing5: %" PRIu64
+               ", Timing6: %" PRIu64 ", internal total: %" PRIu64 ", total: %" PRIu64
+               ", total 2: %" PRIu64 "\n",
+               cycles[7]-t0, cycles[1]-cycles[0], cycles[2]-cycles[1], cycles[3]-cycles[2],
+               cycles[4]-cycles[3], cycles[5]-cycles[4], cycles[6]-cycles[5],
+               cycles[6]-cycles[0], t1-t0, cycles[0]-t0);
     }
 #else
-    printf("\n#instruction,latency\n");
-    uint64_t min = 1000, max = 0, sum = 0;
-    int ok = 0;
-
-    while (!ok) {
-        for(int i = 0; i < REPS; i++) {
-            t0 = bench_start_morello();
-            asm volatile("");
-            t1 = bench_end_morello();
-            if ((t1 - t0) < min) { min = (t1 - t0); }
-            if ((t1 - t0) > max) { max = (t1 - t0); }
-    	    sum += (t1 - t0);
-        }
-	overhead_tsc = min;
-
-        min = 1000, max = 0, sum = 0;
-        for(int i = 0; i < REPS; i++) {
-            t0 = bench_start_morello();
-    	    RUN_FCALL();
-            t1 = bench_end_morello();
-            if ((t1 - t0) < min) { min = (t1 - t0); }
-            if ((t1 - t0) > max) { max = (t1 - t0); }
-    	    sum += (t1 - t0);
-        }
-	overhead_fcall = min;
-
-	if (overhead_fcall > overhead_tsc) ok = 1;
-    }
-
-    printf("fcall,%" PRId64 "\n", overhead_fcall - overhead_tsc);
+    /* One CSV/JSON line per benchmark, see lib/ukbench. The cost of
+     * reading the clock is already subtracted.
+     */
+#define BENCH(name, stmt)					\
+do {								\
+    struct uk_bench b;						\
+								\
+    if (uk_bench_init(&b, name, WARMUP, REPS, 0) < 0)		\
+        return 1;						\
+    uk_bench_foreach(&b) {					\
+        uk_bench_start(&b);					\
+        stmt;							\
+        uk_bench_stop(&b);					\
+    }								\
+    uk_bench_finish(&b);					\
+} while(0)
 
-    min = 1000, max = 0, sum = 0;
-    for(int i = 0; i < REPS; i++) {
-        t0 = bench_start_morello();
-	RUN_ISOLATED_FCALL();
-        t1 = bench_end_morello();
-        if ((t1 - t0) < min) { min = (t1 - t0); }
-        if ((t1 - t0) > max) { max = (t1 - t0); }
-	sum += (t1 - t0);
-    }
+    BENCH("fcall", RUN_FCALL());
 
-    printf(
+    BENCH(
 #if CONFIG_LIBFLEXOS_GATE_INTELPKU_PRIVATE_STACKS && CONFIG_LIBFLEXOS_ENABLE_DSS
-	"pku-dss,%"
+	"pku-dss"
 #elif CONFIG_LIBFLEXOS_GATE_INTELPKU_PRIVATE_STACKS
-	"pku-heap,%"
+	"pku-heap"
 #elif CONFIG_LIBFLEXOS_GATE_INTELPKU_SHARED_STACKS
-	"pku-shared,%"
+	"pku-shared"
 #elif CONFIG_LIBFLEXOS_VMEPT
-	"ept,%"
+	"ept"
 #elif LINUX_USERLAND
-	"scall,%"
+	"scall"
 #else
-	"gate,%"
-#endif
-    PRId64 "\n", min - overhead_tsc);
+	"gate"
 #endif
-
-#define BENCH_NB(NB,p)					\
-do {							\
-    min = 1000, max = 0, sum = 0;			\
-    for(int i = 0; i < REPS; i++) {			\
-        t0 = bench_start_morello();				\
-	empty_fcall_ ## NB ## xBs();			\
-        t1 = bench_end_morello();				\
-        if ((t1 - t0) < min) { min = (t1 - t0); }	\
-        if ((t1 - t0) > max) { max = (t1 - t0); }	\
-	sum += (t1 - t0);				\
-    }							\
-    overhead_gate = min - overhead_tsc;			\
-							\
-    printf(p);						\
-    printf(STRINGIFY(NB) ",%" PRId64 "\n", overhead_gate);\
-} while(0)
+	, RUN_ISOLATED_FCALL());
 
 #if CONFIG_LIBFLEXOS_GATE_INTELPKU_PRIVATE_STACKS
 #if CONFIG_LIBFLEXOS_ENABLE_DSS
-    char prefix[] = "dss";
-    printf("\n\n#allocations,dss_latency\n");
+#define BENCH_NB(NB) BENCH("dss-" #NB, empty_fcall_ ## NB ## xBs())
 #else
-    char prefix[] = "heap";
-    printf("\n\n#allocations,heap_latency\n");
+#define BENCH_NB(NB) BENCH("heap-" #NB, empty_fcall_ ## NB ## xBs())
 #endif
 
-    BENCH_NB(1, prefix);
-    BENCH_NB(2, prefix);
-    BENCH_NB(3, prefix);
-    BENCH_NB(4, prefix);
+    BENCH_NB(1);
+    BENCH_NB(2);
+    BENCH_NB(3);
+    BENCH_NB(4);
 #endif /* CONFIG_LIBFLEXOS_GATE_INTELPKU_PRIVATE_STACKS */
+#endif /* !GATE_BREAKDOWN */
 
     return 0;
 }
@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * getrandom() throughput across request sizes: small requests are what
+ * stack protector guards, hash seeds and TCP sequence numbers ask for,
+ * large ones what key generation and /dev/urandom readers do. Prints
+ * MB/s and the average cost per call for every size.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <sys/random.h>
+#include <uk/essentials.h>
+#include <uk/plat/time.h>
+
+#define TOTAL_BYTES	((uint64_t) CONFIG_APPGETRANDOMBMK_BYTES * 1024)
+#define MAX_REQUEST	65536
+
+static const size_t req_sizes[] = {
+	4, 8, 16, 32, 64, 128, 256, 512, 1024, 4096, 16384, MAX_REQUEST
+};
+
+static unsigned char buf[MAX_REQUEST];
+
+static int bench(size_t size)
+{
+	uint64_t calls, i;
+	__nsec start, ns;
+	ssize_t rc;
+
+	calls = MAX(TOTAL_BYTES / size, (uint64_t) 1);
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < calls; i++) {
+		rc = getrandom(buf, size, 0);
+		if (rc != (ssize_t) size) {
+			printf("getrandom(%zu) returned %zd\n", size, rc);
+			return -1;
+		}
+	}
+	ns = ukplat_monotonic_clock() - start;
+	if (!ns)
+		ns = 1;
+
+	printf("%8zu B %10" PRIu64 " MB/s %8" PRIu64 " ns/call\n", size,
+	       (calls * size * 1000) / (uint64_t) ns, (uint64_t) ns / calls);
+	return 0;
+}
+
+int main(int argc __unused, char *argv[] __unused)
+{
+	unsigned int i;
+
+	printf("%" PRIu64 " KiB per request size\n", TOTAL_BYTES / 1024);
+	printf("%10s %15s %16s\n", "request", "throughput", "latency");
+	for (i = 0; i < ARRAY_SIZE(req_sizes); i++)
+		if (bench(req_sizes[i]) < 0)
+			return 1;
+	return 0;
+}
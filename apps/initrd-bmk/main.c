@@ -0,0 +1,131 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Boot cost of the initrd: prints the time from platform start to main(),
+ * which includes extracting the initrd into ramfs, and the free heap at
+ * that point (with the buddy allocator, which keeps statistics). Then walks the extracted tree and reads every file to check
+ * that the data is intact and to measure read throughput.
+ *
+ * Run under QEMU with an initrd, e.g.:
+ *   (cd rootfs && find . | cpio -o -H newc) > rootfs.cpio
+ *   qemu-system-x86_64 ... -initrd rootfs.cpio
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <uk/alloc.h>
+#include <uk/plat/time.h>
+
+#define PATH_LEN	256
+
+static char buf[64 * 1024];
+static uint64_t nb_files, nb_dirs, nb_bytes;
+
+static int read_file(const char *path)
+{
+	ssize_t rc;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -1;
+
+	while ((rc = read(fd, buf, sizeof(buf))) > 0)
+		nb_bytes += rc;
+
+	close(fd);
+	return rc < 0 ? -1 : 0;
+}
+
+static int walk(char *path, size_t len)
+{
+	struct dirent *de;
+	struct stat st;
+	DIR *dir;
+	int rc = 0;
+
+	dir = opendir(path);
+	if (!dir)
+		return -1;
+	nb_dirs++;
+
+	while (!rc && (de = readdir(dir))) {
+		if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, ".."))
+			continue;
+		if (len + strlen(de->d_name) + 2 > PATH_LEN)
+			continue;
+
+		snprintf(path + len, PATH_LEN - len, "%s%s",
+			 len > 1 ? "/" : "", de->d_name);
+		if (stat(path, &st))
+			rc = -1;
+		else if (S_ISDIR(st.st_mode))
+			rc = walk(path, strlen(path));
+		else if (S_ISREG(st.st_mode) && !(rc = read_file(path)))
+			nb_files++;
+		path[len] = '\0';
+	}
+
+	closedir(dir);
+	return rc;
+}
+
+int main(int argc __unused, char *argv[] __unused)
+{
+	char path[PATH_LEN] = "/";
+	__nsec boot, start, elapsed;
+	ssize_t avail;
+
+	boot = ukplat_monotonic_clock();
+	printf("boot to main:  %"PRIu64" us\n", boot / 1000);
+	avail = uk_alloc_availmem(uk_alloc_get_default());
+	if (avail >= 0)
+		printf("free heap:     %zd KiB\n", avail / 1024);
+
+	start = ukplat_monotonic_clock();
+	if (walk(path, 1)) {
+		printf("Could not read %s: %d\n", path, errno);
+		return 1;
+	}
+	elapsed = ukplat_monotonic_clock() - start;
+
+	printf("read:          %"PRIu64" files, %"PRIu64" dirs, "
+	       "%"PRIu64" KiB in %"PRIu64" us\n",
+	       nb_files, nb_dirs, nb_bytes / 1024, elapsed / 1000);
+	return 0;
+}
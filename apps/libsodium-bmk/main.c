@@ -10,6 +10,15 @@
 #include <flexos/isolation.h>
 #include <flexos/impl/morello.h>
 #include <flexos/example/isolated.h>
+#include <uk/bench.h>
+#if CONFIG_APPFLEXOSEXAMPLE_THROUGHPUT
+#include "throughput.h"
+#endif
+#if CONFIG_APPFLEXOSEXAMPLE_BATCH
+#include <uk/essentials.h>
+#include <uk/plat/time.h>
+#include <sodium_batch.h>
+#endif
 
 typedef int8_t   i8;
 typedef uint8_t  u8;
@@ -949,40 +958,168 @@ scalarmult_xmain(void)
 
 
 
-u64 read_cntvct()
-{
-    u64 val;
-    asm volatile("mrs %0, cntvct_el0" : "=r" (val));
+#if CONFIG_APPFLEXOSEXAMPLE_BATCH
+#define BATCH_MSGLEN   CONFIG_APPFLEXOSEXAMPLE_BATCH_MSGLEN
+#define BATCH_MESSAGES CONFIG_APPFLEXOSEXAMPLE_BATCH_MESSAGES
+#define BATCH_MAX      256
+#define BATCH_CLEN     (BATCH_MSGLEN + crypto_aead_chacha20poly1305_ietf_ABYTES)
+
+static const unsigned int batch_sizes[] = {
+    1, 2, 4, 8, 16, 32, 64, 128, BATCH_MAX
+};
+
+/* Messages and ciphertexts have to be reachable from the libsodium
+ * compartment, so they live in shared memory like the jobs
+ */
+struct batch_bufs {
+    unsigned char key[crypto_aead_chacha20poly1305_ietf_KEYBYTES];
+    unsigned char nonce[BATCH_MAX][crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+    unsigned char msg[BATCH_MAX][BATCH_MSGLEN];
+    unsigned char ctext[BATCH_MAX][BATCH_CLEN];
+    unsigned char ptext[BATCH_MAX][BATCH_MSGLEN];
+};
 
-    return val;
+static void
+batch_setup(struct sodium_batch_job *jobs, struct batch_bufs *b,
+            enum sodium_batch_op op, unsigned int count)
+{
+    unsigned int i;
+
+    for (i = 0; i < count; i++) {
+        jobs[i].op = op;
+        jobs[i].key = b->key;
+        jobs[i].nonce = b->nonce[i];
+        if (op == SODIUM_BATCH_AEAD_DECRYPT) {
+            jobs[i].in = b->ctext[i];
+            jobs[i].inlen = BATCH_CLEN;
+            jobs[i].out = b->ptext[i];
+        } else {
+            jobs[i].in = b->msg[i];
+            jobs[i].inlen = BATCH_MSGLEN;
+            jobs[i].out = b->ctext[i];
+        }
+    }
 }
 
-uint64_t read_counter0()
+/* Round trip through the batch API; a corrupted ciphertext must fail
+ * verification without affecting the other jobs
+ */
+static int
+batch_check(struct sodium_batch_job *jobs, struct batch_bufs *b)
 {
-    uint64_t val;
-    asm volatile("mrs %0, pmevcntr0_el0" : "=r" (val));
+    unsigned int i;
+
+    batch_setup(jobs, b, SODIUM_BATCH_AEAD_ENCRYPT, BATCH_MAX);
+    if (sodium_batch_run(jobs, BATCH_MAX) != 0)
+        return -1;
+    b->ctext[1][0] ^= 1;
+    batch_setup(jobs, b, SODIUM_BATCH_AEAD_DECRYPT, BATCH_MAX);
+    if (sodium_batch_run(jobs, BATCH_MAX) != 1 || jobs[1].status != -1)
+        return -1;
+    for (i = 0; i < BATCH_MAX; i++) {
+        if (i == 1)
+            continue;
+        if (jobs[i].status != 0 || jobs[i].outlen != BATCH_MSGLEN ||
+            memcmp(b->ptext[i], b->msg[i], BATCH_MSGLEN) != 0)
+            return -1;
+    }
+    return 0;
+}
 
-    return val;
+static uint64_t
+batch_rate(uint64_t messages, __nsec ns)
+{
+    if (!ns)
+        ns = 1;
+    return messages * 1000000000ULL / ns;
 }
 
-uint64_t read_counter1()
+/* Messages per second for every batch size, next to one call per message */
+static int
+batch_bmk(void)
 {
-    uint64_t val;
-    asm volatile("mrs %0, pmevcntr1_el0" : "=r" (val));
+    struct sodium_batch_job *jobs;
+    struct batch_bufs       *b;
+    unsigned long long       clen;
+    unsigned int             i, n, size;
+    uint64_t                 done;
+    __nsec                   start;
+    int                      ret = -1;
+
+    if (sodium_init() < 0)
+        return -1;
+    jobs = sodium_batch_alloc(BATCH_MAX);
+    b = uk_calloc(flexos_shared_alloc, 1, sizeof(*b));
+    if (!jobs || !b)
+        goto out;
+    crypto_aead_chacha20poly1305_ietf_keygen(b->key);
+    randombytes_buf(b->nonce, sizeof(b->nonce));
+    randombytes_buf(b->msg, sizeof(b->msg));
+
+    if (batch_check(jobs, b) < 0) {
+        printf("batch: round trip failed\n");
+        goto out;
+    }
 
-    return val;
+    printf("%d B messages, ChaCha20-Poly1305 encryption\n", BATCH_MSGLEN);
+    printf("%10s %14s\n", "batch", "messages/s");
+
+    start = ukplat_monotonic_clock();
+    for (done = 0; done < BATCH_MESSAGES; done++)
+        crypto_aead_chacha20poly1305_ietf_encrypt(b->ctext[0], &clen,
+            b->msg[0], BATCH_MSGLEN, NULL, 0, NULL, b->nonce[0], b->key);
+    printf("%10s %14" PRIu64 "\n", "unbatched",
+           batch_rate(done, ukplat_monotonic_clock() - start));
+
+    for (i = 0; i < ARRAY_SIZE(batch_sizes); i++) {
+        size = batch_sizes[i];
+        batch_setup(jobs, b, SODIUM_BATCH_AEAD_ENCRYPT, size);
+        start = ukplat_monotonic_clock();
+        for (done = 0; done < BATCH_MESSAGES; done += size) {
+            n = sodium_batch_run(jobs, size);
+            if (n) {
+                printf("batch: %u jobs failed\n", n);
+                goto out;
+            }
+        }
+        printf("%10u %14" PRIu64 "\n", size,
+               batch_rate(done, ukplat_monotonic_clock() - start));
+    }
+    ret = 0;
+out:
+    if (b)
+        uk_free(flexos_shared_alloc, b);
+    if (jobs)
+        sodium_batch_free(jobs);
+    return ret;
 }
+#endif /* CONFIG_APPFLEXOSEXAMPLE_BATCH */
 
 
 
 int main()
 {
-     uint64_t c0s, c1s, c0e, c1e;
-     for (int j = 0; j < 10; j++) {
-     //    uint64_t start = read_cntvct();
-//     c0s = c1s = c0e = c1e = 0;
-//   c0s = read_counter0();
-//   c1s = read_counter1();
+     struct uk_bench b;
+#if CONFIG_APPFLEXOSEXAMPLE_THROUGHPUT
+     if (throughput_bmk() < 0)
+         return 1;
+#endif
+#if CONFIG_APPFLEXOSEXAMPLE_BATCH
+     if (batch_bmk() < 0)
+         return 1;
+#endif
+     /* One trial runs every test vector 200 times. Timings and PMU event
+      * counts come out as one CSV/JSON line, see lib/ukbench.
+      */
+     if (uk_bench_init(&b, "testvectors", CONFIG_APPFLEXOSEXAMPLE_WARMUP,
+                       CONFIG_APPFLEXOSEXAMPLE_TRIALS, 0) < 0)
+         return 1;
+#if CONFIG_LIBUKBENCH_PMU_COMPARTMENTS
+     /* Count events per compartment from here on: main runs in 0 */
+     uk_pmu_comp_reset();
+#endif
+     uk_bench_foreach(&b) {
+         uk_bench_start(&b);
          for (int i = 0; i < 200; i++) {
              tv_hchacha20();
              tv_stream_xchacha20();
@@ -993,16 +1130,12 @@ int main()
              secretstream_xmain();
              scalarmult_xmain();
          }
-
-//             c0e = read_counter0();
-//   c1e = read_counter1();
-         // uint64_t end = read_cntvct();
-         // uk_pr_crit("cycles: %d executed\n", end - start);
-//         printf("L1I: %d, L1I_REFILL: %d\n", c0e-c0s, c1e-c1s);
-//printf("L1D: %d, L1D_REFILL: %d\n", c0e-c0s, c1e-c1s);
-//printf("BR_RET: %d, BR_RET_MISPRED: %d\n", c0e-c0s, c1e-c1s);
-//printf("INST_RET: %d, MEM_ACC: %d\n", c0e-c0s, c1e-c1s);
+         uk_bench_stop(&b);
     }
+    uk_bench_finish(&b);
+#if CONFIG_LIBUKBENCH_PMU_COMPARTMENTS
+    uk_pmu_comp_report(0);
+#endif
     printf("done\n");
   	printf("\n");
 	return 0;
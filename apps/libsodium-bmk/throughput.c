@@ -0,0 +1,192 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * ChaCha20 and Poly1305 throughput for 64 B to 64 KiB messages. Every
+ * size is run through libsodium's reference code (chacha20_ref,
+ * poly1305_donna) and through the public API, i.e., whatever
+ * sodium_init() picked; with CONFIG_LIBSODIUM_SIMD, that is the
+ * vectorised implementation. Before measuring, the selected ChaCha20 and,
+ * with CONFIG_LIBSODIUM_SIMD, the port's vector ChaCha20 are checked
+ * against the reference code, since on x86_64 sodium_init() usually picks
+ * another one.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <sodium.h>
+#include <uk/essentials.h>
+#include <uk/plat/time.h>
+
+#include "ref/chacha20_ref.h"
+#include "donna/poly1305_donna.h"
+#if CONFIG_LIBSODIUM_SIMD
+#include "chacha20_vec.h"
+#endif
+
+#include "throughput.h"
+
+#define TOTAL_BYTES \
+	((uint64_t) CONFIG_APPFLEXOSEXAMPLE_THROUGHPUT_BYTES * 1024)
+#define MAX_MESSAGE	65536
+
+static const size_t msg_sizes[] = {
+	64, 128, 256, 512, 1024, 4096, 16384, MAX_MESSAGE
+};
+
+/* Also covers partial blocks and the scalar tail of vector code */
+static const size_t check_sizes[] = {
+	1, 63, 64, 65, 255, 256, 257, 1000, MAX_MESSAGE
+};
+
+static unsigned char msg[MAX_MESSAGE];
+static unsigned char out[MAX_MESSAGE];
+static unsigned char key[crypto_stream_chacha20_KEYBYTES];
+static unsigned char nonce[crypto_stream_chacha20_NONCEBYTES];
+static unsigned char tag[crypto_onetimeauth_poly1305_BYTES];
+
+enum bench_op {
+	CHACHA20_REF,
+	CHACHA20,
+	POLY1305_REF,
+	POLY1305,
+};
+
+static const char *const op_names[] = {
+	"chacha20 ref", "chacha20", "poly1305 ref", "poly1305"
+};
+
+static void run(enum bench_op op, size_t size)
+{
+	switch (op) {
+	case CHACHA20_REF:
+		crypto_stream_chacha20_ref_implementation.stream_xor_ic(
+			out, msg, size, nonce, 0, key);
+		break;
+	case CHACHA20:
+		crypto_stream_chacha20_xor(out, msg, size, nonce, key);
+		break;
+	case POLY1305_REF:
+		crypto_onetimeauth_poly1305_donna_implementation.onetimeauth(
+			tag, msg, size, key);
+		break;
+	case POLY1305:
+		crypto_onetimeauth_poly1305(tag, msg, size, key);
+		break;
+	}
+}
+
+static unsigned char check_out[MAX_MESSAGE];
+
+/* 0 if `impl` (NULL: the selected one) agrees with the reference code */
+static int check_chacha20(const char *name,
+			  crypto_stream_chacha20_implementation *impl)
+{
+	static const uint64_t ics[] = { 0, 1, 0xffffffffULL };
+	unsigned int i, j;
+	size_t size;
+
+	for (i = 0; i < ARRAY_SIZE(check_sizes); i++) {
+		for (j = 0; j < ARRAY_SIZE(ics); j++) {
+			size = check_sizes[i];
+			/* The public API always starts at block 0 */
+			if (!impl && ics[j])
+				continue;
+
+			crypto_stream_chacha20_ref_implementation.stream_xor_ic(
+				out, msg, size, nonce, ics[j], key);
+			if (impl)
+				impl->stream_xor_ic(check_out, msg, size,
+						    nonce, ics[j], key);
+			else
+				crypto_stream_chacha20_xor(check_out, msg, size,
+							   nonce, key);
+			if (sodium_memcmp(out, check_out, size)) {
+				printf("%s: output differs from the reference for %zu B at block %" PRIu64 "\n",
+				       name, size, ics[j]);
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* MB/s of `op` on messages of `size` bytes */
+static uint64_t bench(enum bench_op op, size_t size)
+{
+	uint64_t calls, i;
+	__nsec start, ns;
+
+	calls = MAX(TOTAL_BYTES / size, (uint64_t) 1);
+
+	start = ukplat_monotonic_clock();
+	for (i = 0; i < calls; i++)
+		run(op, size);
+	ns = ukplat_monotonic_clock() - start;
+	if (!ns)
+		ns = 1;
+
+	return (calls * size * 1000) / (uint64_t) ns;
+}
+
+int throughput_bmk(void)
+{
+	unsigned int i, op;
+
+	if (sodium_init() < 0) {
+		printf("sodium_init() failed\n");
+		return -1;
+	}
+	randombytes_buf(msg, sizeof(msg));
+	crypto_stream_chacha20_keygen(key);
+	randombytes_buf(nonce, sizeof(nonce));
+
+	if (check_chacha20("chacha20", NULL))
+		return -1;
+#if CONFIG_LIBSODIUM_SIMD
+	if (check_chacha20("chacha20 vec",
+			   &crypto_stream_chacha20_vec_implementation))
+		return -1;
+#endif
+
+	printf("%" PRIu64 " KiB per message size, MB/s\n", TOTAL_BYTES / 1024);
+	printf("%8s", "message");
+	for (op = 0; op < ARRAY_SIZE(op_names); op++)
+		printf(" %13s", op_names[op]);
+	printf("\n");
+	for (i = 0; i < ARRAY_SIZE(msg_sizes); i++) {
+		printf("%6zu B", msg_sizes[i]);
+		for (op = 0; op < ARRAY_SIZE(op_names); op++)
+			printf(" %13" PRIu64, bench(op, msg_sizes[i]));
+		printf("\n");
+	}
+	return 0;
+}
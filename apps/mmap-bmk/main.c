@@ -0,0 +1,192 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Churn of large anonymous mappings, the pattern of allocators that serve
+ * big requests with mmap: a fixed number of slots each hold a mapping of
+ * random size, and every round unmaps a random slot and maps a new size
+ * into it, so the mapped area gets fragmented over time. Prints the average
+ * cost of mmap and munmap, then the cost of growing a mapping with mremap
+ * in place and with a move.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <uk/plat/time.h>
+
+#define SLOTS		CONFIG_APPMMAPBMK_SLOTS
+#define MAX_PAGES	(CONFIG_APPMMAPBMK_MAX_SIZE * 1024 / 4096)
+#define MIN_PAGES	16
+
+static void *slot_addr[SLOTS];
+static size_t slot_len[SLOTS];
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15ULL;
+
+static inline uint64_t rnd_next(void)
+{
+	rnd_state ^= rnd_state << 13;
+	rnd_state ^= rnd_state >> 7;
+	rnd_state ^= rnd_state << 17;
+	return rnd_state;
+}
+
+static size_t rnd_len(void)
+{
+	return (MIN_PAGES + rnd_next() % (MAX_PAGES - MIN_PAGES + 1)) * 4096;
+}
+
+static int map_slot(unsigned int i, uint64_t *ns)
+{
+	__nsec start;
+
+	slot_len[i] = rnd_len();
+	start = ukplat_monotonic_clock();
+	slot_addr[i] = mmap(NULL, slot_len[i], PROT_READ | PROT_WRITE,
+			    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	*ns += ukplat_monotonic_clock() - start;
+
+	if (slot_addr[i] == MAP_FAILED) {
+		printf("mmap of %zu bytes failed\n", slot_len[i]);
+		return -1;
+	}
+	/* Touch the mapping so it is not just bookkeeping */
+	*(volatile char *) slot_addr[i] = 1;
+	return 0;
+}
+
+static void unmap_slot(unsigned int i, uint64_t *ns)
+{
+	__nsec start;
+
+	start = ukplat_monotonic_clock();
+	munmap(slot_addr[i], slot_len[i]);
+	*ns += ukplat_monotonic_clock() - start;
+}
+
+static int churn(void)
+{
+	uint64_t map_ns = 0, unmap_ns = 0, bytes = 0;
+	unsigned int i, r;
+
+	for (i = 0; i < SLOTS; i++) {
+		if (map_slot(i, &map_ns))
+			return -1;
+	}
+
+	map_ns = 0;
+	for (r = 0; r < CONFIG_APPMMAPBMK_ITERATIONS; r++) {
+		i = rnd_next() % SLOTS;
+		unmap_slot(i, &unmap_ns);
+		if (map_slot(i, &map_ns))
+			return -1;
+		bytes += slot_len[i];
+	}
+
+	printf("churn: %d slots, %d rounds, %"PRIu64" KiB per mapping\n",
+	       SLOTS, CONFIG_APPMMAPBMK_ITERATIONS,
+	       bytes / CONFIG_APPMMAPBMK_ITERATIONS / 1024);
+	printf("%12s %12s\n", "mmap (ns)", "munmap (ns)");
+	printf("%12"PRIu64" %12"PRIu64"\n",
+	       map_ns / CONFIG_APPMMAPBMK_ITERATIONS,
+	       unmap_ns / CONFIG_APPMMAPBMK_ITERATIONS);
+
+	for (i = 0; i < SLOTS; i++)
+		unmap_slot(i, &unmap_ns);
+	return 0;
+}
+
+/*
+ * Grows a mapping page by page up to MAX_PAGES. With `blocked` set, a page
+ * mapped right behind it forces every step to move the mapping.
+ */
+static int grow(int blocked, uint64_t *ns)
+{
+	size_t len = 4096;
+	void *p, *q, *guard = NULL;
+	__nsec start;
+
+	p = mmap(NULL, len, PROT_READ | PROT_WRITE,
+		 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED)
+		return -1;
+	memset(p, 0x5a, len);
+
+	*ns = 0;
+	while (len < MAX_PAGES * 4096) {
+		if (blocked) {
+			guard = mmap((char *) p + len, 4096, PROT_NONE,
+				     MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
+				     -1, 0);
+			if (guard == MAP_FAILED)
+				return -1;
+		}
+
+		start = ukplat_monotonic_clock();
+		q = mremap(p, len, len + 4096, MREMAP_MAYMOVE);
+		*ns += ukplat_monotonic_clock() - start;
+
+		if (guard)
+			munmap(guard, 4096);
+		if (q == MAP_FAILED)
+			return -1;
+		if (*(char *) q != 0x5a) {
+			printf("mremap lost the contents of the mapping\n");
+			return -1;
+		}
+		p = q;
+		len += 4096;
+	}
+
+	*ns /= MAX_PAGES - 1;
+	munmap(p, len);
+	return 0;
+}
+
+int main(int argc __unused, char *argv[] __unused)
+{
+	uint64_t in_place, moved;
+
+	if (churn())
+		return 1;
+
+	if (grow(0, &in_place) || grow(1, &moved)) {
+		printf("mremap failed\n");
+		return 1;
+	}
+	printf("mremap by one page, up to %d KiB\n",
+	       CONFIG_APPMMAPBMK_MAX_SIZE);
+	printf("%12s %12s\n", "grow (ns)", "move (ns)");
+	printf("%12"PRIu64" %12"PRIu64"\n", in_place, moved);
+	return 0;
+}
@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <sodium.h>
+#include <uk/alloc.h>
+#include <uk/config.h>
+#include <flexos/isolation.h>
+#include <sodium_batch.h>
+
+#define AEAD_ABYTES	crypto_aead_chacha20poly1305_ietf_ABYTES
+
+static int batch_job(struct sodium_batch_job *job)
+{
+	if (!job->key || !job->nonce || !job->out
+	    || (!job->in && job->inlen))
+		return -1;
+
+	/* Oversized messages would end in sodium_misuse() and abort */
+	switch (job->op) {
+	case SODIUM_BATCH_STREAM_XOR:
+		if (job->inlen > crypto_stream_chacha20_ietf_MESSAGEBYTES_MAX)
+			return -1;
+		job->outlen = job->inlen;
+		return crypto_stream_chacha20_ietf_xor(job->out, job->in,
+						       job->inlen, job->nonce,
+						       job->key);
+	case SODIUM_BATCH_AEAD_ENCRYPT:
+		if (job->inlen >
+		    crypto_aead_chacha20poly1305_ietf_MESSAGEBYTES_MAX)
+			return -1;
+		return crypto_aead_chacha20poly1305_ietf_encrypt(
+			job->out, &job->outlen, job->in, job->inlen,
+			NULL, 0, NULL, job->nonce, job->key);
+	case SODIUM_BATCH_AEAD_DECRYPT:
+		if (job->inlen < AEAD_ABYTES || job->inlen - AEAD_ABYTES >
+		    crypto_aead_chacha20poly1305_ietf_MESSAGEBYTES_MAX)
+			return -1;
+		return crypto_aead_chacha20poly1305_ietf_decrypt(
+			job->out, &job->outlen, NULL, job->in, job->inlen,
+			NULL, 0, job->nonce, job->key);
+	}
+	return -1;
+}
+
+#if CONFIG_LIBFLEXOS_MORELLO
+/* Runs in the libsodium compartment; the job array is only reachable
+ * through a capability bounded to it
+ */
+static void sodium_batch_run_morello(struct sodium_batch_job *__capability jobs,
+				     unsigned int count)
+{
+	struct sodium_batch_job job;
+	unsigned int i;
+
+	for (i = 0; i < count; i++) {
+		job = jobs[i];
+		jobs[i].status = batch_job(&job) ? -1 : 0;
+		jobs[i].outlen = job.outlen;
+	}
+}
+#else
+static void sodium_batch_exec(struct sodium_batch_job *jobs,
+			      unsigned int count)
+{
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		jobs[i].status = batch_job(&jobs[i]) ? -1 : 0;
+}
+#endif /* CONFIG_LIBFLEXOS_MORELLO */
+
+struct sodium_batch_job *sodium_batch_alloc(unsigned int count)
+{
+	return uk_calloc(flexos_shared_alloc, count,
+			 sizeof(struct sodium_batch_job));
+}
+
+void sodium_batch_free(struct sodium_batch_job *jobs)
+{
+	uk_free(flexos_shared_alloc, jobs);
+}
+
+unsigned int sodium_batch_run(struct sodium_batch_job *jobs,
+			      unsigned int count)
+{
+	unsigned int i, failed = 0;
+
+	if (!count)
+		return 0;
+
+#if CONFIG_LIBFLEXOS_MORELLO
+	/* One crossing for the whole batch */
+	__flexos_morello_gate2_ci(0, 1, sodium_batch_run_morello,
+				  cheri_ptr(jobs, count * sizeof(*jobs)),
+				  count);
+#else
+	sodium_batch_exec(jobs, count);
+#endif /* CONFIG_LIBFLEXOS_MORELLO */
+
+	for (i = 0; i < count; i++)
+		if (jobs[i].status)
+			failed++;
+	return failed;
+}
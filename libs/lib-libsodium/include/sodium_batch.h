@@ -0,0 +1,99 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SODIUM_BATCH_H__
+#define __SODIUM_BATCH_H__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Batched entry into the libsodium compartment. With isolation, every
+ * libsodium call is a compartment crossing, and for small messages the
+ * gate costs more than the cryptography. sodium_batch_run() crosses once
+ * for a whole vector of jobs.
+ *
+ * The jobs and every buffer they point to have to be reachable from the
+ * libsodium compartment, i.e., live in shared memory;
+ * sodium_batch_alloc() allocates jobs there.
+ */
+
+enum sodium_batch_op {
+	/* out = in ^ ChaCha20-IETF(key, nonce), outlen = inlen */
+	SODIUM_BATCH_STREAM_XOR = 0,
+	/* out = ChaCha20-Poly1305-IETF encryption of in, followed by the
+	 * tag; outlen = inlen + crypto_aead_chacha20poly1305_ietf_ABYTES
+	 */
+	SODIUM_BATCH_AEAD_ENCRYPT,
+	/* Verifies and decrypts the output of SODIUM_BATCH_AEAD_ENCRYPT,
+	 * outlen = inlen - crypto_aead_chacha20poly1305_ietf_ABYTES. A
+	 * forged or corrupted message fails with status -1.
+	 */
+	SODIUM_BATCH_AEAD_DECRYPT,
+};
+
+struct sodium_batch_job {
+	enum sodium_batch_op op;
+	/* crypto_aead_chacha20poly1305_ietf_KEYBYTES */
+	const unsigned char *key;
+	/* crypto_aead_chacha20poly1305_ietf_NPUBBYTES */
+	const unsigned char *nonce;
+	const unsigned char *in;
+	unsigned long long inlen;
+	unsigned char *out;
+	/* Set by sodium_batch_run() */
+	unsigned long long outlen;
+	int status;
+};
+
+/*
+ * Allocates `count` zeroed jobs from the shared heap.
+ * Returns NULL if out of memory.
+ */
+struct sodium_batch_job *sodium_batch_alloc(unsigned int count);
+void sodium_batch_free(struct sodium_batch_job *jobs);
+
+/*
+ * Runs `count` jobs with a single crossing into the libsodium compartment.
+ * Every job gets status 0 on success or -1 on failure (invalid
+ * arguments, failed verification); failed jobs do not stop the batch.
+ * Returns the number of failed jobs.
+ */
+unsigned int sodium_batch_run(struct sodium_batch_job *jobs,
+			      unsigned int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SODIUM_BATCH_H__ */
@@ -0,0 +1,371 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uk/config.h>
+
+#include "core.h"
+#include "crypto_stream_chacha20.h"
+#include "private/common.h"
+#include "utils.h"
+
+#include "chacha20_vec.h"
+
+#if CONFIG_LIBFLEXOS_MORELLO
+# include <flexos/isolation.h>
+/* The kernel runs in libsodium's compartment and reaches the caller's
+ * buffers through capabilities bounded to them.
+ */
+# define VEC_CAP __capability
+#else
+# define VEC_CAP
+#endif
+
+#define VEC_LANES       4
+#define VEC_BATCH_BYTES (VEC_LANES * 64)
+
+typedef uint32_t chacha_v4u32 __attribute__((vector_size(16)));
+/* Unaligned view of 16 message, keystream or output bytes */
+typedef uint8_t chacha_v16u8 __attribute__((vector_size(16), aligned(1)));
+
+typedef struct chacha_ctx {
+    uint32_t input[16];
+} chacha_ctx;
+
+#define VROTL32(v, c) (((v) << (c)) | ((v) >> (32 - (c))))
+
+#define VQUARTERROUND(a, b, c, d)       \
+    do {                                \
+        a += b; d = VROTL32(d ^ a, 16); \
+        c += d; b = VROTL32(b ^ c, 12); \
+        a += b; d = VROTL32(d ^ a, 8);  \
+        c += d; b = VROTL32(b ^ c, 7);  \
+    } while (0)
+
+#define QUARTERROUND(a, b, c, d)          \
+    do {                                  \
+        a += b; d = ROTL32(d ^ a, 16);    \
+        c += d; b = ROTL32(b ^ c, 12);    \
+        a += b; d = ROTL32(d ^ a, 8);     \
+        c += d; b = ROTL32(b ^ c, 7);     \
+    } while (0)
+
+static void
+chacha_keysetup(chacha_ctx *ctx, const uint8_t *k)
+{
+    ctx->input[0]  = 0x61707865;
+    ctx->input[1]  = 0x3320646e;
+    ctx->input[2]  = 0x79622d32;
+    ctx->input[3]  = 0x6b206574;
+    ctx->input[4]  = LOAD32_LE(k + 0);
+    ctx->input[5]  = LOAD32_LE(k + 4);
+    ctx->input[6]  = LOAD32_LE(k + 8);
+    ctx->input[7]  = LOAD32_LE(k + 12);
+    ctx->input[8]  = LOAD32_LE(k + 16);
+    ctx->input[9]  = LOAD32_LE(k + 20);
+    ctx->input[10] = LOAD32_LE(k + 24);
+    ctx->input[11] = LOAD32_LE(k + 28);
+}
+
+static void
+chacha_ivsetup(chacha_ctx *ctx, const uint8_t *iv, const uint8_t *counter)
+{
+    ctx->input[12] = counter == NULL ? 0 : LOAD32_LE(counter + 0);
+    ctx->input[13] = counter == NULL ? 0 : LOAD32_LE(counter + 4);
+    ctx->input[14] = LOAD32_LE(iv + 0);
+    ctx->input[15] = LOAD32_LE(iv + 4);
+}
+
+static void
+chacha_ietf_ivsetup(chacha_ctx *ctx, const uint8_t *iv, const uint8_t *counter)
+{
+    ctx->input[12] = counter == NULL ? 0 : LOAD32_LE(counter);
+    ctx->input[13] = LOAD32_LE(iv + 0);
+    ctx->input[14] = LOAD32_LE(iv + 4);
+    ctx->input[15] = LOAD32_LE(iv + 8);
+}
+
+#ifdef __clang__
+# define VSHUFFLE(a, b, i0, i1, i2, i3) \
+    __builtin_shufflevector(a, b, i0, i1, i2, i3)
+#else
+# define VSHUFFLE(a, b, i0, i1, i2, i3) \
+    __builtin_shuffle(a, b, (chacha_v4u32) { i0, i1, i2, i3 })
+#endif
+
+/* Keystream of the blocks at counter input[12,13] + 0..3, lane j of every
+ * state vector belonging to block j. The counter carries into input[13]
+ * like in the reference implementation.
+ */
+static void
+chacha20_vec_blocks(uint8_t ks[VEC_BATCH_BYTES], const uint32_t input[16])
+{
+    chacha_v4u32 x[16];
+    chacha_v4u32 in[16];
+    uint64_t     ctr;
+    unsigned int i;
+    unsigned int j;
+
+    for (i = 0; i < 16; i++) {
+        in[i] = (chacha_v4u32) { input[i], input[i], input[i], input[i] };
+    }
+    ctr = ((uint64_t) input[13] << 32) | input[12];
+    for (j = 0; j < VEC_LANES; j++) {
+        in[12][j] = (uint32_t) (ctr + j);
+        in[13][j] = (uint32_t) ((ctr + j) >> 32);
+    }
+    for (i = 0; i < 16; i++) {
+        x[i] = in[i];
+    }
+    for (i = 20; i > 0; i -= 2) {
+        VQUARTERROUND(x[0], x[4], x[8], x[12]);
+        VQUARTERROUND(x[1], x[5], x[9], x[13]);
+        VQUARTERROUND(x[2], x[6], x[10], x[14]);
+        VQUARTERROUND(x[3], x[7], x[11], x[15]);
+        VQUARTERROUND(x[0], x[5], x[10], x[15]);
+        VQUARTERROUND(x[1], x[6], x[11], x[12]);
+        VQUARTERROUND(x[2], x[7], x[8], x[13]);
+        VQUARTERROUND(x[3], x[4], x[9], x[14]);
+    }
+    for (i = 0; i < 16; i++) {
+        x[i] += in[i];
+    }
+#ifdef NATIVE_LITTLE_ENDIAN
+    /* Transpose every group of four words so that each vector holds
+     * 16 consecutive keystream bytes of one block
+     */
+    for (i = 0; i < 16; i += 4) {
+        chacha_v4u32 t0 = VSHUFFLE(x[i + 0], x[i + 1], 0, 4, 1, 5);
+        chacha_v4u32 t1 = VSHUFFLE(x[i + 0], x[i + 1], 2, 6, 3, 7);
+        chacha_v4u32 t2 = VSHUFFLE(x[i + 2], x[i + 3], 0, 4, 1, 5);
+        chacha_v4u32 t3 = VSHUFFLE(x[i + 2], x[i + 3], 2, 6, 3, 7);
+
+        *(chacha_v16u8 *) (ks + 0 * 64 + 4 * i) =
+            (chacha_v16u8) VSHUFFLE(t0, t2, 0, 1, 4, 5);
+        *(chacha_v16u8 *) (ks + 1 * 64 + 4 * i) =
+            (chacha_v16u8) VSHUFFLE(t0, t2, 2, 3, 6, 7);
+        *(chacha_v16u8 *) (ks + 2 * 64 + 4 * i) =
+            (chacha_v16u8) VSHUFFLE(t1, t3, 0, 1, 4, 5);
+        *(chacha_v16u8 *) (ks + 3 * 64 + 4 * i) =
+            (chacha_v16u8) VSHUFFLE(t1, t3, 2, 3, 6, 7);
+    }
+#else
+    for (j = 0; j < VEC_LANES; j++) {
+        for (i = 0; i < 16; i++) {
+            STORE32_LE(ks + 64 * j + 4 * i, x[i][j]);
+        }
+    }
+#endif
+}
+
+/* Single block for messages, or their last part, of at most 64 bytes,
+ * which are cheaper to compute with scalar registers than as a batch
+ */
+static void
+chacha20_block(uint8_t ks[64], const uint32_t input[16])
+{
+    uint32_t     x[16];
+    unsigned int i;
+
+    memcpy(x, input, sizeof x);
+    for (i = 20; i > 0; i -= 2) {
+        QUARTERROUND(x[0], x[4], x[8], x[12]);
+        QUARTERROUND(x[1], x[5], x[9], x[13]);
+        QUARTERROUND(x[2], x[6], x[10], x[14]);
+        QUARTERROUND(x[3], x[7], x[11], x[15]);
+        QUARTERROUND(x[0], x[5], x[10], x[15]);
+        QUARTERROUND(x[1], x[6], x[11], x[12]);
+        QUARTERROUND(x[2], x[7], x[8], x[13]);
+        QUARTERROUND(x[3], x[4], x[9], x[14]);
+    }
+    for (i = 0; i < 16; i++) {
+        STORE32_LE(ks + 4 * i, x[i] + input[i]);
+    }
+    sodium_memzero(x, sizeof x);
+}
+
+/* c = m ^ keystream over the whole buffer, 16 bytes per vector */
+static void
+chacha20_vec_xor(const chacha_ctx *VEC_CAP ctx, const uint8_t *VEC_CAP m,
+                 uint8_t *VEC_CAP c, unsigned long long bytes)
+{
+    uint32_t input[16];
+    uint8_t  ks[VEC_BATCH_BYTES];
+    uint64_t ctr;
+    size_t   n;
+    size_t   i;
+
+    for (i = 0; i < 16; i++) {
+        input[i] = ctx->input[i];
+    }
+    while (bytes > 0) {
+        if (bytes <= 64) {
+            chacha20_block(ks, input);
+        } else {
+            chacha20_vec_blocks(ks, input);
+        }
+        n = bytes < VEC_BATCH_BYTES ? (size_t) bytes : VEC_BATCH_BYTES;
+        for (i = 0; i + 16 <= n; i += 16) {
+            *(chacha_v16u8 *VEC_CAP) (c + i) =
+                *(const chacha_v16u8 *VEC_CAP) (m + i) ^
+                *(const chacha_v16u8 *) (ks + i);
+        }
+        for (; i < n; i++) {
+            c[i] = m[i] ^ ks[i];
+        }
+        ctr = (((uint64_t) input[13] << 32) | input[12]) + VEC_LANES;
+        input[12] = (uint32_t) ctr;
+        input[13] = (uint32_t) (ctr >> 32);
+        m += n;
+        c += n;
+        bytes -= n;
+    }
+    sodium_memzero(ks, sizeof ks);
+    sodium_memzero(input, sizeof input);
+}
+
+#if CONFIG_LIBFLEXOS_MORELLO
+static void
+chacha20_vec_xor_morello(uint8_t *__capability c,
+                         const uint8_t *__capability m,
+                         const chacha_ctx *__capability ctx, size_t bytes)
+{
+    chacha20_vec_xor(ctx, m, c, bytes);
+}
+
+/* One gate per message: input and output are passed as capabilities
+ * bounded to the message, rather than crossing a gate for every word
+ * that is loaded or stored.
+ */
+static void
+chacha20_encrypt_bytes(chacha_ctx *ctx, const uint8_t *m, uint8_t *c,
+                       unsigned long long bytes)
+{
+    __flexos_morello_gate4(0, 1, chacha20_vec_xor_morello,
+                           cheri_ptr(c, bytes), cheri_ptr(m, bytes),
+                           cheri_ptr(ctx, sizeof *ctx), (size_t) bytes);
+}
+#else
+static void
+chacha20_encrypt_bytes(chacha_ctx *ctx, const uint8_t *m, uint8_t *c,
+                       unsigned long long bytes)
+{
+    chacha20_vec_xor(ctx, m, c, bytes);
+}
+#endif
+
+static int
+stream_vec(unsigned char *c, unsigned long long clen, const unsigned char *n,
+           const unsigned char *k)
+{
+    struct chacha_ctx ctx;
+
+    if (!clen) {
+        return 0;
+    }
+    COMPILER_ASSERT(crypto_stream_chacha20_KEYBYTES == 256 / 8);
+    chacha_keysetup(&ctx, k);
+    chacha_ivsetup(&ctx, n, NULL);
+    memset(c, 0, clen);
+    chacha20_encrypt_bytes(&ctx, c, c, clen);
+    sodium_memzero(&ctx, sizeof ctx);
+
+    return 0;
+}
+
+static int
+stream_ietf_ext_vec(unsigned char *c, unsigned long long clen,
+                    const unsigned char *n, const unsigned char *k)
+{
+    struct chacha_ctx ctx;
+
+    if (!clen) {
+        return 0;
+    }
+    COMPILER_ASSERT(crypto_stream_chacha20_KEYBYTES == 256 / 8);
+    chacha_keysetup(&ctx, k);
+    chacha_ietf_ivsetup(&ctx, n, NULL);
+    memset(c, 0, clen);
+    chacha20_encrypt_bytes(&ctx, c, c, clen);
+    sodium_memzero(&ctx, sizeof ctx);
+
+    return 0;
+}
+
+static int
+stream_vec_xor_ic(unsigned char *c, const unsigned char *m,
+                  unsigned long long mlen, const unsigned char *n, uint64_t ic,
+                  const unsigned char *k)
+{
+    struct chacha_ctx ctx;
+    uint8_t           ic_bytes[8];
+
+    if (!mlen) {
+        return 0;
+    }
+    STORE32_LE(&ic_bytes[0], (uint32_t) ic);
+    STORE32_LE(&ic_bytes[4], (uint32_t) (ic >> 32));
+    chacha_keysetup(&ctx, k);
+    chacha_ivsetup(&ctx, n, ic_bytes);
+    chacha20_encrypt_bytes(&ctx, m, c, mlen);
+    sodium_memzero(&ctx, sizeof ctx);
+
+    return 0;
+}
+
+static int
+stream_ietf_ext_vec_xor_ic(unsigned char *c, const unsigned char *m,
+                           unsigned long long mlen, const unsigned char *n,
+                           uint32_t ic, const unsigned char *k)
+{
+    struct chacha_ctx ctx;
+    uint8_t           ic_bytes[4];
+
+    if (!mlen) {
+        return 0;
+    }
+    STORE32_LE(ic_bytes, ic);
+    chacha_keysetup(&ctx, k);
+    chacha_ietf_ivsetup(&ctx, n, ic_bytes);
+    chacha20_encrypt_bytes(&ctx, m, c, mlen);
+    sodium_memzero(&ctx, sizeof ctx);
+
+    return 0;
+}
+
+struct crypto_stream_chacha20_implementation
+    crypto_stream_chacha20_vec_implementation = {
+        SODIUM_C99(.stream =) stream_vec,
+        SODIUM_C99(.stream_ietf_ext =) stream_ietf_ext_vec,
+        SODIUM_C99(.stream_xor_ic =) stream_vec_xor_ic,
+        SODIUM_C99(.stream_ietf_ext_xor_ic =) stream_ietf_ext_vec_xor_ic
+    };
@@ -50,20 +50,11 @@ static void _netbuf_free(struct pbuf *p)
 	flexos_gate(uknetdev, uk_netbuf_free_single, nb);
 }
 
-struct uk_netbuf *lwip_alloc_netbuf(struct uk_alloc *a, size_t alloc_size,
-				    size_t alloc_align, uint16_t headroom)
+void lwip_netbuf_prepare(struct uk_netbuf *b)
 {
-	struct uk_netbuf *b;
 	struct _netbuf_pbuf *np;
 
-	b = uk_netbuf_alloc_buf(a, alloc_size, alloc_align,
-				headroom, sizeof(struct _netbuf_pbuf), NULL);
-	if (unlikely(!b)) {
-		LWIP_DEBUGF(PBUF_DEBUG,
-			    ("Failed to allocate netbuf with encapsulated pbuf: requested headroom: %"__PRIu16", size: %"__PRIsz", alignement: %"__PRIsz"\n",
-			     headroom, alloc_size, alloc_align));
-		goto err_out;
-	}
+	UK_ASSERT(b);
 
 	/* Fill-out meta data */
 	np = (struct _netbuf_pbuf *) uk_netbuf_get_priv(b);
@@ -79,7 +70,23 @@ struct uk_netbuf *lwip_alloc_netbuf(struct uk_alloc *a, size_t alloc_size,
 	 * Set length of netbuf to available space so that it
 	 * can be used as receive buffer
 	 */
-	b->len = b->buflen - headroom;
+	b->len = b->buflen - uk_netbuf_headroom(b);
+}
+
+struct uk_netbuf *lwip_alloc_netbuf(struct uk_alloc *a, size_t alloc_size,
+				    size_t alloc_align, uint16_t headroom)
+{
+	struct uk_netbuf *b;
+
+	b = uk_netbuf_alloc_buf(a, alloc_size, alloc_align,
+				headroom, sizeof(struct _netbuf_pbuf), NULL);
+	if (unlikely(!b)) {
+		LWIP_DEBUGF(PBUF_DEBUG,
+			    ("Failed to allocate netbuf with encapsulated pbuf: requested headroom: %"__PRIu16", size: %"__PRIsz", alignement: %"__PRIsz"\n",
+			     headroom, alloc_size, alloc_align));
+		goto err_out;
+	}
+	lwip_netbuf_prepare(b);
 
 	LWIP_DEBUGF(PBUF_DEBUG,
 		    ("Allocated netbuf with encapsulated pbuf %p (buflen: %"__PRIsz", headroom: %"__PRIsz")\n",
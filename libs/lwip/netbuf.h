@@ -63,6 +63,13 @@ struct _netbuf_pbuf {
 struct uk_netbuf *lwip_alloc_netbuf(struct uk_alloc *a, size_t alloc_size,
 				    size_t alloc_align, uint16_t headroom);
 
+/**
+ * Sets up the embedded pbuf of a netbuf that was taken from a netbuf pool
+ * with a private area of `sizeof(struct _netbuf_pbuf)`, see
+ * lwip_alloc_netbuf().
+ */
+void lwip_netbuf_prepare(struct uk_netbuf *b);
+
 /**
  * Returns the reference of the embedded pbuf of a netbuf
  */
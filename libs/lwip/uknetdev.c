@@ -51,6 +51,9 @@
 #include "lwip/sys.h"
 #include "lwip/tcpip.h"
 #include "lwip/ethip6.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/ip6.h"
 #include "netif/etharp.h"
 #include "netif/ethernet.h"
 #include <uk/arch/atomic.h>
@@ -79,6 +82,20 @@
 #define UKNETDEV_NETIF_NAME0 'e'
 #define UKNETDEV_NETIF_NAME1 'n'
 
+struct lwip_netdev_data;
+
+/*
+ * Per queue pair state: receive descriptors are refilled from `rx_pool` and
+ * transmit buffers are taken from `tx_pool`; both are recycled on free.
+ * Without pools (LWIP_UKNETDEV_POOLBUFS is 0) or when a pool runs empty,
+ * buffers are allocated from `pkt_a`.
+ */
+struct lwip_netdev_queue {
+	struct lwip_netdev_data *lwip_data;
+	struct uk_netbuf_pool *rx_pool;
+	struct uk_netbuf_pool *tx_pool;
+};
+
 struct lwip_netdev_data {
 	/*
 	 * NOTE: For now we use the same allocator for RX and TX packets.
@@ -89,6 +106,8 @@ struct lwip_netdev_data {
 	 */
 	struct uk_alloc *pkt_a;
 	struct uk_netdev_info dev_info;
+	uint16_t nb_queues; /* Configured receive-transmit queue pairs */
+	struct lwip_netdev_queue queue[CONFIG_LWIP_UKNETDEV_QUEUES];
 #ifdef CONFIG_HAVE_SCHED
 	struct uk_thread *poll_thread; /* Thread per device */
 	char *_name; /* Thread name */
@@ -121,14 +140,23 @@ UK_CTASSERT((sizeof(struct lwip_netdev_data)) <= CONFIG_UK_NETDEV_SCRATCH_SIZE);
 static uint16_t netif_alloc_rxpkts(void *argp, struct uk_netbuf *nb[],
 				   uint16_t count)
 {
+	struct lwip_netdev_queue *queue;
 	struct lwip_netdev_data *lwip_data;
-	uint16_t i;
+	uint16_t i = 0, j;
 
 	UK_ASSERT(argp);
 
-	lwip_data = (struct lwip_netdev_data *) argp;
+	queue = (struct lwip_netdev_queue *) argp;
+	lwip_data = queue->lwip_data;
 
-	for (i = 0; i < count; ++i) {
+	if (queue->rx_pool) {
+		i = uk_netbuf_pool_take_batch(queue->rx_pool, nb, count);
+		for (j = 0; j < i; ++j)
+			lwip_netbuf_prepare(nb[j]);
+	}
+
+	/* Fall back to the allocator when the pool ran empty */
+	for (; i < count; ++i) {
 		nb[i] = lwip_alloc_netbuf(lwip_data->pkt_a,
 					  UKNETDEV_BUFLEN,
 					  lwip_data->dev_info.ioalign,
@@ -142,12 +170,85 @@ static uint16_t netif_alloc_rxpkts(void *argp, struct uk_netbuf *nb[],
 	return i;
 }
 
+/*
+ * Selects the transmit queue of an outgoing frame by hashing its flow
+ * (addresses, protocol and ports). All packets of a connection are sent on
+ * the same queue; devices that steer receive flows (e.g., virtio-net with
+ * VIRTIO_NET_F_MQ) deliver the replies to the paired receive queue. Frames
+ * that cannot be parsed from the first pbuf (ARP, fragments, ...) use
+ * queue 0.
+ */
+static uint16_t uknetdev_txq_select(struct pbuf *p, uint16_t nb_queues)
+{
+	const struct eth_hdr *ethhdr;
+	const uint8_t *l4 = NULL;
+	uint32_t hash = 0;
+	uint8_t proto = 0;
+
+	if (nb_queues <= 1 || p->len < SIZEOF_ETH_HDR)
+		return 0;
+
+	ethhdr = (const struct eth_hdr *) p->payload;
+	switch (ethhdr->type) {
+#if LWIP_IPV4
+	case PP_HTONS(ETHTYPE_IP): {
+		const struct ip_hdr *iphdr;
+		u16_t hlen;
+
+		if (p->len < SIZEOF_ETH_HDR + IP_HLEN)
+			return 0;
+		iphdr = (const struct ip_hdr *)
+			((const uint8_t *) p->payload + SIZEOF_ETH_HDR);
+		hash = iphdr->src.addr ^ iphdr->dest.addr;
+		proto = IPH_PROTO(iphdr);
+		hlen = IPH_HL_BYTES(iphdr);
+		/* Only the first fragment carries the ports */
+		if ((IPH_OFFSET(iphdr) & PP_HTONS(IP_OFFMASK | IP_MF)) == 0 &&
+		    p->len >= SIZEOF_ETH_HDR + hlen + 4)
+			l4 = (const uint8_t *) iphdr + hlen;
+		break;
+	}
+#endif /* LWIP_IPV4 */
+#if LWIP_IPV6
+	case PP_HTONS(ETHTYPE_IPV6): {
+		const struct ip6_hdr *ip6hdr;
+		int i;
+
+		if (p->len < SIZEOF_ETH_HDR + IP6_HLEN)
+			return 0;
+		ip6hdr = (const struct ip6_hdr *)
+			((const uint8_t *) p->payload + SIZEOF_ETH_HDR);
+		for (i = 0; i < 4; ++i)
+			hash ^= ip6hdr->src.addr[i] ^ ip6hdr->dest.addr[i];
+		/* Extension headers are not followed */
+		proto = IP6H_NEXTH(ip6hdr);
+		if (p->len >= SIZEOF_ETH_HDR + IP6_HLEN + 4)
+			l4 = (const uint8_t *) ip6hdr + IP6_HLEN;
+		break;
+	}
+#endif /* LWIP_IPV6 */
+	default:
+		return 0;
+	}
+
+	if (l4 && (proto == IP_PROTO_TCP || proto == IP_PROTO_UDP))
+		hash ^= ((uint32_t) l4[0] << 24) | ((uint32_t) l4[1] << 16)
+			| ((uint32_t) l4[2] << 8) | l4[3];
+	hash ^= proto;
+
+	/* Mix the bits so that the modulo uses all of them */
+	hash *= 0x9e3779b1u;
+	hash ^= hash >> 16;
+	return (uint16_t) (hash % nb_queues);
+}
+
 static err_t uknetdev_output(struct netif *nf, struct pbuf *p)
 {
 	struct uk_netdev *dev;
 	struct lwip_netdev_data *lwip_data;
 	struct pbuf *q;
 	struct uk_netbuf *nb;
+	uint16_t queue_id;
 	char *wpos;
 	int ret;
 
@@ -157,12 +258,17 @@ static err_t uknetdev_output(struct netif *nf, struct pbuf *p)
 
 	flexos_gate_r(uknetdev, lwip_data, _retrieve_scratchpad, dev);
 	UK_ASSERT(lwip_data);
+	queue_id = uknetdev_txq_select(p, lwip_data->nb_queues);
 
-	nb = uk_netbuf_alloc_buf(lwip_data->pkt_a,
-				 UKNETDEV_BUFLEN,
-				 lwip_data->dev_info.ioalign,
-				 lwip_data->dev_info.nb_encap_tx,
-				 0, NULL);
+	nb = NULL;
+	if (lwip_data->queue[queue_id].tx_pool)
+		nb = uk_netbuf_pool_take(lwip_data->queue[queue_id].tx_pool);
+	if (!nb)
+		nb = uk_netbuf_alloc_buf(lwip_data->pkt_a,
+					 UKNETDEV_BUFLEN,
+					 lwip_data->dev_info.ioalign,
+					 lwip_data->dev_info.nb_encap_tx,
+					 0, NULL);
 	if (!nb)
 		return ERR_MEM;
 
@@ -189,7 +295,8 @@ static err_t uknetdev_output(struct netif *nf, struct pbuf *p)
 
 	/* Transmit packet */
 	do {
-		flexos_gate_r(uknetdev, ret, uk_netdev_tx_one, dev, 0, nb);
+		flexos_gate_r(uknetdev, ret, uk_netdev_tx_one, dev, queue_id,
+			      nb);
 	} while (uk_netdev_status_notready(ret));
 	if (unlikely(ret < 0)) {
 		LWIP_DEBUGF(NETIF_DEBUG,
@@ -203,9 +310,9 @@ static err_t uknetdev_output(struct netif *nf, struct pbuf *p)
 		uk_netbuf_free_single(nb);
 		return ERR_IF;
 	}
-	LWIP_DEBUGF(NETIF_DEBUG, ("%s: %c%c%u: Sent %"PRIu16" bytes\n",
+	LWIP_DEBUGF(NETIF_DEBUG, ("%s: %c%c%u: Sent %"PRIu16" bytes on queue %"PRIu16"\n",
 				  __func__, nf->name[0], nf->name[1], nf->num,
-				  p->tot_len));
+				  p->tot_len, queue_id));
 
 	return ERR_OK;
 }
@@ -224,10 +331,12 @@ static void _uknetdev_input(struct uk_netdev *dev,
 	UK_ASSERT(nf);
 	UK_ASSERT(nf->input);
 
-	LWIP_DEBUGF(NETIF_DEBUG, ("%s: %c%c%u: Poll receive queue...\n",
-				  __func__, nf->name[0], nf->name[1], nf->num));
+	LWIP_DEBUGF(NETIF_DEBUG, ("%s: %c%c%u: Poll receive queue %"PRIu16"...\n",
+				  __func__, nf->name[0], nf->name[1], nf->num,
+				  queue_id));
 	do {
-		flexos_gate_r(uknetdev, ret, uk_netdev_rx_one, dev, 0, &nb);
+		flexos_gate_r(uknetdev, ret, uk_netdev_rx_one, dev, queue_id,
+			      &nb);
 		LWIP_DEBUGF(NETIF_DEBUG,
 			    ("%s: %c%c%u: Input status %d (%c%c%c)\n",
 			     __func__, nf->name[0], nf->name[1], nf->num, ret,
@@ -317,6 +426,8 @@ static void uknetdev_input(struct uk_netdev *dev,
 void uknetdev_poll(struct netif *nf)
 {
 	struct uk_netdev *dev;
+	struct lwip_netdev_data *lwip_data;
+	uint16_t i;
 
 	UK_ASSERT(nf);
 	/*
@@ -330,12 +441,16 @@ void uknetdev_poll(struct netif *nf)
 	dev = netif_to_uknetdev(nf);
 	UK_ASSERT(dev);
 
-	/* do not go through gate (hence the '_') */
+	flexos_gate_r(uknetdev, lwip_data, _retrieve_scratchpad, dev);
+
+	for (i = 0; i < lwip_data->nb_queues; ++i) {
+		/* do not go through gate (hence the '_') */
 #if CONFIG_LIBFLEXOS_NONE
-	uknetdev_input(dev, 0, nf);
+		uknetdev_input(dev, i, nf);
 #else
-	__uknetdev_input(dev, 0, nf);
+		__uknetdev_input(dev, i, nf);
 #endif
+	}
 }
 
 #ifdef CONFIG_LWIP_NOTHREADS
@@ -385,6 +500,8 @@ static void uknetdev_updown(struct netif *nf)
 	struct uk_netdev *dev;
 	int ret;
 	struct lwip_netdev_data  *lwip_data;
+	uint16_t i;
+	int flush = 0;
 
 	UK_ASSERT(nf);
 	dev = netif_to_uknetdev(nf);
@@ -396,27 +513,32 @@ static void uknetdev_updown(struct netif *nf)
 
 	if (nf->flags & NETIF_FLAG_UP) {
 		if (uk_netdev_rxintr_supported(lwip_data->dev_info.features)) {
-			flexos_gate_r(uknetdev, ret, uk_netdev_rxq_intr_enable, dev, 0);
-			if (ret < 0) {
-				LWIP_DEBUGF(NETIF_DEBUG,
-						("%s: %c%c%u: Failed to enable rx interrupt mode on netdev %u\n",
-						 __func__, nf->name[0],
-						 nf->name[1],
-						 nf->num,
-						 uk_netdev_id_get(dev)));
-			} else {
-				LWIP_DEBUGF(NETIF_DEBUG,
-					("%s: %c%c%u: Enabled rx interrupt mode on netdev %u\n",
-						 __func__, nf->name[0],
-						 nf->name[1],
-						 nf->num,
-						 uk_netdev_id_get(dev)));
+			for (i = 0; i < lwip_data->nb_queues; ++i) {
+				flexos_gate_r(uknetdev, ret,
+					      uk_netdev_rxq_intr_enable, dev, i);
+				if (ret < 0) {
+					LWIP_DEBUGF(NETIF_DEBUG,
+						    ("%s: %c%c%u: Failed to enable rx interrupt mode on netdev %u queue %"PRIu16"\n",
+						     __func__, nf->name[0],
+						     nf->name[1],
+						     nf->num,
+						     uk_netdev_id_get(dev), i));
+				} else {
+					LWIP_DEBUGF(NETIF_DEBUG,
+						    ("%s: %c%c%u: Enabled rx interrupt mode on netdev %u queue %"PRIu16"\n",
+						     __func__, nf->name[0],
+						     nf->name[1],
+						     nf->num,
+						     uk_netdev_id_get(dev), i));
+				}
+				if (ret == 1)
+					flush = 1;
 			}
 
-			if (ret == 1) {
+			if (flush) {
 				/*
 				 * uk_netdev_rxq_intr_enable() told us that we
-				 * need to flush the receive queue before
+				 * need to flush a receive queue before
 				 * interrupts are enabled. For this purpose
 				 * we do an initial poll.
 				 */
@@ -445,7 +567,8 @@ static void uknetdev_updown(struct netif *nf)
 		 * Cleanup the thread on stopping the network interface.
 		 */
 		if (uk_netdev_rxintr_supported(lwip_data->dev_info.features)) {
-			uk_netdev_rxq_intr_disable(dev, 0);
+			for (i = 0; i < lwip_data->nb_queues; ++i)
+				uk_netdev_rxq_intr_disable(dev, i);
 			LWIP_DEBUGF(NETIF_DEBUG,
 					("%s: %c%c%u: Disabled rx interrupts on netdev %u\n",
 					 __func__, nf->name[0], nf->name[1],
@@ -482,6 +605,7 @@ err_t uknetdev_init(struct netif *nf)
 	struct lwip_netdev_data *lwip_data;
 	const struct uk_hwaddr *hwaddr;
 	unsigned int i;
+	uint16_t q;
 	int ret;
 
 	UK_ASSERT(nf);
@@ -541,10 +665,14 @@ err_t uknetdev_init(struct netif *nf)
 
 	/*
 	 * Device configuration,
-	 * we want to use just one queue for each direction
+	 * we use as many queue pairs as the device offers, up to
+	 * LWIP_UKNETDEV_QUEUES
 	 */
-	dev_conf.nb_rx_queues = 1;
-	dev_conf.nb_tx_queues = 1;
+	lwip_data->nb_queues = MIN3((uint16_t) CONFIG_LWIP_UKNETDEV_QUEUES,
+				    lwip_data->dev_info.max_rx_queues,
+				    lwip_data->dev_info.max_tx_queues);
+	dev_conf.nb_rx_queues = lwip_data->nb_queues;
+	dev_conf.nb_tx_queues = lwip_data->nb_queues;
 	flexos_gate_r(uknetdev, ret, uk_netdev_configure, dev, &dev_conf);
 	if (ret < 0) {
 		LWIP_DEBUGF(NETIF_DEBUG,
@@ -555,12 +683,40 @@ err_t uknetdev_init(struct netif *nf)
 	}
 
 	/*
-	 * Receive queue,
+	 * Packet buffer pools per queue pair. If a pool cannot be allocated,
+	 * the queue allocates its buffers from `a`.
+	 */
+	for (q = 0; q < lwip_data->nb_queues; ++q) {
+		lwip_data->queue[q].lwip_data = lwip_data;
+#if CONFIG_LWIP_UKNETDEV_POOLBUFS
+		flexos_gate_r(uknetdev, lwip_data->queue[q].rx_pool,
+			      uk_netbuf_pool_alloc, a,
+			      CONFIG_LWIP_UKNETDEV_POOLBUFS, UKNETDEV_BUFLEN,
+			      lwip_data->dev_info.ioalign,
+			      lwip_data->dev_info.nb_encap_rx,
+			      sizeof(struct _netbuf_pbuf), NULL);
+		flexos_gate_r(uknetdev, lwip_data->queue[q].tx_pool,
+			      uk_netbuf_pool_alloc, a,
+			      CONFIG_LWIP_UKNETDEV_POOLBUFS, UKNETDEV_BUFLEN,
+			      lwip_data->dev_info.ioalign,
+			      lwip_data->dev_info.nb_encap_tx,
+			      0, NULL);
+		if (!lwip_data->queue[q].rx_pool
+		    || !lwip_data->queue[q].tx_pool) {
+			LWIP_DEBUGF(NETIF_DEBUG,
+				    ("%s: %c%c%u: Failed to allocate buffer pools for queue %"PRIu16", using the allocator\n",
+				     __func__, nf->name[0], nf->name[1],
+				     nf->num, q));
+		}
+#endif /* CONFIG_LWIP_UKNETDEV_POOLBUFS */
+	}
+
+	/*
+	 * Receive queues,
 	 * use driver default descriptors
 	 */
 	rxq_conf.a = a;
 	rxq_conf.alloc_rxpkts = netif_alloc_rxpkts;
-	rxq_conf.alloc_rxpkts_argp = lwip_data;
 #ifdef CONFIG_LWIP_NOTHREADS
 	/*
 	 * In mainloop mode, we will not use interrupts.
@@ -578,28 +734,39 @@ err_t uknetdev_init(struct netif *nf)
 
 #endif /* CONFIG_LIBUKNETDEV_DISPATCHERTHREADS */
 #endif /* CONFIG_LWIP_NOTHREADS */
-	flexos_gate_r(uknetdev, ret, uk_netdev_rxq_configure, dev, 0, 0, &rxq_conf);
-	if (ret < 0) {
-		LWIP_DEBUGF(NETIF_DEBUG,
-			    ("%s: %c%c%u: Failed to configure rx queue of netdev %u\n",
-			     __func__, nf->name[0], nf->name[1], nf->num,
-			     uk_netdev_id_get(dev)));
-		return ERR_IF;
+	for (q = 0; q < lwip_data->nb_queues; ++q) {
+		rxq_conf.alloc_rxpkts_argp = &lwip_data->queue[q];
+		flexos_gate_r(uknetdev, ret, uk_netdev_rxq_configure, dev, q,
+			      0, &rxq_conf);
+		if (ret < 0) {
+			LWIP_DEBUGF(NETIF_DEBUG,
+				    ("%s: %c%c%u: Failed to configure rx queue %"PRIu16" of netdev %u\n",
+				     __func__, nf->name[0], nf->name[1],
+				     nf->num, q, uk_netdev_id_get(dev)));
+			return ERR_IF;
+		}
 	}
 
 	/*
-	 * Transmit queue,
+	 * Transmit queues,
 	 * use driver default descriptors
 	 */
 	txq_conf.a = a;
-	flexos_gate_r(uknetdev, ret, uk_netdev_txq_configure, dev, 0, 0, &txq_conf);
-	if (ret < 0) {
-		LWIP_DEBUGF(NETIF_DEBUG,
-			    ("%s: %c%c%u: Failed to configure tx queue of netdev %u\n",
-			     __func__, nf->name[0], nf->name[1], nf->num,
-			     uk_netdev_id_get(dev)));
-		return ERR_IF;
+	for (q = 0; q < lwip_data->nb_queues; ++q) {
+		flexos_gate_r(uknetdev, ret, uk_netdev_txq_configure, dev, q,
+			      0, &txq_conf);
+		if (ret < 0) {
+			LWIP_DEBUGF(NETIF_DEBUG,
+				    ("%s: %c%c%u: Failed to configure tx queue %"PRIu16" of netdev %u\n",
+				     __func__, nf->name[0], nf->name[1],
+				     nf->num, q, uk_netdev_id_get(dev)));
+			return ERR_IF;
+		}
 	}
+	LWIP_DEBUGF(NETIF_DEBUG,
+		    ("%s: %c%c%u: Using %"PRIu16" queue pair(s)\n",
+		     __func__, nf->name[0], nf->name[1], nf->num,
+		     lwip_data->nb_queues));
 
 	/* Start interface */
 	flexos_gate_r(uknetdev, ret, uk_netdev_start, dev)
@@ -0,0 +1,76 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __SQLITE3_FLEXOS_H__
+#define __SQLITE3_FLEXOS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The "flexos" VFS sits on top of SQLite's unix VFS and batches what it
+ * forwards to vfscore: contiguous page writes are coalesced into one
+ * pwrite, sequential reads are served from a read-ahead window, the file
+ * size is cached instead of calling fstat, and with
+ * CONFIG_LIBSQLITE_VFS_EXCLUSIVE lock state is only tracked in memory.
+ */
+#define SQLITE3_FLEXOS_VFS_NAME "flexos"
+
+struct sqlite3_flexos_vfs_stats {
+	/* xRead/xWrite/xSync/xTruncate/xFileSize/xLock/xUnlock/
+	 * xCheckReservedLock calls issued by SQLite, i.e., what the unix
+	 * VFS alone would have turned into vfscore calls
+	 */
+	unsigned long long requests;
+	/* Calls that were actually forwarded to the unix VFS */
+	unsigned long long forwarded;
+	/* Write transactions on main database files */
+	unsigned long long transactions;
+};
+
+/*
+ * Registers the VFS as the default one. Called by sqlite3_initialize()
+ * through SQLITE_EXTRA_INIT.
+ */
+int sqlite3_flexos_vfs_init(const char *unused);
+
+/*
+ * Copies the global counters into `stats` and resets them if `reset` is
+ * non-zero.
+ */
+void sqlite3_flexos_vfs_stats(struct sqlite3_flexos_vfs_stats *stats,
+			      int reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SQLITE3_FLEXOS_H__ */
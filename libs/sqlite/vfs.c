@@ -0,0 +1,524 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Every call into the patched unix VFS that touches the file system is a
+ * gate into libvfscore. This VFS wraps it and keeps as much as possible on
+ * the SQLite side of the gate:
+ *
+ *  - writes to contiguous offsets (journal records, runs of dirty pages)
+ *    are collected in a write-behind buffer and forwarded as one write
+ *    when the run breaks, the buffer fills, or on sync/unlock/truncate/
+ *    close;
+ *  - a sequential read fills a read-ahead window with one read;
+ *  - the file size is cached after the first xFileSize and kept up to
+ *    date locally, so fstat is not called again;
+ *  - with CONFIG_LIBSQLITE_VFS_EXCLUSIVE the unix-none VFS is used
+ *    underneath and lock levels are only tracked here, since vfscore does
+ *    not implement advisory locks anyway.
+ *
+ * Without CONFIG_LIBSQLITE_VFS_EXCLUSIVE the cached size and the read-ahead
+ * window are dropped whenever a SHARED lock is (re)acquired, which is where
+ * SQLite itself expects other connections' changes to become visible.
+ */
+
+#include <string.h>
+#include <uk/config.h>
+#include <uk/essentials.h>
+#include <flexos/isolation.h>
+#include "sqlite3.h"
+#include "sqlite3_flexos.h"
+
+#define FLEXOS_VFS_BUFSIZE CONFIG_LIBSQLITE_VFS_BUFSIZE
+
+#if CONFIG_LIBSQLITE_VFS_EXCLUSIVE
+#define FLEXOS_VFS_BASE "unix-none"
+#else
+#define FLEXOS_VFS_BASE "unix"
+#endif
+
+struct flexos_vfs_file {
+	sqlite3_file base;
+	/* File opened by the unix VFS, located right after this struct */
+	sqlite3_file *real;
+	int lock;
+
+	/* Cached file size including pending writes, -1 if unknown */
+	sqlite3_int64 size;
+
+	/* Write-behind run [woff, woff + wlen) */
+	char *wbuf;
+	sqlite3_int64 woff;
+	int wlen;
+
+	/* Read-ahead window [roff, roff + rlen) */
+	char *rbuf;
+	sqlite3_int64 roff;
+	int rlen;
+	/* End offset of the previous read, used to detect sequential scans */
+	sqlite3_int64 rnext;
+};
+
+static sqlite3_vfs flexos_vfs;
+static struct sqlite3_flexos_vfs_stats flexos_vfs_stats;
+
+#define REAL_VFS() ((sqlite3_vfs *) flexos_vfs.pAppData)
+
+static inline int ranges_overlap(sqlite3_int64 a, sqlite3_int64 alen,
+				 sqlite3_int64 b, sqlite3_int64 blen)
+{
+	return a < b + blen && b < a + alen;
+}
+
+static int flexos_vfs_flush(struct flexos_vfs_file *f)
+{
+	int rc;
+
+	if (!f->wlen)
+		return SQLITE_OK;
+
+	flexos_vfs_stats.forwarded++;
+	rc = f->real->pMethods->xWrite(f->real, f->wbuf, f->wlen, f->woff);
+	f->wlen = 0;
+	return rc;
+}
+
+static void flexos_vfs_invalidate(struct flexos_vfs_file *f)
+{
+	f->size = -1;
+	f->rlen = 0;
+	f->rnext = -1;
+}
+
+static int flexos_vfs_close(sqlite3_file *file)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+	int rc, rc2;
+
+	rc = flexos_vfs_flush(f);
+	rc2 = f->real->pMethods->xClose(f->real);
+	if (f->wbuf)
+		flexos_free_whitelist(f->wbuf, libvfscore);
+	if (f->rbuf)
+		flexos_free_whitelist(f->rbuf, libvfscore);
+	return (rc != SQLITE_OK) ? rc : rc2;
+}
+
+static int flexos_vfs_read(sqlite3_file *file, void *buf, int amt,
+			   sqlite3_int64 off)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+	int sequential;
+	int len, rc;
+
+	flexos_vfs_stats.requests++;
+	sequential = (off == f->rnext);
+	f->rnext = off + amt;
+
+	if (f->wlen && ranges_overlap(off, amt, f->woff, f->wlen)) {
+		if (off >= f->woff && off + amt <= f->woff + f->wlen) {
+			memcpy(buf, f->wbuf + (off - f->woff), amt);
+			return SQLITE_OK;
+		}
+		rc = flexos_vfs_flush(f);
+		if (rc != SQLITE_OK)
+			return rc;
+	}
+
+	if (f->rlen && off >= f->roff && off + amt <= f->roff + f->rlen) {
+		memcpy(buf, f->rbuf + (off - f->roff), amt);
+		return SQLITE_OK;
+	}
+
+	/* Read ahead only within the known file size so that the unix VFS
+	 * never has to zero-fill a short read for us.
+	 */
+	if (f->rbuf && sequential && amt < FLEXOS_VFS_BUFSIZE
+	    && f->size >= 0 && off + amt <= f->size) {
+		len = (int) MIN((sqlite3_int64) FLEXOS_VFS_BUFSIZE,
+				f->size - off);
+		if (f->wlen && ranges_overlap(off, len, f->woff, f->wlen)) {
+			rc = flexos_vfs_flush(f);
+			if (rc != SQLITE_OK)
+				return rc;
+		}
+		flexos_vfs_stats.forwarded++;
+		rc = f->real->pMethods->xRead(f->real, f->rbuf, len, off);
+		if (rc == SQLITE_OK) {
+			f->roff = off;
+			f->rlen = len;
+			memcpy(buf, f->rbuf, amt);
+			return SQLITE_OK;
+		}
+		f->rlen = 0;
+		if (rc != SQLITE_IOERR_SHORT_READ)
+			return rc;
+		/* The size changed behind our back, retry uncached */
+		f->size = -1;
+	}
+
+	flexos_vfs_stats.forwarded++;
+	return f->real->pMethods->xRead(f->real, buf, amt, off);
+}
+
+static int flexos_vfs_write(sqlite3_file *file, const void *buf, int amt,
+			    sqlite3_int64 off)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+	int rc;
+
+	flexos_vfs_stats.requests++;
+
+	if (f->rlen && ranges_overlap(off, amt, f->roff, f->rlen))
+		f->rlen = 0;
+
+	if (f->wbuf && amt <= FLEXOS_VFS_BUFSIZE) {
+		/* Extend or overwrite the current run if the write starts
+		 * inside or right after it and still fits
+		 */
+		if (!f->wlen || off < f->woff || off > f->woff + f->wlen
+		    || off + amt > f->woff + FLEXOS_VFS_BUFSIZE) {
+			rc = flexos_vfs_flush(f);
+			if (rc != SQLITE_OK)
+				return rc;
+			f->woff = off;
+		}
+		memcpy(f->wbuf + (off - f->woff), buf, amt);
+		f->wlen = (int) MAX((sqlite3_int64) f->wlen,
+				    off + amt - f->woff);
+		rc = SQLITE_OK;
+	} else {
+		rc = flexos_vfs_flush(f);
+		if (rc != SQLITE_OK)
+			return rc;
+		flexos_vfs_stats.forwarded++;
+		rc = f->real->pMethods->xWrite(f->real, buf, amt, off);
+	}
+
+	if (rc == SQLITE_OK && f->size >= 0 && off + amt > f->size)
+		f->size = off + amt;
+	return rc;
+}
+
+static int flexos_vfs_truncate(sqlite3_file *file, sqlite3_int64 size)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+	int rc;
+
+	flexos_vfs_stats.requests++;
+	rc = flexos_vfs_flush(f);
+	if (rc != SQLITE_OK)
+		return rc;
+
+	flexos_vfs_stats.forwarded++;
+	rc = f->real->pMethods->xTruncate(f->real, size);
+	f->rlen = 0;
+	f->size = (rc == SQLITE_OK) ? size : -1;
+	return rc;
+}
+
+static int flexos_vfs_sync(sqlite3_file *file, int flags)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+	int rc;
+
+	flexos_vfs_stats.requests++;
+	rc = flexos_vfs_flush(f);
+	if (rc != SQLITE_OK)
+		return rc;
+
+	flexos_vfs_stats.forwarded++;
+	return f->real->pMethods->xSync(f->real, flags);
+}
+
+static int flexos_vfs_file_size(sqlite3_file *file, sqlite3_int64 *size)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+	int rc;
+
+	flexos_vfs_stats.requests++;
+	if (f->size < 0) {
+		flexos_vfs_stats.forwarded++;
+		rc = f->real->pMethods->xFileSize(f->real, &f->size);
+		if (rc != SQLITE_OK) {
+			f->size = -1;
+			return rc;
+		}
+		/* Pending writes are not on disk yet */
+		if (f->wlen && f->woff + f->wlen > f->size)
+			f->size = f->woff + f->wlen;
+	}
+
+	*size = f->size;
+	return SQLITE_OK;
+}
+
+static int flexos_vfs_lock(sqlite3_file *file, int lock)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+	int rc = SQLITE_OK;
+
+	flexos_vfs_stats.requests++;
+#if !CONFIG_LIBSQLITE_VFS_EXCLUSIVE
+	flexos_vfs_stats.forwarded++;
+	rc = f->real->pMethods->xLock(f->real, lock);
+	if (rc != SQLITE_OK)
+		return rc;
+	if (f->lock == SQLITE_LOCK_NONE)
+		flexos_vfs_invalidate(f);
+#endif /* !CONFIG_LIBSQLITE_VFS_EXCLUSIVE */
+	if (lock > f->lock)
+		f->lock = lock;
+	return rc;
+}
+
+static int flexos_vfs_unlock(sqlite3_file *file, int lock)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+	int rc;
+
+	flexos_vfs_stats.requests++;
+	/* Other connections must see our writes once we drop the lock */
+	rc = flexos_vfs_flush(f);
+	if (rc != SQLITE_OK)
+		return rc;
+
+	if (f->lock >= SQLITE_LOCK_RESERVED && lock <= SQLITE_LOCK_SHARED)
+		flexos_vfs_stats.transactions++;
+
+#if !CONFIG_LIBSQLITE_VFS_EXCLUSIVE
+	flexos_vfs_stats.forwarded++;
+	rc = f->real->pMethods->xUnlock(f->real, lock);
+#endif /* !CONFIG_LIBSQLITE_VFS_EXCLUSIVE */
+	if (lock < f->lock)
+		f->lock = lock;
+	return rc;
+}
+
+static int flexos_vfs_check_reserved_lock(sqlite3_file *file, int *out)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+
+	flexos_vfs_stats.requests++;
+#if CONFIG_LIBSQLITE_VFS_EXCLUSIVE
+	/* We are the only process, nobody else can hold the lock */
+	(void) f;
+	*out = 0;
+	return SQLITE_OK;
+#else
+	flexos_vfs_stats.forwarded++;
+	return f->real->pMethods->xCheckReservedLock(f->real, out);
+#endif /* CONFIG_LIBSQLITE_VFS_EXCLUSIVE */
+}
+
+static int flexos_vfs_file_control(sqlite3_file *file, int op, void *arg)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+	int rc;
+
+	switch (op) {
+#if CONFIG_LIBSQLITE_VFS_EXCLUSIVE
+	case SQLITE_FCNTL_HAS_MOVED:
+		/* Would stat() the path; nobody else can rename it */
+		*(int *) arg = 0;
+		return SQLITE_OK;
+#endif /* CONFIG_LIBSQLITE_VFS_EXCLUSIVE */
+	case SQLITE_FCNTL_SIZE_HINT:
+	case SQLITE_FCNTL_CHUNK_SIZE:
+		/* The unix VFS may grow the file for these */
+		rc = flexos_vfs_flush(f);
+		if (rc != SQLITE_OK)
+			return rc;
+		rc = f->real->pMethods->xFileControl(f->real, op, arg);
+		f->size = -1;
+		return rc;
+	default:
+		return f->real->pMethods->xFileControl(f->real, op, arg);
+	}
+}
+
+static int flexos_vfs_sector_size(sqlite3_file *file)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+
+	return f->real->pMethods->xSectorSize(f->real);
+}
+
+static int flexos_vfs_device_characteristics(sqlite3_file *file)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+
+	return f->real->pMethods->xDeviceCharacteristics(f->real);
+}
+
+static int flexos_vfs_shm_map(sqlite3_file *file, int pg, int pgsz,
+			      int extend, void volatile **p)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+
+	return f->real->pMethods->xShmMap(f->real, pg, pgsz, extend, p);
+}
+
+static int flexos_vfs_shm_lock(sqlite3_file *file, int offset, int n,
+			       int flags)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+
+	return f->real->pMethods->xShmLock(f->real, offset, n, flags);
+}
+
+static void flexos_vfs_shm_barrier(sqlite3_file *file)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+
+	f->real->pMethods->xShmBarrier(f->real);
+}
+
+static int flexos_vfs_shm_unmap(sqlite3_file *file, int delete)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+
+	return f->real->pMethods->xShmUnmap(f->real, delete);
+}
+
+static int flexos_vfs_fetch(sqlite3_file *file, sqlite3_int64 off, int amt,
+			    void **p)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+	int rc;
+
+	/* The mapping must not miss data that is still buffered */
+	rc = flexos_vfs_flush(f);
+	if (rc != SQLITE_OK)
+		return rc;
+	return f->real->pMethods->xFetch(f->real, off, amt, p);
+}
+
+static int flexos_vfs_unfetch(sqlite3_file *file, sqlite3_int64 off, void *p)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+
+	return f->real->pMethods->xUnfetch(f->real, off, p);
+}
+
+/* The unix-none methods stop at version 1 (no shared memory, no mmap), so
+ * we advertise the same version as the file underneath.
+ */
+#define FLEXOS_VFS_IO(version)						\
+	{								\
+		.iVersion		= version,			\
+		.xClose			= flexos_vfs_close,		\
+		.xRead			= flexos_vfs_read,		\
+		.xWrite			= flexos_vfs_write,		\
+		.xTruncate		= flexos_vfs_truncate,		\
+		.xSync			= flexos_vfs_sync,		\
+		.xFileSize		= flexos_vfs_file_size,		\
+		.xLock			= flexos_vfs_lock,		\
+		.xUnlock		= flexos_vfs_unlock,		\
+		.xCheckReservedLock	= flexos_vfs_check_reserved_lock, \
+		.xFileControl		= flexos_vfs_file_control,	\
+		.xSectorSize		= flexos_vfs_sector_size,	\
+		.xDeviceCharacteristics	= flexos_vfs_device_characteristics, \
+		.xShmMap		= flexos_vfs_shm_map,		\
+		.xShmLock		= flexos_vfs_shm_lock,		\
+		.xShmBarrier		= flexos_vfs_shm_barrier,	\
+		.xShmUnmap		= flexos_vfs_shm_unmap,		\
+		.xFetch			= flexos_vfs_fetch,		\
+		.xUnfetch		= flexos_vfs_unfetch,		\
+	}
+
+static const sqlite3_io_methods flexos_vfs_io[] = {
+	FLEXOS_VFS_IO(1),
+	FLEXOS_VFS_IO(2),
+	FLEXOS_VFS_IO(3),
+};
+
+static int flexos_vfs_open(sqlite3_vfs *vfs, const char *name,
+			   sqlite3_file *file, int flags, int *out_flags)
+{
+	struct flexos_vfs_file *f = (struct flexos_vfs_file *) file;
+	int rc;
+
+	memset(f, 0, sizeof(*f));
+	f->real = (sqlite3_file *) (f + 1);
+	f->lock = SQLITE_LOCK_NONE;
+	flexos_vfs_invalidate(f);
+
+	rc = REAL_VFS()->xOpen(REAL_VFS(), name, f->real, flags, out_flags);
+	if (rc != SQLITE_OK)
+		return rc;
+
+	/* Buffers are handed to pread/pwrite in libvfscore, so they have to
+	 * be shared with it. Without them, everything is just forwarded.
+	 */
+	f->wbuf = flexos_malloc_whitelist(FLEXOS_VFS_BUFSIZE, libvfscore);
+	f->rbuf = flexos_malloc_whitelist(FLEXOS_VFS_BUFSIZE, libvfscore);
+	if (!f->wbuf || !f->rbuf) {
+		if (f->wbuf)
+			flexos_free_whitelist(f->wbuf, libvfscore);
+		if (f->rbuf)
+			flexos_free_whitelist(f->rbuf, libvfscore);
+		f->wbuf = f->rbuf = NULL;
+	}
+
+	f->base.pMethods = &flexos_vfs_io[MIN(MAX(f->real->pMethods->iVersion,
+						  1), 3) - 1];
+	return SQLITE_OK;
+}
+
+void sqlite3_flexos_vfs_stats(struct sqlite3_flexos_vfs_stats *stats,
+			      int reset)
+{
+	*stats = flexos_vfs_stats;
+	if (reset)
+		memset(&flexos_vfs_stats, 0, sizeof(flexos_vfs_stats));
+}
+
+int sqlite3_flexos_vfs_init(const char *unused __unused)
+{
+	sqlite3_vfs *real;
+
+	if (flexos_vfs.pAppData)
+		return SQLITE_OK;
+
+	real = sqlite3_vfs_find(FLEXOS_VFS_BASE);
+	if (!real)
+		return SQLITE_ERROR;
+
+	/* Path handling, randomness, time etc. are taken over unchanged */
+	flexos_vfs = *real;
+	flexos_vfs.pNext = NULL;
+	flexos_vfs.zName = SQLITE3_FLEXOS_VFS_NAME;
+	flexos_vfs.szOsFile = sizeof(struct flexos_vfs_file) + real->szOsFile;
+	flexos_vfs.pAppData = real;
+	flexos_vfs.xOpen = flexos_vfs_open;
+
+	return sqlite3_vfs_register(&flexos_vfs, 1);
+}
@@ -117,6 +117,87 @@ typedef int (*uk_init_func_t)(void);
 #define uk_sys_initcall(fn)       uk_sys_initcall_prio(fn, UK_PRIO_LATEST)
 #define uk_late_initcall(fn)      uk_late_initcall_prio(fn, UK_PRIO_LATEST)
 
+/**
+ * Asynchronous and lazy init functions
+ *
+ * An asynchronous init function is started at (class, prio) of the init
+ * table and must have completed before the entry at (join_class,
+ * join_prio) runs. In between, the rest of the init table continues:
+ * with CONFIG_LIBUKBOOT_INITASYNC the function runs in its own thread,
+ * which makes progress whenever the boot thread blocks or yields (e.g.,
+ * while waiting for a device), otherwise it is simply called in place.
+ * If it returns an error, boot stops at the join point.
+ *
+ * A lazy init function is not started by the boot code at all: it runs
+ * on the first uk_init_wait() call, i.e., when its subsystem is first
+ * used. Any later caller of uk_init_wait() returns its result.
+ */
+#define UK_INIT_ASYNC_PENDING	0
+#define UK_INIT_ASYNC_RUNNING	1
+#define UK_INIT_ASYNC_DONE	2
+#define UK_INIT_ASYNC_JOINED	3
+
+struct uk_init_async {
+	uk_init_func_t fn;
+	const char *name;
+	volatile int state;
+	int ret;
+	/* Time spent in fn, in nanoseconds */
+	__u64 time;
+};
+
+/* Starts `ia` (in a thread with CONFIG_LIBUKBOOT_INITASYNC). Returns 0 or
+ * a negative errno if the thread could not be created.
+ */
+int uk_init_async_start(struct uk_init_async *ia);
+/* Waits for `ia` to complete, running it first if it was never started,
+ * and returns its result.
+ */
+int uk_init_async_wait(struct uk_init_async *ia);
+
+#define UK_INIT_ASYNC(fn)						\
+	__uk_init_async_ ## fn
+
+#define UK_INIT_ASYNC_DECLARE(fn)					\
+	extern struct uk_init_async UK_INIT_ASYNC(fn)
+
+#define UK_INIT_ASYNC_DEFINE(initfn)					\
+	struct uk_init_async UK_INIT_ASYNC(initfn) = {			\
+		.fn = (initfn),						\
+		.name = STRINGIFY(initfn),				\
+		.state = UK_INIT_ASYNC_PENDING,				\
+	}
+
+#define uk_init_wait(fn)						\
+	uk_init_async_wait(&UK_INIT_ASYNC(fn))
+
+#define uk_initcall_async_prio(fn, class, prio, join_class, join_prio)	\
+	UK_CTASSERT((class) < (join_class) ||				\
+		    ((class) == (join_class) && (prio) < (join_prio)));	\
+	UK_INIT_ASYNC_DEFINE(fn);					\
+	static int __uk_init_async_start_ ## fn(void)			\
+	{								\
+		return uk_init_async_start(&UK_INIT_ASYNC(fn));		\
+	}								\
+	static int __uk_init_async_join_ ## fn(void)			\
+	{								\
+		return uk_init_async_wait(&UK_INIT_ASYNC(fn));		\
+	}								\
+	uk_initcall_class_prio(__uk_init_async_start_ ## fn, class, prio); \
+	uk_initcall_class_prio(__uk_init_async_join_ ## fn,		\
+			       join_class, join_prio)
+
+/**
+ * Starts `fn` at the end of `class` and waits for it at the beginning of
+ * `join_class`, so that it overlaps with all classes in between.
+ */
+#define uk_initcall_async(fn, class, join_class)			\
+	uk_initcall_async_prio(fn, class, UK_PRIO_LATEST,		\
+			       join_class, UK_PRIO_EARLIEST)
+
+#define uk_initcall_lazy(fn)						\
+	UK_INIT_ASYNC_DEFINE(fn)
+
 extern const uk_init_func_t uk_inittab_start[];
 extern const uk_init_func_t uk_inittab_end;
 
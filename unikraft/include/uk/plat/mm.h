@@ -349,5 +349,20 @@ int uk_stack_free(void *vaddr);
  */
 int uk_heap_map(unsigned long vaddr, unsigned long len);
 
+/**
+ * Give libraries a chance to resolve a page fault before the platform
+ * crashes, e.g., to implement copy-on-write. The default implementation
+ * resolves nothing; a library overrides it by defining the function.
+ * Called from the page fault handler with the faulting context's extended
+ * registers saved.
+ *
+ * @param vaddr: the faulting virtual address.
+ * @param write: non-zero if the fault was a write to a present page.
+ *
+ * @return: 0 if the mapping was fixed and the access can be retried, -1
+ * otherwise.
+ */
+int uk_page_fault_handle(unsigned long vaddr, int write);
+
 #endif /* __UKPLAT_MM__ */
 
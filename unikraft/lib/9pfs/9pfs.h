@@ -34,10 +34,13 @@
 #define __UK_9PFS__
 
 #include <stdbool.h>
+#include <uk/config.h>
 #include <uk/9pdev.h>
 #include <uk/9pfid.h>
+#include <uk/arch/time.h>
 
 #include <vfscore/prex.h>
+#include <vfscore/vnode.h>
 
 /*
  * Currently supports only the 9P2000.u variant of the protocol.
@@ -58,7 +61,29 @@ struct uk_9pfs_mount_data {
 	const char		*uname;
 	/* File tree to access when offered multiple exported filesystems. */
 	const char		*aname;
+#if CONFIG_LIB9PFS_CACHE
+	/*
+	 * How long cached attributes and failed lookups stay valid, 0 keeps
+	 * them until a local change invalidates them ("cache=loose").
+	 */
+	__nsec			cache_ttl;
+	/* Failed lookups, UK_9PFS_NEGCACHE_SIZE entries. */
+	struct uk_9pfs_negent	*negcache;
+#endif
+};
+
+#if CONFIG_LIB9PFS_CACHE
+/* Names longer than this are not cached. */
+#define UK_9PFS_NEGCACHE_NAMELEN	56
+#define UK_9PFS_NEGCACHE_SIZE		64
+
+struct uk_9pfs_negent {
+	/* Inode number of the directory, 0 if the entry is free. */
+	uint64_t		dir;
+	__nsec			expire;
+	char			name[UK_9PFS_NEGCACHE_NAMELEN];
 };
+#endif
 
 struct uk_9pfs_file_data {
 	/* Fid associated with the 9pfs file. */
@@ -84,11 +109,109 @@ struct uk_9pfs_node_data {
 	int                    nb_open_files;
 	/* Is a 9P remove call required when nb_open_files reaches 0? */
 	bool                   removed;
+	/* Fid opened for writing, created on the first write. */
+	struct uk_9pfid        *wfid;
+	/* Read-ahead window, holds file data [ra_off, ra_off + ra_len). */
+	char                   *ra_buf;
+	uint64_t               ra_off;
+	uint32_t               ra_len;
+	/* Where a sequential read would continue. */
+	uint64_t               ra_next;
+#if CONFIG_LIB9PFS_CACHE
+	/* The window is dropped at the same TTL as the attributes. */
+	__nsec                 ra_expire;
+#endif
+	/* Write-back buffer, holds data for [wb_off, wb_off + wb_len). */
+	char                   *wb_buf;
+	uint64_t               wb_off;
+	uint32_t               wb_len;
+#if CONFIG_LIB9PFS_CACHE
+	/* Are the attributes of the last Tstat still usable? */
+	bool                   attr_valid;
+	__nsec                 attr_expire;
+	struct vattr           attr;
+#endif
 };
 
+/* Forgets the read-ahead window because the file may have changed. */
+static inline void uk_9pfs_ra_drop(struct uk_9pfs_node_data *nd)
+{
+	nd->ra_len = 0;
+	nd->ra_next = 0;
+}
+
 int uk_9pfs_allocate_vnode_data(struct vnode *vp, struct uk_9pfid *fid);
 void uk_9pfs_free_vnode_data(struct vnode *vp);
 
+#if CONFIG_LIB9PFS_CACHE
+int uk_9pfs_cache_init(struct uk_9pfs_mount_data *md);
+void uk_9pfs_cache_fini(struct uk_9pfs_mount_data *md);
+
+/* Returns 0 and fills `attr` if the vnode has valid cached attributes. */
+int uk_9pfs_attr_get(struct vnode *vp, struct vattr *attr);
+void uk_9pfs_attr_set(struct vnode *vp, struct vattr *attr);
+void uk_9pfs_attr_invalidate(struct vnode *vp);
+
+/* Starts the TTL of a freshly read read-ahead window. */
+void uk_9pfs_ra_stamp(struct vnode *vp);
+/* Returns false once the read-ahead window of `vp` is too old to use. */
+bool uk_9pfs_ra_valid(struct vnode *vp);
+
+/* Returns true if `name` is known not to exist in `dvp`. */
+bool uk_9pfs_neg_lookup(struct vnode *dvp, const char *name);
+void uk_9pfs_neg_add(struct vnode *dvp, const char *name);
+void uk_9pfs_neg_remove(struct vnode *dvp, const char *name);
+#else
+static inline int uk_9pfs_cache_init(struct uk_9pfs_mount_data *md __unused)
+{
+	return 0;
+}
+
+static inline void uk_9pfs_cache_fini(struct uk_9pfs_mount_data *md __unused)
+{
+}
+
+static inline int uk_9pfs_attr_get(struct vnode *vp __unused,
+		struct vattr *attr __unused)
+{
+	return -1;
+}
+
+static inline void uk_9pfs_attr_set(struct vnode *vp __unused,
+		struct vattr *attr __unused)
+{
+}
+
+static inline void uk_9pfs_attr_invalidate(struct vnode *vp __unused)
+{
+}
+
+static inline void uk_9pfs_ra_stamp(struct vnode *vp __unused)
+{
+}
+
+static inline bool uk_9pfs_ra_valid(struct vnode *vp __unused)
+{
+	return true;
+}
+
+static inline bool uk_9pfs_neg_lookup(struct vnode *dvp __unused,
+		const char *name __unused)
+{
+	return false;
+}
+
+static inline void uk_9pfs_neg_add(struct vnode *dvp __unused,
+		const char *name __unused)
+{
+}
+
+static inline void uk_9pfs_neg_remove(struct vnode *dvp __unused,
+		const char *name __unused)
+{
+}
+#endif /* CONFIG_LIB9PFS_CACHE */
+
 /* Default readdir buffer size. */
 #define UK_9PFS_READDIR_BUFSZ	8192
 
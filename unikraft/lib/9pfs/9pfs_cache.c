@@ -0,0 +1,179 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Metadata cache: attributes returned by Tstat are kept in the node data,
+ * and names that failed to walk are kept per mount, so that repeated stat()
+ * calls and lookups of missing files (e.g., a database's journal) do not
+ * cost a round trip to the host each time. Entries expire after the mount's
+ * cache_ttl, or only on local changes if it is 0. Changes made on the host
+ * are seen once the entries expire.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <uk/config.h>
+#include <uk/plat/time.h>
+#include <vfscore/mount.h>
+#include <vfscore/vnode.h>
+
+#include "9pfs.h"
+
+int uk_9pfs_cache_init(struct uk_9pfs_mount_data *md)
+{
+	md->cache_ttl = ukarch_time_msec_to_nsec(CONFIG_LIB9PFS_CACHE_TTL);
+	md->negcache = calloc(UK_9PFS_NEGCACHE_SIZE, sizeof(*md->negcache));
+	if (!md->negcache)
+		return ENOMEM;
+
+	return 0;
+}
+
+void uk_9pfs_cache_fini(struct uk_9pfs_mount_data *md)
+{
+	free(md->negcache);
+	md->negcache = NULL;
+}
+
+static __nsec uk_9pfs_cache_expire(struct uk_9pfs_mount_data *md)
+{
+	if (!md->cache_ttl)
+		return 0;
+	return ukplat_monotonic_clock() + md->cache_ttl;
+}
+
+static bool uk_9pfs_cache_valid(struct uk_9pfs_mount_data *md, __nsec expire)
+{
+	return !md->cache_ttl || ukplat_monotonic_clock() < expire;
+}
+
+int uk_9pfs_attr_get(struct vnode *vp, struct vattr *attr)
+{
+	struct uk_9pfs_node_data *nd = UK_9PFS_ND(vp);
+
+	if (!nd || !nd->attr_valid)
+		return -1;
+
+	if (!uk_9pfs_cache_valid(UK_9PFS_MD(vp->v_mount), nd->attr_expire)) {
+		nd->attr_valid = false;
+		uk_9pfs_ra_drop(nd);
+		return -1;
+	}
+
+	*attr = nd->attr;
+	return 0;
+}
+
+void uk_9pfs_attr_set(struct vnode *vp, struct vattr *attr)
+{
+	struct uk_9pfs_node_data *nd = UK_9PFS_ND(vp);
+
+	if (!nd)
+		return;
+
+	nd->attr = *attr;
+	nd->attr_expire = uk_9pfs_cache_expire(UK_9PFS_MD(vp->v_mount));
+	nd->attr_valid = true;
+}
+
+void uk_9pfs_attr_invalidate(struct vnode *vp)
+{
+	struct uk_9pfs_node_data *nd = UK_9PFS_ND(vp);
+
+	if (nd)
+		nd->attr_valid = false;
+}
+
+void uk_9pfs_ra_stamp(struct vnode *vp)
+{
+	UK_9PFS_ND(vp)->ra_expire =
+		uk_9pfs_cache_expire(UK_9PFS_MD(vp->v_mount));
+}
+
+bool uk_9pfs_ra_valid(struct vnode *vp)
+{
+	return uk_9pfs_cache_valid(UK_9PFS_MD(vp->v_mount),
+				   UK_9PFS_ND(vp)->ra_expire);
+}
+
+static struct uk_9pfs_negent *uk_9pfs_neg_slot(struct vnode *dvp,
+		const char *name)
+{
+	struct uk_9pfs_mount_data *md = UK_9PFS_MD(dvp->v_mount);
+	uint64_t hash = 0xcbf29ce484222325ULL ^ dvp->v_ino;
+
+	/* FNV-1a */
+	for (; *name; name++)
+		hash = (hash ^ (unsigned char) *name) * 0x100000001b3ULL;
+
+	return &md->negcache[hash % UK_9PFS_NEGCACHE_SIZE];
+}
+
+/* Directory inode numbers may be 0 (e.g., the root), so store them + 1 */
+static inline uint64_t uk_9pfs_neg_key(struct vnode *dvp)
+{
+	return dvp->v_ino + 1;
+}
+
+bool uk_9pfs_neg_lookup(struct vnode *dvp, const char *name)
+{
+	struct uk_9pfs_negent *ne = uk_9pfs_neg_slot(dvp, name);
+
+	if (ne->dir != uk_9pfs_neg_key(dvp) || strcmp(ne->name, name))
+		return false;
+
+	if (!uk_9pfs_cache_valid(UK_9PFS_MD(dvp->v_mount), ne->expire)) {
+		ne->dir = 0;
+		return false;
+	}
+
+	return true;
+}
+
+void uk_9pfs_neg_add(struct vnode *dvp, const char *name)
+{
+	struct uk_9pfs_negent *ne;
+
+	if (strlen(name) >= UK_9PFS_NEGCACHE_NAMELEN)
+		return;
+
+	ne = uk_9pfs_neg_slot(dvp, name);
+	ne->dir = uk_9pfs_neg_key(dvp);
+	ne->expire = uk_9pfs_cache_expire(UK_9PFS_MD(dvp->v_mount));
+	strcpy(ne->name, name);
+}
+
+void uk_9pfs_neg_remove(struct vnode *dvp, const char *name)
+{
+	struct uk_9pfs_negent *ne = uk_9pfs_neg_slot(dvp, name);
+
+	if (ne->dir == uk_9pfs_neg_key(dvp) && !strcmp(ne->name, name))
+		ne->dir = 0;
+}
@@ -112,13 +112,17 @@ static int uk_9pfs_mount(struct mount *mp, const char *dev,
 	if (rc)
 		goto out_free_mdata;
 
+	rc = uk_9pfs_cache_init(md);
+	if (rc)
+		goto out_free_mdata;
+
 	mp->m_data = md;
 
 	/* Establish connection with the given 9P endpoint. */
 	md->dev = uk_9pdev_connect(md->trans, dev, data, NULL);
 	if (PTRISERR(md->dev)) {
 		rc = -PTR2ERR(md->dev);
-		goto out_free_mdata;
+		goto out_free_cache;
 	}
 
 	/* Create a new 9pfs session via a VERSION message. */
@@ -158,6 +162,8 @@ static int uk_9pfs_mount(struct mount *mp, const char *dev,
 
 out_disconnect:
 	uk_9pdev_disconnect(md->dev);
+out_free_cache:
+	uk_9pfs_cache_fini(md);
 out_free_mdata:
 	free(md);
 	return rc;
@@ -180,6 +186,7 @@ static int uk_9pfs_unmount(struct mount *mp, int flags __unused)
 	uk_9pfs_release_tree_fids(mp->m_root);
 	vfscore_release_mp_dentries(mp);
 	uk_9pdev_disconnect(md->dev);
+	uk_9pfs_cache_fini(md);
 	free(md);
 
 	return 0;
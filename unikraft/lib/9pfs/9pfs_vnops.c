@@ -124,6 +124,173 @@ static uint64_t uk_9pfs_ino(struct uk_9p_stat *stat)
 	return stat->qid.path;
 }
 
+static void uk_9pfs_vattr_from_stat(struct vnode *vp, struct uk_9p_stat *stat,
+		struct vattr *attr)
+{
+	attr->va_type = uk_9pfs_vtype_from_mode(stat->mode);
+	attr->va_mode = uk_9pfs_posix_mode_from_mode(stat->mode);
+	attr->va_nodeid = vp->v_ino;
+	attr->va_size = stat->length;
+
+	attr->va_atime.tv_sec = stat->atime;
+	attr->va_atime.tv_nsec = 0;
+	attr->va_mtime.tv_sec = stat->mtime;
+	attr->va_mtime.tv_nsec = 0;
+	attr->va_ctime.tv_sec = 0;
+	attr->va_ctime.tv_nsec = 0;
+}
+
+static int uk_9pfs_uio_skip(void *dst __unused, void *src __unused,
+		size_t *cnt __unused)
+{
+	return 0;
+}
+
+/*
+ * Reads or writes `len` bytes at `offset` scattered over `iov`. Requests
+ * are split at the message size and up to CONFIG_LIB9PFS_INFLIGHT of them
+ * are in flight at once. Returns the number of bytes transferred, which is
+ * less than `len` at the end of the file, or a negative error if nothing
+ * was transferred.
+ */
+static int64_t uk_9pfs_xfer(struct uk_9pdev *dev, struct uk_9pfid *fid,
+		bool write, uint64_t offset, const struct iovec *iov,
+		size_t len)
+{
+	struct uk_9preq *reqs[CONFIG_LIB9PFS_INFLIGHT];
+	uint32_t counts[CONFIG_LIB9PFS_INFLIGHT];
+	int head = 0, inflight = 0, slot;
+	size_t issued = 0, done = 0, iov_off = 0;
+	bool stop = false;
+	int64_t rc, err = 0;
+	uint32_t chunk, count;
+	char *buf;
+
+	chunk = dev->msize - 23;
+	if (fid->iounit != 0)
+		chunk = MIN(chunk, fid->iounit);
+
+	for (;;) {
+		while (!stop && issued < len
+		       && inflight < CONFIG_LIB9PFS_INFLIGHT) {
+			while (iov_off == iov->iov_len) {
+				iov++;
+				iov_off = 0;
+			}
+
+			count = MIN3((size_t) chunk, iov->iov_len - iov_off,
+				     len - issued);
+			buf = (char *) iov->iov_base + iov_off;
+			slot = (head + inflight) % CONFIG_LIB9PFS_INFLIGHT;
+			if (write)
+				reqs[slot] = uk_9p_write_send(dev, fid,
+						offset + issued, count, buf);
+			else
+				reqs[slot] = uk_9p_read_send(dev, fid,
+						offset + issued, count, buf);
+			if (PTRISERR(reqs[slot])) {
+				err = PTR2ERR(reqs[slot]);
+				stop = true;
+				break;
+			}
+
+			counts[slot] = count;
+			inflight++;
+			issued += count;
+			iov_off += count;
+		}
+
+		if (!inflight)
+			break;
+
+		/* Replies are consumed in order, so done stays contiguous. */
+		if (write)
+			rc = uk_9p_write_wait(dev, reqs[head]);
+		else
+			rc = uk_9p_read_wait(dev, reqs[head]);
+		count = counts[head];
+		head = (head + 1) % CONFIG_LIB9PFS_INFLIGHT;
+		inflight--;
+
+		if (stop)
+			continue;
+		if (rc < 0) {
+			err = rc;
+			stop = true;
+			continue;
+		}
+
+		done += rc;
+		/* End of file, or the server took less than it was given. */
+		if ((uint32_t) rc < count)
+			stop = true;
+	}
+
+	return done ? (int64_t) done : err;
+}
+
+static int64_t uk_9pfs_xfer_buf(struct uk_9pdev *dev, struct uk_9pfid *fid,
+		bool write, uint64_t offset, char *buf, size_t len)
+{
+	struct iovec iov = {
+		.iov_base = buf,
+		.iov_len = len,
+	};
+
+	return uk_9pfs_xfer(dev, fid, write, offset, &iov, len);
+}
+
+static struct uk_9pfid *uk_9pfs_wfid(struct vnode *vp)
+{
+	struct uk_9pdev *dev = UK_9PFS_MD(vp->v_mount)->dev;
+	struct uk_9pfs_node_data *nd = UK_9PFS_ND(vp);
+	struct uk_9pfid *fid;
+	int rc;
+
+	if (nd->wfid)
+		return nd->wfid;
+
+	/* Clone vnode fid. */
+	fid = uk_9p_walk(dev, nd->fid, NULL);
+	if (PTRISERR(fid))
+		return fid;
+
+	rc = uk_9p_open(dev, fid, UK_9P_OWRITE);
+	if (rc) {
+		uk_9pfid_put(fid);
+		return ERR2PTR(rc);
+	}
+
+	nd->wfid = fid;
+	return fid;
+}
+
+/* Sends the data collected in the write-back buffer. */
+static int uk_9pfs_wb_flush(struct vnode *vp)
+{
+	struct uk_9pdev *dev = UK_9PFS_MD(vp->v_mount)->dev;
+	struct uk_9pfs_node_data *nd = UK_9PFS_ND(vp);
+	struct uk_9pfid *fid;
+	int64_t rc;
+
+	if (!nd->wb_len)
+		return 0;
+
+	fid = uk_9pfs_wfid(vp);
+	if (PTRISERR(fid))
+		return -PTR2ERR(fid);
+
+	rc = uk_9pfs_xfer_buf(dev, fid, true, nd->wb_off, nd->wb_buf,
+			nd->wb_len);
+	if (rc < 0)
+		return -rc;
+	if ((uint32_t) rc < nd->wb_len)
+		return EIO;
+
+	nd->wb_len = 0;
+	return 0;
+}
+
 int uk_9pfs_allocate_vnode_data(struct vnode *vp, struct uk_9pfid *fid)
 {
 	struct uk_9pfs_node_data *nd;
@@ -135,6 +302,15 @@ int uk_9pfs_allocate_vnode_data(struct vnode *vp, struct uk_9pfid *fid)
 	nd->fid = fid;
 	nd->nb_open_files = 0;
 	nd->removed = false;
+	nd->wfid = NULL;
+	nd->ra_buf = NULL;
+	nd->ra_len = 0;
+	nd->ra_next = 0;
+	nd->wb_buf = NULL;
+	nd->wb_len = 0;
+#if CONFIG_LIB9PFS_CACHE
+	nd->attr_valid = false;
+#endif
 	vp->v_data = nd;
 
 	return 0;
@@ -150,7 +326,14 @@ void uk_9pfs_free_vnode_data(struct vnode *vp)
 
 	if (nd->removed)
 		uk_9p_remove(dev, nd->fid);
-
+	else if (uk_9pfs_wb_flush(vp))
+		uk_pr_err("9pfs: lost buffered writes to inode %lu\n",
+			  (unsigned long) vp->v_ino);
+
+	if (nd->wfid)
+		uk_9pfid_put(nd->wfid);
+	free(nd->ra_buf);
+	free(nd->wb_buf);
 	uk_9pfid_put(nd->fid);
 	free(nd);
 	vp->v_data = NULL;
@@ -186,6 +369,8 @@ static int uk_9pfs_open(struct vfscore_file *file)
 	fd->fid = openedfid;
 	file->f_data = fd;
  	UK_9PFS_ND(file->f_dentry->d_vnode)->nb_open_files++;
+	/* Opening a file is where changes on the host have to show up. */
+	uk_9pfs_ra_drop(UK_9PFS_ND(file->f_dentry->d_vnode));
 
 	return 0;
 
@@ -196,9 +381,13 @@ out:
 	return -rc;
 }
 
-static int uk_9pfs_close(struct vnode *vn __unused, struct vfscore_file *file)
+static int uk_9pfs_close(struct vnode *vn, struct vfscore_file *file)
 {
 	struct uk_9pfs_file_data *fd = UK_9PFS_FD(file);
+	int rc;
+
+	/* Other clients of the share see the data once the file is closed. */
+	rc = uk_9pfs_wb_flush(vn);
 
 	if (fd->readdir_buf)
 		free(fd->readdir_buf);
@@ -207,7 +396,7 @@ static int uk_9pfs_close(struct vnode *vn __unused, struct vfscore_file *file)
 	free(fd);
 	UK_9PFS_ND(file->f_dentry->d_vnode)->nb_open_files--;
 
-	return 0;
+	return rc;
 }
 
 static int uk_9pfs_lookup(struct vnode *dvp, char *name, struct vnode **vpp)
@@ -217,15 +406,21 @@ static int uk_9pfs_lookup(struct vnode *dvp, char *name, struct vnode **vpp)
 	struct uk_9pfid *fid;
 	struct uk_9p_stat stat;
 	struct uk_9preq *stat_req;
+	struct vattr attr;
 	struct vnode *vp;
 	int rc;
 
 	if (strlen(name) > NAME_MAX)
 		return ENAMETOOLONG;
 
+	if (uk_9pfs_neg_lookup(dvp, name))
+		return ENOENT;
+
 	fid = uk_9p_walk(dev, dfid, name);
 	if (PTRISERR(fid)) {
 		rc = PTR2ERR(fid);
+		if (rc == -ENOENT)
+			uk_9pfs_neg_add(dvp, name);
 		goto out;
 	}
 
@@ -243,8 +438,12 @@ static int uk_9pfs_lookup(struct vnode *dvp, char *name, struct vnode **vpp)
 		rc = 0;
 		*vpp = vp;
 		/* if the vnode already has node data, it may be reused. */
-		if (vp->v_data)
+		if (vp->v_data) {
+			uk_9pfs_vattr_from_stat(vp, &stat, &attr);
+			uk_9pfs_attr_set(vp, &attr);
+			uk_9pfs_ra_drop(UK_9PFS_ND(vp));
 			goto out_fid;
+		}
 	}
 
 	if (!vp) {
@@ -261,6 +460,10 @@ static int uk_9pfs_lookup(struct vnode *dvp, char *name, struct vnode **vpp)
 	if (rc != 0)
 		goto out_fid;
 
+	/* The stat above also answers the stat() that usually follows. */
+	uk_9pfs_vattr_from_stat(vp, &stat, &attr);
+	uk_9pfs_attr_set(vp, &attr);
+
 	*vpp = vp;
 
 	return 0;
@@ -293,6 +496,10 @@ static int uk_9pfs_create_generic(struct vnode *dvp, char *name, mode_t mode)
 
 	rc = uk_9p_create(dev, fid, name, uk_9pfs_perm_from_posix_mode(mode),
 			UK_9P_OTRUNC | UK_9P_OWRITE, NULL);
+	if (!rc) {
+		uk_9pfs_neg_remove(dvp, name);
+		uk_9pfs_attr_invalidate(dvp);
+	}
 
 	uk_9pfid_put(fid);
 	return -rc;
@@ -314,17 +521,24 @@ static int uk_9pfs_remove_generic(struct vnode *dvp, struct vnode *vp)
 	return -uk_9p_remove(dev, nd->fid);
 }
 
-static int uk_9pfs_remove(struct vnode *dvp, struct vnode *vp,
-		char *name __unused)
+static int uk_9pfs_remove(struct vnode *dvp, struct vnode *vp, char *name)
 {
 	struct uk_9pfs_node_data *nd = UK_9PFS_ND(vp);
 	int rc = 0;
 
+	/* Buffered writes to a removed file do not matter anymore. */
+	nd->wb_len = 0;
+
 	if (!nd->nb_open_files)
 		rc = uk_9pfs_remove_generic(dvp, vp);
 	else
 		nd->removed = true;
 
+	if (!rc) {
+		uk_9pfs_neg_add(dvp, name);
+		uk_9pfs_attr_invalidate(dvp);
+	}
+
 	return rc;
 }
 
@@ -336,10 +550,17 @@ static int uk_9pfs_mkdir(struct vnode *dvp, char *name, mode_t mode)
 	return uk_9pfs_create_generic(dvp, name, mode);
 }
 
-static int uk_9pfs_rmdir(struct vnode *dvp, struct vnode *vp,
-		char *name __unused)
+static int uk_9pfs_rmdir(struct vnode *dvp, struct vnode *vp, char *name)
 {
-	return uk_9pfs_remove_generic(dvp, vp);
+	int rc;
+
+	rc = uk_9pfs_remove_generic(dvp, vp);
+	if (!rc) {
+		uk_9pfs_neg_add(dvp, name);
+		uk_9pfs_attr_invalidate(dvp);
+	}
+
+	return rc;
 }
 
 static int uk_9pfs_readdir(struct vnode *vp, struct vfscore_file *fp,
@@ -430,9 +651,11 @@ static int uk_9pfs_read(struct vnode *vp, struct vfscore_file *fp,
 			struct uio *uio, int ioflag __unused)
 {
 	struct uk_9pdev *dev = UK_9PFS_MD(vp->v_mount)->dev;
+	struct uk_9pfs_node_data *nd = UK_9PFS_ND(vp);
 	struct uk_9pfid *fid = UK_9PFS_FD(fp)->fid;
-	struct iovec *iov;
-	int rc;
+	uint64_t off;
+	int64_t rc;
+	size_t len;
 
 	if (vp->v_type == VDIR)
 		return EISDIR;
@@ -446,31 +669,68 @@ static int uk_9pfs_read(struct vnode *vp, struct vfscore_file *fp,
 	if (!uio->uio_resid)
 		return 0;
 
-	iov = uio->uio_iov;
-	while (!iov->iov_len) {
-		uio->uio_iov++;
-		uio->uio_iovcnt--;
-	}
+	/* The server has to see buffered writes before we read. */
+	rc = uk_9pfs_wb_flush(vp);
+	if (rc)
+		return rc;
 
-	rc = uk_9p_read(dev, fid, uio->uio_offset,
-			   iov->iov_len, iov->iov_base);
-	if (rc < 0)
-		return -rc;
+	if (nd->ra_len && !uk_9pfs_ra_valid(vp))
+		uk_9pfs_ra_drop(nd);
 
-	iov->iov_base = (char *)iov->iov_base + rc;
-	iov->iov_len -= rc;
-	uio->uio_resid -= rc;
-	uio->uio_offset += rc;
+	while (uio->uio_resid && uio->uio_offset < (off_t) vp->v_size) {
+		off = uio->uio_offset;
+		len = MIN((size_t) uio->uio_resid, vp->v_size - off);
 
-	return 0;
+		if (nd->ra_len && off >= nd->ra_off
+		    && off < nd->ra_off + nd->ra_len) {
+			len = MIN(len, nd->ra_off + nd->ra_len - off);
+			vfscore_uiomove(nd->ra_buf + (off - nd->ra_off), len,
+					uio);
+			continue;
+		}
+
+		/*
+		 * Small sequential reads fetch a whole window, everything
+		 * else goes straight into the caller's buffers.
+		 */
+		if (CONFIG_LIB9PFS_READAHEAD && len < CONFIG_LIB9PFS_READAHEAD
+		    && off == nd->ra_next) {
+			if (!nd->ra_buf) {
+				nd->ra_buf = malloc(CONFIG_LIB9PFS_READAHEAD);
+				if (!nd->ra_buf)
+					return ENOMEM;
+			}
+
+			nd->ra_len = 0;
+			rc = uk_9pfs_xfer_buf(dev, fid, false, off, nd->ra_buf,
+					CONFIG_LIB9PFS_READAHEAD);
+			if (rc <= 0)
+				break;
+			nd->ra_off = off;
+			nd->ra_len = rc;
+			uk_9pfs_ra_stamp(vp);
+			continue;
+		}
+
+		rc = uk_9pfs_xfer(dev, fid, false, off, uio->uio_iov, len);
+		if (rc <= 0)
+			break;
+		vfscore_uioforeach(uk_9pfs_uio_skip, NULL, rc, uio);
+		if ((size_t) rc < len)
+			break;
+	}
+
+	nd->ra_next = uio->uio_offset;
+	return rc < 0 ? -rc : 0;
 }
 
 static int uk_9pfs_write(struct vnode *vp, struct uio *uio, int ioflag)
 {
 	struct uk_9pdev *dev = UK_9PFS_MD(vp->v_mount)->dev;
+	struct uk_9pfs_node_data *nd = UK_9PFS_ND(vp);
 	struct uk_9pfid *fid;
-	struct iovec *iov;
-	int rc;
+	size_t len;
+	int64_t rc;
 
 	if (vp->v_type == VDIR)
 		return EISDIR;
@@ -486,39 +746,55 @@ static int uk_9pfs_write(struct vnode *vp, struct uio *uio, int ioflag)
 	if (ioflag & IO_APPEND)
 		uio->uio_offset = vp->v_size;
 
-	/* Clone vnode fid. */
-	fid = uk_9p_walk(dev, UK_9PFS_VFID(vp), NULL);
-	if (PTRISERR(fid))
-		return -PTR2ERR(fid);
+	len = uio->uio_resid;
+
+	/* Drop read-ahead data this write makes stale. */
+	if (nd->ra_len && (uint64_t) uio->uio_offset < nd->ra_off + nd->ra_len
+	    && (uint64_t) uio->uio_offset + len > nd->ra_off)
+		nd->ra_len = 0;
+
+	/* Small writes that continue the buffered ones are collected. */
+	if (CONFIG_LIB9PFS_WRITEBACK && len < CONFIG_LIB9PFS_WRITEBACK) {
+		if (nd->wb_len && ((uint64_t) uio->uio_offset
+				   != nd->wb_off + nd->wb_len
+				   || nd->wb_len + len
+				   > CONFIG_LIB9PFS_WRITEBACK)) {
+			rc = uk_9pfs_wb_flush(vp);
+			if (rc)
+				return rc;
+		}
 
-	rc = uk_9p_open(dev, fid, UK_9P_OWRITE);
-	if (rc < 0)
-		goto out;
+		if (!nd->wb_buf) {
+			nd->wb_buf = malloc(CONFIG_LIB9PFS_WRITEBACK);
+			if (!nd->wb_buf)
+				return ENOMEM;
+		}
 
-	if (!uio->uio_resid)
-		return 0;
+		if (!nd->wb_len)
+			nd->wb_off = uio->uio_offset;
+		vfscore_uiomove(nd->wb_buf + nd->wb_len, len, uio);
+		nd->wb_len += len;
+		rc = 0;
 
-	iov = uio->uio_iov;
-	while (!iov->iov_len) {
-		uio->uio_iov++;
-		uio->uio_iovcnt--;
+		if (ioflag & IO_SYNC)
+			rc = uk_9pfs_wb_flush(vp);
+	} else {
+		rc = uk_9pfs_wb_flush(vp);
+		if (rc)
+			return rc;
+
+		fid = uk_9pfs_wfid(vp);
+		if (PTRISERR(fid))
+			return -PTR2ERR(fid);
+
+		rc = uk_9pfs_xfer(dev, fid, true, uio->uio_offset,
+				uio->uio_iov, len);
+		if (rc < 0)
+			return -rc;
+		vfscore_uioforeach(uk_9pfs_uio_skip, NULL, rc, uio);
+		rc = 0;
 	}
 
-	rc = uk_9p_write(dev, fid, uio->uio_offset,
-			    iov->iov_len, iov->iov_base);
-	if (rc < 0)
-		return -rc;
-
-	iov->iov_base = (char *)iov->iov_base + rc;
-	iov->iov_len -= rc;
-	uio->uio_resid -= rc;
-	uio->uio_offset += rc;
-
-	if (rc < 0)
-		goto out;
-
-	rc = 0;
-
 	/*
 	 * If the uio offset after completion of the write requests is bigger
 	 * than the vnode's associated size, then the size must be updated
@@ -526,10 +802,14 @@ static int uk_9pfs_write(struct vnode *vp, struct uio *uio, int ioflag)
 	 */
 	if (uio->uio_offset > vp->v_size)
 		vp->v_size = uio->uio_offset;
+	uk_9pfs_attr_invalidate(vp);
 
-out:
-	uk_9pfid_put(fid);
-	return -rc;
+	return rc;
+}
+
+static int uk_9pfs_fsync(struct vnode *vp, struct vfscore_file *fp __unused)
+{
+	return uk_9pfs_wb_flush(vp);
 }
 
 static int uk_9pfs_getattr(struct vnode *vp, struct vattr *attr)
@@ -540,6 +820,14 @@ static int uk_9pfs_getattr(struct vnode *vp, struct vattr *attr)
 	struct uk_9preq *stat_req;
 	int rc = 0;
 
+	if (!uk_9pfs_attr_get(vp, attr))
+		return 0;
+
+	/* The size the server reports has to include buffered writes. */
+	rc = uk_9pfs_wb_flush(vp);
+	if (rc)
+		return rc;
+
 	stat_req = uk_9p_stat(dev, fid, &stat);
 	if (PTRISERR(stat_req)) {
 		rc = PTR2ERR(stat_req);
@@ -549,27 +837,35 @@ static int uk_9pfs_getattr(struct vnode *vp, struct vattr *attr)
 	/* No stat string fields are used below. */
 	uk_9pdev_req_remove(dev, stat_req);
 
-	attr->va_type = uk_9pfs_vtype_from_mode(stat.mode);
-	attr->va_mode = uk_9pfs_posix_mode_from_mode(stat.mode);
-	attr->va_nodeid = vp->v_ino;
-	attr->va_size = stat.length;
-
-	attr->va_atime.tv_sec = stat.atime;
-	attr->va_atime.tv_nsec = 0;
-	attr->va_mtime.tv_sec = stat.mtime;
-	attr->va_mtime.tv_nsec = 0;
-	attr->va_ctime.tv_sec = 0;
-	attr->va_ctime.tv_nsec = 0;
+	uk_9pfs_vattr_from_stat(vp, &stat, attr);
+	uk_9pfs_attr_set(vp, attr);
+	uk_9pfs_ra_drop(UK_9PFS_ND(vp));
 
 out:
 	return -rc;
 }
 
+/*
+ * Attributes and sizes are not sent to the host, but buffered file data
+ * must not outlive a local change of them, e.g. reads of a truncated and
+ * regrown range have to return zeros.
+ */
+static int uk_9pfs_setattr(struct vnode *vp, struct vattr *attr __unused)
+{
+	uk_9pfs_ra_drop(UK_9PFS_ND(vp));
+	uk_9pfs_attr_invalidate(vp);
+	return 0;
+}
+
+static int uk_9pfs_truncate(struct vnode *vp, off_t length __unused)
+{
+	uk_9pfs_ra_drop(UK_9PFS_ND(vp));
+	uk_9pfs_attr_invalidate(vp);
+	return 0;
+}
+
 #define uk_9pfs_seek		((vnop_seek_t)vfscore_vop_nullop)
 #define uk_9pfs_ioctl		((vnop_ioctl_t)vfscore_vop_einval)
-#define uk_9pfs_fsync		((vnop_fsync_t)vfscore_vop_nullop)
-#define uk_9pfs_setattr		((vnop_setattr_t)vfscore_vop_nullop)
-#define uk_9pfs_truncate	((vnop_truncate_t)vfscore_vop_nullop)
 #define uk_9pfs_link		((vnop_link_t)vfscore_vop_eperm)
 #define uk_9pfs_cache		((vnop_cache_t)NULL)
 #define uk_9pfs_readlink	((vnop_readlink_t)vfscore_vop_einval)
@@ -0,0 +1,187 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _BLKFS_H
+#define _BLKFS_H
+
+#include <stdint.h>
+#include <uk/essentials.h>
+#include <uk/mutex.h>
+#include <uk/blkdev.h>
+#include <vfscore/prex.h>
+#include <vfscore/vnode.h>
+#include <vfscore/mount.h>
+
+/*
+ * On-disk layout (all fields little-endian, one block = one page):
+ *
+ *   block 0                superblock
+ *   bitmap_start ...       block allocation bitmap, 1 bit per block
+ *   itable_start ...       inode table, BLKFS_INODES_PER_BLOCK per block
+ *   data_start ...         file and directory data
+ *
+ * Inode 0 is the root directory. A file's data is described by up to
+ * BLKFS_MAXEXTENTS extents that map consecutive logical blocks, i.e., the
+ * first extent maps the first blocks of the file. The first
+ * BLKFS_NEXTENTS extents are stored in the inode, the others in one
+ * indirect extent block that is allocated on demand. Blocks are allocated
+ * lazily when dirty pages are written back, so appends tend to extend the
+ * last extent. Directories are files of fixed-size entries; an entry with
+ * a zero name length is free.
+ *
+ * There is no journal: after a crash, only data and metadata of files that
+ * were fsync()'ed are guaranteed to be on disk.
+ */
+
+#define BLKFS_MAGIC		0x53464b42	/* "BKFS" */
+#define BLKFS_VERSION		2
+#define BLKFS_BSIZE		__PAGE_SIZE
+#define BLKFS_BSHIFT		__PAGE_SHIFT
+#define BLKFS_ROOT_INO		0
+#define BLKFS_NEXTENTS		9
+/* Extents in the indirect extent block */
+#define BLKFS_NIEXTENTS		(BLKFS_BSIZE / sizeof(struct blkfs_extent))
+#define BLKFS_MAXEXTENTS	(BLKFS_NEXTENTS + BLKFS_NIEXTENTS)
+#define BLKFS_NAME_MAX		57
+/* Default number of inodes per MiB of disk when formatting */
+#define BLKFS_INODES_PER_MB	16
+#define BLKFS_INODES_MIN	256
+#define BLKFS_INODES_MAX	65536
+/* Maximum number of block requests in flight at once */
+#define BLKFS_BIO_BATCH		32
+
+struct blkfs_super {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t bsize;
+	uint32_t nblocks;
+	uint32_t ninodes;
+	uint32_t bitmap_start;
+	uint32_t bitmap_blocks;
+	uint32_t itable_start;
+	uint32_t itable_blocks;
+	uint32_t data_start;
+};
+
+struct blkfs_extent {
+	uint32_t start;		/* first physical block */
+	uint32_t len;		/* number of blocks */
+};
+
+struct blkfs_dinode {
+	uint32_t mode;		/* 0 if the inode is free */
+	uint32_t nlink;
+	uint64_t size;
+	int64_t atime;		/* nanoseconds since the epoch */
+	int64_t mtime;
+	int64_t ctime;
+	uint32_t nblocks;	/* allocated blocks, sum of extent lengths */
+	uint32_t nextents;
+	uint32_t iext;		/* indirect extent block, 0 if none */
+	uint32_t reserved;
+	struct blkfs_extent ext[BLKFS_NEXTENTS];
+};
+
+UK_CTASSERT(sizeof(struct blkfs_dinode) == 128);
+
+#define BLKFS_INODES_PER_BLOCK	(BLKFS_BSIZE / sizeof(struct blkfs_dinode))
+
+struct blkfs_dirent {
+	uint32_t ino;
+	uint8_t type;		/* DT_* */
+	uint8_t namelen;	/* 0 if the entry is free */
+	char name[BLKFS_NAME_MAX + 1];
+};
+
+UK_CTASSERT(sizeof(struct blkfs_dirent) == 64);
+
+#define BLKFS_DIRENTS_PER_BLOCK	(BLKFS_BSIZE / sizeof(struct blkfs_dirent))
+
+/*
+ * In-memory state of a mounted filesystem. The allocation bitmap and the
+ * inode table are kept in memory in full and written back block by block.
+ */
+struct blkfs_mount {
+	struct uk_blkdev *dev;
+	uint16_t qid;
+	__sector spb;			/* device sectors per block */
+	struct blkfs_super sb;
+	uint8_t *bitmap;
+	uint8_t *bitmap_dirty;		/* one flag per bitmap block */
+	struct blkfs_dinode *itable;
+	uint8_t *itable_dirty;		/* one flag per inode table block */
+	uint32_t free_blocks;
+	uint32_t free_inodes;
+	uint32_t alloc_hint;
+	int flush;			/* device has a volatile write cache */
+	struct uk_mutex lock;		/* bitmap and inode allocation */
+};
+
+/* In-memory inode, attached to vnode->v_data */
+struct blkfs_node {
+	uint32_t ino;
+	struct blkfs_dinode *di;
+	/* Contents of the indirect extent block, NULL if there is none */
+	struct blkfs_extent *iext;
+	int iext_dirty;
+	/* Size or block mapping changed since the last sync, so that the
+	 * data cannot be read back without writing the inode.
+	 */
+	int map_dirty;
+};
+
+#define BLKFS_MOUNT(mp)	((struct blkfs_mount *) (mp)->m_data)
+#define BLKFS_NODE(vp)	((struct blkfs_node *) (vp)->v_data)
+
+extern struct vnops blkfs_vnops;
+
+/* blkfs_vnops.c */
+int blkfs_node_init(struct blkfs_mount *bm, struct vnode *vp);
+
+/* blkfs_subr.c */
+int blkfs_bio(struct blkfs_mount *bm, int write, const uint32_t *blks,
+	      void **bufs, unsigned int cnt);
+int blkfs_flush(struct blkfs_mount *bm);
+int blkfs_format(struct blkfs_mount *bm);
+int blkfs_load(struct blkfs_mount *bm);
+int blkfs_sync_meta(struct blkfs_mount *bm);
+void blkfs_inode_dirty(struct blkfs_mount *bm, uint32_t ino);
+int blkfs_inode_alloc(struct blkfs_mount *bm, uint32_t mode, uint32_t *ino);
+void blkfs_inode_free(struct blkfs_mount *bm, uint32_t ino);
+int blkfs_iext_load(struct blkfs_mount *bm, struct blkfs_node *np);
+int blkfs_iext_sync(struct blkfs_mount *bm, struct blkfs_node *np);
+int blkfs_bmap(struct blkfs_node *np, uint32_t lblk, uint32_t *pblk);
+int blkfs_bmap_alloc(struct blkfs_mount *bm, struct blkfs_node *np,
+		     uint32_t lblk, uint32_t *pblk);
+void blkfs_bmap_trunc(struct blkfs_mount *bm, struct blkfs_node *np,
+		      uint32_t nblocks);
+int64_t blkfs_now(void);
+
+#endif /* !_BLKFS_H */
@@ -0,0 +1,708 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * blkfs_subr.c - block I/O, allocation and metadata of BlkFS
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <uk/assert.h>
+#include <uk/print.h>
+#include <uk/alloc.h>
+
+#include "blkfs.h"
+
+static char blkfs_zero_block[BLKFS_BSIZE] __align(BLKFS_BSIZE);
+
+int64_t blkfs_now(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	return (int64_t) now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * Reads or writes `cnt` blocks, each with its own buffer. Requests are
+ * submitted in batches (one device notification per batch) and completed
+ * by polling the queue.
+ */
+int blkfs_bio(struct blkfs_mount *bm, int write, const uint32_t *blks,
+	      void **bufs, unsigned int cnt)
+{
+	struct uk_blkreq reqs[BLKFS_BIO_BATCH];
+	struct uk_blkreq *rp[BLKFS_BIO_BATCH];
+	unsigned int i, n, sent;
+	int rc;
+
+	while (cnt) {
+		n = MIN(cnt, (unsigned int) BLKFS_BIO_BATCH);
+		for (i = 0; i < n; i++) {
+			uk_blkreq_init(&reqs[i],
+				       write ? UK_BLKREQ_WRITE : UK_BLKREQ_READ,
+				       (__sector) blks[i] * bm->spb, bm->spb,
+				       bufs[i], NULL, NULL);
+			rp[i] = &reqs[i];
+		}
+
+		for (sent = 0; sent < n; sent += rc) {
+			rc = uk_blkdev_queue_submit_batch(bm->dev, bm->qid,
+							  &rp[sent], n - sent);
+			if (rc == -ENOSPC) {
+				/* Ring is full: wait for what we have sent */
+				uk_blkdev_queue_poll_reqs(bm->dev, bm->qid,
+							  rp, sent);
+				if (!sent)
+					uk_blkdev_queue_finish_reqs(bm->dev,
+								    bm->qid);
+				rc = 0;
+				continue;
+			}
+			if (unlikely(rc < 0)) {
+				uk_pr_err("blkfs: Failed to submit I/O: %d\n",
+					  rc);
+				uk_blkdev_queue_poll_reqs(bm->dev, bm->qid,
+							  rp, sent);
+				return EIO;
+			}
+		}
+
+		rc = uk_blkdev_queue_poll_reqs(bm->dev, bm->qid, rp, n);
+		if (unlikely(rc < 0))
+			return EIO;
+		for (i = 0; i < n; i++) {
+			if (unlikely(reqs[i].result < 0)) {
+				uk_pr_err("blkfs: I/O error on block %"PRIu32": %d\n",
+					  blks[i], reqs[i].result);
+				return EIO;
+			}
+		}
+
+		blks += n;
+		bufs += n;
+		cnt -= n;
+	}
+
+	return 0;
+}
+
+/* Transfers `nblks` consecutive blocks from/to a contiguous buffer */
+static int blkfs_bio_range(struct blkfs_mount *bm, int write, uint32_t start,
+			   uint32_t nblks, void *buf)
+{
+	uint32_t blks[BLKFS_BIO_BATCH];
+	void *bufs[BLKFS_BIO_BATCH];
+	uint32_t i, n;
+	int error;
+
+	while (nblks) {
+		n = MIN(nblks, (uint32_t) BLKFS_BIO_BATCH);
+		for (i = 0; i < n; i++) {
+			blks[i] = start + i;
+			bufs[i] = (char *) buf + ((size_t) i << BLKFS_BSHIFT);
+		}
+		error = blkfs_bio(bm, write, blks, bufs, n);
+		if (error)
+			return error;
+		start += n;
+		nblks -= n;
+		buf = (char *) buf + ((size_t) n << BLKFS_BSHIFT);
+	}
+	return 0;
+}
+
+int blkfs_flush(struct blkfs_mount *bm)
+{
+	struct uk_blkreq req, *rp = &req;
+	int rc;
+
+	if (!bm->flush)
+		return 0;
+
+	uk_blkreq_init(&req, UK_BLKREQ_FFLUSH, 0, 0, NULL, NULL, NULL);
+	rc = uk_blkdev_queue_submit_batch(bm->dev, bm->qid, &rp, 1);
+	if (rc == -ENOTSUP) {
+		/* No volatile write cache: completed writes are durable */
+		bm->flush = 0;
+		return 0;
+	}
+	if (unlikely(rc < 0))
+		return EIO;
+
+	rc = uk_blkdev_queue_poll_reqs(bm->dev, bm->qid, &rp, 1);
+	if (unlikely(rc < 0 || req.result < 0))
+		return EIO;
+	return 0;
+}
+
+static inline int bitmap_test(struct blkfs_mount *bm, uint32_t blk)
+{
+	return bm->bitmap[blk >> 3] & (1 << (blk & 7));
+}
+
+static void bitmap_set(struct blkfs_mount *bm, uint32_t blk, int used)
+{
+	if (used)
+		bm->bitmap[blk >> 3] |= (1 << (blk & 7));
+	else
+		bm->bitmap[blk >> 3] &= ~(1 << (blk & 7));
+	bm->bitmap_dirty[blk >> (BLKFS_BSHIFT + 3)] = 1;
+}
+
+static int blkfs_alloc_bufs(struct blkfs_mount *bm)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+
+	bm->bitmap = uk_palloc(a, bm->sb.bitmap_blocks);
+	bm->itable = uk_palloc(a, bm->sb.itable_blocks);
+	bm->bitmap_dirty = calloc(1, bm->sb.bitmap_blocks);
+	bm->itable_dirty = calloc(1, bm->sb.itable_blocks);
+	if (!bm->bitmap || !bm->itable || !bm->bitmap_dirty ||
+	    !bm->itable_dirty)
+		return ENOMEM;
+	return 0;
+}
+
+/*
+ * Creates an empty filesystem that spans the whole device and leaves it
+ * loaded, as blkfs_load() would.
+ */
+int blkfs_format(struct blkfs_mount *bm)
+{
+	struct blkfs_super *sb = &bm->sb;
+	struct blkfs_dinode *root;
+	uint64_t nblocks, ninodes, blk;
+	char *sbbuf;
+	int error;
+
+	nblocks = uk_blkdev_size(bm->dev) >> BLKFS_BSHIFT;
+	nblocks = MIN(nblocks, (uint64_t) UINT32_MAX);
+	ninodes = (nblocks << BLKFS_BSHIFT) / (1024 * 1024)
+		  * BLKFS_INODES_PER_MB;
+	ninodes = MAX(ninodes, (uint64_t) BLKFS_INODES_MIN);
+	ninodes = MIN(ninodes, (uint64_t) BLKFS_INODES_MAX);
+	ninodes = ALIGN_UP(ninodes, BLKFS_INODES_PER_BLOCK);
+
+	memset(sb, 0, sizeof(*sb));
+	sb->magic = BLKFS_MAGIC;
+	sb->version = BLKFS_VERSION;
+	sb->bsize = BLKFS_BSIZE;
+	sb->nblocks = nblocks;
+	sb->ninodes = ninodes;
+	sb->bitmap_start = 1;
+	sb->bitmap_blocks = DIV_ROUND_UP(nblocks, BLKFS_BSIZE * 8);
+	sb->itable_start = sb->bitmap_start + sb->bitmap_blocks;
+	sb->itable_blocks = ninodes / BLKFS_INODES_PER_BLOCK;
+	sb->data_start = sb->itable_start + sb->itable_blocks;
+	if (sb->data_start >= sb->nblocks) {
+		uk_pr_err("blkfs: Device is too small\n");
+		return ENOSPC;
+	}
+
+	error = blkfs_alloc_bufs(bm);
+	if (error)
+		return error;
+
+	memset(bm->bitmap, 0, (size_t) sb->bitmap_blocks << BLKFS_BSHIFT);
+	/* Blocks past the end of the device are never free */
+	for (blk = 0; blk < (uint64_t) sb->bitmap_blocks * BLKFS_BSIZE * 8;
+	     blk++)
+		if (blk < sb->data_start || blk >= sb->nblocks)
+			bitmap_set(bm, blk, 1);
+
+	memset(bm->itable, 0, (size_t) sb->itable_blocks << BLKFS_BSHIFT);
+	root = &bm->itable[BLKFS_ROOT_INO];
+	root->mode = S_IFDIR | 0777;
+	root->nlink = 2;
+	root->atime = root->mtime = root->ctime = blkfs_now();
+
+	error = blkfs_bio_range(bm, 1, sb->bitmap_start, sb->bitmap_blocks,
+				bm->bitmap);
+	if (error)
+		return error;
+	error = blkfs_bio_range(bm, 1, sb->itable_start, sb->itable_blocks,
+				bm->itable);
+	if (error)
+		return error;
+
+	/* Write the superblock last so that an interrupted format leaves
+	 * an unformatted device behind
+	 */
+	sbbuf = uk_palloc(uk_alloc_get_default(), 1);
+	if (!sbbuf)
+		return ENOMEM;
+	memset(sbbuf, 0, BLKFS_BSIZE);
+	memcpy(sbbuf, sb, sizeof(*sb));
+	error = blkfs_bio_range(bm, 1, 0, 1, sbbuf);
+	uk_pfree(uk_alloc_get_default(), sbbuf, 1);
+	if (error)
+		return error;
+
+	memset(bm->bitmap_dirty, 0, sb->bitmap_blocks);
+	bm->free_blocks = sb->nblocks - sb->data_start;
+	bm->free_inodes = sb->ninodes - 1;
+	bm->alloc_hint = sb->data_start;
+	uk_pr_info("blkfs: Formatted %"PRIu32" blocks, %"PRIu32" inodes\n",
+		   sb->nblocks, sb->ninodes);
+	return blkfs_flush(bm);
+}
+
+/*
+ * Reads the superblock, allocation bitmap and inode table. Returns ENODEV
+ * if the device does not contain a BlkFS filesystem.
+ */
+int blkfs_load(struct blkfs_mount *bm)
+{
+	struct blkfs_super *sb = &bm->sb;
+	uint32_t blk, ino;
+	void *sbbuf;
+	int error;
+
+	sbbuf = uk_palloc(uk_alloc_get_default(), 1);
+	if (!sbbuf)
+		return ENOMEM;
+	error = blkfs_bio_range(bm, 0, 0, 1, sbbuf);
+	memcpy(sb, sbbuf, sizeof(*sb));
+	uk_pfree(uk_alloc_get_default(), sbbuf, 1);
+	if (error)
+		return error;
+
+	if (sb->magic != BLKFS_MAGIC)
+		return ENODEV;
+	if (sb->version != BLKFS_VERSION || sb->bsize != BLKFS_BSIZE ||
+	    sb->data_start >= sb->nblocks ||
+	    ((uint64_t) sb->nblocks << BLKFS_BSHIFT) >
+	    uk_blkdev_size(bm->dev)) {
+		uk_pr_err("blkfs: Unsupported or corrupt superblock\n");
+		return EINVAL;
+	}
+
+	error = blkfs_alloc_bufs(bm);
+	if (error)
+		return error;
+	error = blkfs_bio_range(bm, 0, sb->bitmap_start, sb->bitmap_blocks,
+				bm->bitmap);
+	if (error)
+		return error;
+	error = blkfs_bio_range(bm, 0, sb->itable_start, sb->itable_blocks,
+				bm->itable);
+	if (error)
+		return error;
+
+	bm->free_blocks = 0;
+	for (blk = sb->data_start; blk < sb->nblocks; blk++)
+		if (!bitmap_test(bm, blk))
+			bm->free_blocks++;
+	bm->free_inodes = 0;
+	for (ino = 0; ino < sb->ninodes; ino++)
+		if (!bm->itable[ino].mode)
+			bm->free_inodes++;
+	bm->alloc_hint = sb->data_start;
+	return 0;
+}
+
+/*
+ * Writes back the dirty blocks of the allocation bitmap and inode table.
+ */
+int blkfs_sync_meta(struct blkfs_mount *bm)
+{
+	uint32_t blks[BLKFS_BIO_BATCH];
+	void *bufs[BLKFS_BIO_BATCH];
+	unsigned int n = 0;
+	uint32_t i;
+	int error = 0;
+
+	uk_mutex_lock(&bm->lock);
+	for (i = 0; i < bm->sb.bitmap_blocks + bm->sb.itable_blocks; i++) {
+		uint8_t *dirty;
+		char *buf;
+
+		if (i < bm->sb.bitmap_blocks) {
+			dirty = &bm->bitmap_dirty[i];
+			buf = (char *) bm->bitmap;
+			blks[n] = bm->sb.bitmap_start + i;
+			buf += (size_t) i << BLKFS_BSHIFT;
+		} else {
+			uint32_t j = i - bm->sb.bitmap_blocks;
+
+			dirty = &bm->itable_dirty[j];
+			buf = (char *) bm->itable;
+			blks[n] = bm->sb.itable_start + j;
+			buf += (size_t) j << BLKFS_BSHIFT;
+		}
+		if (!*dirty)
+			continue;
+		*dirty = 0;
+		bufs[n++] = buf;
+
+		if (n == BLKFS_BIO_BATCH) {
+			error = blkfs_bio(bm, 1, blks, bufs, n);
+			if (error)
+				goto out;
+			n = 0;
+		}
+	}
+	if (n)
+		error = blkfs_bio(bm, 1, blks, bufs, n);
+out:
+	uk_mutex_unlock(&bm->lock);
+	return error;
+}
+
+void blkfs_inode_dirty(struct blkfs_mount *bm, uint32_t ino)
+{
+	bm->itable_dirty[ino / BLKFS_INODES_PER_BLOCK] = 1;
+}
+
+int blkfs_inode_alloc(struct blkfs_mount *bm, uint32_t mode, uint32_t *ino)
+{
+	struct blkfs_dinode *di;
+	uint32_t i;
+
+	uk_mutex_lock(&bm->lock);
+	for (i = BLKFS_ROOT_INO + 1; i < bm->sb.ninodes; i++) {
+		di = &bm->itable[i];
+		if (di->mode)
+			continue;
+
+		memset(di, 0, sizeof(*di));
+		di->mode = mode;
+		di->nlink = S_ISDIR(mode) ? 2 : 1;
+		di->atime = di->mtime = di->ctime = blkfs_now();
+		blkfs_inode_dirty(bm, i);
+		bm->free_inodes--;
+		uk_mutex_unlock(&bm->lock);
+
+		*ino = i;
+		return 0;
+	}
+	uk_mutex_unlock(&bm->lock);
+	return ENOSPC;
+}
+
+void blkfs_inode_free(struct blkfs_mount *bm, uint32_t ino)
+{
+	UK_ASSERT(ino != BLKFS_ROOT_INO && ino < bm->sb.ninodes);
+	UK_ASSERT(bm->itable[ino].nblocks == 0);
+	UK_ASSERT(bm->itable[ino].iext == 0);
+
+	uk_mutex_lock(&bm->lock);
+	memset(&bm->itable[ino], 0, sizeof(bm->itable[ino]));
+	blkfs_inode_dirty(bm, ino);
+	bm->free_inodes++;
+	uk_mutex_unlock(&bm->lock);
+}
+
+static inline struct blkfs_extent *blkfs_ext(struct blkfs_node *np,
+					     uint32_t i)
+{
+	if (i < BLKFS_NEXTENTS)
+		return &np->di->ext[i];
+	return &np->iext[i - BLKFS_NEXTENTS];
+}
+
+/*
+ * Reads the indirect extent block of a node, if it has one, and checks
+ * that its extents cover the blocks of the inode.
+ */
+int blkfs_iext_load(struct blkfs_mount *bm, struct blkfs_node *np)
+{
+	struct blkfs_dinode *di = np->di;
+	uint64_t nblocks = 0;
+	uint32_t i;
+	void *buf;
+	int error;
+
+	np->iext = NULL;
+	np->iext_dirty = 0;
+	if (di->nextents > BLKFS_MAXEXTENTS ||
+	    (di->nextents > BLKFS_NEXTENTS) != (di->iext != 0) ||
+	    (di->iext && (di->iext < bm->sb.data_start ||
+			  di->iext >= bm->sb.nblocks)))
+		goto corrupt;
+
+	if (di->iext) {
+		buf = uk_palloc(uk_alloc_get_default(), 1);
+		if (!buf)
+			return ENOMEM;
+		error = blkfs_bio(bm, 0, &di->iext, &buf, 1);
+		if (error) {
+			uk_pfree(uk_alloc_get_default(), buf, 1);
+			return error;
+		}
+		np->iext = buf;
+	}
+
+	for (i = 0; i < di->nextents; i++)
+		nblocks += blkfs_ext(np, i)->len;
+	if (nblocks != di->nblocks) {
+		if (np->iext)
+			uk_pfree(uk_alloc_get_default(), np->iext, 1);
+		np->iext = NULL;
+		goto corrupt;
+	}
+	return 0;
+
+corrupt:
+	uk_pr_err("blkfs: Inconsistent extent list in inode %"PRIu32"\n",
+		  np->ino);
+	return EIO;
+}
+
+/*
+ * Writes back the indirect extent block of a node if it changed.
+ */
+int blkfs_iext_sync(struct blkfs_mount *bm, struct blkfs_node *np)
+{
+	void *buf = np->iext;
+	int error;
+
+	if (!np->iext_dirty)
+		return 0;
+	error = blkfs_bio(bm, 1, &np->di->iext, &buf, 1);
+	if (!error)
+		np->iext_dirty = 0;
+	return error;
+}
+
+/*
+ * Returns ENOENT if `lblk` is not allocated and EIO if the extent list
+ * does not match the number of blocks of the inode.
+ */
+int blkfs_bmap(struct blkfs_node *np, uint32_t lblk, uint32_t *pblk)
+{
+	struct blkfs_dinode *di = np->di;
+	struct blkfs_extent *ext;
+	uint32_t i;
+
+	if (lblk >= di->nblocks)
+		return ENOENT;
+
+	for (i = 0; i < di->nextents; i++) {
+		ext = blkfs_ext(np, i);
+		if (lblk < ext->len) {
+			*pblk = ext->start + lblk;
+			return 0;
+		}
+		lblk -= ext->len;
+	}
+
+	uk_pr_err("blkfs: Inconsistent extent list\n");
+	return EIO;
+}
+
+/*
+ * Allocates up to `need` free blocks, contiguous and starting at `goal` if
+ * possible. Must be called with bm->lock held.
+ */
+static int blkfs_balloc(struct blkfs_mount *bm, uint32_t goal, uint32_t need,
+			uint32_t *start, uint32_t *len)
+{
+	uint32_t blk, i, n;
+
+	if (!bm->free_blocks)
+		return ENOSPC;
+
+	if (goal < bm->sb.data_start || goal >= bm->sb.nblocks ||
+	    bitmap_test(bm, goal)) {
+		/* Next free block after the last allocation */
+		n = bm->sb.nblocks - bm->sb.data_start;
+		blk = bm->alloc_hint;
+		for (i = 0; i < n; i++, blk++) {
+			if (blk >= bm->sb.nblocks)
+				blk = bm->sb.data_start;
+			if (!bitmap_test(bm, blk))
+				break;
+		}
+		UK_ASSERT(i < n);
+		goal = blk;
+	}
+
+	for (n = 0; n < need && goal + n < bm->sb.nblocks &&
+		    !bitmap_test(bm, goal + n); n++)
+		bitmap_set(bm, goal + n, 1);
+
+	bm->free_blocks -= n;
+	bm->alloc_hint = goal + n;
+	*start = goal;
+	*len = n;
+	return 0;
+}
+
+static void blkfs_bfree(struct blkfs_mount *bm, uint32_t start, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		UK_ASSERT(bitmap_test(bm, start + i));
+		bitmap_set(bm, start + i, 0);
+	}
+	bm->free_blocks += len;
+}
+
+/*
+ * Allocates the indirect extent block of a node. Must be called with
+ * bm->lock held.
+ */
+static int blkfs_iext_alloc(struct blkfs_mount *bm, struct blkfs_node *np)
+{
+	uint32_t blk, len;
+	int error;
+
+	UK_ASSERT(!np->iext && !np->di->iext);
+
+	np->iext = uk_palloc(uk_alloc_get_default(), 1);
+	if (!np->iext)
+		return ENOMEM;
+	error = blkfs_balloc(bm, bm->alloc_hint, 1, &blk, &len);
+	if (error) {
+		uk_pfree(uk_alloc_get_default(), np->iext, 1);
+		np->iext = NULL;
+		return error;
+	}
+	memset(np->iext, 0, BLKFS_BSIZE);
+	np->di->iext = blk;
+	np->iext_dirty = 1;
+	return 0;
+}
+
+/*
+ * Maps a logical block of a file, allocating all blocks up to it if needed.
+ * Newly allocated blocks in front of `lblk` are holes and zeroed on disk.
+ */
+int blkfs_bmap_alloc(struct blkfs_mount *bm, struct blkfs_node *np,
+		     uint32_t lblk, uint32_t *pblk)
+{
+	struct blkfs_dinode *di = np->di;
+	struct blkfs_extent *last, *ext;
+	uint32_t goal, start, len, first, zblks[BLKFS_BIO_BATCH];
+	void *zbufs[BLKFS_BIO_BATCH];
+	unsigned int nz;
+	int error;
+
+	while (di->nblocks <= lblk) {
+		last = di->nextents ? blkfs_ext(np, di->nextents - 1) : NULL;
+		goal = last ? last->start + last->len : bm->alloc_hint;
+
+		uk_mutex_lock(&bm->lock);
+		error = blkfs_balloc(bm, goal, lblk + 1 - di->nblocks,
+				     &start, &len);
+		if (error) {
+			uk_mutex_unlock(&bm->lock);
+			return error;
+		}
+		if (last && start == last->start + last->len) {
+			last->len += len;
+			if (di->nextents > BLKFS_NEXTENTS)
+				np->iext_dirty = 1;
+		} else if (di->nextents < BLKFS_MAXEXTENTS) {
+			if (di->nextents == BLKFS_NEXTENTS) {
+				error = blkfs_iext_alloc(bm, np);
+				if (error) {
+					blkfs_bfree(bm, start, len);
+					uk_mutex_unlock(&bm->lock);
+					return error;
+				}
+			}
+			ext = blkfs_ext(np, di->nextents);
+			ext->start = start;
+			ext->len = len;
+			di->nextents++;
+			if (di->nextents > BLKFS_NEXTENTS)
+				np->iext_dirty = 1;
+		} else {
+			blkfs_bfree(bm, start, len);
+			uk_mutex_unlock(&bm->lock);
+			return EFBIG;
+		}
+		first = di->nblocks;
+		di->nblocks += len;
+		blkfs_inode_dirty(bm, np->ino);
+		np->map_dirty = 1;
+		uk_mutex_unlock(&bm->lock);
+
+		/* Zero the holes in front of lblk */
+		nz = 0;
+		for (; first < di->nblocks && first < lblk; first++) {
+			zblks[nz] = start + (first - (di->nblocks - len));
+			zbufs[nz++] = blkfs_zero_block;
+			if (nz == BLKFS_BIO_BATCH ||
+			    first + 1 == MIN(di->nblocks, lblk)) {
+				error = blkfs_bio(bm, 1, zblks, zbufs, nz);
+				if (error)
+					return error;
+				nz = 0;
+			}
+		}
+	}
+
+	return blkfs_bmap(np, lblk, pblk);
+}
+
+/*
+ * Shrinks the block mapping of a file to `nblocks` blocks and frees the
+ * blocks past it.
+ */
+void blkfs_bmap_trunc(struct blkfs_mount *bm, struct blkfs_node *np,
+		      uint32_t nblocks)
+{
+	struct blkfs_dinode *di = np->di;
+	struct blkfs_extent *last;
+	uint32_t cut;
+
+	uk_mutex_lock(&bm->lock);
+	while (di->nblocks > nblocks) {
+		UK_ASSERT(di->nextents > 0);
+		last = blkfs_ext(np, di->nextents - 1);
+		cut = MIN(last->len, di->nblocks - nblocks);
+
+		blkfs_bfree(bm, last->start + last->len - cut, cut);
+		last->len -= cut;
+		if (di->nextents > BLKFS_NEXTENTS)
+			np->iext_dirty = 1;
+		if (!last->len)
+			di->nextents--;
+		di->nblocks -= cut;
+		np->map_dirty = 1;
+	}
+	if (di->iext && di->nextents <= BLKFS_NEXTENTS) {
+		blkfs_bfree(bm, di->iext, 1);
+		di->iext = 0;
+		uk_pfree(uk_alloc_get_default(), np->iext, 1);
+		np->iext = NULL;
+		np->iext_dirty = 0;
+	}
+	blkfs_inode_dirty(bm, np->ino);
+	uk_mutex_unlock(&bm->lock);
+}
@@ -0,0 +1,257 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/statfs.h>
+#include <uk/alloc.h>
+#include <uk/print.h>
+#include <vfscore/vnode.h>
+#include <vfscore/mount.h>
+#include <vfscore/dentry.h>
+
+#include "blkfs.h"
+
+static int blkfs_mount(struct mount *mp, const char *dev, int flags,
+		       const void *data);
+static int blkfs_unmount(struct mount *mp, int flags);
+static int blkfs_sync(struct mount *mp);
+static int blkfs_vget(struct mount *mp, struct vnode *vp);
+static int blkfs_statfs(struct mount *mp, struct statfs *statp);
+
+struct vfsops blkfs_vfsops __section(".data_shared") = {
+	blkfs_mount,		/* mount */
+	blkfs_unmount,		/* unmount */
+	blkfs_sync,		/* sync */
+	blkfs_vget,		/* vget */
+	blkfs_statfs,		/* statfs */
+	&blkfs_vnops,		/* vnops */
+};
+
+static struct vfscore_fs_type fs_blkfs __section(".data_shared") = {
+	.vs_name = "blkfs",
+	.vs_init = NULL,
+	.vs_op = &blkfs_vfsops,
+};
+
+UK_FS_REGISTER(fs_blkfs);
+
+/*
+ * Brings queue 0 of the device up without an event callback: BlkFS polls
+ * for completions. A device that was already started by someone else is
+ * used as is.
+ */
+static int blkfs_dev_start(struct uk_blkdev *dev)
+{
+	struct uk_blkdev_conf conf = { .nb_queues = 1 };
+	struct uk_blkdev_queue_conf qconf = {
+		.a = uk_alloc_get_default(),
+	};
+	struct uk_blkdev_queue_info qinfo;
+	int rc;
+
+	if (uk_blkdev_state_get(dev) != UK_BLKDEV_UNCONFIGURED)
+		return 0;
+
+	rc = uk_blkdev_configure(dev, &conf);
+	if (rc < 0)
+		return rc;
+	rc = uk_blkdev_queue_get_info(dev, 0, &qinfo);
+	if (rc < 0)
+		return rc;
+	rc = uk_blkdev_queue_configure(dev, 0, qinfo.nb_max, &qconf);
+	if (rc < 0)
+		return rc;
+	return uk_blkdev_start(dev);
+}
+
+static void blkfs_free_mount(struct blkfs_mount *bm)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+
+	if (bm->bitmap)
+		uk_pfree(a, bm->bitmap, bm->sb.bitmap_blocks);
+	if (bm->itable)
+		uk_pfree(a, bm->itable, bm->sb.itable_blocks);
+	free(bm->bitmap_dirty);
+	free(bm->itable_dirty);
+	free(bm);
+}
+
+/*
+ * Returns 1 if the comma-separated mount options `data` contain `opt`
+ */
+static int
+blkfs_has_option(const char *data, const char *opt)
+{
+	size_t len = strlen(opt);
+
+	while (data && *data) {
+		if (!strncmp(data, opt, len) &&
+		    (data[len] == '\0' || data[len] == ','))
+			return 1;
+		data = strchr(data, ',');
+		if (data)
+			data++;
+	}
+	return 0;
+}
+
+/*
+ * `dev` is the number of the block device, as in uk_blkdev_get(). The
+ * device is only formatted if the "format" mount option is given, a
+ * device without a BlkFS superblock fails to mount with ENODEV.
+ */
+static int
+blkfs_mount(struct mount *mp, const char *dev, int flags __unused,
+	    const void *data)
+{
+	struct blkfs_mount *bm;
+	char *end;
+	unsigned long id;
+	int error;
+
+	id = strtoul(dev, &end, 10);
+	if (!*dev || *end)
+		return EINVAL;
+
+	bm = calloc(1, sizeof(*bm));
+	if (!bm)
+		return ENOMEM;
+	uk_mutex_init(&bm->lock);
+	bm->flush = 1;
+
+	bm->dev = uk_blkdev_get(id);
+	if (!bm->dev) {
+		uk_pr_err("blkfs: No block device %lu\n", id);
+		error = ENODEV;
+		goto err;
+	}
+	if (BLKFS_BSIZE % uk_blkdev_ssize(bm->dev)) {
+		uk_pr_err("blkfs: Unsupported sector size %"__PRIsz"\n",
+			  (size_t) uk_blkdev_ssize(bm->dev));
+		error = EINVAL;
+		goto err;
+	}
+	bm->spb = BLKFS_BSIZE / uk_blkdev_ssize(bm->dev);
+
+	error = -blkfs_dev_start(bm->dev);
+	if (error) {
+		uk_pr_err("blkfs: Failed to start block device %lu: %d\n",
+			  id, -error);
+		goto err;
+	}
+
+	if (blkfs_has_option(data, "format")) {
+		uk_pr_info("blkfs: Formatting block device %lu\n", id);
+		error = blkfs_format(bm);
+	} else {
+		error = blkfs_load(bm);
+		if (error == ENODEV)
+			uk_pr_err("blkfs: No filesystem on block device %lu\n",
+				  id);
+	}
+	if (error)
+		goto err;
+
+	mp->m_data = bm;
+	error = blkfs_node_init(bm, mp->m_root->d_vnode);
+	if (error) {
+		mp->m_data = NULL;
+		goto err;
+	}
+
+	uk_pr_info("blkfs: Mounted block device %lu: %"PRIu32" of %"PRIu32" blocks free\n",
+		   id, bm->free_blocks, bm->sb.nblocks - bm->sb.data_start);
+	return 0;
+
+err:
+	blkfs_free_mount(bm);
+	return error;
+}
+
+static int
+blkfs_unmount(struct mount *mp, int flags __unused)
+{
+	struct blkfs_mount *bm = BLKFS_MOUNT(mp);
+	int error;
+
+	/* Inactivates all vnodes, which writes back their pages */
+	vfscore_release_mp_dentries(mp);
+
+	error = blkfs_sync(mp);
+	if (error)
+		return error;
+
+	mp->m_data = NULL;
+	blkfs_free_mount(bm);
+	return 0;
+}
+
+/*
+ * Writes back the filesystem metadata. Cached file data is written back
+ * on fsync() and when a file is no longer referenced.
+ */
+static int
+blkfs_sync(struct mount *mp)
+{
+	struct blkfs_mount *bm = BLKFS_MOUNT(mp);
+	int error;
+
+	error = blkfs_sync_meta(bm);
+	if (error)
+		return error;
+	return blkfs_flush(bm);
+}
+
+static int
+blkfs_vget(struct mount *mp, struct vnode *vp)
+{
+	/* The root vnode is created before blkfs_mount() */
+	if (!mp->m_data)
+		return 0;
+	return blkfs_node_init(BLKFS_MOUNT(mp), vp);
+}
+
+static int
+blkfs_statfs(struct mount *mp, struct statfs *statp)
+{
+	struct blkfs_mount *bm = BLKFS_MOUNT(mp);
+
+	statp->f_bsize = BLKFS_BSIZE;
+	statp->f_blocks = bm->sb.nblocks - bm->sb.data_start;
+	statp->f_bfree = bm->free_blocks;
+	statp->f_bavail = bm->free_blocks;
+	statp->f_files = bm->sb.ninodes;
+	statp->f_ffree = bm->free_inodes;
+	statp->f_namelen = BLKFS_NAME_MAX;
+	return 0;
+}
@@ -0,0 +1,759 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <uk/essentials.h>
+#include <uk/print.h>
+#include <uk/alloc.h>
+#include <vfscore/vnode.h>
+#include <vfscore/mount.h>
+#include <vfscore/uio.h>
+#include <vfscore/file.h>
+#include <vfscore/fs.h>
+#include <vfscore/pagecache.h>
+
+#include "blkfs.h"
+
+/*
+ * Moves data between the page cache and the device. Blocks that are not
+ * allocated read as zeros; blocks are allocated when first written back.
+ */
+static int blkfs_readpages(struct vnode *vp, off_t off, void **pages, int cnt)
+{
+	struct blkfs_mount *bm = BLKFS_MOUNT(vp->v_mount);
+	struct blkfs_node *np = BLKFS_NODE(vp);
+	uint32_t lblk = off >> BLKFS_BSHIFT;
+	uint32_t blks[BLKFS_BIO_BATCH];
+	void *bufs[BLKFS_BIO_BATCH];
+	unsigned int n = 0;
+	int i, error;
+
+	for (i = 0; i < cnt; i++, lblk++) {
+		error = blkfs_bmap(np, lblk, &blks[n]);
+		if (error == ENOENT) {
+			memset(pages[i], 0, BLKFS_BSIZE);
+			continue;
+		}
+		if (error)
+			return error;
+		bufs[n++] = pages[i];
+		if (n == BLKFS_BIO_BATCH) {
+			error = blkfs_bio(bm, 0, blks, bufs, n);
+			if (error)
+				return error;
+			n = 0;
+		}
+	}
+	return n ? blkfs_bio(bm, 0, blks, bufs, n) : 0;
+}
+
+static int blkfs_writepages(struct vnode *vp, const off_t *offs, void **pages,
+			    int cnt)
+{
+	struct blkfs_mount *bm = BLKFS_MOUNT(vp->v_mount);
+	struct blkfs_node *np = BLKFS_NODE(vp);
+	uint32_t blks[BLKFS_BIO_BATCH];
+	void *bufs[BLKFS_BIO_BATCH];
+	unsigned int n = 0;
+	int i, error;
+
+	for (i = 0; i < cnt; i++) {
+		error = blkfs_bmap_alloc(bm, np, offs[i] >> BLKFS_BSHIFT,
+					 &blks[n]);
+		if (error)
+			return error;
+		bufs[n++] = pages[i];
+		if (n == BLKFS_BIO_BATCH) {
+			error = blkfs_bio(bm, 1, blks, bufs, n);
+			if (error)
+				return error;
+			n = 0;
+		}
+	}
+	if (n) {
+		error = blkfs_bio(bm, 1, blks, bufs, n);
+		if (error)
+			return error;
+	}
+	return blkfs_iext_sync(bm, np);
+}
+
+static const struct vfscore_pcache_ops blkfs_pcache_ops = {
+	.readpages = blkfs_readpages,
+	.writepages = blkfs_writepages,
+};
+
+int blkfs_node_init(struct blkfs_mount *bm, struct vnode *vp)
+{
+	struct blkfs_node *np;
+	struct blkfs_dinode *di;
+	int error;
+
+	if (vp->v_ino >= bm->sb.ninodes || !bm->itable[vp->v_ino].mode) {
+		uk_pr_err("blkfs: Reference to free inode %"PRIu64"\n",
+			  (uint64_t) vp->v_ino);
+		return EIO;
+	}
+
+	np = malloc(sizeof(*np));
+	if (!np)
+		return ENOMEM;
+	np->ino = vp->v_ino;
+	np->di = di = &bm->itable[np->ino];
+	np->map_dirty = 0;
+	error = blkfs_iext_load(bm, np);
+	if (error) {
+		free(np);
+		return error;
+	}
+
+	vp->v_data = np;
+	vp->v_type = S_ISDIR(di->mode) ? VDIR : VREG;
+	vp->v_mode = di->mode & UK_ALLPERMS;
+	vp->v_size = di->size;
+	vfscore_pcache_attach(vp, &blkfs_pcache_ops);
+	return 0;
+}
+
+/*
+ * Records a change of the node in its inode. `data` tells whether the
+ * contents changed (mtime) or only the metadata (ctime).
+ */
+static void blkfs_node_touch(struct vnode *vp, int data)
+{
+	struct blkfs_mount *bm = BLKFS_MOUNT(vp->v_mount);
+	struct blkfs_node *np = BLKFS_NODE(vp);
+	int64_t now = blkfs_now();
+
+	if (np->di->size != (uint64_t) vp->v_size) {
+		np->di->size = vp->v_size;
+		np->map_dirty = 1;
+	}
+	if (data)
+		np->di->mtime = now;
+	np->di->ctime = now;
+	blkfs_inode_dirty(bm, np->ino);
+}
+
+static inline void blkfs_ns_to_ts(int64_t ns, struct timespec *ts)
+{
+	ts->tv_sec = ns / 1000000000LL;
+	ts->tv_nsec = ns % 1000000000LL;
+}
+
+static inline int64_t blkfs_ts_to_ns(const struct timespec *ts)
+{
+	return (int64_t) ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+/*
+ * Directories are regular BlkFS files of struct blkfs_dirent that are read
+ * and written through the page cache like file data.
+ */
+static int blkfs_dir_io(struct vnode *dvp, enum uio_rw rw, off_t off,
+			void *buf, size_t len)
+{
+	struct iovec iov = {
+		.iov_base = buf,
+		.iov_len = len,
+	};
+	struct uio uio = {
+		.uio_iov = &iov,
+		.uio_iovcnt = 1,
+		.uio_offset = off,
+		.uio_resid = len,
+		.uio_rw = rw,
+	};
+
+	if (rw == UIO_READ)
+		return vfscore_pcache_read(dvp, &uio);
+	return vfscore_pcache_write(dvp, &uio, 0);
+}
+
+/*
+ * Looks up `name` in a directory and returns its entry and offset. If the
+ * name does not exist, returns ENOENT and the offset of the first free
+ * entry, which may be the end of the directory.
+ */
+static int blkfs_dir_find(struct vnode *dvp, const char *name,
+			  struct blkfs_dirent *de, off_t *offp)
+{
+	struct blkfs_dirent *buf;
+	size_t namelen = strlen(name);
+	off_t off, free_off = -1;
+	unsigned int i, n;
+	int error = ENOENT;
+
+	buf = malloc(BLKFS_BSIZE);
+	if (!buf)
+		return ENOMEM;
+
+	for (off = 0; off < dvp->v_size; off += BLKFS_BSIZE) {
+		n = MIN(dvp->v_size - off, (off_t) BLKFS_BSIZE) / sizeof(*buf);
+		error = blkfs_dir_io(dvp, UIO_READ, off, buf,
+				     n * sizeof(*buf));
+		if (error)
+			goto out;
+
+		error = ENOENT;
+		for (i = 0; i < n; i++) {
+			if (!buf[i].namelen) {
+				if (free_off < 0)
+					free_off = off + i * sizeof(*buf);
+				continue;
+			}
+			if (buf[i].namelen == namelen &&
+			    !memcmp(buf[i].name, name, namelen)) {
+				*de = buf[i];
+				*offp = off + i * sizeof(*buf);
+				error = 0;
+				goto out;
+			}
+		}
+	}
+	*offp = (free_off < 0) ? dvp->v_size : free_off;
+
+out:
+	free(buf);
+	return error;
+}
+
+static int blkfs_dir_add(struct vnode *dvp, const char *name, uint32_t ino,
+			 uint8_t type)
+{
+	struct blkfs_dirent de;
+	off_t off;
+	int error;
+
+	error = blkfs_dir_find(dvp, name, &de, &off);
+	if (!error)
+		return EEXIST;
+	if (error != ENOENT)
+		return error;
+
+	memset(&de, 0, sizeof(de));
+	de.ino = ino;
+	de.type = type;
+	de.namelen = strlen(name);
+	memcpy(de.name, name, de.namelen);
+
+	error = blkfs_dir_io(dvp, UIO_WRITE, off, &de, sizeof(de));
+	if (error)
+		return error;
+	blkfs_node_touch(dvp, 1);
+	return 0;
+}
+
+static int blkfs_dir_del(struct vnode *dvp, const char *name)
+{
+	struct blkfs_dirent de;
+	off_t off;
+	int error;
+
+	error = blkfs_dir_find(dvp, name, &de, &off);
+	if (error)
+		return error;
+
+	memset(&de, 0, sizeof(de));
+	error = blkfs_dir_io(dvp, UIO_WRITE, off, &de, sizeof(de));
+	if (error)
+		return error;
+	blkfs_node_touch(dvp, 1);
+	return 0;
+}
+
+/* Returns 0 if the directory is empty, ENOTEMPTY or an I/O error otherwise */
+static int blkfs_dir_empty(struct vnode *dvp)
+{
+	struct blkfs_dirent de;
+	off_t off;
+	int error;
+
+	for (off = 0; off < dvp->v_size; off += sizeof(de)) {
+		error = blkfs_dir_io(dvp, UIO_READ, off, &de, sizeof(de));
+		if (error)
+			return error;
+		if (de.namelen)
+			return ENOTEMPTY;
+	}
+	return 0;
+}
+
+static int
+blkfs_lookup(struct vnode *dvp, char *name, struct vnode **vpp)
+{
+	struct blkfs_dirent de;
+	struct vnode *vp;
+	off_t off;
+	int error;
+
+	*vpp = NULL;
+
+	if (*name == '\0')
+		return ENOENT;
+	if (strlen(name) > BLKFS_NAME_MAX)
+		return ENAMETOOLONG;
+
+	error = blkfs_dir_find(dvp, name, &de, &off);
+	if (error)
+		return error;
+
+	if (vfscore_vget(dvp->v_mount, de.ino, &vp)) {
+		/* found in cache */
+		*vpp = vp;
+		return 0;
+	}
+	if (!vp)
+		return ENOMEM;
+
+	*vpp = vp;
+	return 0;
+}
+
+static int
+blkfs_mknode(struct vnode *dvp, char *name, mode_t mode)
+{
+	struct blkfs_mount *bm = BLKFS_MOUNT(dvp->v_mount);
+	struct blkfs_node *dnp = BLKFS_NODE(dvp);
+	uint32_t ino;
+	int error;
+
+	if (strlen(name) > BLKFS_NAME_MAX)
+		return ENAMETOOLONG;
+
+	error = blkfs_inode_alloc(bm, mode, &ino);
+	if (error)
+		return error;
+
+	error = blkfs_dir_add(dvp, name, ino,
+			      S_ISDIR(mode) ? DT_DIR : DT_REG);
+	if (error) {
+		blkfs_inode_free(bm, ino);
+		return error;
+	}
+
+	if (S_ISDIR(mode)) {
+		/* ".." of the new directory */
+		dnp->di->nlink++;
+		blkfs_inode_dirty(bm, dnp->ino);
+	}
+	return 0;
+}
+
+static int
+blkfs_create(struct vnode *dvp, char *name, mode_t mode)
+{
+	if (!S_ISREG(mode))
+		return EINVAL;
+	return blkfs_mknode(dvp, name, S_IFREG | (mode & UK_ALLPERMS));
+}
+
+static int
+blkfs_mkdir(struct vnode *dvp, char *name, mode_t mode)
+{
+	if (!S_ISDIR(mode))
+		return EINVAL;
+	return blkfs_mknode(dvp, name, S_IFDIR | (mode & UK_ALLPERMS));
+}
+
+/*
+ * Unlinked nodes keep their blocks until the last reference is dropped,
+ * see blkfs_inactive().
+ */
+static int
+blkfs_remove(struct vnode *dvp, struct vnode *vp, char *name)
+{
+	struct blkfs_node *np = BLKFS_NODE(vp);
+	int error;
+
+	if (vp->v_type == VDIR)
+		return EISDIR;
+
+	error = blkfs_dir_del(dvp, name);
+	if (error)
+		return error;
+
+	np->di->nlink--;
+	blkfs_node_touch(vp, 0);
+	return 0;
+}
+
+static int
+blkfs_rmdir(struct vnode *dvp, struct vnode *vp, char *name)
+{
+	struct blkfs_node *np = BLKFS_NODE(vp);
+	struct blkfs_node *dnp = BLKFS_NODE(dvp);
+	int error;
+
+	if (vp->v_type != VDIR)
+		return ENOTDIR;
+
+	error = blkfs_dir_empty(vp);
+	if (error)
+		return error;
+	error = blkfs_dir_del(dvp, name);
+	if (error)
+		return error;
+
+	np->di->nlink = 0;
+	blkfs_node_touch(vp, 0);
+	dnp->di->nlink--;
+	blkfs_node_touch(dvp, 0);
+	return 0;
+}
+
+static int
+blkfs_rename(struct vnode *dvp1, struct vnode *vp1, char *name1,
+	     struct vnode *dvp2, struct vnode *vp2, char *name2)
+{
+	struct blkfs_node *np1 = BLKFS_NODE(vp1);
+	struct blkfs_node *dnp1 = BLKFS_NODE(dvp1);
+	struct blkfs_node *dnp2 = BLKFS_NODE(dvp2);
+	uint8_t type = (vp1->v_type == VDIR) ? DT_DIR : DT_REG;
+	struct blkfs_dirent de;
+	off_t off;
+	int error;
+
+	if (strlen(name2) > BLKFS_NAME_MAX)
+		return ENAMETOOLONG;
+
+	if (vp2) {
+		struct blkfs_node *np2 = BLKFS_NODE(vp2);
+
+		if (vp2->v_type == VDIR) {
+			error = blkfs_dir_empty(vp2);
+			if (error)
+				return error;
+		}
+
+		/* Point the existing destination entry to the source */
+		error = blkfs_dir_find(dvp2, name2, &de, &off);
+		if (error)
+			return error;
+		de.ino = np1->ino;
+		de.type = type;
+		error = blkfs_dir_io(dvp2, UIO_WRITE, off, &de, sizeof(de));
+		if (error)
+			return error;
+
+		if (vp2->v_type == VDIR) {
+			np2->di->nlink = 0;
+			dnp2->di->nlink--;
+		} else {
+			np2->di->nlink--;
+		}
+		blkfs_node_touch(vp2, 0);
+		blkfs_node_touch(dvp2, 1);
+	} else {
+		error = blkfs_dir_add(dvp2, name2, np1->ino, type);
+		if (error)
+			return error;
+	}
+
+	error = blkfs_dir_del(dvp1, name1);
+	if (error)
+		return error;
+
+	if (vp1->v_type == VDIR && dvp1 != dvp2) {
+		dnp1->di->nlink--;
+		dnp2->di->nlink++;
+		blkfs_node_touch(dvp2, 0);
+	}
+	blkfs_node_touch(vp1, 0);
+	return 0;
+}
+
+static int
+blkfs_readdir(struct vnode *vp, struct vfscore_file *fp, struct dirent *dir)
+{
+	struct blkfs_dirent de;
+	off_t off;
+	int error;
+
+	if (fp->f_offset == 0) {
+		dir->d_type = DT_DIR;
+		strlcpy((char *) &dir->d_name, ".", sizeof(dir->d_name));
+	} else if (fp->f_offset == 1) {
+		dir->d_type = DT_DIR;
+		strlcpy((char *) &dir->d_name, "..", sizeof(dir->d_name));
+	} else {
+		/* f_offset - 2 is the index of the next entry to look at */
+		for (;;) {
+			off = (fp->f_offset - 2) * sizeof(de);
+			if (off >= vp->v_size)
+				return ENOENT;
+
+			error = blkfs_dir_io(vp, UIO_READ, off, &de,
+					     sizeof(de));
+			if (error)
+				return error;
+			if (de.namelen)
+				break;
+			fp->f_offset++;
+		}
+		dir->d_type = de.type;
+		memcpy(dir->d_name, de.name, de.namelen);
+		dir->d_name[de.namelen] = '\0';
+	}
+	dir->d_fileno = fp->f_offset;
+
+	fp->f_offset++;
+	return 0;
+}
+
+static int
+blkfs_read(struct vnode *vp, struct vfscore_file *fp __unused,
+	   struct uio *uio, int ioflag __unused)
+{
+	if (vp->v_type == VDIR)
+		return EISDIR;
+	if (vp->v_type != VREG)
+		return EINVAL;
+	if (uio->uio_offset < 0)
+		return EINVAL;
+
+	return vfscore_pcache_read(vp, uio);
+}
+
+static int blkfs_fsync(struct vnode *vp, struct vfscore_file *fp);
+
+static int
+blkfs_write(struct vnode *vp, struct uio *uio, int ioflag)
+{
+	int error;
+
+	if (vp->v_type == VDIR)
+		return EISDIR;
+	if (vp->v_type != VREG)
+		return EINVAL;
+	if (uio->uio_offset < 0)
+		return EINVAL;
+	if (uio->uio_resid == 0)
+		return 0;
+
+	if (ioflag & IO_APPEND)
+		uio->uio_offset = vp->v_size;
+
+	error = vfscore_pcache_write(vp, uio, ioflag & ~IO_SYNC);
+	blkfs_node_touch(vp, 1);
+	if (!error && (ioflag & IO_SYNC))
+		error = blkfs_fsync(vp, NULL);
+	return error;
+}
+
+static int
+blkfs_fsync(struct vnode *vp, struct vfscore_file *fp __unused)
+{
+	struct blkfs_mount *bm = BLKFS_MOUNT(vp->v_mount);
+	struct blkfs_node *np = BLKFS_NODE(vp);
+	int error;
+
+	error = vfscore_pcache_sync(vp);
+	if (error)
+		return error;
+	error = blkfs_iext_sync(bm, np);
+	if (error)
+		return error;
+	error = blkfs_sync_meta(bm);
+	if (error)
+		return error;
+	np->map_dirty = 0;
+	return blkfs_flush(bm);
+}
+
+/*
+ * Like blkfs_fsync(), but skips the metadata write-back unless the file's
+ * size or block mapping changed: overwriting allocated blocks in place only
+ * costs the data writes and a cache flush.
+ */
+static int
+blkfs_fdatasync(struct vnode *vp, struct vfscore_file *fp __unused)
+{
+	struct blkfs_mount *bm = BLKFS_MOUNT(vp->v_mount);
+	struct blkfs_node *np = BLKFS_NODE(vp);
+	int error;
+
+	error = vfscore_pcache_sync(vp);
+	if (error)
+		return error;
+	if (np->map_dirty) {
+		error = blkfs_iext_sync(bm, np);
+		if (error)
+			return error;
+		error = blkfs_sync_meta(bm);
+		if (error)
+			return error;
+		np->map_dirty = 0;
+	}
+	return blkfs_flush(bm);
+}
+
+static int
+blkfs_getattr(struct vnode *vp, struct vattr *attr)
+{
+	struct blkfs_dinode *di = BLKFS_NODE(vp)->di;
+
+	attr->va_nodeid = vp->v_ino;
+	attr->va_size = vp->v_size;
+	attr->va_type = vp->v_type;
+	attr->va_mode = di->mode & UK_ALLPERMS;
+	attr->va_nlink = di->nlink;
+	attr->va_nblocks = di->nblocks;
+
+	blkfs_ns_to_ts(di->atime, &attr->va_atime);
+	blkfs_ns_to_ts(di->mtime, &attr->va_mtime);
+	blkfs_ns_to_ts(di->ctime, &attr->va_ctime);
+
+	return 0;
+}
+
+static int
+blkfs_setattr(struct vnode *vp, struct vattr *attr)
+{
+	struct blkfs_node *np = BLKFS_NODE(vp);
+
+	if (attr->va_mask & AT_ATIME)
+		np->di->atime = blkfs_ts_to_ns(&attr->va_atime);
+	if (attr->va_mask & AT_MTIME)
+		np->di->mtime = blkfs_ts_to_ns(&attr->va_mtime);
+	if (attr->va_mask & AT_CTIME)
+		np->di->ctime = blkfs_ts_to_ns(&attr->va_ctime);
+	if (attr->va_mask & AT_MODE) {
+		np->di->mode = (np->di->mode & ~UK_ALLPERMS) |
+			       (attr->va_mode & UK_ALLPERMS);
+		vp->v_mode = attr->va_mode & UK_ALLPERMS;
+	}
+
+	blkfs_inode_dirty(BLKFS_MOUNT(vp->v_mount), np->ino);
+	return 0;
+}
+
+static int
+blkfs_truncate(struct vnode *vp, off_t length)
+{
+	struct blkfs_mount *bm = BLKFS_MOUNT(vp->v_mount);
+	int error;
+
+	if (vp->v_type == VDIR)
+		return EISDIR;
+	if (vp->v_type != VREG)
+		return EINVAL;
+	if (length < 0)
+		return EINVAL;
+
+	error = vfscore_pcache_truncate(vp, length);
+	if (error)
+		return error;
+	if (length < vp->v_size)
+		blkfs_bmap_trunc(bm, BLKFS_NODE(vp),
+				 DIV_ROUND_UP(length, BLKFS_BSIZE));
+
+	vp->v_size = length;
+	blkfs_node_touch(vp, 1);
+	return 0;
+}
+
+/*
+ * Called when the last reference to a vnode is dropped: writes back its
+ * pages, or releases its blocks and inode if it was unlinked.
+ */
+static int
+blkfs_inactive(struct vnode *vp)
+{
+	struct blkfs_mount *bm = BLKFS_MOUNT(vp->v_mount);
+	struct blkfs_node *np = BLKFS_NODE(vp);
+	int error = 0;
+
+	/* Root vnode of a mount that failed */
+	if (!np)
+		return 0;
+
+	if (np->di->nlink == 0) {
+		vfscore_pcache_release(vp);
+		blkfs_bmap_trunc(bm, np, 0);
+		blkfs_inode_free(bm, np->ino);
+	} else {
+		error = vfscore_pcache_sync(vp);
+		if (!error)
+			error = blkfs_iext_sync(bm, np);
+		if (error)
+			uk_pr_err("blkfs: Failed to write back inode %"PRIu32": %d\n",
+				  np->ino, error);
+	}
+
+	if (np->iext)
+		uk_pfree(uk_alloc_get_default(), np->iext, 1);
+	free(np);
+	vp->v_data = NULL;
+	return error;
+}
+
+#define blkfs_open	((vnop_open_t)vfscore_vop_nullop)
+#define blkfs_close	((vnop_close_t)vfscore_vop_nullop)
+#define blkfs_seek	((vnop_seek_t)vfscore_vop_nullop)
+#define blkfs_ioctl	((vnop_ioctl_t)vfscore_vop_einval)
+#define blkfs_link	((vnop_link_t)vfscore_vop_eperm)
+#define blkfs_fallocate	((vnop_fallocate_t)vfscore_vop_nullop)
+#define blkfs_readlink	((vnop_readlink_t)vfscore_vop_einval)
+#define blkfs_symlink	((vnop_symlink_t)vfscore_vop_eperm)
+
+/*
+ * vnode operations
+ */
+struct vnops blkfs_vnops __section(".data_shared") = {
+	blkfs_open,		/* open */
+	blkfs_close,		/* close */
+	blkfs_read,		/* read */
+	blkfs_write,		/* write */
+	blkfs_seek,		/* seek */
+	blkfs_ioctl,		/* ioctl */
+	blkfs_fsync,		/* fsync */
+	blkfs_readdir,		/* readdir */
+	blkfs_lookup,		/* lookup */
+	blkfs_create,		/* create */
+	blkfs_remove,		/* remove */
+	blkfs_rename,		/* rename */
+	blkfs_mkdir,		/* mkdir */
+	blkfs_rmdir,		/* rmdir */
+	blkfs_getattr,		/* getattr */
+	blkfs_setattr,		/* setattr */
+	blkfs_inactive,		/* inactive */
+	blkfs_truncate,		/* truncate */
+	blkfs_link,		/* link */
+	(vnop_cache_t) NULL,	/* arc */
+	blkfs_fallocate,	/* fallocate */
+	blkfs_readlink,		/* read link */
+	blkfs_symlink,		/* symbolic link */
+	blkfs_fdatasync,	/* fdatasync */
+};
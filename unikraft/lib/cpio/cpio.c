@@ -46,6 +46,12 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#if CONFIG_LIBRAMFS
+#include <vfscore/file.h>
+#include <vfscore/mount.h>
+#include <vfscore/vnode.h>
+#include <ramfs/ramfs.h>
+#endif
 
 #define CPIO_MAGIC_NEWC "070701"
 #define CPIO_MAGIC_CRC "070702"
@@ -136,6 +142,41 @@ static char *absolute_path(char *path_to_prepend, char *path)
 	return abs_path;
 }
 
+#if CONFIG_LIBRAMFS
+/*
+ * Files extracted to ramfs keep their data where it is in the archive
+ * instead of getting a copy, so the initrd is not in memory twice and
+ * extraction time does not grow with the size of the files. ramfs copies
+ * the data out on the first write to a file.
+ */
+static int borrow_file_data(int fd, char *data, uint32_t size)
+{
+	struct vfscore_file *fp;
+	struct vnode *vp;
+	int rc = -1;
+
+	fp = vfscore_get_file(fd);
+	if (!fp)
+		return -1;
+
+	vp = fp->f_dentry->d_vnode;
+	if (vp->v_mount->m_op == &ramfs_vfsops) {
+		vn_lock(vp);
+		rc = ramfs_set_file_data(vp, data, size);
+		vn_unlock(vp);
+	}
+
+	vfscore_put_file(fp);
+	return rc;
+}
+#else
+static int borrow_file_data(int fd __unused, char *data __unused,
+			    uint32_t size __unused)
+{
+	return -1;
+}
+#endif /* CONFIG_LIBRAMFS */
+
 static enum cpio_error read_section(struct cpio_header **header_ptr,
 				    char *mount_loc, uintptr_t last)
 {
@@ -169,7 +210,7 @@ static enum cpio_error read_section(struct cpio_header **header_ptr,
 		*header_ptr = NULL;
 		return -CPIO_MALFORMED_FILE;
 	}
-	if (IS_FILE(header_mode) && header_filesize != 0) {
+	if (IS_FILE(header_mode)) {
 		//flexos_gate(ukdebug, uk_pr_debug, "Creating file %s...\n", path_from_root);
 		int fd = open(path_from_root, O_CREAT | O_RDWR);
 
@@ -189,6 +230,10 @@ static enum cpio_error read_section(struct cpio_header **header_ptr,
 		uint32_t bytes_to_write = header_filesize;
 		int bytes_written = 0;
 
+		if (bytes_to_write > 0
+		    && !borrow_file_data(fd, data_location, bytes_to_write))
+			bytes_to_write = 0;
+
 		while (bytes_to_write > 0) {
 			if ((bytes_written =
 				 write(fd, data_location + bytes_written,
@@ -35,6 +35,7 @@
 #include <uk/config.h>
 #include <uk/sections.h>
 #include <stdint.h>
+#include <flexos/impl/pmu.h>
 
 struct uk_alloc;
 
@@ -128,8 +129,10 @@ do {									\
 		fname(__VA_ARGS__);					\
 	} else {							\
 		_flexos_intelpku_gate_inst_in(key_from, key_to, #fname);\
+		flexos_gate_pmu_in(key_from, key_to);			\
 		_eflexos_intelpku_gate(COUNT_ARGUMENTS(__VA_ARGS__),	\
 			key_from, key_to, fname, ## __VA_ARGS__);	\
+		flexos_gate_pmu_out(key_from, key_to);			\
 		_flexos_intelpku_gate_inst_out(key_from, key_to);	\
 	}								\
 } while (0)
@@ -144,8 +147,10 @@ do {									\
 		retval = fname(__VA_ARGS__);				\
 	} else {							\
 		_flexos_intelpku_gate_inst_in(key_from, key_to, #fname);\
+		flexos_gate_pmu_in(key_from, key_to);			\
 		_eflexos_intelpku_gate_r(COUNT_ARGUMENTS(__VA_ARGS__),	\
 			key_from, key_to, retval, fname, ## __VA_ARGS__);\
+		flexos_gate_pmu_out(key_from, key_to);			\
 		_flexos_intelpku_gate_inst_out(key_from, key_to);	\
 	}								\
 } while (0)
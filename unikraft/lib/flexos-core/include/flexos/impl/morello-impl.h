@@ -2,6 +2,7 @@
 #define FLEXOS_MORELLO_IMPL_H
 
 #include <flexos/impl/morello.h>
+#include <flexos/impl/pmu.h>
 #include <uk/page.h>
 #include <uk/arch/lcpu.h>
 
@@ -316,6 +317,7 @@ do {	\
 
 #define __flexos_morello_gate0(key_from, key_to, f_ptr)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"stp c29, c19, [sp, #-32]!\n"		\
 /* x12 will hold tsb sp and x13 will hold tsb fp */ 	\
@@ -370,10 +372,12 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 #define __flexos_morello_gate0_r(key_from, key_to, retval_ptr, f_ptr)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"stp c29, c19, [sp, #-32]!\n"		\
 /* x12 will hold tsb sp and x13 will hold tsb fp */ 	\
@@ -430,10 +434,12 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 #define __flexos_morello_gate1_i_instrumented(key_from, key_to, f_ptr, arg1)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"isb\n"\
 	"mrs x15, PMCCNTR_EL0\n"\
@@ -509,11 +515,13 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 
 #define __flexos_morello_gate1_i(key_from, key_to, f_ptr, arg1)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"mov x0, %8\n"\
 	"stp c29, c19, [sp, #-32]!\n"		\
@@ -562,11 +570,13 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 
 #define __flexos_morello_gate1_r(key_from, key_to, retval_ptr, f_ptr, arg1)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 	\
 	if (IS_CAP(arg1)) {	\
  		flexos_morello_move_arg_cap_into_reg(arg1, 1);	\
@@ -636,11 +646,13 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 
 #define __flexos_morello_gate1_rword(key_from, key_to, retval_ptr, f_ptr, arg1)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 	\
 	if (IS_CAP(arg1)) {	\
  		flexos_morello_move_arg_cap_into_reg(arg1, 1);	\
@@ -713,10 +725,12 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 #define __flexos_morello_gate1_rword_i(key_from, key_to, retval_ptr, f_ptr, arg1)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"mov x0, %9\n"\
 	"stp c29, c19, [sp, #-32]!\n"		\
@@ -774,11 +788,13 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 
 #define __flexos_morello_gate1_rword_c(key_from, key_to, retval_ptr, f_ptr, arg1)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"mov c0, %9\n"\
 	"stp c29, c19, [sp, #-32]!\n"		\
@@ -836,11 +852,13 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 /*There is an issue where if you enter a compartment from a different place you may break the sp/fp, this needs fixing someday*/
 #define __flexos_morello_gate2_ii(key_from, key_to, f_ptr, arg1, arg2)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 	/* todo \
 * - backup registers we need first, come back to this */ \
 \
@@ -901,11 +919,13 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 
 #define __flexos_morello_gate2_ci(key_from, key_to, f_ptr, arg1, arg2)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 	/* todo \
 * - backup registers we need first, come back to this */ \
 \
@@ -966,11 +986,13 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 
 #define __flexos_morello_gate2_r(key_from, key_to, retval_ptr, f_ptr, arg1, arg2)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 	\
 	if (IS_CAP(arg1)) {	\
  		flexos_morello_move_arg_cap_into_reg(arg1, 1);	\
@@ -1049,10 +1071,12 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 #define __flexos_morello_gate2_r_word_ii(key_from, key_to, retval_ptr, f_ptr, arg1, arg2)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"mov x0, %9\n"\
 	"mov x1, %10\n"\
@@ -1111,10 +1135,12 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 #define __flexos_morello_gate3_r_pii(key_from, key_to, retval_ptr, f_ptr, arg1, arg2, arg3)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"mov x0, %9\n"\
 	"mov x1, %10\n"\
@@ -1174,10 +1200,12 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 #define __flexos_morello_gate3_r_word_pii(key_from, key_to, retval_ptr, f_ptr, arg1, arg2, arg3)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"mov x0, %9\n"\
 	"mov x1, %10\n"\
@@ -1239,10 +1267,12 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 #define __flexos_morello_gate4(key_from, key_to, f_ptr, arg1, arg2, arg3, arg4)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 	\
 	if (IS_CAP(arg1)) {	\
  		flexos_morello_move_arg_cap_into_reg(arg1, 1);	\
@@ -1333,11 +1363,13 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 
 #define __flexos_morello_gate4_variant1(key_from, key_to, f_ptr, arg1, arg2, arg3, arg4)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"mov c0, %8\n"\
 	"mov c1, %9\n"\
@@ -1398,10 +1430,12 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 #define __flexos_morello_gate4_r_word_iiii(key_from, key_to, retval_ptr, f_ptr, arg1, arg2, arg3, arg4)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"mov x0, %9\n"\
 	"mov x1, %10\n"\
@@ -1464,6 +1498,7 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 
@@ -1472,6 +1507,7 @@ __asm__ volatile (	\
 
 #define __flexos_morello_gate4_r_cici(key_from, key_to, retval_ptr, f_ptr, arg1, arg2, arg3, arg4)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 __asm__ volatile (	\
 	"mov c0, %9\n"\
 	"mov x1, %10\n"\
@@ -1534,11 +1570,13 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 
 #define __flexos_morello_gate7_r(key_from, key_to, retval_ptr, f_ptr, arg1, arg2, arg3, arg4, arg5, arg6, arg7)\
 do {									\
+	flexos_gate_pmu_in(key_from, key_to);			\
 	\
 	 	if (IS_CAP(arg1)) {	\
  		flexos_morello_move_arg_cap_into_reg(arg1, 1);	\
@@ -1641,6 +1679,7 @@ __asm__ volatile (	\
 \
 \
 \
+	flexos_gate_pmu_out(key_from, key_to);			\
 } while (0)
 
 
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FLEXOS_PMU_H
+#define FLEXOS_PMU_H
+
+#include <uk/config.h>
+
+/* Gate instrumentation shared by the backends: with
+ * CONFIG_LIBUKBENCH_PMU_COMPARTMENTS, PMU event counts are charged to the
+ * compartment that ran since the previous gate (see lib/ukbench).
+ * Called in the source compartment, before the gate has touched any
+ * register and after it has stored the return value.
+ */
+#if CONFIG_LIBUKBENCH_PMU_COMPARTMENTS
+#include <uk/pmu.h>
+
+#define flexos_gate_pmu_in(key_from, key_to)				\
+	uk_pmu_gate_enter(key_from, key_to)
+#define flexos_gate_pmu_out(key_from, key_to)				\
+	uk_pmu_gate_exit(key_from, key_to)
+#else
+#define flexos_gate_pmu_in(key_from, key_to)
+#define flexos_gate_pmu_out(key_from, key_to)
+#endif
+
+#endif /* FLEXOS_PMU_H */
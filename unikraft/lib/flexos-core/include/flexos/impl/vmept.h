@@ -257,6 +257,12 @@ static inline __attribute__((always_inline)) void flexos_vmept_init_master_rpc_c
 
 int flexos_vmept_master_rpc_call(uint8_t key_from, uint8_t key_to, uint8_t local_tid, uint8_t action);
 
+/* split version of flexos_vmept_master_rpc_call: the master rpc ctrl of each
+ * compartment is independent, so a caller can post calls to several
+ * compartments first and only then wait for each of them to return */
+void flexos_vmept_master_rpc_send(uint8_t key_from, uint8_t key_to, uint8_t local_tid, uint8_t action);
+int flexos_vmept_master_rpc_wait(uint8_t key_to);
+
 int flexos_vmept_master_rpc_call_main(uint8_t key_from, uint8_t key_to, uint8_t local_tid, uint8_t action);
 
 void flexos_vmept_wait_for_rpc();
@@ -295,7 +295,7 @@ void flexos_vmept_master_rpc_loop()
 	}
 }
 
-int flexos_vmept_master_rpc_call(uint8_t key_from, uint8_t key_to, uint8_t local_tid, uint8_t action)
+void flexos_vmept_master_rpc_send(uint8_t key_from, uint8_t key_to, uint8_t local_tid, uint8_t action)
 {
 	volatile struct flexos_vmept_master_rpc_ctrl *master_ctrl = flexos_vmept_master_rpc_ctrl(key_to);
 	FLEXOS_VMEPT_DEBUG_PRINT(("Making master rpc call from comp %d to comp %d (master_ctrl at %p) with local_tid=%d, action=%d.\n", key_from, key_to, master_ctrl, local_tid, action));
@@ -315,6 +315,11 @@ int flexos_vmept_master_rpc_call(uint8_t key_from, uint8_t key_to, uint8_t local
 
 	// important: state should always be the last field that is set
 	master_ctrl->state = FLEXOS_VMEPT_MASTER_RPC_STATE_CALLED;
+}
+
+int flexos_vmept_master_rpc_wait(uint8_t key_to)
+{
+	volatile struct flexos_vmept_master_rpc_ctrl *master_ctrl = flexos_vmept_master_rpc_ctrl(key_to);
 
 	// wait for call to return
 	while ((master_ctrl->state & FLEXOS_VMEPT_MASTER_RPC_STATE_CONSTANT_MASK) != FLEXOS_VMEPT_MASTER_RPC_STATE_RETURNED) {
@@ -328,6 +333,12 @@ int flexos_vmept_master_rpc_call(uint8_t key_from, uint8_t key_to, uint8_t local
 	return ret;
 }
 
+int flexos_vmept_master_rpc_call(uint8_t key_from, uint8_t key_to, uint8_t local_tid, uint8_t action)
+{
+	flexos_vmept_master_rpc_send(key_from, key_to, local_tid, action);
+	return flexos_vmept_master_rpc_wait(key_to);
+}
+
 
 void flexos_vmept_create_rpc_loop_thread()
 {
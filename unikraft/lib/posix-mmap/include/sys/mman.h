@@ -47,6 +47,13 @@
 #define MAP_ANONYMOUS	0x20
 #define MAP_ANON	MAP_ANONYMOUS
 
+#define MS_ASYNC	0x1
+#define MS_INVALIDATE	0x2
+#define MS_SYNC		0x4
+
+#define MREMAP_MAYMOVE	0x1
+#define MREMAP_FIXED	0x2
+
 void *mmap(void *addr, size_t length, int prot, int flags,
 		   int fd, off_t offset);
 
@@ -56,4 +63,7 @@ int mprotect(void *addr, size_t len, int prot);
 
 int msync(void *addr, size_t length, int flags);
 
+void *mremap(void *old_address, size_t old_size, size_t new_size,
+	     int flags, ... /* void *new_address */);
+
 #endif /* __POSIX_MMAP__ */
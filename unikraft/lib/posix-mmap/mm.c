@@ -31,6 +31,8 @@
  */
 
 #include <errno.h>
+#include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -42,52 +44,374 @@
 
 #include <sys/mman.h>
 
+#if CONFIG_LIBPOSIX_MMAP_FILE
+#include <vfscore/dentry.h>
+#include <vfscore/file.h>
+#include <vfscore/fs.h>
+#include <vfscore/vnode.h>
+#endif /* CONFIG_LIBPOSIX_MMAP_FILE */
+
+#include "vma.h"
+
+static int libc_to_internal_prot(int prot)
+{
+	int page_prot = PAGE_PROT_NONE;
+
+	if (prot & PROT_READ)
+		page_prot |= PAGE_PROT_READ;
+	if (prot & PROT_WRITE)
+		page_prot |= PAGE_PROT_WRITE;
+	if (prot & PROT_EXEC)
+		page_prot |= PAGE_PROT_EXEC;
+
+	return page_prot;
+}
+
 /*
- * XXX
- * This does for now a linear search, starting from |start|, looking for a
- * memory area with |length| bytes (aligned to page size)
+ * Maps zeroed pages at [area, area + length). Pages that are mapped already
+ * make it fail unless `overwrite` is set. Nothing stays mapped on failure.
  */
-static unsigned long get_free_virtual_area(unsigned long start, size_t length)
+static int map_anon_pages(unsigned long area, size_t length, int prot,
+			  int overwrite)
 {
-	unsigned long page;
+	unsigned long page, page_prot;
+	size_t i;
+
+	for (i = 0; i < length; i += PAGE_SIZE) {
+		page = area + i;
+		if ((!overwrite && PAGE_PRESENT(uk_virt_to_pte(page)))
+		    || uk_page_map(page, PAGE_PADDR_ANY,
+				   PAGE_PROT_READ | PAGE_PROT_WRITE, 0)) {
+			while (i) {
+				i -= PAGE_SIZE;
+				uk_page_unmap(area + i);
+			}
+			return -1;
+		}
+	}
+
+	/* MAP_ANONYMOUS pages are zeroed out */
+	/*
+	 * XXX: there is a bug when building with performance
+	 * optimizations flag that make this memset loop infintely.
+	 * Using for loop for now.
+	 */
+	/* memset((void *) area, 0, length); */
+	for (i = 0; i < length / sizeof(unsigned long); i++)
+		*((unsigned long *) area + i) = 0;
 
-	if (!PAGE_ALIGNED(length))
+	page_prot = libc_to_internal_prot(prot);
+	for (page = area; page < area + length; page += PAGE_SIZE)
+		uk_page_set_prot(page, page_prot);
+
+	return 0;
+}
+
+/*
+ * Splits `vma` at `addr`: `vma` keeps [start, addr) and the returned area
+ * covers [addr, end).
+ */
+static struct vma *vma_split(struct vma *vma, unsigned long addr)
+{
+	struct vma *tail;
+
+	tail = malloc(sizeof(*tail));
+	if (!tail)
+		return NULL;
+
+	vma_remove(vma);
+	*tail = *vma;
+	vma->end = addr;
+	tail->start = addr;
+	vma_insert(vma);
+	vma_insert(tail);
+	return tail;
+}
+
+/* Returns the part of `vma` that lies in [start, end), split off as needed */
+static struct vma *vma_clip(struct vma *vma, unsigned long start,
+			    unsigned long end)
+{
+	if (vma->start < start) {
+		vma = vma_split(vma, start);
+		if (!vma)
+			return NULL;
+	}
+	if (vma->end > end && !vma_split(vma, end))
+		return NULL;
+	return vma;
+}
+
+#if CONFIG_LIBPOSIX_MMAP_FILE
+/*
+ * File mappings alias the frames of the memory that the file system keeps
+ * the file in (see VOP_MAP), so loads and stores go straight to the file.
+ * Private mappings start out read-only and get a private copy of a page on
+ * the first write to it.
+ */
+#define MMAP_PAGE_PROT	0x07	/* PROT_* the page was mapped with */
+#define MMAP_PAGE_COW	0x10	/* private page has its own copy */
+#define MMAP_PAGE_GONE	0x20	/* page was unmapped */
+
+/* Shared by all areas that a file mapping got split into */
+struct mmap_file {
+	struct vfscore_mapping vm;
+	struct vnode *vp;
+	unsigned long start;
+	unsigned long pages;
+	unsigned long live;		/* pages not unmapped yet */
+	int flags;
+	unsigned char *state;		/* MMAP_PAGE_* for each page */
+};
+
+static char cow_bounce[PAGE_SIZE] __align(PAGE_SIZE);
+
+static struct mmap_file *mmap_file_find(unsigned long page, unsigned long *idx)
+{
+	struct vma *vma;
+
+	vma = vma_find(page);
+	if (!vma || !vma->file)
+		return NULL;
+
+	*idx = (page - vma->file->start) >> PAGE_SHIFT;
+	return vma->file;
+}
+
+/* The heap that file data lives in may be mapped with large pages */
+static unsigned long page_to_paddr(unsigned long vaddr)
+{
+	unsigned long pte = uk_virt_to_pte(vaddr);
+
+	if (!PAGE_PRESENT(pte))
+		return PAGE_INVALID;
+	if (PAGE_LARGE(pte))
+		return (PTE_REMOVE_FLAGS(pte) & ~(PAGE_LARGE_SIZE - 1))
+			+ (vaddr & (PAGE_LARGE_SIZE - 1));
+	return PTE_REMOVE_FLAGS(pte);
+}
+
+static int alias_page(unsigned long vaddr, unsigned long src,
+		      unsigned long prot)
+{
+	unsigned long paddr = page_to_paddr(src);
+
+	if (paddr == PAGE_INVALID)
 		return -1;
+	return uk_page_map(vaddr, paddr, prot, 0);
+}
 
-	while (start <= MMAP_AREA_END - length) {
-		for (page = start; page < start + length; page += PAGE_SIZE) {
-			if (PAGE_PRESENT(uk_virt_to_pte(page)))
-				break;
-		}
+/* Remove an alias without releasing the frame, it belongs to the file */
+static void unalias_page(unsigned long vaddr)
+{
+	unsigned long pte = uk_virt_to_pte(vaddr);
+
+	if (!PAGE_PRESENT(pte))
+		return;
+	uk_page_unmap(vaddr);
+	uk_frame_reserve(pte_to_pfn(pte) << PAGE_SHIFT, PAGE_SIZE, 1);
+}
 
-		if (page == start + length)
-			return start;
+static unsigned long file_page_prot(struct mmap_file *m, unsigned long i)
+{
+	unsigned long prot;
 
-		start = page + PAGE_SIZE;
+	prot = libc_to_internal_prot(m->state[i] & MMAP_PAGE_PROT);
+	if ((m->flags & MAP_PRIVATE) && !(m->state[i] & MMAP_PAGE_COW))
+		prot &= ~PAGE_PROT_WRITE;
+	return prot;
+}
+
+/* The file system moved the file data, follow it */
+static void mmap_file_moved(struct vfscore_mapping *vm, void *addr)
+{
+	struct mmap_file *m = __containerof(vm, struct mmap_file, vm);
+	unsigned long i, page;
+
+	for (i = 0; i < m->pages; i++) {
+		if (m->state[i] & (MMAP_PAGE_COW | MMAP_PAGE_GONE))
+			continue;
+
+		page = m->start + (i << PAGE_SHIFT);
+		unalias_page(page);
+		if (alias_page(page, (unsigned long) addr + (i << PAGE_SHIFT),
+			       file_page_prot(m, i)))
+			uk_pr_err("Could not remap file page %p\n",
+				  (void *) page);
 	}
+}
+
+static int mmap_file(struct vma *vma, int fd, off_t offset)
+{
+	unsigned long length = vma->end - vma->start;
+	struct vfscore_file *fp;
+	struct mmap_file *m;
+	struct vnode *vp;
+	unsigned long i;
+	void *base;
+	int rc;
+
+	fp = vfscore_get_file(fd);
+	if (!fp)
+		return EBADF;
+
+	if (!fp->f_dentry || !fp->f_dentry->d_vnode->v_op->vop_map) {
+		rc = ENODEV;
+		goto out;
+	}
+	vp = fp->f_dentry->d_vnode;
+
+	if (!(fp->f_flags & UK_FREAD) || ((vma->flags & MAP_SHARED)
+	    && (vma->prot & PROT_WRITE) && !(fp->f_flags & UK_FWRITE))) {
+		rc = EACCES;
+		goto out;
+	}
+
+	m = calloc(1, sizeof(*m));
+	if (!m) {
+		rc = ENOMEM;
+		goto out;
+	}
+	m->pages = length >> PAGE_SHIFT;
+	m->state = malloc(m->pages);
+	if (!m->state) {
+		rc = ENOMEM;
+		goto out_free;
+	}
+	memset(m->state, vma->prot & MMAP_PAGE_PROT, m->pages);
+	m->vm.vm_off = offset;
+	m->vm.vm_len = length;
+	m->vm.vm_moved = mmap_file_moved;
+	m->vp = vp;
+	m->start = vma->start;
+	m->live = m->pages;
+	m->flags = vma->flags;
+
+	vn_lock(vp);
+	rc = VOP_MAP(vp, &m->vm, &base);
+	if (rc) {
+		vn_unlock(vp);
+		goto out_free;
+	}
+
+	for (i = 0; i < m->pages; i++) {
+		if (alias_page(m->start + (i << PAGE_SHIFT),
+			       (unsigned long) base + (i << PAGE_SHIFT),
+			       file_page_prot(m, i))) {
+			while (i--)
+				unalias_page(m->start + (i << PAGE_SHIFT));
+			VOP_UNMAP(vp, &m->vm);
+			vn_unlock(vp);
+			rc = ENOMEM;
+			goto out_free;
+		}
+	}
+
+	/* The mapping keeps the file around until it is unmapped */
+	vref(vp);
+	vn_unlock(vp);
+	vma->file = m;
+	vfscore_put_file(fp);
+	return 0;
 
-	return -1;
+out_free:
+	free(m->state);
+	free(m);
+out:
+	vfscore_put_file(fp);
+	return rc;
 }
 
-static int libc_to_internal_prot(int prot)
+/*
+ * Shared mappings need no write-back since they are the file's memory;
+ * the file system is asked to sync once the last page is gone.
+ */
+static void munmap_file_page(struct mmap_file *m, unsigned long page)
 {
-	int page_prot = PAGE_PROT_NONE;
+	unsigned long i = (page - m->start) >> PAGE_SHIFT;
 
-	if (prot & PROT_READ)
-		page_prot |= PAGE_PROT_READ;
-	if (prot & PROT_WRITE)
-		page_prot |= PAGE_PROT_WRITE;
-	if (prot & PROT_EXEC)
-		page_prot |= PAGE_PROT_EXEC;
+	if (m->state[i] & MMAP_PAGE_COW)
+		uk_page_unmap(page);
+	else
+		unalias_page(page);
+	m->state[i] |= MMAP_PAGE_GONE;
+
+	if (--m->live)
+		return;
+
+	vn_lock(m->vp);
+	if (m->flags & MAP_SHARED)
+		VOP_FSYNC(m->vp, NULL);
+	VOP_UNMAP(m->vp, &m->vm);
+	vn_unlock(m->vp);
+	vrele(m->vp);
+
+	free(m->state);
+	free(m);
+}
 
-	return page_prot;
+static unsigned long mprotect_file_page(struct mmap_file *m,
+					unsigned long page, int prot)
+{
+	unsigned long i = (page - m->start) >> PAGE_SHIFT;
+
+	m->state[i] = (m->state[i] & ~MMAP_PAGE_PROT) | (prot & MMAP_PAGE_PROT);
+	return file_page_prot(m, i);
 }
+
+/* Copy-on-write for private file mappings */
+int uk_page_fault_handle(unsigned long vaddr, int write)
+{
+	unsigned long page = PAGE_ALIGN_DOWN(vaddr);
+	struct mmap_file *m;
+	unsigned long i;
+
+	if (!write)
+		return -1;
+
+	m = mmap_file_find(page, &i);
+	if (!m || !(m->flags & MAP_PRIVATE) || (m->state[i] & MMAP_PAGE_COW)
+	    || !(m->state[i] & PROT_WRITE))
+		return -1;
+
+	memcpy(cow_bounce, (void *) page, PAGE_SIZE);
+	unalias_page(page);
+	if (uk_page_map(page, PAGE_PADDR_ANY,
+			PAGE_PROT_READ | PAGE_PROT_WRITE, 0))
+		return -1;
+	memcpy((void *) page, cow_bounce, PAGE_SIZE);
+
+	m->state[i] |= MMAP_PAGE_COW;
+	uk_page_set_prot(page, file_page_prot(m, i));
+	return 0;
+}
+#endif /* CONFIG_LIBPOSIX_MMAP_FILE */
+
+/* Unmaps the pages of `vma` and drops it */
+static void vma_unmap(struct vma *vma)
+{
+	unsigned long page;
+
+	for (page = vma->start; page < vma->end; page += PAGE_SIZE) {
+#if CONFIG_LIBPOSIX_MMAP_FILE
+		if (vma->file) {
+			munmap_file_page(vma->file, page);
+			continue;
+		}
+#endif /* CONFIG_LIBPOSIX_MMAP_FILE */
+		uk_page_unmap(page);
+	}
+
+	vma_remove(vma);
+	free(vma);
+}
+
 UK_SYSCALL_DEFINE(void *, mmap, void *, addr, size_t, length, int, prot,
 		int, flags, int, fd, off_t, offset)
 {
 	unsigned long page_addr = (unsigned long) addr;
-	unsigned long area_to_map, page_prot, page;
-	size_t i;
+	unsigned long area_to_map;
+	struct vma *vma;
 
 	if (flags & MAP_ANONYMOUS) {
 		if (fd != -1 || offset) {
@@ -95,9 +419,15 @@ UK_SYSCALL_DEFINE(void *, mmap, void *, addr, size_t, length, int, prot,
 			return MAP_FAILED;
 		}
 	} else {
-		/* TODO: We don't currently support mapping files */
+#if CONFIG_LIBPOSIX_MMAP_FILE
+		if (fd < 0 || !PAGE_ALIGNED((unsigned long) offset)) {
+			errno = (fd < 0) ? EBADF : EINVAL;
+			return MAP_FAILED;
+		}
+#else
 		errno = ENOTSUP;
 		return MAP_FAILED;
+#endif /* CONFIG_LIBPOSIX_MMAP_FILE */
 	}
 
 
@@ -119,15 +449,16 @@ UK_SYSCALL_DEFINE(void *, mmap, void *, addr, size_t, length, int, prot,
 	}
 
 	if (flags & MAP_FIXED) {
-		/* Discard any overlapping mappings */
-		// TODO: bug when unmapping memory from static pagetable
 		/*
-		if (munmap(addr, length)) {
-			errno = EINVAL;
+		 * Discard any overlapping mappings. Only areas created by
+		 * mmap are tracked, so this leaves the static page tables
+		 * alone.
+		 */
+		page_addr = PAGE_ALIGN_UP(page_addr);
+		if (munmap((void *) page_addr, length)) {
+			errno = ENOMEM;
 			return MAP_FAILED;
 		}
-		*/
-		page_addr = PAGE_ALIGN_UP(page_addr);
 		area_to_map = page_addr;
 	} else {
 		if ((void *) page_addr == NULL || page_addr < MMAP_AREA_START)
@@ -135,7 +466,12 @@ UK_SYSCALL_DEFINE(void *, mmap, void *, addr, size_t, length, int, prot,
 		else
 			page_addr = PAGE_ALIGN_UP(page_addr);
 
-		area_to_map = get_free_virtual_area(page_addr, length);
+		/* Treat the address as a hint and fall back to first fit */
+		area_to_map = vma_gap_find(page_addr, MMAP_AREA_END, length);
+		if (area_to_map == (unsigned long) -1
+		    && page_addr != MMAP_AREA_START)
+			area_to_map = vma_gap_find(MMAP_AREA_START,
+						   MMAP_AREA_END, length);
 	}
 
 	if (area_to_map == (unsigned long) -1) {
@@ -143,41 +479,46 @@ UK_SYSCALL_DEFINE(void *, mmap, void *, addr, size_t, length, int, prot,
 		return MAP_FAILED;
 	}
 
-	for (i = 0; i < length; i += PAGE_SIZE) {
-		page = area_to_map + i;
-		if (uk_page_map(page, PAGE_PADDR_ANY,
-				PAGE_PROT_READ | PAGE_PROT_WRITE, 0)) {
-			munmap((void *) area_to_map, length);
-			errno = ENOMEM;
+	vma = malloc(sizeof(*vma));
+	if (!vma) {
+		errno = ENOMEM;
+		return MAP_FAILED;
+	}
+	vma->start = area_to_map;
+	vma->end = area_to_map + length;
+	vma->prot = prot;
+	vma->flags = flags;
+	vma->file = NULL;
+
+#if CONFIG_LIBPOSIX_MMAP_FILE
+	if (!(flags & MAP_ANONYMOUS)) {
+		int rc = mmap_file(vma, fd, offset);
+
+		if (rc) {
+			free(vma);
+			errno = rc;
 			return MAP_FAILED;
 		}
+		vma_insert(vma);
+		return (void *) area_to_map;
 	}
+#endif /* CONFIG_LIBPOSIX_MMAP_FILE */
 
-	if (flags & MAP_ANONYMOUS) {
-		/* MAP_ANONYMOUS pages are zeroed out */
-		/*
-		 * XXX: there is a bug when building with performance
-		 * optimizations flag that make this memset loop infintely.
-		 * Using for loop for now.
-		 */
-		/* memset((void *) area_to_map, 0, length); */
-		for (i = 0; i < length / sizeof(unsigned long); i++)
-			*((unsigned long *) area_to_map + i) = 0;
-	} else {
-		/* TODO: file mapping */
+	if (map_anon_pages(area_to_map, length, prot, 1)) {
+		free(vma);
+		errno = ENOMEM;
+		return MAP_FAILED;
 	}
 
-	page_prot = libc_to_internal_prot(prot);
-	for (page = area_to_map; page < area_to_map + length; page += PAGE_SIZE)
-		uk_page_set_prot(page, page_prot);
-
+	vma_insert(vma);
 	return (void *) area_to_map;
 }
 
 UK_SYSCALL_DEFINE(int, munmap, void *, addr, size_t, length)
 {
 	unsigned long start = (unsigned long) addr;
-	unsigned long page;
+	unsigned long end;
+	struct vma *vma;
 
 	if (!PAGE_ALIGNED(start)) {
 		errno = EINVAL;
@@ -188,8 +529,21 @@ UK_SYSCALL_DEFINE(int, munmap, void *, addr, size_t, length)
 		return 0;
 
 	length = PAGE_ALIGN_UP(length);
-	for (page = start; page < start + length; page += PAGE_SIZE)
-		uk_page_unmap(page);
+	end = start + length;
+	if (end < start) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	while ((vma = vma_next(start)) && vma->start < end) {
+		vma = vma_clip(vma, start, end);
+		if (!vma) {
+			errno = ENOMEM;
+			return -1;
+		}
+		start = vma->end;
+		vma_unmap(vma);
+	}
 
 	return 0;
 }
@@ -197,9 +551,10 @@ UK_SYSCALL_DEFINE(int, munmap, void *, addr, size_t, length)
 UK_SYSCALL_DEFINE(int, mprotect, void*, addr, size_t, length, int, prot)
 {
 	unsigned long start = (unsigned long) addr;
-	unsigned long page_prot, page;
+	unsigned long page_prot, page, end, next;
+	struct vma *vma;
 
-	if (PAGE_ALIGNED(start)) {
+	if (!PAGE_ALIGNED(start)) {
 		errno = EINVAL;
 		return -1;
 	}
@@ -212,23 +567,236 @@ UK_SYSCALL_DEFINE(int, mprotect, void*, addr, size_t, length, int, prot)
 		return -1;
 	}
 
-	page_prot = PAGE_PROT_NONE;
-	if (prot & PROT_READ)
-		page_prot |= PAGE_PROT_READ;
-	if (prot & PROT_WRITE)
-		page_prot |= PAGE_PROT_WRITE;
-	if (prot & PROT_EXEC)
-		page_prot |= PAGE_PROT_EXEC;
+	page_prot = libc_to_internal_prot(prot);
 
 	length = PAGE_ALIGN_UP(length);
-	for (page = start; page < start + length; page += PAGE_SIZE)
-		uk_page_set_prot(page, page_prot);
+	end = start + length;
+	while (start < end) {
+		vma = vma_find(start);
+		if (!vma) {
+			/* Not mapped by mmap, only change the page tables */
+			vma = vma_next(start);
+			next = (vma && vma->start < end) ? vma->start : end;
+			for (page = start; page < next; page += PAGE_SIZE)
+				uk_page_set_prot(page, page_prot);
+			start = next;
+			continue;
+		}
+
+		vma = vma_clip(vma, start, end);
+		if (!vma) {
+			errno = ENOMEM;
+			return -1;
+		}
+		vma->prot = prot;
+
+		for (page = vma->start; page < vma->end; page += PAGE_SIZE) {
+#if CONFIG_LIBPOSIX_MMAP_FILE
+			if (vma->file) {
+				uk_page_set_prot(page,
+					mprotect_file_page(vma->file, page,
+							   prot));
+				continue;
+			}
+#endif /* CONFIG_LIBPOSIX_MMAP_FILE */
+			uk_page_set_prot(page, page_prot);
+		}
+		start = vma->end;
+	}
 
 	return 0;
 }
 
-int msync(void *addr __unused, size_t length __unused, int flags __unused)
+/* Moves the frames of [src, src + length) to `dst` without copying them */
+static void move_pages(unsigned long src, unsigned long dst, size_t length,
+		       int prot)
 {
-	errno = ENOTSUP;
-	return -1;
+	unsigned long page_prot = libc_to_internal_prot(prot);
+	unsigned long pte;
+	size_t i;
+
+	for (i = 0; i < length; i += PAGE_SIZE) {
+		pte = uk_virt_to_pte(src + i);
+		if (!PAGE_PRESENT(pte))
+			continue;
+
+		uk_page_unmap(src + i);
+		if (uk_page_map(dst + i, PTE_REMOVE_FLAGS(pte), page_prot, 0))
+			uk_pr_err("Could not move page %p to %p\n",
+				  (void *) (src + i), (void *) (dst + i));
+	}
+}
+
+void *mremap(void *old_address, size_t old_size, size_t new_size,
+	     int flags, ...)
+{
+	unsigned long start = (unsigned long) old_address;
+	unsigned long target = 0;
+	struct vma *vma, *next;
+	va_list ap;
+
+	if (!PAGE_ALIGNED(start) || !new_size
+	    || (flags & ~(MREMAP_MAYMOVE | MREMAP_FIXED))
+	    || ((flags & MREMAP_FIXED) && !(flags & MREMAP_MAYMOVE))) {
+		errno = EINVAL;
+		return MAP_FAILED;
+	}
+
+	if (flags & MREMAP_FIXED) {
+		va_start(ap, flags);
+		target = (unsigned long) va_arg(ap, void *);
+		va_end(ap);
+		if (!PAGE_ALIGNED(target)) {
+			errno = EINVAL;
+			return MAP_FAILED;
+		}
+	}
+
+	old_size = PAGE_ALIGN_UP(old_size);
+	new_size = PAGE_ALIGN_UP(new_size);
+	if (!old_size || !new_size) {
+		errno = !new_size ? ENOMEM : EINVAL;
+		return MAP_FAILED;
+	}
+
+	vma = vma_find(start);
+	if (!vma || start + old_size > vma->end || start + old_size < start) {
+		errno = EFAULT;
+		return MAP_FAILED;
+	}
+
+	if (!(flags & MREMAP_FIXED) && new_size <= old_size) {
+		if (new_size < old_size
+		    && munmap((void *) (start + new_size), old_size - new_size))
+			return MAP_FAILED;
+		return old_address;
+	}
+
+	/*
+	 * Growing or moving a file mapping would need the file system to
+	 * extend what it maps, which VOP_MAP does not support
+	 */
+	if (vma->file) {
+		errno = EINVAL;
+		return MAP_FAILED;
+	}
+
+	/* Only MREMAP_FIXED gets here when shrinking, drop the tail first */
+	if (new_size < old_size) {
+		if (munmap((void *) (start + new_size), old_size - new_size))
+			return MAP_FAILED;
+		old_size = new_size;
+	}
+
+	/* Grow in place if nothing follows the area */
+	if (!(flags & MREMAP_FIXED) && start + old_size == vma->end) {
+		next = vma_next(vma->end);
+		if (start + new_size > start
+		    && (!next || next->start >= start + new_size)
+		    && !map_anon_pages(vma->end, start + new_size - vma->end,
+				       vma->prot, 0)) {
+			vma_remove(vma);
+			vma->end = start + new_size;
+			vma_insert(vma);
+			return old_address;
+		}
+	}
+
+	if (!(flags & MREMAP_MAYMOVE)) {
+		errno = ENOMEM;
+		return MAP_FAILED;
+	}
+
+	if (flags & MREMAP_FIXED) {
+		if (target + new_size <= target
+		    || (target < start + old_size
+			&& start < target + new_size)) {
+			errno = EINVAL;
+			return MAP_FAILED;
+		}
+		if (munmap((void *) target, new_size))
+			return MAP_FAILED;
+	} else {
+		target = vma_gap_find(MMAP_AREA_START, MMAP_AREA_END, new_size);
+		if (target == (unsigned long) -1) {
+			errno = ENOMEM;
+			return MAP_FAILED;
+		}
+	}
+
+	/* munmap above may have split it */
+	vma = vma_clip(vma_find(start), start, start + old_size);
+	if (!vma) {
+		errno = ENOMEM;
+		return MAP_FAILED;
+	}
+
+	if (new_size > old_size
+	    && map_anon_pages(target + old_size, new_size - old_size,
+			      vma->prot, 1)) {
+		errno = ENOMEM;
+		return MAP_FAILED;
+	}
+	move_pages(start, target, old_size, vma->prot);
+
+	vma_remove(vma);
+	vma->start = target;
+	vma->end = target + new_size;
+	vma_insert(vma);
+
+	return (void *) target;
+}
+
+int msync(void *addr, size_t length, int flags)
+{
+	unsigned long start = (unsigned long) addr;
+	unsigned long page;
+#if CONFIG_LIBPOSIX_MMAP_FILE
+	struct mmap_file *m;
+	struct vma *vma;
+	unsigned long end;
+	int rc;
+#endif /* CONFIG_LIBPOSIX_MMAP_FILE */
+
+	if (!PAGE_ALIGNED(start)
+	    || (flags & ~(MS_ASYNC | MS_SYNC | MS_INVALIDATE))
+	    || ((flags & MS_ASYNC) && (flags & MS_SYNC))) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	length = PAGE_ALIGN_UP(length);
+	for (page = start; page < start + length; page += PAGE_SIZE) {
+		if (!PAGE_PRESENT(uk_virt_to_pte(page))) {
+			errno = ENOMEM;
+			return -1;
+		}
+	}
+
+#if CONFIG_LIBPOSIX_MMAP_FILE
+	/* Stores to shared mappings already are in the file's memory, so
+	 * only MS_SYNC has something left to do: let the file system write
+	 * the file back.
+	 */
+	if (!(flags & MS_SYNC))
+		return 0;
+
+	end = start + length;
+	while ((vma = vma_next(start)) && vma->start < end) {
+		start = vma->end;
+		m = vma->file;
+		if (!m || !(m->flags & MAP_SHARED))
+			continue;
+
+		vn_lock(m->vp);
+		rc = VOP_FSYNC(m->vp, NULL);
+		vn_unlock(m->vp);
+		if (rc) {
+			errno = rc;
+			return -1;
+		}
+	}
+#endif /* CONFIG_LIBPOSIX_MMAP_FILE */
+
+	return 0;
 }
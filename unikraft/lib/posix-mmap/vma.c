@@ -0,0 +1,253 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stddef.h>
+
+#include "vma.h"
+
+static struct vma *vma_root;
+
+static inline int vma_height(struct vma *n)
+{
+	return n ? n->height : 0;
+}
+
+static void vma_update(struct vma *n)
+{
+	struct vma *l = n->left, *r = n->right;
+	unsigned long gap = 0;
+
+	n->height = 1 + MAX(vma_height(l), vma_height(r));
+	n->min_start = l ? l->min_start : n->start;
+	n->max_end = r ? r->max_end : n->end;
+
+	if (l)
+		gap = MAX3(gap, l->max_gap, n->start - l->max_end);
+	if (r)
+		gap = MAX3(gap, r->max_gap, r->min_start - n->end);
+	n->max_gap = gap;
+}
+
+static struct vma *vma_rotate_right(struct vma *n)
+{
+	struct vma *l = n->left;
+
+	n->left = l->right;
+	l->right = n;
+	vma_update(n);
+	vma_update(l);
+	return l;
+}
+
+static struct vma *vma_rotate_left(struct vma *n)
+{
+	struct vma *r = n->right;
+
+	n->right = r->left;
+	r->left = n;
+	vma_update(n);
+	vma_update(r);
+	return r;
+}
+
+static struct vma *vma_balance(struct vma *n)
+{
+	int bf;
+
+	vma_update(n);
+	bf = vma_height(n->left) - vma_height(n->right);
+
+	if (bf > 1) {
+		if (vma_height(n->left->left) < vma_height(n->left->right))
+			n->left = vma_rotate_left(n->left);
+		return vma_rotate_right(n);
+	}
+	if (bf < -1) {
+		if (vma_height(n->right->right) < vma_height(n->right->left))
+			n->right = vma_rotate_right(n->right);
+		return vma_rotate_left(n);
+	}
+	return n;
+}
+
+static struct vma *vma_do_insert(struct vma *n, struct vma *vma)
+{
+	if (!n)
+		return vma;
+
+	if (vma->start < n->start)
+		n->left = vma_do_insert(n->left, vma);
+	else
+		n->right = vma_do_insert(n->right, vma);
+	return vma_balance(n);
+}
+
+static struct vma *vma_remove_min(struct vma *n, struct vma **min)
+{
+	if (!n->left) {
+		*min = n;
+		return n->right;
+	}
+	n->left = vma_remove_min(n->left, min);
+	return vma_balance(n);
+}
+
+static struct vma *vma_do_remove(struct vma *n, struct vma *vma)
+{
+	struct vma *min;
+
+	if (!n)
+		return NULL;
+
+	if (n == vma) {
+		if (!n->right)
+			return n->left;
+		n->right = vma_remove_min(n->right, &min);
+		min->left = n->left;
+		min->right = n->right;
+		return vma_balance(min);
+	}
+
+	if (vma->start < n->start)
+		n->left = vma_do_remove(n->left, vma);
+	else
+		n->right = vma_do_remove(n->right, vma);
+	return vma_balance(n);
+}
+
+void vma_insert(struct vma *vma)
+{
+	vma->left = vma->right = NULL;
+	vma_update(vma);
+	vma_root = vma_do_insert(vma_root, vma);
+}
+
+void vma_remove(struct vma *vma)
+{
+	vma_root = vma_do_remove(vma_root, vma);
+}
+
+struct vma *vma_find(unsigned long addr)
+{
+	struct vma *n = vma_root;
+
+	while (n) {
+		if (addr < n->start)
+			n = n->left;
+		else if (addr >= n->end)
+			n = n->right;
+		else
+			return n;
+	}
+	return NULL;
+}
+
+struct vma *vma_next(unsigned long addr)
+{
+	struct vma *n = vma_root, *next = NULL;
+
+	/* Areas do not overlap, so they are sorted by their end as well */
+	while (n) {
+		if (n->end > addr) {
+			next = n;
+			n = n->left;
+		} else {
+			n = n->right;
+		}
+	}
+	return next;
+}
+
+struct vma_gap_search {
+	unsigned long lo;
+	unsigned long hi;
+	unsigned long len;
+	unsigned long prev;	/* end of the last area visited */
+	unsigned long found;
+};
+
+/* Checks the gap between the last area visited and `end` */
+static int vma_gap_fits(struct vma_gap_search *s, unsigned long end)
+{
+	unsigned long start = MAX(s->prev, s->lo);
+
+	end = MIN(end, s->hi);
+	if (start >= end || end - start < s->len)
+		return 0;
+
+	s->found = start;
+	return 1;
+}
+
+/* In-order walk that skips subtrees below `lo` or without a large enough
+ * gap, so only O(log n) nodes are visited
+ */
+static int vma_gap_walk(struct vma *n, struct vma_gap_search *s)
+{
+	if (!n || s->prev >= s->hi)
+		return 0;
+
+	if (n->max_end <= s->lo) {
+		s->prev = n->max_end;
+		return 0;
+	}
+
+	if (n->max_gap < s->len) {
+		if (vma_gap_fits(s, n->min_start))
+			return 1;
+		s->prev = n->max_end;
+		return 0;
+	}
+
+	if (vma_gap_walk(n->left, s))
+		return 1;
+	if (vma_gap_fits(s, n->start))
+		return 1;
+	s->prev = n->end;
+	return vma_gap_walk(n->right, s);
+}
+
+unsigned long vma_gap_find(unsigned long lo, unsigned long hi,
+			   unsigned long len)
+{
+	struct vma_gap_search s = {
+		.lo = lo,
+		.hi = hi,
+		.len = len,
+		.prev = lo,
+	};
+
+	if (!len || lo >= hi)
+		return -1;
+
+	if (vma_gap_walk(vma_root, &s) || vma_gap_fits(&s, hi))
+		return s.found;
+	return -1;
+}
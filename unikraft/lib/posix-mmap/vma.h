@@ -0,0 +1,82 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __POSIX_MMAP_VMA_H__
+#define __POSIX_MMAP_VMA_H__
+
+#include <uk/essentials.h>
+
+struct mmap_file;
+
+/*
+ * A virtual memory area: a page-aligned range [start, end) that was mapped
+ * with the same protection and flags by one mmap call (or what is left of
+ * it after munmap/mprotect split it up).
+ *
+ * Areas are kept in an AVL tree keyed by their start address. Every node
+ * also records the lowest start, the highest end and the largest gap
+ * between two areas of its subtree, so that a free range of a given size
+ * can be found without visiting subtrees that cannot contain one.
+ */
+struct vma {
+	struct vma *left;
+	struct vma *right;
+	int height;
+
+	unsigned long start;
+	unsigned long end;
+	int prot;			/* PROT_* */
+	int flags;			/* MAP_* */
+	struct mmap_file *file;		/* NULL for anonymous memory */
+
+	/* Subtree summary, maintained by the tree */
+	unsigned long min_start;
+	unsigned long max_end;
+	unsigned long max_gap;
+};
+
+/* Returns the area containing `addr`, NULL if there is none */
+struct vma *vma_find(unsigned long addr);
+
+/* Returns the lowest area ending above `addr`, NULL if there is none */
+struct vma *vma_next(unsigned long addr);
+
+/* `vma` must not overlap any area in the tree */
+void vma_insert(struct vma *vma);
+void vma_remove(struct vma *vma);
+
+/*
+ * Returns the lowest address >= `lo` such that [addr, addr + len) does not
+ * overlap any area and ends at or below `hi`, or -1 if there is none.
+ */
+unsigned long vma_gap_find(unsigned long lo, unsigned long hi,
+			   unsigned long len);
+
+#endif /* __POSIX_MMAP_VMA_H__ */
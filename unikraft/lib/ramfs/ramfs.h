@@ -36,6 +36,8 @@
 #include <vfscore/prex.h>
 #include <stdbool.h>
 
+struct ramfs_stale_buf;
+
 /*
  * File/directory node for RAMFS
  */
@@ -53,6 +55,8 @@ struct ramfs_node {
 	struct timespec rn_mtime;
 	int rn_mode;
 	bool rn_owns_buf;
+	bool rn_removed;    /* unlinked while mapped, freed on inactive */
+	struct ramfs_stale_buf *rn_stale;    /* replaced buffers still mapped */
 };
 
 struct ramfs_node *ramfs_allocate_node(const char *name, int type);
@@ -45,12 +45,14 @@
 #include <stdlib.h>
 
 #include <uk/page.h>
+#include <uk/assert.h>
 #include <vfscore/vnode.h>
 #include <vfscore/mount.h>
 #include <vfscore/uio.h>
 #include <vfscore/file.h>
 
 #include "ramfs.h"
+#include <ramfs/ramfs.h>
 #include <dirent.h>
 #include <fcntl.h>
 #include <vfscore/fs.h>
@@ -109,11 +111,33 @@ ramfs_allocate_node(const char *name, int type)
 	return np;
 }
 
+/*
+ * Buffers that were replaced while the file was mapped. They are kept until
+ * the last mapping is gone, in case a page still aliases them.
+ */
+struct ramfs_stale_buf {
+	struct ramfs_stale_buf *next;
+	void *buf;
+};
+
+static void
+ramfs_free_stale_bufs(struct ramfs_node *np)
+{
+	struct ramfs_stale_buf *sb;
+
+	while ((sb = np->rn_stale) != NULL) {
+		np->rn_stale = sb->next;
+		free(sb->buf);
+		free(sb);
+	}
+}
+
 void
 ramfs_free_node(struct ramfs_node *np)
 {
 	if (np->rn_buf != NULL && np->rn_owns_buf)
 		free(np->rn_buf);
+	ramfs_free_stale_bufs(np);
 
 	free(np->rn_name);
 	free(np);
@@ -150,9 +174,16 @@ ramfs_add_node(struct ramfs_node *dnp, char *name, int type)
 	return np;
 }
 
+/*
+ * Unlink the node of `vp` from the directory of `dvp`. The node of a mapped
+ * file is only freed by ramfs_inactive, after the last munmap dropped its
+ * vnode reference.
+ */
 static int
-ramfs_remove_node(struct ramfs_node *dnp, struct ramfs_node *np)
+ramfs_remove_node(struct vnode *dvp, struct vnode *vp)
 {
+	struct ramfs_node *dnp = dvp->v_data;
+	struct ramfs_node *np = vp->v_data;
 	struct ramfs_node *prev;
 
 	if (dnp->rn_child == NULL)
@@ -178,7 +209,11 @@ ramfs_remove_node(struct ramfs_node *dnp, struct ramfs_node *np)
 		}
 		prev->rn_next = np->rn_next;
 	}
-	ramfs_free_node(np);
+	np->rn_next = NULL;
+	if (uk_list_empty(&vp->v_mappings))
+		ramfs_free_node(np);
+	else
+		np->rn_removed = true;
 
 	set_times_to_now(&(dnp->rn_mtime), &(dnp->rn_ctime), NULL);
 
@@ -345,7 +380,7 @@ ramfs_readlink(struct vnode *vp, struct uio *uio)
 static int
 ramfs_rmdir(struct vnode *dvp, struct vnode *vp, char *name __unused)
 {
-	return ramfs_remove_node(dvp->v_data, vp->v_data);
+	return ramfs_remove_node(dvp, vp);
 }
 
 /* Remove a file */
@@ -354,7 +389,59 @@ ramfs_remove(struct vnode *dvp, struct vnode *vp, char *name __maybe_unused)
 {
 	//flexos_gate(ukdebug, uk_pr_debug, "remove %s in %s\n", name,
 	//	 RAMFS_NODE(dvp)->rn_name);
-	return ramfs_remove_node(dvp->v_data, vp->v_data);
+	return ramfs_remove_node(dvp, vp);
+}
+
+/*
+ * Move the file data to a new buffer that holds at least `size` bytes.
+ * Buffers of mapped files are page-aligned and the mappings are told where
+ * the data went.
+ */
+static int
+ramfs_grow_buf(struct vnode *vp, size_t size, bool align)
+{
+	struct ramfs_node *np = vp->v_data;
+	bool mapped = !uk_list_empty(&vp->v_mappings);
+	size_t new_size = round_pgup(size);
+	struct ramfs_stale_buf *sb = NULL;
+	void *new_buf;
+
+	if (mapped && np->rn_buf != NULL && np->rn_owns_buf) {
+		sb = malloc(sizeof(*sb));
+		if (!sb)
+			return ENOMEM;
+	}
+
+	/* TODO: this could use a page level allocator */
+	if (mapped || align) {
+		if (posix_memalign(&new_buf, __PAGE_SIZE, new_size)) {
+			free(sb);
+			return EIO;
+		}
+		memset(new_buf, 0, new_size);
+	} else {
+		new_buf = calloc(1, new_size);
+		if (!new_buf)
+			return EIO;
+	}
+
+	if (np->rn_size != 0)
+		memcpy(new_buf, np->rn_buf, np->rn_size);
+	if (sb) {
+		/* Freed by ramfs_unmap once no mapping can alias it */
+		sb->buf = np->rn_buf;
+		sb->next = np->rn_stale;
+		np->rn_stale = sb;
+	} else if (np->rn_buf != NULL && np->rn_owns_buf) {
+		free(np->rn_buf);
+	}
+	np->rn_buf = (char *) new_buf;
+	np->rn_bufsize = new_size;
+	np->rn_owns_buf = true;
+
+	if (mapped)
+		vn_mappings_moved(vp, np->rn_buf);
+	return 0;
 }
 
 /* Truncate file */
@@ -362,34 +449,24 @@ static int
 ramfs_truncate(struct vnode *vp, off_t length)
 {
 	struct ramfs_node *np;
-	void *new_buf;
-	size_t new_size;
+	int error;
 
 	//flexos_gate(ukdebug, uk_pr_debug, "truncate %s length=%lld\n", RAMFS_NODE(vp)->rn_name,
 	//	 (long long) length);
 	np = vp->v_data;
 
 	if (length == 0) {
-		if (np->rn_buf != NULL) {
+		/* Mapped memory has to stay around until it is unmapped */
+		if (np->rn_buf != NULL && uk_list_empty(&vp->v_mappings)) {
 			if (np->rn_owns_buf)
 				free(np->rn_buf);
 			np->rn_buf = NULL;
 			np->rn_bufsize = 0;
 		}
 	} else if ((size_t) length > np->rn_bufsize) {
-		/* TODO: this could use a page level allocator */
-		new_size = round_pgup(length);
-		new_buf = malloc(new_size);
-		if (!new_buf)
-			return EIO;
-		if (np->rn_size != 0) {
-			memcpy(new_buf, np->rn_buf, vp->v_size);
-			if (np->rn_owns_buf)
-				free(np->rn_buf);
-		}
-		np->rn_buf = (char *) new_buf;
-		np->rn_bufsize = new_size;
-		np->rn_owns_buf = true;
+		error = ramfs_grow_buf(vp, length, false);
+		if (error)
+			return error;
 	}
 	np->rn_size = length;
 	vp->v_size = length;
@@ -447,6 +524,9 @@ ramfs_read(struct vnode *vp, struct vfscore_file *fp __unused,
 	return vfscore_uiomove(np->rn_buf + uio->uio_offset, len, uio);
 }
 
+/*
+ * Called by cpio to let an extracted file point into the initrd.
+ */
 int
 ramfs_set_file_data(struct vnode *vp, const void *data, size_t size)
 {
@@ -487,28 +567,29 @@ ramfs_write(struct vnode *vp, struct uio *uio, int ioflag)
 	if (ioflag & IO_APPEND)
 		uio->uio_offset = np->rn_size;
 
+	/* Borrowed data (see ramfs_set_file_data) is copied on first write */
+	if (np->rn_buf != NULL && !np->rn_owns_buf) {
+		int error = ramfs_grow_buf(vp,
+				MAX(np->rn_size,
+				    (size_t) uio->uio_offset + uio->uio_resid),
+				false);
+
+		if (error)
+			return error;
+	}
+
 	if ((size_t) uio->uio_offset + uio->uio_resid > (size_t) vp->v_size) {
 		/* Expand the file size before writing to it */
 		off_t end_pos = uio->uio_offset + uio->uio_resid;
 
 		if (end_pos > (off_t) np->rn_bufsize) {
-			// XXX: this could use a page level allocator
-			size_t new_size = round_pgup(end_pos);
-			void *new_buf = calloc(1, new_size);
-
-			if (!new_buf)
-				return EIO;
-			if (np->rn_size != 0) {
-				memcpy(new_buf, np->rn_buf, vp->v_size);
-				if (np->rn_owns_buf)
-					free(np->rn_buf);
-			}
-			np->rn_buf = (char *) new_buf;
-			np->rn_bufsize = new_size;
+			int error = ramfs_grow_buf(vp, end_pos, false);
+
+			if (error)
+				return error;
 		}
 		np->rn_size = end_pos;
 		vp->v_size = end_pos;
-		np->rn_owns_buf = true;
 	}
 
 	set_times_to_now(&(np->rn_mtime), &(np->rn_ctime), NULL);
@@ -516,6 +597,58 @@ ramfs_write(struct vnode *vp, struct uio *uio, int ioflag)
 			       uio);
 }
 
+/*
+ * Hand out the file buffer itself, so mappings of ramfs files are zero
+ * copy. The first mapping moves the data into a page-aligned buffer that
+ * covers the mapped range.
+ */
+static int
+ramfs_map(struct vnode *vp, struct vfscore_mapping *vm, void **addr)
+{
+	struct ramfs_node *np = vp->v_data;
+	size_t end = vm->vm_off + vm->vm_len;
+	int error;
+
+	if (vp->v_type != VREG)
+		return ENODEV;
+
+	if (np->rn_buf == NULL || !np->rn_owns_buf
+	    || round_pgdown((unsigned long) np->rn_buf)
+		   != (unsigned long) np->rn_buf
+	    || end > np->rn_bufsize) {
+		error = ramfs_grow_buf(vp, MAX(end, np->rn_bufsize), true);
+		if (error)
+			return error;
+	}
+
+	uk_list_add(&vm->vm_link, &vp->v_mappings);
+	*addr = np->rn_buf + vm->vm_off;
+	return 0;
+}
+
+static int
+ramfs_unmap(struct vnode *vp, struct vfscore_mapping *vm)
+{
+	uk_list_del(&vm->vm_link);
+	if (uk_list_empty(&vp->v_mappings))
+		ramfs_free_stale_bufs(vp->v_data);
+	return 0;
+}
+
+/* Free the node of a file that was removed while it was still mapped */
+static int
+ramfs_inactive(struct vnode *vp)
+{
+	struct ramfs_node *np = vp->v_data;
+
+	if (np != NULL && np->rn_removed) {
+		UK_ASSERT(uk_list_empty(&vp->v_mappings));
+		ramfs_free_node(np);
+		vp->v_data = NULL;
+	}
+	return 0;
+}
+
 static int
 ramfs_rename(struct vnode *dvp1, struct vnode *vp1, char *name1 __unused,
 			 struct vnode *dvp2, struct vnode *vp2, char *name2)
@@ -525,7 +658,7 @@ ramfs_rename(struct vnode *dvp1, struct vnode *vp1, char *name1 __unused,
 
 	if (vp2) {
 		/* Remove destination file, first */
-		error = ramfs_remove_node(dvp2->v_data, vp2->v_data);
+		error = ramfs_remove_node(dvp2, vp2);
 		if (error)
 			return error;
 	}
@@ -547,10 +680,17 @@ ramfs_rename(struct vnode *dvp1, struct vnode *vp1, char *name1 __unused,
 			np->rn_buf = old_np->rn_buf;
 			np->rn_size = old_np->rn_size;
 			np->rn_bufsize = old_np->rn_bufsize;
+			np->rn_owns_buf = old_np->rn_owns_buf;
+			np->rn_stale = old_np->rn_stale;
 			old_np->rn_buf = NULL;
+			old_np->rn_stale = NULL;
 		}
 		/* Remove source file */
-		ramfs_remove_node(dvp1->v_data, vp1->v_data);
+		ramfs_remove_node(dvp1, vp1);
+		if (old_np->rn_removed)
+			ramfs_free_node(old_np);
+		/* Mappings of vp1 alias the buffer that now belongs to np */
+		vp1->v_data = np;
 	}
 	return 0;
 }
@@ -673,7 +813,6 @@ ramfs_setattr(struct vnode *vnode, struct vattr *attr)
 #define ramfs_seek      ((vnop_seek_t)vfscore_vop_nullop)
 #define ramfs_ioctl     ((vnop_ioctl_t)vfscore_vop_einval)
 #define ramfs_fsync     ((vnop_fsync_t)vfscore_vop_nullop)
-#define ramfs_inactive  ((vnop_inactive_t)vfscore_vop_nullop)
 #define ramfs_link      ((vnop_link_t)vfscore_vop_eperm)
 #define ramfs_fallocate ((vnop_fallocate_t)vfscore_vop_nullop)
 
@@ -705,5 +844,8 @@ struct vnops ramfs_vnops __section(".data_shared") = {
 		ramfs_fallocate,        /* fallocate */
 		ramfs_readlink,         /* read link */
 		ramfs_symlink,          /* symbolic link */
+		(vnop_fsync_t) NULL,    /* fdatasync */
+		ramfs_map,              /* map */
+		ramfs_unmap,            /* unmap */
 };
 
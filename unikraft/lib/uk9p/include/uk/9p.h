@@ -225,6 +225,77 @@ int64_t uk_9p_read(struct uk_9pdev *dev, struct uk_9pfid *fid,
 int64_t uk_9p_write(struct uk_9pdev *dev, struct uk_9pfid *fid,
 		uint64_t offset, uint32_t count, const char *buf);
 
+/**
+ * Sends a read request like uk_9p_read() without waiting for the reply, so
+ * that several requests can be in flight at once. The data is placed into
+ * buf once the reply arrives, buf must stay valid until then.
+ *
+ * @param dev
+ *   The Unikraft 9P Device.
+ * @param fid
+ *   9P fid to read from.
+ * @param offset
+ *   Offset at which to start reading.
+ * @param count
+ *   Maximum number of bytes to read.
+ * @param buf
+ *   Buffer to read into.
+ * @return
+ *   - (!ERRPTR): The request, to be passed to uk_9p_read_wait().
+ *   - ERRPTR: The error returned by the API.
+ */
+struct uk_9preq *uk_9p_read_send(struct uk_9pdev *dev, struct uk_9pfid *fid,
+		uint64_t offset, uint32_t count, char *buf);
+
+/**
+ * Waits for the reply to a request sent with uk_9p_read_send() and removes
+ * the request.
+ *
+ * @param dev
+ *   The Unikraft 9P Device.
+ * @param req
+ *   The request returned by uk_9p_read_send().
+ * @return
+ *   - (>= 0): Amount of bytes read.
+ *   - (< 0): An error occurred.
+ */
+int64_t uk_9p_read_wait(struct uk_9pdev *dev, struct uk_9preq *req);
+
+/**
+ * Sends a write request like uk_9p_write() without waiting for the reply.
+ * buf must stay valid until the reply arrives.
+ *
+ * @param dev
+ *   The Unikraft 9P Device.
+ * @param fid
+ *   9P fid to write to.
+ * @param offset
+ *   Offset at which to start writing.
+ * @param count
+ *   Maximum number of bytes to write.
+ * @param buf
+ *   Data to be written.
+ * @return
+ *   - (!ERRPTR): The request, to be passed to uk_9p_write_wait().
+ *   - ERRPTR: The error returned by the API.
+ */
+struct uk_9preq *uk_9p_write_send(struct uk_9pdev *dev, struct uk_9pfid *fid,
+		uint64_t offset, uint32_t count, const char *buf);
+
+/**
+ * Waits for the reply to a request sent with uk_9p_write_send() and removes
+ * the request.
+ *
+ * @param dev
+ *   The Unikraft 9P Device.
+ * @param req
+ *   The request returned by uk_9p_write_send().
+ * @return
+ *   - (>= 0): Amount of bytes written.
+ *   - (< 0): An error occurred.
+ */
+int64_t uk_9p_write_wait(struct uk_9pdev *dev, struct uk_9preq *req);
+
 /**
  * Stats the given fid and places the data into the given stat structure.
  *
@@ -74,6 +74,10 @@ int uk_alloc_register(struct uk_alloc *a)
 {
 	struct uk_alloc *this = _uk_alloc_head;
 
+#if CONFIG_LIBUKALLOC_STATS
+	memset(&a->stats, 0, sizeof(a->stats));
+#endif
+
 	if (!_uk_alloc_head) {
 		_uk_alloc_head = a;
 		a->next = NULL;
@@ -87,6 +91,25 @@ int uk_alloc_register(struct uk_alloc *a)
 	return 0;
 }
 
+int uk_alloc_set_default(struct uk_alloc *a)
+{
+	struct uk_alloc *this = _uk_alloc_head;
+
+	UK_ASSERT(a);
+	if (this == a)
+		return 0;
+
+	while (this && this->next != a)
+		this = this->next;
+	if (!this)
+		return -ENOENT;
+
+	this->next = a->next;
+	a->next = _uk_alloc_head;
+	_uk_alloc_head = a;
+	return 0;
+}
+
 struct metadata_ifpages {
 	unsigned long	num_pages;
 	void		*base;
@@ -135,6 +158,11 @@ static size_t uk_getmallocsize(const void *ptr)
 	       __PAGE_SIZE - (size_t)ptr;
 }
 
+size_t uk_getsize_ifpages(struct uk_alloc *a __unused, const void *ptr)
+{
+	return uk_getmallocsize(ptr);
+}
+
 void *uk_malloc_ifpages(struct uk_alloc *a, size_t size)
 {
 	uintptr_t intptr;
@@ -322,6 +350,11 @@ static size_t uk_getmallocsize_ifmalloc(const void *ptr)
 			 (uintptr_t) ptr);
 }
 
+size_t uk_getsize_ifmalloc(struct uk_alloc *a __unused, const void *ptr)
+{
+	return uk_getmallocsize_ifmalloc(ptr);
+}
+
 void uk_free_ifmalloc(struct uk_alloc *a, void *ptr)
 {
 	struct metadata_ifmalloc *metadata;
@@ -483,8 +516,11 @@ void *uk_realloc_compat(struct uk_alloc *a, void *ptr, size_t size)
 	if (!retptr)
 		return NULL;
 
-	memcpy(retptr, ptr, size);
-
+	/* Without getsize() we cannot know how large the old object was */
+	if (a->getsize)
+		memcpy(retptr, ptr, MIN(size, a->getsize(a, ptr)));
+	else
+		memcpy(retptr, ptr, size);
 
 	uk_free(a, ptr);
 	return retptr;
@@ -69,11 +69,47 @@ typedef void  (*uk_alloc_pfree_func_t)
 		(struct uk_alloc *a, void *ptr, unsigned long num_pages);
 typedef int   (*uk_alloc_addmem_func_t)
 		(struct uk_alloc *a, void *base, size_t size);
+typedef size_t (*uk_alloc_getsize_func_t)
+		(struct uk_alloc *a, const void *ptr);
 #if CONFIG_LIBUKALLOC_IFSTATS
 typedef ssize_t (*uk_alloc_availmem_func_t)
 		(struct uk_alloc *a);
 #endif
 
+#if CONFIG_LIBUKALLOC_STATS
+/* Size classes of the allocation histogram: class 0 counts requests of up
+ * to 16 bytes, class i requests of (2^(i+3), 2^(i+4)] bytes, and the last
+ * class everything larger.
+ */
+#define UK_ALLOC_STATS_NR_CLASSES 16
+
+struct uk_alloc_stats {
+	/* Label used by uk_alloc_stats_dump(), see uk_alloc_stats_set_name() */
+	const char *name;
+
+	uint64_t nb_allocs;	/* successful malloc/calloc/memalign/palloc */
+	uint64_t nb_frees;	/* free/pfree of non-NULL pointers */
+	uint64_t nb_reallocs;	/* successful resizing reallocs */
+	uint64_t nb_enomem;	/* failed requests */
+
+	int64_t cur_nb_allocs;	/* live objects */
+	int64_t max_nb_allocs;
+
+	/* Bytes handed out as reported by getsize() (or whole pages for
+	 * palloc), only tracked for allocators that implement getsize().
+	 */
+	ssize_t cur_mem_use;
+	ssize_t max_mem_use;
+	size_t max_alloc_size;	/* largest single request */
+
+	uint64_t size_class[UK_ALLOC_STATS_NR_CLASSES];
+
+	/* internal: nesting depth, only the outermost call is accounted */
+	unsigned int nest;
+	unsigned int sample;
+};
+#endif /* CONFIG_LIBUKALLOC_STATS */
+
 struct uk_alloc {
 	/* memory allocation */
 	uk_alloc_malloc_func_t malloc;
@@ -97,7 +133,12 @@ struct uk_alloc {
 #endif
 	/* optional interface */
 	uk_alloc_addmem_func_t addmem;
+	/* optional interface: usable size of an allocated object */
+	uk_alloc_getsize_func_t getsize;
 	size_t len;
+#if CONFIG_LIBUKALLOC_STATS
+	struct uk_alloc_stats stats;
+#endif
 
 	/* internal */
 	struct uk_alloc *next;
@@ -172,11 +213,38 @@ static inline struct uk_alloc *uk_alloc_get_default(void)
 #pragma GCC pop_options
 #endif
 
+/**
+ * Makes the registered allocator `a` the one returned by
+ * uk_alloc_get_default() (outside of compartment-specific heaps).
+ *
+ * @return
+ *  0 on success, -ENOENT if `a` was never registered.
+ */
+int uk_alloc_set_default(struct uk_alloc *a);
+
+#if CONFIG_LIBUKALLOC_STATS
+/* Accounting versions of the wrappers below, see stats.c */
+void *_uk_alloc_stats_malloc(struct uk_alloc *a, size_t size);
+void *_uk_alloc_stats_calloc(struct uk_alloc *a, size_t nmemb, size_t size);
+void *_uk_alloc_stats_realloc(struct uk_alloc *a, void *ptr, size_t size);
+int _uk_alloc_stats_posix_memalign(struct uk_alloc *a, void **memptr,
+				   size_t align, size_t size);
+void *_uk_alloc_stats_memalign(struct uk_alloc *a, size_t align, size_t size);
+void _uk_alloc_stats_free(struct uk_alloc *a, void *ptr);
+void *_uk_alloc_stats_palloc(struct uk_alloc *a, unsigned long num_pages);
+void _uk_alloc_stats_pfree(struct uk_alloc *a, void *ptr,
+			   unsigned long num_pages);
+#endif /* CONFIG_LIBUKALLOC_STATS */
+
 /* wrapper functions */
 static inline void *uk_do_malloc(struct uk_alloc *a, size_t size)
 {
 	UK_ASSERT(a);
+#if CONFIG_LIBUKALLOC_STATS
+	return _uk_alloc_stats_malloc(a, size);
+#else
 	return a->malloc(a, size);
+#endif
 }
 
 static inline void *uk_malloc(struct uk_alloc *a, size_t size)
@@ -192,7 +260,11 @@ static inline void *uk_do_calloc(struct uk_alloc *a,
 				 size_t nmemb, size_t size)
 {
 	UK_ASSERT(a);
+#if CONFIG_LIBUKALLOC_STATS
+	return _uk_alloc_stats_calloc(a, nmemb, size);
+#else
 	return a->calloc(a, nmemb, size);
+#endif
 }
 
 static inline void *uk_calloc(struct uk_alloc *a,
@@ -209,7 +281,11 @@ static inline void *uk_do_realloc(struct uk_alloc *a,
 				  void *ptr, size_t size)
 {
 	UK_ASSERT(a);
+#if CONFIG_LIBUKALLOC_STATS
+	return _uk_alloc_stats_realloc(a, ptr, size);
+#else
 	return a->realloc(a, ptr, size);
+#endif
 }
 
 static inline void *uk_realloc(struct uk_alloc *a, void *ptr, size_t size)
@@ -225,7 +301,11 @@ static inline int uk_do_posix_memalign(struct uk_alloc *a, void **memptr,
 				       size_t align, size_t size)
 {
 	UK_ASSERT(a);
+#if CONFIG_LIBUKALLOC_STATS
+	return _uk_alloc_stats_posix_memalign(a, memptr, align, size);
+#else
 	return a->posix_memalign(a, memptr, align, size);
+#endif
 }
 
 static inline int uk_posix_memalign(struct uk_alloc *a, void **memptr,
@@ -242,7 +322,11 @@ static inline void *uk_do_memalign(struct uk_alloc *a,
 				   size_t align, size_t size)
 {
 	UK_ASSERT(a);
+#if CONFIG_LIBUKALLOC_STATS
+	return _uk_alloc_stats_memalign(a, align, size);
+#else
 	return a->memalign(a, align, size);
+#endif
 }
 
 static inline void *uk_memalign(struct uk_alloc *a,
@@ -256,7 +340,11 @@ static inline void *uk_memalign(struct uk_alloc *a,
 static inline void uk_do_free(struct uk_alloc *a, void *ptr)
 {
 	UK_ASSERT(a);
+#if CONFIG_LIBUKALLOC_STATS
+	_uk_alloc_stats_free(a, ptr);
+#else
 	a->free(a, ptr);
+#endif
 }
 
 static inline void uk_free(struct uk_alloc *a, void *ptr)
@@ -267,7 +355,11 @@ static inline void uk_free(struct uk_alloc *a, void *ptr)
 static inline void *uk_do_palloc(struct uk_alloc *a, unsigned long num_pages)
 {
 	UK_ASSERT(a);
+#if CONFIG_LIBUKALLOC_STATS
+	return _uk_alloc_stats_palloc(a, num_pages);
+#else
 	return a->palloc(a, num_pages);
+#endif
 }
 
 static inline void *uk_palloc(struct uk_alloc *a, unsigned long num_pages)
@@ -281,7 +373,11 @@ static inline void uk_do_pfree(struct uk_alloc *a, void *ptr,
 			       unsigned long num_pages)
 {
 	UK_ASSERT(a);
+#if CONFIG_LIBUKALLOC_STATS
+	_uk_alloc_stats_pfree(a, ptr, num_pages);
+#else
 	a->pfree(a, ptr, num_pages);
+#endif
 }
 
 static inline void uk_pfree(struct uk_alloc *a, void *ptr,
@@ -299,6 +395,19 @@ static inline int uk_alloc_addmem(struct uk_alloc *a, void *base,
 	else
 		return -ENOTSUP;
 }
+
+/**
+ * Returns the usable size of the object `ptr` allocated from `a`, or 0 if
+ * `ptr` is NULL or the allocator does not implement the interface.
+ */
+static inline size_t uk_alloc_getsize(struct uk_alloc *a, const void *ptr)
+{
+	UK_ASSERT(a);
+	if (!ptr || !a->getsize)
+		return 0;
+	return a->getsize(a, ptr);
+}
+
 #if CONFIG_LIBUKALLOC_IFSTATS
 static inline ssize_t uk_alloc_availmem(struct uk_alloc *a)
 {
@@ -309,6 +418,58 @@ static inline ssize_t uk_alloc_availmem(struct uk_alloc *a)
 }
 #endif /* CONFIG_LIBUKALLOC_IFSTATS */
 
+#if CONFIG_LIBUKALLOC_STATS
+/* Sampled call site, see uk_alloc_stats_callsites() */
+struct uk_alloc_callsite {
+	struct uk_alloc *a;
+	/* Return address into the function that called the uk_alloc API
+	 * and, one frame further up, into its caller (e.g., the code that
+	 * called the libc's malloc())
+	 */
+	void *pc;
+	void *caller;
+	uint64_t samples;
+	uint64_t bytes;		/* sum of the sampled request sizes */
+};
+
+/**
+ * Sets the label used for `a` when dumping statistics.
+ */
+void uk_alloc_stats_set_name(struct uk_alloc *a, const char *name);
+
+/**
+ * Copies the current statistics of `a` to `stats`.
+ *
+ * @return
+ *  0 on success, -EINVAL if `a` or `stats` is NULL.
+ */
+int uk_alloc_stats_get(struct uk_alloc *a, struct uk_alloc_stats *stats);
+
+/**
+ * Resets the counters of `a`. Live objects and bytes in use are kept and
+ * become the new peaks.
+ */
+void uk_alloc_stats_reset(struct uk_alloc *a);
+
+/**
+ * Copies up to `max` sampled call sites of `a` (of all allocators if `a` is
+ * NULL) to `cs`, ordered by decreasing sampled bytes.
+ *
+ * @return
+ *  Number of entries written. Always 0 without
+ *  CONFIG_LIBUKALLOC_STATS_CALLSITES.
+ */
+unsigned int uk_alloc_stats_callsites(struct uk_alloc *a,
+				      struct uk_alloc_callsite *cs,
+				      unsigned int max);
+
+/**
+ * Prints the statistics of `a` (of all registered allocators if `a` is
+ * NULL) to the console.
+ */
+void uk_alloc_stats_dump(struct uk_alloc *a);
+#endif /* CONFIG_LIBUKALLOC_STATS */
+
 #ifdef __cplusplus
 }
 #endif
@@ -59,6 +59,7 @@ void *uk_realloc_ifpages(struct uk_alloc *a, void *ptr, size_t size);
 int uk_posix_memalign_ifpages(struct uk_alloc *a, void **memptr,
 				size_t align, size_t size);
 void uk_free_ifpages(struct uk_alloc *a, void *ptr);
+size_t uk_getsize_ifpages(struct uk_alloc *a, const void *ptr);
 
 #if CONFIG_LIBUKALLOC_IFMALLOC
 void *uk_malloc_ifmalloc(struct uk_alloc *a, size_t size);
@@ -66,6 +67,7 @@ void *uk_realloc_ifmalloc(struct uk_alloc *a, void *ptr, size_t size);
 int uk_posix_memalign_ifmalloc(struct uk_alloc *a, void **memptr,
 				     size_t align, size_t size);
 void uk_free_ifmalloc(struct uk_alloc *a, void *ptr);
+size_t uk_getsize_ifmalloc(struct uk_alloc *a, const void *ptr);
 #endif
 
 /* Functionality that is provided based on malloc() and posix_memalign() */
@@ -90,6 +92,7 @@ void uk_pfree_compat(struct uk_alloc *a, void *ptr, unsigned long num_pages);
 		(a)->palloc         = uk_palloc_compat;			\
 		(a)->pfree          = uk_pfree_compat;			\
 		(a)->addmem         = (addmem_f);			\
+		(a)->getsize        = NULL;				\
 									\
 		uk_alloc_register((a));					\
 	} while (0)
@@ -108,6 +111,7 @@ void uk_pfree_compat(struct uk_alloc *a, void *ptr, unsigned long num_pages);
 		(a)->palloc         = uk_palloc_compat;			\
 		(a)->pfree          = uk_pfree_compat;			\
 		(a)->addmem         = (addmem_f);			\
+		(a)->getsize        = uk_getsize_ifmalloc;		\
 									\
 		uk_alloc_register((a));					\
 	} while (0)
@@ -127,6 +131,7 @@ void uk_pfree_compat(struct uk_alloc *a, void *ptr, unsigned long num_pages);
 		(a)->palloc         = (palloc_func);			\
 		(a)->pfree          = (pfree_func);			\
 		(a)->addmem         = (addmem_func);			\
+		(a)->getsize        = uk_getsize_ifpages;		\
 									\
 		uk_alloc_register((a));					\
 	} while (0)
@@ -0,0 +1,465 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Allocation statistics: the uk_alloc wrappers in <uk/alloc.h> call into
+ * this file when CONFIG_LIBUKALLOC_STATS is set. Only the outermost call on
+ * an allocator is accounted, so that compatibility helpers calling back
+ * into the same allocator (e.g., uk_calloc_compat() -> uk_malloc(), or
+ * uk_malloc_ifpages() -> uk_palloc()) are not counted twice.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <uk/alloc_impl.h>
+#include <uk/config.h>
+#include <uk/essentials.h>
+#include <uk/assert.h>
+#include <uk/arch/limits.h>
+#include <uk/arch/lcpu.h>
+#include <uk/arch/atomic.h>
+
+#if CONFIG_LIBUKALLOC_STATS_CALLSITES
+#define CALLSITES_MAX  CONFIG_LIBUKALLOC_STATS_CALLSITES_MAX
+#define CALLSITES_RATE CONFIG_LIBUKALLOC_STATS_CALLSITES_RATE
+#define CALLSITES_PROBE 8
+
+UK_CTASSERT(CALLSITES_MAX > 0);
+UK_CTASSERT(CALLSITES_RATE > 0);
+
+/* Allocators of every compartment record here */
+static struct uk_alloc_callsite callsites[CALLSITES_MAX]
+	__section(".data_shared");
+static uint64_t callsites_dropped __section(".data_shared");
+#endif /* CONFIG_LIBUKALLOC_STATS_CALLSITES */
+
+static const char * const class_names[UK_ALLOC_STATS_NR_CLASSES] = {
+	"16", "32", "64", "128", "256", "512", "1K", "2K", "4K", "8K",
+	"16K", "32K", "64K", "128K", "256K", ">256K"
+};
+
+#define stats_nested(a) ((a)->stats.nest != 0)
+#define stats_enter(a)  ((a)->stats.nest++)
+#define stats_leave(a)  ((a)->stats.nest--)
+
+static inline unsigned int size_class(size_t size)
+{
+	unsigned long c;
+
+	if (size <= 16)
+		return 0;
+	c = ukarch_flsl(size - 1) - 3;
+	return (unsigned int) MIN(c, UK_ALLOC_STATS_NR_CLASSES - 1UL);
+}
+
+#if CONFIG_LIBUKALLOC_STATS_CALLSITES
+/* `fp` is the frame of the _uk_alloc_stats_*() entry point: its return
+ * address points into the function that used the uk_alloc API, the one of
+ * the frame above into that function's caller. The frame chain is only
+ * followed while it looks sane because the stack base may not end in a
+ * NULL frame pointer.
+ */
+static void callsite_record(struct uk_alloc *a, void **fp, size_t size)
+{
+	struct uk_alloc_callsite *cs;
+	void **next;
+	void *pc, *caller = NULL;
+	unsigned long h;
+	unsigned int i;
+
+	pc = fp[1];
+	next = (void **) fp[0];
+	if ((uintptr_t) next > (uintptr_t) fp
+	    && (uintptr_t) next - (uintptr_t) fp < 16 * __PAGE_SIZE)
+		caller = next[1];
+
+	h = ((unsigned long) pc ^ ((unsigned long) caller >> 3)
+	     ^ ((unsigned long) a >> 6)) * 0x9e3779b97f4a7c15UL;
+	for (i = 0; i < CALLSITES_PROBE; i++) {
+		cs = &callsites[(h + i) % CALLSITES_MAX];
+		if (!cs->samples) {
+			cs->a = a;
+			cs->pc = pc;
+			cs->caller = caller;
+		} else if (cs->a != a || cs->pc != pc || cs->caller != caller) {
+			continue;
+		}
+		cs->samples++;
+		cs->bytes += size;
+		return;
+	}
+	callsites_dropped++;
+}
+#endif /* CONFIG_LIBUKALLOC_STATS_CALLSITES */
+
+static void count_alloc(struct uk_alloc *a, size_t size, size_t usable,
+			void **fp __maybe_unused)
+{
+	struct uk_alloc_stats *st = &a->stats;
+
+	st->nb_allocs++;
+	st->cur_nb_allocs++;
+	if (st->cur_nb_allocs > st->max_nb_allocs)
+		st->max_nb_allocs = st->cur_nb_allocs;
+	st->cur_mem_use += usable;
+	if (st->cur_mem_use > st->max_mem_use)
+		st->max_mem_use = st->cur_mem_use;
+	if (size > st->max_alloc_size)
+		st->max_alloc_size = size;
+	st->size_class[size_class(size)]++;
+
+#if CONFIG_LIBUKALLOC_STATS_CALLSITES
+	if (++st->sample >= CALLSITES_RATE) {
+		st->sample = 0;
+		callsite_record(a, fp, size);
+	}
+#endif
+}
+
+static void count_free(struct uk_alloc *a, size_t usable)
+{
+	struct uk_alloc_stats *st = &a->stats;
+
+	st->nb_frees++;
+	st->cur_nb_allocs--;
+	st->cur_mem_use -= usable;
+}
+
+void *_uk_alloc_stats_malloc(struct uk_alloc *a, size_t size)
+{
+	void *ptr;
+
+	if (stats_nested(a))
+		return a->malloc(a, size);
+
+	stats_enter(a);
+	ptr = a->malloc(a, size);
+	if (ptr)
+		count_alloc(a, size, uk_alloc_getsize(a, ptr),
+			    __builtin_frame_address(0));
+	else if (size)
+		a->stats.nb_enomem++;
+	stats_leave(a);
+	return ptr;
+}
+
+void *_uk_alloc_stats_calloc(struct uk_alloc *a, size_t nmemb, size_t size)
+{
+	size_t total;
+	void *ptr;
+
+	if (stats_nested(a))
+		return a->calloc(a, nmemb, size);
+
+	if (__builtin_mul_overflow(nmemb, size, &total))
+		total = (size_t) -1;
+
+	stats_enter(a);
+	ptr = a->calloc(a, nmemb, size);
+	if (ptr)
+		count_alloc(a, total, uk_alloc_getsize(a, ptr),
+			    __builtin_frame_address(0));
+	else if (total)
+		a->stats.nb_enomem++;
+	stats_leave(a);
+	return ptr;
+}
+
+void *_uk_alloc_stats_realloc(struct uk_alloc *a, void *ptr, size_t size)
+{
+	struct uk_alloc_stats *st = &a->stats;
+	size_t old;
+	void *ret;
+
+	if (stats_nested(a))
+		return a->realloc(a, ptr, size);
+
+	stats_enter(a);
+	old = uk_alloc_getsize(a, ptr);
+	ret = a->realloc(a, ptr, size);
+	if (!ptr) {
+		if (ret)
+			count_alloc(a, size, uk_alloc_getsize(a, ret),
+				    __builtin_frame_address(0));
+		else if (size)
+			st->nb_enomem++;
+	} else if (!size) {
+		count_free(a, old);
+	} else if (ret) {
+		st->nb_reallocs++;
+		st->cur_mem_use += (ssize_t) uk_alloc_getsize(a, ret)
+				   - (ssize_t) old;
+		if (st->cur_mem_use > st->max_mem_use)
+			st->max_mem_use = st->cur_mem_use;
+		if (size > st->max_alloc_size)
+			st->max_alloc_size = size;
+	} else {
+		st->nb_enomem++;
+	}
+	stats_leave(a);
+	return ret;
+}
+
+int _uk_alloc_stats_posix_memalign(struct uk_alloc *a, void **memptr,
+				   size_t align, size_t size)
+{
+	int rc;
+
+	if (stats_nested(a))
+		return a->posix_memalign(a, memptr, align, size);
+
+	stats_enter(a);
+	rc = a->posix_memalign(a, memptr, align, size);
+	if (rc == 0)
+		count_alloc(a, size, uk_alloc_getsize(a, *memptr),
+			    __builtin_frame_address(0));
+	else if (rc == ENOMEM)
+		a->stats.nb_enomem++;
+	stats_leave(a);
+	return rc;
+}
+
+void *_uk_alloc_stats_memalign(struct uk_alloc *a, size_t align, size_t size)
+{
+	void *ptr;
+
+	if (stats_nested(a))
+		return a->memalign(a, align, size);
+
+	stats_enter(a);
+	ptr = a->memalign(a, align, size);
+	if (ptr)
+		count_alloc(a, size, uk_alloc_getsize(a, ptr),
+			    __builtin_frame_address(0));
+	else if (size)
+		a->stats.nb_enomem++;
+	stats_leave(a);
+	return ptr;
+}
+
+void _uk_alloc_stats_free(struct uk_alloc *a, void *ptr)
+{
+	size_t usable;
+
+	if (!ptr || stats_nested(a)) {
+		a->free(a, ptr);
+		return;
+	}
+
+	stats_enter(a);
+	usable = uk_alloc_getsize(a, ptr);
+	a->free(a, ptr);
+	count_free(a, usable);
+	stats_leave(a);
+}
+
+void *_uk_alloc_stats_palloc(struct uk_alloc *a, unsigned long num_pages)
+{
+	void *ptr;
+
+	if (stats_nested(a))
+		return a->palloc(a, num_pages);
+
+	stats_enter(a);
+	ptr = a->palloc(a, num_pages);
+	if (ptr)
+		count_alloc(a, num_pages * __PAGE_SIZE,
+			    num_pages * __PAGE_SIZE,
+			    __builtin_frame_address(0));
+	else if (num_pages)
+		a->stats.nb_enomem++;
+	stats_leave(a);
+	return ptr;
+}
+
+void _uk_alloc_stats_pfree(struct uk_alloc *a, void *ptr,
+			   unsigned long num_pages)
+{
+	if (!ptr || stats_nested(a)) {
+		a->pfree(a, ptr, num_pages);
+		return;
+	}
+
+	stats_enter(a);
+	a->pfree(a, ptr, num_pages);
+	count_free(a, num_pages * __PAGE_SIZE);
+	stats_leave(a);
+}
+
+void uk_alloc_stats_set_name(struct uk_alloc *a, const char *name)
+{
+	UK_ASSERT(a);
+	a->stats.name = name;
+}
+
+int uk_alloc_stats_get(struct uk_alloc *a, struct uk_alloc_stats *stats)
+{
+	if (!a || !stats)
+		return -EINVAL;
+
+	*stats = a->stats;
+	return 0;
+}
+
+void uk_alloc_stats_reset(struct uk_alloc *a)
+{
+	struct uk_alloc_stats *st;
+#if CONFIG_LIBUKALLOC_STATS_CALLSITES
+	unsigned int i;
+#endif
+
+	UK_ASSERT(a);
+	st = &a->stats;
+
+	st->nb_allocs = 0;
+	st->nb_frees = 0;
+	st->nb_reallocs = 0;
+	st->nb_enomem = 0;
+	st->max_nb_allocs = st->cur_nb_allocs;
+	st->max_mem_use = st->cur_mem_use;
+	st->max_alloc_size = 0;
+	memset(st->size_class, 0, sizeof(st->size_class));
+
+#if CONFIG_LIBUKALLOC_STATS_CALLSITES
+	for (i = 0; i < CALLSITES_MAX; i++)
+		if (callsites[i].a == a)
+			memset(&callsites[i], 0, sizeof(callsites[i]));
+#endif
+}
+
+unsigned int uk_alloc_stats_callsites(struct uk_alloc *a __maybe_unused,
+				      struct uk_alloc_callsite *cs
+				      __maybe_unused,
+				      unsigned int max __maybe_unused)
+{
+	unsigned int n = 0;
+#if CONFIG_LIBUKALLOC_STATS_CALLSITES
+	unsigned int i, j;
+
+	UK_ASSERT(cs || !max);
+
+	/* insertion into the (small) result array keeps the top `max` */
+	for (i = 0; i < CALLSITES_MAX; i++) {
+		struct uk_alloc_callsite *e = &callsites[i];
+
+		if (!e->samples || (a && e->a != a))
+			continue;
+		if (n == max && (!n || cs[n - 1].bytes >= e->bytes))
+			continue;
+
+		j = (n < max) ? n++ : n - 1;
+		while (j > 0 && cs[j - 1].bytes < e->bytes) {
+			cs[j] = cs[j - 1];
+			j--;
+		}
+		cs[j] = *e;
+	}
+#endif
+	return n;
+}
+
+static void stats_dump_one(struct uk_alloc *a)
+{
+	struct uk_alloc_stats st = a->stats;
+	unsigned int i;
+
+	if (st.name)
+		printf("ukalloc %s (%p):\n", st.name, a);
+	else
+		printf("ukalloc %p:\n", a);
+
+	printf("  allocs %llu, frees %llu, reallocs %llu, failed %llu\n",
+	       (unsigned long long) st.nb_allocs,
+	       (unsigned long long) st.nb_frees,
+	       (unsigned long long) st.nb_reallocs,
+	       (unsigned long long) st.nb_enomem);
+	printf("  live %lld (peak %lld), largest request %llu B\n",
+	       (long long) st.cur_nb_allocs, (long long) st.max_nb_allocs,
+	       (unsigned long long) st.max_alloc_size);
+	if (a->getsize || st.cur_mem_use || st.max_mem_use)
+		printf("  in use %lld B (peak %lld B)\n",
+		       (long long) st.cur_mem_use,
+		       (long long) st.max_mem_use);
+#if CONFIG_LIBUKALLOC_IFSTATS
+	if (a->availmem)
+		printf("  available %lld B\n",
+		       (long long) uk_alloc_availmem(a));
+#endif
+
+	printf("  sizes:");
+	for (i = 0; i < UK_ALLOC_STATS_NR_CLASSES; i++)
+		if (st.size_class[i])
+			printf(" %s%s:%llu", (i + 1 < UK_ALLOC_STATS_NR_CLASSES)
+						? "<=" : "",
+			       class_names[i],
+			       (unsigned long long) st.size_class[i]);
+	printf("\n");
+}
+
+#if CONFIG_LIBUKALLOC_STATS_CALLSITES
+#define CALLSITES_DUMP 16
+
+static void callsites_dump(struct uk_alloc *a)
+{
+	struct uk_alloc_callsite cs[CALLSITES_DUMP];
+	unsigned int i, n;
+
+	n = uk_alloc_stats_callsites(a, cs, CALLSITES_DUMP);
+	if (!n)
+		return;
+
+	printf("ukalloc call sites (1 in %d allocations sampled",
+	       CALLSITES_RATE);
+	if (callsites_dropped)
+		printf(", %llu samples dropped",
+		       (unsigned long long) callsites_dropped);
+	printf("):\n");
+	for (i = 0; i < n; i++)
+		printf("  %p <- %p on %p: ~%llu allocs, ~%llu B\n",
+		       cs[i].pc, cs[i].caller, cs[i].a,
+		       (unsigned long long) cs[i].samples * CALLSITES_RATE,
+		       (unsigned long long) cs[i].bytes * CALLSITES_RATE);
+}
+#endif /* CONFIG_LIBUKALLOC_STATS_CALLSITES */
+
+void uk_alloc_stats_dump(struct uk_alloc *a)
+{
+	struct uk_alloc *this;
+
+	if (a) {
+		stats_dump_one(a);
+	} else {
+		for (this = _uk_alloc_head; this; this = this->next)
+			stats_dump_one(this);
+	}
+
+#if CONFIG_LIBUKALLOC_STATS_CALLSITES
+	callsites_dump(a);
+#endif
+}
@@ -245,10 +245,12 @@ static inline unsigned long num_pages_to_order(unsigned long num_pages)
 /*********************
  * BINARY BUDDY PAGE ALLOCATOR
  */
+static void bbuddy_free_chunk(struct uk_bbpalloc *b, void *obj, size_t order);
+
 static void *bbuddy_palloc(struct uk_alloc *a, unsigned long num_pages)
 {
 	struct uk_bbpalloc *b;
-	size_t i;
+	size_t i, tail;
 	chunk_head_t *alloc_ch, *spare_ch;
 	chunk_tail_t *spare_ct;
 
@@ -291,6 +293,17 @@ static void *bbuddy_palloc(struct uk_alloc *a, unsigned long num_pages)
 	}
 	map_alloc(b, (uintptr_t)alloc_ch, 1UL << order);
 
+	/* Return the tail beyond num_pages right away instead of keeping a
+	 * whole power of two, e.g., a 5-page request keeps 5 pages and not
+	 * 8. The tail is split at its lowest set bits so that every piece
+	 * is aligned to its size.
+	 */
+	for (i = num_pages; i < (1UL << order); i += 1UL << tail) {
+		tail = (size_t)ukarch_ffsl(i);
+		bbuddy_free_chunk(b, (char *)alloc_ch + (i << __PAGE_SHIFT),
+				  tail);
+	}
+
 	return ((void *)alloc_ch);
 
 no_memory:
@@ -300,21 +313,12 @@ no_memory:
 	return NULL;
 }
 
-static void bbuddy_pfree(struct uk_alloc *a, void *obj, unsigned long num_pages)
+static void bbuddy_free_chunk(struct uk_bbpalloc *b, void *obj, size_t order)
 {
-	struct uk_bbpalloc *b;
 	chunk_head_t *freed_ch, *to_merge_ch;
 	chunk_tail_t *freed_ct;
 	unsigned long mask;
 
-	UK_ASSERT(a != NULL);
-	b = (struct uk_bbpalloc *)&a->priv;
-
-	size_t order = (size_t)num_pages_to_order(num_pages);
-
-	/* if the object is not page aligned it was clearly not from us */
-	UK_ASSERT((((uintptr_t)obj) & (__PAGE_SIZE - 1)) == 0);
-
 	/* First free the chunk */
 	map_free(b, (uintptr_t)obj, 1UL << order);
 
@@ -362,6 +366,31 @@ static void bbuddy_pfree(struct uk_alloc *a, void *obj, unsigned long num_pages)
 	b->free_head[order] = freed_ch;
 }
 
+static void bbuddy_pfree(struct uk_alloc *a, void *obj, unsigned long num_pages)
+{
+	struct uk_bbpalloc *b;
+	size_t order;
+
+	UK_ASSERT(a != NULL);
+	b = (struct uk_bbpalloc *)&a->priv;
+
+	/* if the object is not page aligned it was clearly not from us */
+	UK_ASSERT((((uintptr_t)obj) & (__PAGE_SIZE - 1)) == 0);
+	UK_ASSERT(num_pages != 0);
+
+	/* palloc() only keeps num_pages of its chunk (see there), so give
+	 * them back as the chunks of decreasing size they are made of. The
+	 * allocation was aligned to the next power of two, so each of them
+	 * is aligned to its own size.
+	 */
+	while (num_pages) {
+		order = (size_t)ukarch_flsl(num_pages);
+		bbuddy_free_chunk(b, obj, order);
+		obj = (char *)obj + (1UL << (order + __PAGE_SHIFT));
+		num_pages -= 1UL << order;
+	}
+}
+
 static int bbuddy_addmem(struct uk_alloc *a, void *base, size_t len)
 {
 	struct uk_bbpalloc *b;
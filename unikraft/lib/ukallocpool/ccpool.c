@@ -0,0 +1,623 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <uk/essentials.h>
+#include <uk/alloc_impl.h>
+#include <uk/ccpool.h>
+#include <uk/arch/atomic.h>
+#include <uk/arch/lcpu.h>
+#include <uk/assert.h>
+#include <uk/print.h>
+#if CONFIG_LIBUKSCHED
+#include <uk/sched.h>
+#include <uk/thread.h>
+#endif
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <errno.h>
+
+/*
+ * CONCURRENT POOL: MEMORY LAYOUT
+ *
+ *          ++---------------------++
+ *          || struct uk_ccpool    ||
+ *          ||  (+ thread caches)  ||
+ *          ++---------------------++
+ *          |    // padding //      |
+ *          +=======================+
+ *          |   OBJECT 1 (idx 1)    |
+ *          +=======================+
+ *          |   OBJECT 2 (idx 2)    |
+ *          +=======================+
+ *          |         ...           |
+ *          v                       v
+ *
+ * Free objects are kept in chains linked by `next`. The first object of
+ * a chain additionally records the chain length and the index of the
+ * next chain on the global stack. The stack head packs a 32-bit object
+ * index with a 32-bit tag that is incremented on every update, so a
+ * compare-and-swap fails whenever the head was popped and pushed again
+ * in between (ABA). Indices are 1-based; 0 terminates the stack.
+ */
+
+#define MIN_OBJ_ALIGN sizeof(void *)
+#define MIN_OBJ_LEN   sizeof(struct free_obj)
+
+#define MAG_SIZE      CONFIG_LIBUKALLOCPOOL_CCPOOL_MAGAZINE
+#define NR_CACHES     CONFIG_LIBUKALLOCPOOL_CCPOOL_CACHES
+
+#define POOL_ALIGN    __alignof__(struct uk_ccpool)
+
+#define HEAD_IDX(h)        ((__u32) ((h) & 0xffffffffULL))
+#define HEAD_TAG(h)        ((__u32) ((h) >> 32))
+#define HEAD_MAKE(tag, idx) (((__u64) (tag) << 32) | (__u64) (idx))
+
+struct free_obj {
+	struct free_obj *next;
+	/* only valid on the first object of a chain on the stack */
+	__u32 chain_next;
+	__u32 chain_len;
+};
+
+/* Two magazines per thread: `loaded` serves takes and returns, `prev`
+ * is either empty or full. Only the owning thread touches them.
+ */
+struct ccpool_cache {
+	void *owner;
+	struct free_obj *loaded;
+	unsigned int loaded_count;
+	struct free_obj *prev;
+	unsigned int prev_count;
+} __align(64);
+
+struct uk_ccpool {
+	struct uk_alloc self;
+
+	__u64 stack __align(64);
+	unsigned int stack_count;
+
+	size_t obj_align;
+	size_t obj_len;
+	unsigned int obj_count;
+	void *obj_base;
+
+	struct uk_alloc *parent;
+	void *base;
+
+	struct ccpool_cache cache[NR_CACHES];
+};
+
+UK_CTASSERT(MAG_SIZE > 0);
+UK_CTASSERT(NR_CACHES > 0);
+
+static inline struct uk_ccpool *ukalloc2ccpool(struct uk_alloc *a)
+{
+	UK_ASSERT(a);
+	return __containerof(a, struct uk_ccpool, self);
+}
+
+#define ccpool2ukalloc(p) \
+	(&(p)->self)
+
+struct uk_alloc *uk_ccpool2ukalloc(struct uk_ccpool *p)
+{
+	UK_ASSERT(p);
+	return ccpool2ukalloc(p);
+}
+
+static inline struct free_obj *_idx2obj(struct uk_ccpool *p, __u32 idx)
+{
+	UK_ASSERT(idx > 0 && idx <= p->obj_count);
+	return (struct free_obj *) ((uintptr_t) p->obj_base
+				    + (uintptr_t) (idx - 1) * p->obj_len);
+}
+
+static inline __u32 _obj2idx(struct uk_ccpool *p, struct free_obj *obj)
+{
+	uintptr_t off = (uintptr_t) obj - (uintptr_t) p->obj_base;
+
+	UK_ASSERT((uintptr_t) obj >= (uintptr_t) p->obj_base);
+	UK_ASSERT(off % p->obj_len == 0);
+	UK_ASSERT(off / p->obj_len < p->obj_count);
+	return (__u32) (off / p->obj_len) + 1;
+}
+
+/* Push a chain of `len` objects starting at `head` */
+static void _stack_push(struct uk_ccpool *p, struct free_obj *head,
+			unsigned int len)
+{
+	__u32 idx = _obj2idx(p, head);
+	__u64 old, new;
+
+	UK_ASSERT(len > 0);
+
+	head->chain_len = len;
+	do {
+		old = ukarch_load_n(&p->stack);
+		UK_WRITE_ONCE(head->chain_next, HEAD_IDX(old));
+		new = HEAD_MAKE(HEAD_TAG(old) + 1, idx);
+	} while (ukarch_compare_exchange_sync(&p->stack, old, new) != new);
+
+	ukarch_fetch_add(&p->stack_count, len);
+}
+
+/* Pop a whole chain; its length is returned in `len` */
+static struct free_obj *_stack_pop(struct uk_ccpool *p, unsigned int *len)
+{
+	struct free_obj *head;
+	__u64 old, new;
+
+	do {
+		old = ukarch_load_n(&p->stack);
+		if (HEAD_IDX(old) == 0)
+			return NULL;
+		head = _idx2obj(p, HEAD_IDX(old));
+		/* `head` may be taken concurrently, in which case the value
+		 * read here is stale but the tag makes the exchange fail
+		 */
+		new = HEAD_MAKE(HEAD_TAG(old) + 1,
+				UK_READ_ONCE(head->chain_next));
+	} while (ukarch_compare_exchange_sync(&p->stack, old, new) != new);
+
+	*len = head->chain_len;
+	ukarch_fetch_add(&p->stack_count, -(*len));
+	return head;
+}
+
+static struct ccpool_cache *_cache_get(struct uk_ccpool *p)
+{
+#if CONFIG_LIBUKSCHED
+	struct uk_sched *s = uk_sched_get_default();
+	struct ccpool_cache *c;
+	void *self;
+	unsigned int h, i;
+
+	if (unlikely(!s || !uk_sched_started(s)))
+		return NULL;
+
+	self = uk_thread_current();
+	h = (unsigned int) (((uintptr_t) self >> 6) % NR_CACHES);
+	if (likely(UK_READ_ONCE(p->cache[h].owner) == self))
+		return &p->cache[h];
+
+	for (i = 0; i < NR_CACHES; ++i)
+		if (UK_READ_ONCE(p->cache[i].owner) == self)
+			return &p->cache[i];
+
+	for (i = 0; i < NR_CACHES; ++i) {
+		c = &p->cache[(h + i) % NR_CACHES];
+		if (!UK_READ_ONCE(c->owner)
+		    && ukarch_compare_exchange_sync(&c->owner, NULL,
+						    self) == self)
+			return c;
+	}
+#endif
+	return NULL;
+}
+
+static inline int _cache_refill(struct uk_ccpool *p, struct ccpool_cache *c)
+{
+	UK_ASSERT(c->loaded_count == 0);
+
+	if (c->prev_count) {
+		c->loaded = c->prev;
+		c->loaded_count = c->prev_count;
+		c->prev = NULL;
+		c->prev_count = 0;
+		return 0;
+	}
+
+	c->loaded = _stack_pop(p, &c->loaded_count);
+	if (unlikely(!c->loaded)) {
+		c->loaded_count = 0;
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+static inline void _cache_spill(struct uk_ccpool *p, struct ccpool_cache *c)
+{
+	UK_ASSERT(c->loaded_count >= MAG_SIZE);
+
+	if (c->prev_count)
+		_stack_push(p, c->prev, c->prev_count);
+	c->prev = c->loaded;
+	c->prev_count = c->loaded_count;
+	c->loaded = NULL;
+	c->loaded_count = 0;
+}
+
+static void *_take_uncached(struct uk_ccpool *p)
+{
+	struct free_obj *obj;
+	unsigned int len;
+
+	obj = _stack_pop(p, &len);
+	if (unlikely(!obj))
+		return NULL;
+	if (len > 1)
+		_stack_push(p, obj->next, len - 1);
+	return obj;
+}
+
+void *uk_ccpool_take(struct uk_ccpool *p)
+{
+	struct ccpool_cache *c;
+	struct free_obj *obj;
+
+	UK_ASSERT(p);
+
+	c = _cache_get(p);
+	if (unlikely(!c))
+		return _take_uncached(p);
+
+	if (unlikely(c->loaded_count == 0) && _cache_refill(p, c) < 0)
+		return NULL;
+
+	obj = c->loaded;
+	c->loaded = obj->next;
+	c->loaded_count--;
+	return obj;
+}
+
+unsigned int uk_ccpool_take_batch(struct uk_ccpool *p,
+				  void *obj[], unsigned int count)
+{
+	struct ccpool_cache *c;
+	struct free_obj *head;
+	unsigned int len;
+	unsigned int i = 0;
+
+	UK_ASSERT(p);
+	UK_ASSERT(obj);
+
+	c = _cache_get(p);
+	if (c) {
+		while (i < count) {
+			if (c->loaded_count == 0 && _cache_refill(p, c) < 0)
+				break;
+			obj[i++] = c->loaded;
+			c->loaded = c->loaded->next;
+			c->loaded_count--;
+		}
+		return i;
+	}
+
+	while (i < count) {
+		head = _stack_pop(p, &len);
+		if (!head)
+			break;
+		for (; len && i < count; --len) {
+			obj[i++] = head;
+			head = head->next;
+		}
+		if (len)
+			_stack_push(p, head, len);
+	}
+	return i;
+}
+
+void uk_ccpool_return(struct uk_ccpool *p, void *obj)
+{
+	struct ccpool_cache *c;
+	struct free_obj *o = (struct free_obj *) obj;
+
+	UK_ASSERT(p);
+	UK_ASSERT(obj);
+
+	c = _cache_get(p);
+	if (unlikely(!c)) {
+		o->next = NULL;
+		_stack_push(p, o, 1);
+		return;
+	}
+
+	if (unlikely(c->loaded_count >= MAG_SIZE))
+		_cache_spill(p, c);
+
+	o->next = c->loaded;
+	c->loaded = o;
+	c->loaded_count++;
+}
+
+void uk_ccpool_return_batch(struct uk_ccpool *p,
+			    void *obj[], unsigned int count)
+{
+	struct ccpool_cache *c;
+	struct free_obj *head, *o;
+	unsigned int i, len;
+
+	UK_ASSERT(p);
+	UK_ASSERT(obj);
+
+	c = _cache_get(p);
+	if (c && c->loaded_count + count <= MAG_SIZE) {
+		for (i = 0; i < count; ++i) {
+			o = (struct free_obj *) obj[i];
+			o->next = c->loaded;
+			c->loaded = o;
+		}
+		c->loaded_count += count;
+		return;
+	}
+
+	/* Link the objects into chains of magazine size and hand each
+	 * chain over with a single exchange
+	 */
+	while (count) {
+		len = MIN(count, (unsigned int) MAG_SIZE);
+		head = NULL;
+		for (i = 0; i < len; ++i) {
+			o = (struct free_obj *) obj[--count];
+			o->next = head;
+			head = o;
+		}
+		_stack_push(p, head, len);
+	}
+}
+
+void uk_ccpool_flush(struct uk_ccpool *p)
+{
+#if CONFIG_LIBUKSCHED
+	struct uk_sched *s = uk_sched_get_default();
+	void *self;
+	unsigned int i;
+
+	UK_ASSERT(p);
+
+	if (!s || !uk_sched_started(s))
+		return;
+
+	self = uk_thread_current();
+	for (i = 0; i < NR_CACHES; ++i) {
+		struct ccpool_cache *c = &p->cache[i];
+
+		if (UK_READ_ONCE(c->owner) != self)
+			continue;
+		if (c->loaded_count)
+			_stack_push(p, c->loaded, c->loaded_count);
+		if (c->prev_count)
+			_stack_push(p, c->prev, c->prev_count);
+		c->loaded = c->prev = NULL;
+		c->loaded_count = c->prev_count = 0;
+		ukarch_store_n(&c->owner, NULL);
+	}
+#else
+	UK_ASSERT(p);
+#endif
+}
+
+static void ccpool_free(struct uk_alloc *a, void *ptr)
+{
+	struct uk_ccpool *p = ukalloc2ccpool(a);
+
+	if (likely(ptr))
+		uk_ccpool_return(p, ptr);
+}
+
+static void *ccpool_malloc(struct uk_alloc *a, size_t size)
+{
+	struct uk_ccpool *p = ukalloc2ccpool(a);
+	void *obj;
+
+	if (unlikely(size > p->obj_len)) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	obj = uk_ccpool_take(p);
+	if (unlikely(!obj))
+		errno = ENOMEM;
+	return obj;
+}
+
+static int ccpool_posix_memalign(struct uk_alloc *a, void **memptr,
+				 size_t align, size_t size)
+{
+	struct uk_ccpool *p = ukalloc2ccpool(a);
+	void *obj;
+
+	if (unlikely((size > p->obj_len)
+		     || (align > p->obj_align)))
+		return ENOMEM;
+
+	obj = uk_ccpool_take(p);
+	if (unlikely(!obj))
+		return ENOMEM;
+
+	*memptr = obj;
+	return 0;
+}
+
+unsigned int uk_ccpool_availcount(struct uk_ccpool *p)
+{
+	unsigned int count;
+	unsigned int i;
+
+	UK_ASSERT(p);
+
+	count = ukarch_load_n(&p->stack_count);
+	for (i = 0; i < NR_CACHES; ++i)
+		count += UK_READ_ONCE(p->cache[i].loaded_count)
+			 + UK_READ_ONCE(p->cache[i].prev_count);
+	return count;
+}
+
+size_t uk_ccpool_objlen(struct uk_ccpool *p)
+{
+	return p->obj_len;
+}
+
+static size_t ccpool_getsize(struct uk_alloc *a, const void *ptr __unused)
+{
+	return ukalloc2ccpool(a)->obj_len;
+}
+
+#if CONFIG_LIBUKALLOC_IFSTATS
+static ssize_t ccpool_availmem(struct uk_alloc *a)
+{
+	struct uk_ccpool *p = ukalloc2ccpool(a);
+
+	return (size_t) uk_ccpool_availcount(p) * p->obj_len;
+}
+#endif
+
+size_t uk_ccpool_reqmem(unsigned int obj_count, size_t obj_len,
+			size_t obj_align)
+{
+	size_t obj_alen;
+
+	UK_ASSERT(POWER_OF_2(obj_align));
+
+	obj_len   = MAX(obj_len, MIN_OBJ_LEN);
+	obj_align = MAX(obj_align, MIN_OBJ_ALIGN);
+	obj_alen  = ALIGN_UP(obj_len, obj_align);
+	return (POOL_ALIGN + sizeof(struct uk_ccpool)
+		+ obj_align
+		+ ((size_t) obj_count * obj_alen));
+}
+
+struct uk_ccpool *uk_ccpool_init(void *base, size_t len,
+				 size_t obj_len, size_t obj_align)
+{
+	struct uk_ccpool *p;
+	struct uk_alloc *a;
+	struct free_obj *head, *obj;
+	size_t obj_alen;
+	size_t left;
+	void *obj_ptr;
+	__u32 idx, clen, i;
+
+	UK_ASSERT(POWER_OF_2(obj_align));
+
+	if (!base || sizeof(struct uk_ccpool) + POOL_ALIGN > len) {
+		errno = ENOSPC;
+		return NULL;
+	}
+
+	/* apply minimum requirements */
+	obj_len   = MAX(obj_len, MIN_OBJ_LEN);
+	obj_align = MAX(obj_align, MIN_OBJ_ALIGN);
+
+	/* keep the stack head and the caches on their own cache lines */
+	p = (struct uk_ccpool *) ALIGN_UP((uintptr_t) base, POOL_ALIGN);
+	memset(p, 0, sizeof(*p));
+	a = ccpool2ukalloc(p);
+
+	obj_alen = ALIGN_UP(obj_len, obj_align);
+	obj_ptr = (void *) ALIGN_UP((uintptr_t) p + sizeof(*p),
+				    obj_align);
+	p->obj_base  = obj_ptr;
+	p->obj_len   = obj_alen;
+	p->obj_align = obj_align;
+	p->base      = base;
+	p->parent    = NULL;
+
+	if ((uintptr_t) obj_ptr > (uintptr_t) base + len) {
+		uk_pr_debug("%p: Empty pool: Not enough space for allocating objects\n",
+			    p);
+		goto out;
+	}
+
+	left = len - ((uintptr_t) obj_ptr - (uintptr_t) base);
+	p->obj_count = (unsigned int) MIN(left / obj_alen,
+					  (size_t) UINT32_MAX - 1);
+
+	/* Pre-link the objects into magazine-sized chains */
+	for (idx = p->obj_count; idx > 0; idx -= clen) {
+		clen = MIN(idx, (__u32) MAG_SIZE);
+		head = NULL;
+		for (i = 0; i < clen; ++i) {
+			obj = _idx2obj(p, idx - i);
+			obj->next = head;
+			head = obj;
+		}
+		_stack_push(p, head, clen);
+	}
+
+out:
+	uk_alloc_init_malloc(a,
+			     ccpool_malloc,
+			     uk_calloc_compat,
+			     uk_realloc_compat,
+			     ccpool_free,
+			     ccpool_posix_memalign,
+			     uk_memalign_compat,
+			     NULL);
+	p->self.getsize = ccpool_getsize;
+#if CONFIG_LIBUKALLOC_IFSTATS
+	p->self.availmem = ccpool_availmem;
+#endif
+
+	uk_pr_debug("%p: Concurrent pool created (%"__PRIsz" B): %u objs of %"__PRIsz" B, aligned to %"__PRIsz" B\n",
+		    p, len, p->obj_count, p->obj_len, p->obj_align);
+	return p;
+}
+
+struct uk_ccpool *uk_ccpool_alloc(struct uk_alloc *parent,
+				  unsigned int obj_count,
+				  size_t obj_len, size_t obj_align)
+{
+	struct uk_ccpool *p;
+	void *base;
+	size_t len;
+
+	/* uk_ccpool_reqmem computes minimum requirement */
+	len = uk_ccpool_reqmem(obj_count, obj_len, obj_align);
+	base = uk_malloc(parent, len);
+	if (!base)
+		return NULL;
+
+	p = uk_ccpool_init(base, len, obj_len, obj_align);
+	if (!p) {
+		uk_free(parent, base);
+		errno = ENOSPC;
+		return NULL;
+	}
+
+	p->parent = parent;
+	return p;
+}
+
+void uk_ccpool_free(struct uk_ccpool *p)
+{
+	/* Same restrictions as uk_allocpool_free() */
+	UK_ASSERT(p->parent);
+
+	/* Make sure we got all objects back */
+	UK_ASSERT(ukarch_load_n(&p->stack_count) == p->obj_count);
+
+	/* FIXME: Unregister `ukalloc` interface from `lib/ukalloc` */
+	UK_CRASH("Unregistering from `lib/ukalloc` not implemented.\n");
+
+	uk_free(p->parent, p->base);
+}
@@ -0,0 +1,218 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __LIBUKALLOCPOOL_CCPOOL_H__
+#define __LIBUKALLOCPOOL_CCPOOL_H__
+
+#include <uk/alloc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Concurrent variant of uk_allocpool. Free objects live on a lock-free
+ * global stack (Treiber stack with a tagged head against ABA) of
+ * chains, so that a whole chain of objects is moved with a single
+ * compare-and-swap. In front of it, every thread gets a small cache of
+ * two magazines (CONFIG_LIBUKALLOCPOOL_CCPOOL_MAGAZINE objects each)
+ * that is served without any atomic operation.
+ *
+ * A thread that stops using a pool (e.g., before it exits) should call
+ * uk_ccpool_flush() so that its cached objects go back to the global
+ * stack and its cache slot can be reused. Threads that do not find a
+ * free slot (CONFIG_LIBUKALLOCPOOL_CCPOOL_CACHES) and code that runs
+ * before the scheduler is started operate directly on the global stack.
+ * The pool must not be used from interrupt context.
+ */
+struct uk_ccpool;
+
+/**
+ * Computes the required memory for a concurrent pool allocation.
+ *
+ * @param obj_count
+ *  Number of objects that are allocated with the pool.
+ * @param obj_len
+ *  Size of one object (bytes).
+ * @param obj_align
+ *  Alignment requirement for each pool object.
+ * @return
+ *  Number of bytes needed for pool allocation.
+ */
+size_t uk_ccpool_reqmem(unsigned int obj_count, size_t obj_len,
+			size_t obj_align);
+
+/**
+ * Allocates a concurrent memory pool on a parent allocator.
+ *
+ * @param parent
+ *  Allocator on which the pool will be allocated.
+ * @param obj_count
+ *  Number of objects that are allocated with the pool.
+ * @param obj_len
+ *  Size of one object (bytes).
+ * @param obj_align
+ *  Alignment requirement for each pool object.
+ * @return
+ *  - (NULL): If allocation failed (e.g., ENOMEM).
+ *  - pointer to allocated pool.
+ */
+struct uk_ccpool *uk_ccpool_alloc(struct uk_alloc *parent,
+				  unsigned int obj_count,
+				  size_t obj_len, size_t obj_align);
+
+/**
+ * Frees a concurrent memory pool that was allocated with
+ * uk_ccpool_alloc(). The memory is returned to the parent allocator.
+ * Note: All taken objects have to be returned and all thread caches
+ * flushed before free'ing the pool.
+ *
+ * @param p
+ *  Pointer to memory pool that will be free'd.
+ */
+void uk_ccpool_free(struct uk_ccpool *p);
+
+/**
+ * Initializes a concurrent memory pool on a given memory range.
+ *
+ * @param base
+ *  Base address of memory range.
+ * @param len
+ *  Length of memory range (bytes).
+ * @param obj_len
+ *  Size of one object (bytes).
+ * @param obj_align
+ *  Alignment requirement for each pool object.
+ * @return
+ *  - (NULL): Not enough memory for pool.
+ *  - pointer to initializes pool.
+ */
+struct uk_ccpool *uk_ccpool_init(void *base, size_t len,
+				 size_t obj_len, size_t obj_align);
+
+/**
+ * Return uk_alloc compatible interface for a concurrent pool.
+ *
+ * @param p
+ *  Pointer to memory pool.
+ * @return
+ *  Pointer to uk_alloc interface of given pool.
+ */
+struct uk_alloc *uk_ccpool2ukalloc(struct uk_ccpool *p);
+
+/**
+ * Return the number of currently available (free) objects, including
+ * the ones sitting in thread caches. The value is a snapshot only.
+ *
+ * @param p
+ *  Pointer to memory pool.
+ * @return
+ *  Number of free objects in the pool.
+ */
+unsigned int uk_ccpool_availcount(struct uk_ccpool *p);
+
+/**
+ * Return the size of an object.
+ *
+ * @param p
+ *  Pointer to memory pool.
+ * @return
+ *  Size of an object.
+ */
+size_t uk_ccpool_objlen(struct uk_ccpool *p);
+
+/**
+ * Get one object from a pool.
+ *
+ * @param p
+ *  Pointer to memory pool.
+ * @return
+ *  - (NULL): No more free objects available to this thread.
+ *  - Pointer to object.
+ */
+void *uk_ccpool_take(struct uk_ccpool *p);
+
+/**
+ * Get multiple objects from a pool. Objects are taken from the thread
+ * cache first, then whole chains are popped from the global stack.
+ *
+ * @param p
+ *  Pointer to memory pool.
+ * @param obj
+ *  Pointer to array that will be filled with pointers of
+ *  allocated objects from the pool.
+ * @param count
+ *  Maximum number of objects that should be taken from the pool.
+ * @return
+ *  Number of successfully allocated objects on the given array.
+ */
+unsigned int uk_ccpool_take_batch(struct uk_ccpool *p,
+				  void *obj[], unsigned int count);
+
+/**
+ * Return one object back to a pool.
+ *
+ * @param p
+ *  Pointer to memory pool.
+ * @param obj
+ *  Pointer to object that should be returned.
+ */
+void uk_ccpool_return(struct uk_ccpool *p, void *obj);
+
+/**
+ * Return multiple objects to a pool. Objects that do not fit into the
+ * thread cache are linked into chains of magazine size, each pushed to
+ * the global stack with a single compare-and-swap.
+ *
+ * @param p
+ *  Pointer to memory pool.
+ * @param obj
+ *  Pointer to array that with pointers of objects that
+ *  should be returned.
+ * @param count
+ *  Number of objects that are on the array.
+ */
+void uk_ccpool_return_batch(struct uk_ccpool *p,
+			    void *obj[], unsigned int count);
+
+/**
+ * Move the objects cached by the calling thread back to the global
+ * stack and release its cache slot.
+ *
+ * @param p
+ *  Pointer to memory pool.
+ */
+void uk_ccpool_flush(struct uk_ccpool *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBUKALLOCPOOL_CCPOOL_H__ */
@@ -180,13 +180,11 @@ unsigned int uk_allocpool_take_batch(struct uk_allocpool *p,
 	UK_ASSERT(p);
 	UK_ASSERT(obj);
 
-	for (i = 0; i < count; ++i) {
-		if (unlikely(uk_list_empty(&p->free_obj)))
-			break;
+	count = MIN(count, p->free_obj_count);
+	for (i = 0; i < count; ++i)
 		obj[i] = _take_free_obj(p);
-	}
 
-	return i;
+	return count;
 }
 
 void uk_allocpool_return(struct uk_allocpool *p, void *obj)
@@ -208,6 +206,11 @@ void uk_allocpool_return_batch(struct uk_allocpool *p,
 		_prepend_free_obj(p, obj[i]);
 }
 
+static size_t pool_getsize(struct uk_alloc *a, const void *ptr __unused)
+{
+	return ukalloc2pool(a)->obj_len;
+}
+
 #if CONFIG_LIBUKALLOC_IFSTATS
 static ssize_t pool_availmem(struct uk_alloc *a)
 {
@@ -301,6 +304,7 @@ out:
 			     pool_posix_memalign,
 			     uk_memalign_compat,
 			     NULL);
+	p->self.getsize = pool_getsize;
 #if CONFIG_LIBUKALLOC_IFSTATS
 	p->self.availmem = pool_availmem;
 #endif
@@ -0,0 +1,284 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* Arenas: chained regions with mark/release, see <uk/arena.h>. */
+
+#include <string.h>
+#include <uk/arena.h>
+#include <uk/alloc_impl.h>
+#include <uk/print.h>
+#include <uk/page.h>
+
+#define CHUNK_HDR_SIZE	ALIGN_UP(sizeof(struct uk_arena_chunk),	\
+				 (size_t) UK_ARENA_ALIGN)
+
+#define chunk_start(c)	((uintptr_t)(c) + CHUNK_HDR_SIZE)
+#define chunk_end(c)	((uintptr_t)(c) + ((c)->num_pages << __PAGE_SHIFT))
+#define first_chunk(ar)	((struct uk_arena_chunk *)			\
+			 ((uintptr_t)(ar) - CHUNK_HDR_SIZE))
+
+static struct uk_arena_chunk *chunk_get(struct uk_arena *ar,
+					unsigned long num_pages)
+{
+	struct uk_arena_chunk *c;
+
+	if (num_pages == ar->chunk_pages && ar->spare) {
+		c = ar->spare;
+		ar->spare = NULL;
+	} else {
+		c = uk_palloc(ar->parent, num_pages);
+		if (unlikely(!c))
+			return NULL;
+		c->num_pages = num_pages;
+	}
+
+	c->prev = ar->chunk;
+	ar->chunk = c;
+	ar->top = chunk_start(c);
+	ar->end = chunk_end(c);
+	return c;
+}
+
+static void chunk_put(struct uk_arena *ar, struct uk_arena_chunk *c)
+{
+	if (c->num_pages == ar->chunk_pages && !ar->spare) {
+		ar->spare = c;
+		return;
+	}
+	uk_pfree(ar->parent, c, c->num_pages);
+}
+
+void *_uk_arena_alloc_chunk(struct uk_arena *ar, size_t size, size_t align)
+{
+	unsigned long num_pages;
+	size_t need;
+
+	UK_ASSERT(ar);
+
+	if (unlikely(!size))
+		return NULL;
+
+	/* Worst case: the chunk start is only UK_ARENA_ALIGN-aligned */
+	need = CHUNK_HDR_SIZE + size + align;
+	if (unlikely(need < size)) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	num_pages = MAX(ar->chunk_pages, DIV_ROUND_UP(need, __PAGE_SIZE));
+
+	if (unlikely(!chunk_get(ar, num_pages))) {
+		errno = ENOMEM;
+		return NULL;
+	}
+	return uk_arena_alloc_aligned(ar, size, align);
+}
+
+void uk_arena_release(struct uk_arena *ar, struct uk_arena_mark m)
+{
+	struct uk_arena_chunk *c;
+
+	UK_ASSERT(ar);
+	/* Releasing to a mark of a scope that was already closed */
+	UK_ASSERT(m.depth && m.depth <= ar->depth);
+
+	while (ar->chunk != m.chunk) {
+		c = ar->chunk;
+		UK_ASSERT(c != first_chunk(ar));
+		ar->chunk = c->prev;
+		chunk_put(ar, c);
+	}
+
+	ar->top = m.top;
+	ar->end = chunk_end(ar->chunk);
+	ar->depth = m.depth - 1;
+}
+
+void uk_arena_reset(struct uk_arena *ar)
+{
+	struct uk_arena_mark m = {
+		.chunk = first_chunk(ar),
+		.top = ar->base,
+		.depth = 1,
+	};
+
+	UK_ASSERT(ar);
+	ar->depth = MAX(ar->depth, 1U);
+	uk_arena_release(ar, m);
+}
+
+void uk_arena_destroy(struct uk_arena *ar)
+{
+	struct uk_alloc *parent;
+
+	UK_ASSERT(ar);
+	uk_arena_reset(ar);
+
+	parent = ar->parent;
+	if (ar->spare)
+		uk_pfree(parent, ar->spare, ar->spare->num_pages);
+	uk_pfree(parent, first_chunk(ar), first_chunk(ar)->num_pages);
+}
+
+/*
+ * uk_alloc interface. Each object is preceded by its size so that
+ * realloc() can copy it, and so that the last object can be freed or
+ * resized in place.
+ */
+struct arena_objhdr {
+	size_t size;
+	size_t pad;
+};
+
+UK_CTASSERT(sizeof(struct arena_objhdr) == UK_ARENA_ALIGN);
+
+#define to_arena(a)	__containerof(a, struct uk_arena, ifalloc)
+#define to_objhdr(ptr)	((struct arena_objhdr *)(ptr) - 1)
+
+static int arena_posix_memalign(struct uk_alloc *a, void **memptr,
+				size_t align, size_t size)
+{
+	struct arena_objhdr *hdr;
+	size_t hdrlen;
+	char *p;
+
+	if (((align - 1) & align) != 0 || (align % sizeof(void *)) != 0)
+		return EINVAL;
+	if (!size)
+		return EINVAL;
+
+	align = MAX(align, (size_t) UK_ARENA_ALIGN);
+	hdrlen = ALIGN_UP(sizeof(*hdr), align);
+	if (unlikely(size + hdrlen < size))
+		return ENOMEM;
+
+	p = uk_arena_alloc_aligned(to_arena(a), size + hdrlen, align);
+	if (unlikely(!p))
+		return ENOMEM;
+
+	*memptr = p + hdrlen;
+	hdr = to_objhdr(*memptr);
+	hdr->size = size;
+	return 0;
+}
+
+static void *arena_malloc(struct uk_alloc *a, size_t size)
+{
+	void *ptr;
+
+	if (arena_posix_memalign(a, &ptr, UK_ARENA_ALIGN, size))
+		return NULL;
+	return ptr;
+}
+
+static inline int arena_is_last(struct uk_arena *ar, void *ptr)
+{
+	return (uintptr_t) ptr + to_objhdr(ptr)->size == ar->top;
+}
+
+static void arena_free(struct uk_alloc *a, void *ptr)
+{
+	struct uk_arena *ar = to_arena(a);
+
+	if (ptr && arena_is_last(ar, ptr))
+		ar->top = (uintptr_t) to_objhdr(ptr);
+}
+
+static void *arena_realloc(struct uk_alloc *a, void *ptr, size_t size)
+{
+	struct uk_arena *ar = to_arena(a);
+	void *retptr;
+
+	if (!ptr)
+		return arena_malloc(a, size);
+	if (!size) {
+		arena_free(a, ptr);
+		return NULL;
+	}
+
+	if (arena_is_last(ar, ptr) && (uintptr_t) ptr + size <= ar->end
+	    && (uintptr_t) ptr + size > (uintptr_t) ptr) {
+		ar->top = (uintptr_t) ptr + size;
+		to_objhdr(ptr)->size = size;
+		return ptr;
+	}
+
+	retptr = arena_malloc(a, size);
+	if (unlikely(!retptr))
+		return NULL;
+	memcpy(retptr, ptr, MIN(size, to_objhdr(ptr)->size));
+	return retptr;
+}
+
+static size_t arena_getsize(struct uk_alloc *a __unused, const void *ptr)
+{
+	return to_objhdr(ptr)->size;
+}
+
+struct uk_arena *uk_arena_create(struct uk_alloc *parent, size_t chunk_size)
+{
+	struct uk_arena_chunk *c;
+	struct uk_arena *ar;
+	unsigned long num_pages;
+
+	UK_ASSERT(parent);
+
+	num_pages = DIV_ROUND_UP(MAX(chunk_size,
+				     CHUNK_HDR_SIZE + sizeof(*ar)),
+				 __PAGE_SIZE);
+	c = uk_palloc(parent, num_pages);
+	if (!c) {
+		uk_pr_err("Not enough memory for arena\n");
+		return NULL;
+	}
+	c->prev = NULL;
+	c->num_pages = num_pages;
+
+	ar = (struct uk_arena *) chunk_start(c);
+	memset(ar, 0, sizeof(*ar));
+	ar->parent = parent;
+	ar->chunk_pages = num_pages;
+	ar->chunk = c;
+	ar->base = ALIGN_UP((uintptr_t) (ar + 1), (uintptr_t) UK_ARENA_ALIGN);
+	ar->top = ar->base;
+	ar->end = chunk_end(c);
+
+	ar->ifalloc.malloc         = arena_malloc;
+	ar->ifalloc.calloc         = uk_calloc_compat;
+	ar->ifalloc.realloc        = arena_realloc;
+	ar->ifalloc.posix_memalign = arena_posix_memalign;
+	ar->ifalloc.memalign       = uk_memalign_compat;
+	ar->ifalloc.free           = arena_free;
+	ar->ifalloc.palloc         = uk_palloc_compat;
+	ar->ifalloc.pfree          = uk_pfree_compat;
+	ar->ifalloc.addmem         = NULL;
+	ar->ifalloc.getsize        = arena_getsize;
+
+	return ar;
+}
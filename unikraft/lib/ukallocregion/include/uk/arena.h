@@ -0,0 +1,176 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __LIBUKALLOCREGION_ARENA_H__
+#define __LIBUKALLOCREGION_ARENA_H__
+
+#include <stdint.h>
+#include <uk/alloc.h>
+#include <uk/essentials.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * An arena is a region that can be rolled back. Allocations bump a
+ * pointer in the current chunk and are never freed one by one. Instead,
+ * a mark taken with uk_arena_mark() records the current position and
+ * uk_arena_release() frees everything allocated since then, in O(1) plus
+ * one parent pfree() per chunk that is dropped. Marks nest: a scope is
+ * opened by taking a mark and closed by releasing to it, in LIFO order.
+ *
+ * When the current chunk is full, a new chunk is taken from the parent
+ * allocator and chained to it. Requests larger than a chunk get a
+ * dedicated chunk of their own.
+ *
+ * Arenas are not thread-safe.
+ */
+
+/* All allocations are aligned to this, like malloc() */
+#define UK_ARENA_ALIGN		16
+
+struct uk_arena_chunk {
+	struct uk_arena_chunk *prev;
+	/* Number of pages of this chunk */
+	unsigned long num_pages;
+};
+
+/* The members are only public for the inline fast path */
+struct uk_arena {
+	uintptr_t top;
+	uintptr_t end;
+	struct uk_arena_chunk *chunk;
+	/* One dropped chunk kept for reuse */
+	struct uk_arena_chunk *spare;
+	struct uk_alloc *parent;
+	unsigned long chunk_pages;
+	/* Start of the first allocation, for uk_arena_reset() */
+	uintptr_t base;
+	unsigned int depth;
+	struct uk_alloc ifalloc;
+};
+
+struct uk_arena_mark {
+	struct uk_arena_chunk *chunk;
+	uintptr_t top;
+	unsigned int depth;
+};
+
+/**
+ * Creates an arena whose chunks are `chunk_size` bytes (rounded up to
+ * pages) taken from `parent`. The arena itself lives in its first chunk.
+ *
+ * @return
+ *  - (NULL): `parent` is out of memory.
+ *  - pointer to the arena.
+ */
+struct uk_arena *uk_arena_create(struct uk_alloc *parent, size_t chunk_size);
+
+/**
+ * Returns all chunks, including the one holding `ar`, to the parent.
+ */
+void uk_arena_destroy(struct uk_arena *ar);
+
+/* Slow path of uk_arena_alloc(): chains a new chunk */
+void *_uk_arena_alloc_chunk(struct uk_arena *ar, size_t size, size_t align);
+
+/**
+ * Allocates `size` bytes aligned to `align` (a power of two).
+ *
+ * @return
+ *  - (NULL): the parent is out of memory, or size is 0.
+ *  - pointer to the allocated memory.
+ */
+static inline void *uk_arena_alloc_aligned(struct uk_arena *ar, size_t size,
+					   size_t align)
+{
+	uintptr_t p;
+
+	UK_ASSERT(ar);
+	UK_ASSERT(align && !(align & (align - 1)));
+
+	p = ALIGN_UP(ar->top, (uintptr_t) align);
+	if (likely(size && p + size <= ar->end && p + size > p)) {
+		ar->top = p + size;
+		return (void *) p;
+	}
+	return _uk_arena_alloc_chunk(ar, size, align);
+}
+
+static inline void *uk_arena_alloc(struct uk_arena *ar, size_t size)
+{
+	return uk_arena_alloc_aligned(ar, size, UK_ARENA_ALIGN);
+}
+
+/**
+ * Returns the current position of `ar`, to be passed to
+ * uk_arena_release(). Opens a nested scope.
+ */
+static inline struct uk_arena_mark uk_arena_mark(struct uk_arena *ar)
+{
+	struct uk_arena_mark m;
+
+	UK_ASSERT(ar);
+	m.chunk = ar->chunk;
+	m.top = ar->top;
+	m.depth = ++ar->depth;
+	return m;
+}
+
+/**
+ * Frees everything allocated since `m` was taken, and closes its scope
+ * together with all scopes opened after it.
+ */
+void uk_arena_release(struct uk_arena *ar, struct uk_arena_mark m);
+
+/**
+ * Frees everything allocated in `ar` and closes all scopes. Keeps the
+ * first chunk and at most one spare.
+ */
+void uk_arena_reset(struct uk_arena *ar);
+
+/**
+ * Returns a uk_alloc interface to `ar`, so that code written against
+ * uk_malloc() can allocate from it. free() is a no-op, except that
+ * freeing or reallocating the last allocation reuses its space. The
+ * interface is not registered as a system allocator.
+ */
+static inline struct uk_alloc *uk_arena2ukalloc(struct uk_arena *ar)
+{
+	UK_ASSERT(ar);
+	return &ar->ifalloc;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBUKALLOCREGION_ARENA_H__ */
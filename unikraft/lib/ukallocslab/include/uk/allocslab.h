@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __LIBUKALLOCSLAB_H__
+#define __LIBUKALLOCSLAB_H__
+
+#include <uk/alloc.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct uk_allocslab_stats {
+	/* Objects currently handed out from slabs */
+	unsigned long objs;
+	/* Bytes of those objects, rounded up to their size class */
+	size_t obj_bytes;
+	/* Pages held by slabs (including free objects and spare slabs) */
+	unsigned long slab_pages;
+	/* Allocations forwarded to the backend because they were too large */
+	unsigned long large_allocs;
+	unsigned long mallocs;
+	unsigned long frees;
+	/* Requests served from / returned to a magazine */
+	unsigned long magazine_hits;
+};
+
+/**
+ * Creates a size-class allocator on top of `backend`.
+ *
+ * Requests up to the largest size class (about half a page) are served
+ * from slabs: single backend pages cut into equal objects, with a small
+ * header at the start of the page. Recently freed objects are cached in
+ * a per-class magazine so that malloc/free pairs do not touch the slab
+ * headers. Larger requests, palloc/pfree and addmem are forwarded to
+ * `backend`, which may be any uk_alloc implementation.
+ *
+ * The new allocator is registered but does not become the default one;
+ * see uk_alloc_set_default().
+ *
+ * @param backend
+ *  Allocator providing the pages
+ * @return
+ *  - (NULL): Not enough memory for the allocator metadata.
+ *  - pointer to the new allocator.
+ */
+struct uk_alloc *uk_allocslab_init(struct uk_alloc *backend);
+
+/**
+ * Returns the allocator that `a` forwards to, or NULL if `a` is not a
+ * slab allocator.
+ */
+struct uk_alloc *uk_allocslab_backend(struct uk_alloc *a);
+
+/**
+ * Fills `stats` with the counters of slab allocator `a`.
+ *
+ * @return
+ *  0 on success, -EINVAL if `a` is not a slab allocator.
+ */
+int uk_allocslab_stats(struct uk_alloc *a, struct uk_allocslab_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LIBUKALLOCSLAB_H__ */
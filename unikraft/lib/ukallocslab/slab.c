@@ -0,0 +1,644 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* ukallocslab is a size-class front-end for any uk_alloc.
+ *
+ * Small requests are rounded up to one of a fixed set of size classes and
+ * served from slabs. A slab is a single backend page with a header at its
+ * start, followed by equally sized objects. free() finds the slab of an
+ * object by rounding its address down and looking the page up in a hash
+ * set of all slab pages. Pointers whose page is not in the set belong to
+ * the backend. The page of a backend allocation is never read, since it
+ * may start with anything, e.g. with the data of another block of a TLSF
+ * heap.
+ *
+ * The class sizes are chosen so that a 4 KiB page is cut into objects
+ * with no more than a few bytes left over, and so that every class that
+ * may hold a 16-byte aligned type is a multiple of 16.
+ *
+ * Freed objects first go to a small per-class magazine, from which the
+ * next allocations of that class are served. This keeps alternating
+ * malloc/free pairs away from the slab headers and the partial lists.
+ * There is only one magazine per class for now: allocations do not
+ * block, and with the cooperative scheduler on a single CPU this is
+ * equivalent to per-thread magazines without the lookup cost. Once SMP
+ * exists, it would become a per-CPU array.
+ */
+
+#include <string.h>
+#include <uk/allocslab.h>
+#include <uk/alloc_impl.h>
+#include <uk/essentials.h>
+#include <uk/assert.h>
+#include <uk/print.h>
+#include <uk/page.h>
+
+#define SLAB_HDR_SIZE		64
+#define SLAB_MAGIC		((uintptr_t) 0x51ab51ab51ab51abULL)
+#define SLAB_MAGAZINE		CONFIG_LIBUKALLOCSLAB_MAGAZINE
+
+static const size_t class_sizes[] = {
+	8, 16, 24, 32, 48, 64, 80, 96, 112, 128, 160, 192, 224, 256,
+	320, 384, 448, 496, 576, 672, 800, 1008, 1344, 2016
+};
+
+#define NB_CLASSES		ARRAY_SIZE(class_sizes)
+#define SLAB_MAX_SIZE		2016
+
+/* The slab set is grown when it is more than 3/4 full */
+#define SLAB_SET_MIN_ORDER	9
+#define SLAB_SET_HASH		0x9e3779b97f4a7c15ULL
+
+struct slab_cache;
+
+struct slab {
+	/* SLAB_MAGIC ^ address of the slab, must be the first member */
+	uintptr_t magic;
+	struct slab_cache *cache;
+	/* Objects returned to this slab */
+	void *free;
+	/* First object that was never handed out */
+	char *bump;
+	unsigned int inuse;
+	unsigned int on_partial;
+	struct slab *next;
+	struct slab *prev;
+};
+
+UK_CTASSERT(sizeof(struct slab) <= SLAB_HDR_SIZE);
+
+struct slab_cache {
+	struct uk_allocslab *owner;
+	size_t size;
+	unsigned int per_slab;
+	/* Slabs with at least one free object */
+	struct slab *partial;
+	/* One completely free slab kept to absorb alloc/free oscillation */
+	struct slab *spare;
+	unsigned long objs;
+	unsigned int mag_count;
+	void *mag[SLAB_MAGAZINE];
+};
+
+struct uk_allocslab {
+	struct uk_alloc *backend;
+	unsigned long meta_pages;
+	/* Open-addressed set of slab pages, 1 << set_order entries */
+	struct slab **set;
+	unsigned int set_order;
+	unsigned long set_used;
+	struct uk_allocslab_stats stats;
+	/* Size class of each size in 8-byte steps */
+	unsigned char size2class[SLAB_MAX_SIZE / 8 + 1];
+	struct slab_cache caches[NB_CLASSES];
+};
+
+#define to_allocslab(a) ((struct uk_allocslab *)&(a)->priv)
+
+static inline struct slab_cache *size_to_cache(struct uk_allocslab *b,
+					       size_t size)
+{
+	if (unlikely(size > SLAB_MAX_SIZE))
+		return NULL;
+	return &b->caches[b->size2class[(size + 7) >> 3]];
+}
+
+static inline unsigned long set_pages(unsigned int order)
+{
+	return DIV_ROUND_UP(sizeof(struct slab *) << order, __PAGE_SIZE);
+}
+
+static inline unsigned long set_slot(struct uk_allocslab *b,
+				     const struct slab *s)
+{
+	unsigned long long pfn = (uintptr_t) s >> __PAGE_SHIFT;
+
+	return (unsigned long) ((pfn * SLAB_SET_HASH) >> (64 - b->set_order));
+}
+
+/* Returns the slot of `s` or the free slot where it would go */
+static unsigned long set_find(struct uk_allocslab *b, const struct slab *s)
+{
+	unsigned long mask = (1UL << b->set_order) - 1;
+	unsigned long i = set_slot(b, s);
+
+	while (b->set[i] && b->set[i] != s)
+		i = (i + 1) & mask;
+	return i;
+}
+
+static int set_resize(struct uk_allocslab *b, unsigned int order)
+{
+	struct slab **old = b->set;
+	unsigned int old_order = b->set_order;
+	struct slab **set;
+	unsigned long i;
+
+	set = uk_palloc(b->backend, set_pages(order));
+	if (unlikely(!set))
+		return -ENOMEM;
+	memset(set, 0, sizeof(*set) << order);
+
+	b->set = set;
+	b->set_order = order;
+	if (old) {
+		for (i = 0; i < (1UL << old_order); i++)
+			if (old[i])
+				set[set_find(b, old[i])] = old[i];
+		uk_pfree(b->backend, old, set_pages(old_order));
+	}
+	return 0;
+}
+
+static int set_add(struct uk_allocslab *b, struct slab *s)
+{
+	if ((b->set_used + 1) * 4 > (3UL << b->set_order)
+	    && set_resize(b, b->set_order + 1))
+		return -ENOMEM;
+	b->set[set_find(b, s)] = s;
+	b->set_used++;
+	return 0;
+}
+
+static void set_del(struct uk_allocslab *b, struct slab *s)
+{
+	unsigned long mask = (1UL << b->set_order) - 1;
+	unsigned long i = set_find(b, s);
+	unsigned long j, k;
+
+	UK_ASSERT(b->set[i] == s);
+	b->set[i] = NULL;
+	b->set_used--;
+
+	/* Move up entries of the same probe sequence, so lookups do not
+	 * stop at the hole
+	 */
+	for (j = (i + 1) & mask; b->set[j]; j = (j + 1) & mask) {
+		k = set_slot(b, b->set[j]);
+		if (((j - k) & mask) < ((j - i) & mask))
+			continue;
+		b->set[i] = b->set[j];
+		b->set[j] = NULL;
+		i = j;
+	}
+}
+
+static struct slab *obj_to_slab(struct uk_allocslab *b, const void *ptr)
+{
+	struct slab *s;
+
+	/* Objects never start a page */
+	if (((uintptr_t) ptr & (__PAGE_SIZE - 1)) == 0)
+		return NULL;
+
+	s = (struct slab *) ALIGN_DOWN((uintptr_t) ptr,
+				       (uintptr_t) __PAGE_SIZE);
+	if (b->set[set_find(b, s)] != s)
+		return NULL;
+	UK_ASSERT(s->magic == (SLAB_MAGIC ^ (uintptr_t) s));
+	UK_ASSERT(s->cache->owner == b);
+	return s;
+}
+
+static void partial_add(struct slab_cache *c, struct slab *s)
+{
+	s->prev = NULL;
+	s->next = c->partial;
+	if (c->partial)
+		c->partial->prev = s;
+	c->partial = s;
+	s->on_partial = 1;
+}
+
+static void partial_del(struct slab_cache *c, struct slab *s)
+{
+	if (s->prev)
+		s->prev->next = s->next;
+	else
+		c->partial = s->next;
+	if (s->next)
+		s->next->prev = s->prev;
+	s->on_partial = 0;
+}
+
+static struct slab *slab_new(struct uk_allocslab *b, struct slab_cache *c)
+{
+	struct slab *s;
+
+	if (c->spare) {
+		s = c->spare;
+		c->spare = NULL;
+		return s;
+	}
+
+	s = uk_palloc(b->backend, 1);
+	if (unlikely(!s))
+		return NULL;
+	if (unlikely(set_add(b, s))) {
+		uk_pfree(b->backend, s, 1);
+		return NULL;
+	}
+	b->stats.slab_pages++;
+
+	s->magic = SLAB_MAGIC ^ (uintptr_t) s;
+	s->cache = c;
+	s->free = NULL;
+	s->bump = (char *) s + SLAB_HDR_SIZE;
+	s->inuse = 0;
+	s->on_partial = 0;
+	return s;
+}
+
+static void slab_put(struct uk_allocslab *b, struct slab *s, void *obj);
+
+/* Returns the first `count` objects of the magazine to their slabs */
+static void cache_drain(struct uk_allocslab *b, struct slab_cache *c,
+			unsigned int count)
+{
+	unsigned int i;
+
+	UK_ASSERT(count <= c->mag_count);
+	for (i = 0; i < count; i++)
+		slab_put(b, obj_to_slab(b, c->mag[i]), c->mag[i]);
+	memmove(&c->mag[0], &c->mag[count],
+		(c->mag_count - count) * sizeof(void *));
+	c->mag_count -= count;
+}
+
+/* Objects sitting in magazines keep their slabs alive; give all of them
+ * back before declaring out-of-memory
+ */
+static int drain_all(struct uk_allocslab *b)
+{
+	unsigned long pages = b->stats.slab_pages;
+	unsigned int i;
+
+	for (i = 0; i < NB_CLASSES; i++) {
+		cache_drain(b, &b->caches[i], b->caches[i].mag_count);
+		if (b->caches[i].spare) {
+			b->caches[i].spare->magic = 0;
+			set_del(b, b->caches[i].spare);
+			uk_pfree(b->backend, b->caches[i].spare, 1);
+			b->caches[i].spare = NULL;
+			b->stats.slab_pages--;
+		}
+	}
+	return b->stats.slab_pages != pages;
+}
+
+static void *slab_take(struct uk_allocslab *b, struct slab_cache *c)
+{
+	struct slab *s = c->partial;
+	void *obj;
+
+	if (!s) {
+		s = slab_new(b, c);
+		if (unlikely(!s) && drain_all(b))
+			s = c->partial ? c->partial : slab_new(b, c);
+		if (unlikely(!s))
+			return NULL;
+		if (!s->on_partial)
+			partial_add(c, s);
+	}
+
+	if (s->free) {
+		obj = s->free;
+		s->free = *(void **) obj;
+	} else {
+		/* Objects are only carved out when first needed, so a new
+		 * slab does not touch its whole page
+		 */
+		obj = s->bump;
+		s->bump += c->size;
+	}
+
+	if (++s->inuse == c->per_slab)
+		partial_del(c, s);
+	return obj;
+}
+
+static void slab_put(struct uk_allocslab *b, struct slab *s, void *obj)
+{
+	struct slab_cache *c = s->cache;
+
+	*(void **) obj = s->free;
+	s->free = obj;
+	if (!s->on_partial)
+		partial_add(c, s);
+
+	if (--s->inuse)
+		return;
+
+	/* The slab is empty: keep it as spare or give it back */
+	partial_del(c, s);
+	if (!c->spare) {
+		s->free = NULL;
+		s->bump = (char *) s + SLAB_HDR_SIZE;
+		c->spare = s;
+		return;
+	}
+	s->magic = 0;
+	set_del(b, s);
+	uk_pfree(b->backend, s, 1);
+	b->stats.slab_pages--;
+}
+
+static void *cache_alloc(struct uk_allocslab *b, struct slab_cache *c)
+{
+	void *obj;
+
+	if (c->mag_count) {
+		obj = c->mag[--c->mag_count];
+		b->stats.magazine_hits++;
+	} else {
+		obj = slab_take(b, c);
+		if (unlikely(!obj))
+			return NULL;
+	}
+	c->objs++;
+	return obj;
+}
+
+static void cache_free(struct uk_allocslab *b, struct slab *s, void *obj)
+{
+	struct slab_cache *c = s->cache;
+
+	if (--c->objs == 0) {
+		/* Last object of this class: do not let the magazine pin
+		 * otherwise empty slabs
+		 */
+		cache_drain(b, c, c->mag_count);
+		slab_put(b, s, obj);
+		return;
+	}
+
+	if (c->mag_count == SLAB_MAGAZINE) {
+		/* Magazine is full: return its older half to the slabs, so
+		 * that the most recently freed (cache-hot) objects stay
+		 */
+		cache_drain(b, c, SLAB_MAGAZINE / 2);
+	}
+	c->mag[c->mag_count++] = obj;
+	b->stats.magazine_hits++;
+}
+
+static void *slab_malloc(struct uk_alloc *a, size_t size)
+{
+	struct uk_allocslab *b;
+	struct slab_cache *c;
+	void *obj;
+
+	UK_ASSERT(a);
+	b = to_allocslab(a);
+
+	if (unlikely(!size))
+		return NULL;
+
+	b->stats.mallocs++;
+	c = size_to_cache(b, size);
+	if (!c) {
+		b->stats.large_allocs++;
+		return uk_malloc(b->backend, size);
+	}
+
+	obj = cache_alloc(b, c);
+	if (unlikely(!obj))
+		errno = ENOMEM;
+	return obj;
+}
+
+static void slab_free(struct uk_alloc *a, void *ptr)
+{
+	struct uk_allocslab *b;
+	struct slab *s;
+
+	UK_ASSERT(a);
+	b = to_allocslab(a);
+
+	if (!ptr)
+		return;
+
+	b->stats.frees++;
+	s = obj_to_slab(b, ptr);
+	if (!s) {
+		uk_free(b->backend, ptr);
+		return;
+	}
+	cache_free(b, s, ptr);
+}
+
+static void *slab_realloc(struct uk_alloc *a, void *ptr, size_t size)
+{
+	struct uk_allocslab *b;
+	struct slab *s;
+	void *retptr;
+
+	UK_ASSERT(a);
+	b = to_allocslab(a);
+
+	if (!ptr)
+		return slab_malloc(a, size);
+
+	if (!size) {
+		slab_free(a, ptr);
+		return NULL;
+	}
+
+	s = obj_to_slab(b, ptr);
+	if (!s)
+		return uk_realloc(b->backend, ptr, size);
+
+	if (size <= s->cache->size)
+		return ptr;
+
+	retptr = slab_malloc(a, size);
+	if (unlikely(!retptr))
+		return NULL;
+	memcpy(retptr, ptr, s->cache->size);
+	cache_free(b, s, ptr);
+	b->stats.frees++;
+	return retptr;
+}
+
+static int slab_posix_memalign(struct uk_alloc *a, void **memptr,
+			       size_t align, size_t size)
+{
+	struct uk_allocslab *b;
+	unsigned int i;
+
+	UK_ASSERT(a);
+	b = to_allocslab(a);
+
+	if (((align - 1) & align) != 0 || (align % sizeof(void *)) != 0)
+		return EINVAL;
+	if (!size)
+		return EINVAL;
+
+	/* Objects are at SLAB_HDR_SIZE + n * class size within their page,
+	 * so a class that is a multiple of `align` gives aligned objects.
+	 */
+	if (align <= SLAB_HDR_SIZE && size <= SLAB_MAX_SIZE) {
+		for (i = b->size2class[(size + 7) >> 3]; i < NB_CLASSES; i++) {
+			if (class_sizes[i] % align)
+				continue;
+			b->stats.mallocs++;
+			*memptr = cache_alloc(b, &b->caches[i]);
+			return *memptr ? 0 : ENOMEM;
+		}
+	}
+
+	b->stats.mallocs++;
+	b->stats.large_allocs++;
+	return uk_posix_memalign(b->backend, memptr, align, size);
+}
+
+static void *slab_palloc(struct uk_alloc *a, unsigned long num_pages)
+{
+	UK_ASSERT(a);
+	return uk_palloc(to_allocslab(a)->backend, num_pages);
+}
+
+static void slab_pfree(struct uk_alloc *a, void *ptr, unsigned long num_pages)
+{
+	UK_ASSERT(a);
+	uk_pfree(to_allocslab(a)->backend, ptr, num_pages);
+}
+
+static int slab_addmem(struct uk_alloc *a, void *base, size_t len)
+{
+	UK_ASSERT(a);
+	return uk_alloc_addmem(to_allocslab(a)->backend, base, len);
+}
+
+static size_t slab_getsize(struct uk_alloc *a, const void *ptr)
+{
+	struct uk_allocslab *b;
+	struct slab *s;
+
+	UK_ASSERT(a);
+	b = to_allocslab(a);
+
+	s = obj_to_slab(b, ptr);
+	if (!s)
+		return uk_alloc_getsize(b->backend, ptr);
+	return s->cache->size;
+}
+
+#if CONFIG_LIBUKALLOC_IFSTATS
+static ssize_t slab_availmem(struct uk_alloc *a)
+{
+	UK_ASSERT(a);
+	return uk_alloc_availmem(to_allocslab(a)->backend);
+}
+#endif
+
+struct uk_alloc *uk_allocslab_backend(struct uk_alloc *a)
+{
+	if (!a || a->malloc != slab_malloc)
+		return NULL;
+	return to_allocslab(a)->backend;
+}
+
+int uk_allocslab_stats(struct uk_alloc *a, struct uk_allocslab_stats *stats)
+{
+	struct uk_allocslab *b;
+	unsigned int i;
+
+	if (!a || a->malloc != slab_malloc)
+		return -EINVAL;
+	b = to_allocslab(a);
+
+	*stats = b->stats;
+	stats->objs = 0;
+	stats->obj_bytes = 0;
+	for (i = 0; i < NB_CLASSES; i++) {
+		stats->objs += b->caches[i].objs;
+		stats->obj_bytes += b->caches[i].objs * b->caches[i].size;
+	}
+	return 0;
+}
+
+struct uk_alloc *uk_allocslab_init(struct uk_alloc *backend)
+{
+	struct uk_alloc *a;
+	struct uk_allocslab *b;
+	unsigned long meta_pages;
+	unsigned int i, size;
+
+	UK_ASSERT(backend);
+
+	meta_pages = DIV_ROUND_UP(sizeof(*a) + sizeof(*b), __PAGE_SIZE);
+	a = uk_palloc(backend, meta_pages);
+	if (!a) {
+		uk_pr_err("Not enough memory for slab allocator metadata\n");
+		return NULL;
+	}
+	memset(a, 0, sizeof(*a) + sizeof(*b));
+	b = to_allocslab(a);
+	b->backend = backend;
+	b->meta_pages = meta_pages;
+	if (set_resize(b, SLAB_SET_MIN_ORDER)) {
+		uk_pr_err("Not enough memory for slab allocator metadata\n");
+		uk_pfree(backend, a, meta_pages);
+		return NULL;
+	}
+
+	for (i = 0; i < NB_CLASSES; i++) {
+		b->caches[i].owner = b;
+		b->caches[i].size = class_sizes[i];
+		b->caches[i].per_slab = (__PAGE_SIZE - SLAB_HDR_SIZE)
+					/ class_sizes[i];
+		UK_ASSERT(b->caches[i].per_slab >= 2);
+	}
+	for (size = 0, i = 0; size <= SLAB_MAX_SIZE; size += 8) {
+		while (class_sizes[i] < size)
+			i++;
+		b->size2class[size >> 3] = i;
+	}
+
+	uk_pr_info("Initialize slab allocator @ %p on %p\n", a, backend);
+
+	a->malloc         = slab_malloc;
+	a->calloc         = uk_calloc_compat;
+	a->realloc        = slab_realloc;
+	a->posix_memalign = slab_posix_memalign;
+	a->memalign       = uk_memalign_compat;
+	a->free           = slab_free;
+	a->palloc         = slab_palloc;
+	a->pfree          = slab_pfree;
+	a->addmem         = slab_addmem;
+	a->getsize        = slab_getsize;
+#if CONFIG_LIBUKALLOC_IFSTATS
+	a->availmem       = slab_availmem;
+#endif
+
+	uk_alloc_register(a);
+	return a;
+}
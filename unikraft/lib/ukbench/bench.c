@@ -0,0 +1,266 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __Unikraft__
+#include <uk/init.h>
+#include <uk/essentials.h>
+#else
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+#include <uk/bench.h>
+
+__u64 uk_bench_overhead(void)
+{
+	static __u64 overhead;
+	static int calibrated;
+	__u64 t0, t1;
+	int i;
+
+	if (calibrated)
+		return overhead;
+
+	overhead = ~0ULL;
+	for (i = 0; i < 256; i++) {
+		t0 = uk_bench_clock_begin();
+		t1 = uk_bench_clock_end();
+		if (t1 - t0 < overhead)
+			overhead = t1 - t0;
+	}
+	calibrated = 1;
+	return overhead;
+}
+
+int uk_bench_init(struct uk_bench *b, const char *name,
+		  unsigned int warmup, unsigned int trials, int flags)
+{
+	memset(b, 0, sizeof(*b));
+	b->samples = calloc(MAX(trials, 1U), sizeof(*b->samples));
+	if (!b->samples)
+		return -ENOMEM;
+
+	b->name = name;
+	b->warmup = warmup;
+	b->trials = trials;
+	b->flags = flags;
+	b->res.overhead = uk_bench_overhead();
+	return 0;
+}
+
+int uk_bench_finish(struct uk_bench *b)
+{
+	__u64 overhead = b->res.overhead;
+	unsigned int i;
+	int rc;
+
+	if (b->iter < b->warmup + b->trials) {
+		rc = -EINVAL;
+		goto out;
+	}
+
+	for (i = 0; i < b->trials; i++)
+		b->samples[i] = (b->samples[i] > overhead)
+				? b->samples[i] - overhead : 0;
+	rc = uk_bench_stats(b->samples, b->trials, b->flags, &b->res);
+	if (rc < 0)
+		goto out;
+	b->res.overhead = overhead;
+#if CONFIG_LIBUKBENCH_PMU
+	b->res.nr_events = uk_pmu_nr;
+	for (i = 0; i < uk_pmu_nr; i++)
+		b->res.events[i] = b->evsum[i] / b->trials;
+#endif
+
+	if (!(b->flags & UK_BENCH_QUIET))
+		uk_bench_report(b->name, &b->res);
+
+out:
+	free(b->samples);
+	b->samples = NULL;
+	return rc;
+}
+
+static int bench_cmp(const void *a, const void *b)
+{
+	__u64 x = *(const __u64 *) a;
+	__u64 y = *(const __u64 *) b;
+
+	return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentile of n sorted samples */
+static __u64 bench_percentile(const __u64 *s, unsigned int n,
+			      unsigned int pct)
+{
+	unsigned int rank = ((__u64) n * pct + 99) / 100;
+
+	return s[rank ? rank - 1 : 0];
+}
+
+int uk_bench_stats(__u64 *samples, unsigned int n, int flags,
+		   struct uk_bench_result *res)
+{
+	unsigned int lo = 0, hi = n, i;
+	__u64 q1, q3, spread, fence, sum = 0;
+
+	if (!n)
+		return -EINVAL;
+
+	memset(res, 0, sizeof(*res));
+	qsort(samples, n, sizeof(*samples), bench_cmp);
+
+	/* Tukey's fences. Interrupts and cache misses only ever make a trial
+	 * slower, but a trial that raced with a counter reset can also come
+	 * out too fast.
+	 */
+	if (!(flags & UK_BENCH_KEEP_OUTLIERS)
+	    && CONFIG_LIBUKBENCH_OUTLIER_FENCE && n >= 4) {
+		q1 = bench_percentile(samples, n, 25);
+		q3 = bench_percentile(samples, n, 75);
+		/* Timings are quantised: the interquartile range of a very
+		 * stable benchmark is often 0, so assume at least 1% of the
+		 * median
+		 */
+		spread = MAX(q3 - q1, bench_percentile(samples, n, 50) / 100);
+		fence = spread * CONFIG_LIBUKBENCH_OUTLIER_FENCE;
+		while (lo < n && samples[lo] < q1 && q1 - samples[lo] > fence)
+			lo++;
+		while (hi > lo && samples[hi - 1] > q3
+		       && samples[hi - 1] - q3 > fence)
+			hi--;
+	}
+
+	res->trials = n;
+	res->kept = hi - lo;
+	samples += lo;
+	for (i = 0; i < res->kept; i++)
+		sum += samples[i];
+	res->min = samples[0];
+	res->max = samples[res->kept - 1];
+	res->p50 = bench_percentile(samples, res->kept, 50);
+	res->p90 = bench_percentile(samples, res->kept, 90);
+	res->p99 = bench_percentile(samples, res->kept, 99);
+	res->mean = sum / res->kept;
+	return 0;
+}
+
+#if CONFIG_LIBUKBENCH_PMU
+static const char *bench_event_name(unsigned int idx)
+{
+	const char *name = uk_pmu_counter_name(idx);
+
+	return name ? name : "unknown";
+}
+#endif
+
+#if CONFIG_LIBUKBENCH_FORMAT_JSON
+void uk_bench_report(const char *name, const struct uk_bench_result *res)
+{
+	printf("{\"bench\":\"%s\",\"clock\":\"%s\",\"unit\":\"%s\","
+	       "\"trials\":%u,\"kept\":%u,\"overhead\":%llu,"
+	       "\"min\":%llu,\"p50\":%llu,\"p90\":%llu,\"p99\":%llu,"
+	       "\"max\":%llu,\"mean\":%llu",
+	       name, UK_BENCH_CLOCK_NAME, UK_BENCH_CLOCK_UNIT,
+	       res->trials, res->kept, (unsigned long long) res->overhead,
+	       (unsigned long long) res->min, (unsigned long long) res->p50,
+	       (unsigned long long) res->p90, (unsigned long long) res->p99,
+	       (unsigned long long) res->max, (unsigned long long) res->mean);
+#if CONFIG_LIBUKBENCH_PMU
+	if (res->nr_events) {
+		unsigned int i;
+
+		printf(",\"events\":{");
+		for (i = 0; i < res->nr_events; i++)
+			printf("%s\"%s\":%llu", i ? "," : "",
+			       bench_event_name(i),
+			       (unsigned long long) res->events[i]);
+		printf("}");
+	}
+#endif
+	printf("}\n");
+}
+#else /* CONFIG_LIBUKBENCH_FORMAT_CSV */
+void uk_bench_report(const char *name, const struct uk_bench_result *res)
+{
+	/* Event columns of the last header */
+	static char header[128];
+	static int header_printed;
+	char columns[sizeof(header)] = "";
+#if CONFIG_LIBUKBENCH_PMU
+	unsigned int i;
+	size_t len = 0;
+
+	for (i = 0; i < res->nr_events && len < sizeof(columns); i++)
+		len += snprintf(columns + len, sizeof(columns) - len, ",%s",
+				bench_event_name(i));
+#endif
+
+	if (!header_printed || strcmp(header, columns)) {
+		printf("bench,clock,unit,trials,kept,overhead,"
+		       "min,p50,p90,p99,max,mean%s\n", columns);
+		strcpy(header, columns);
+		header_printed = 1;
+	}
+
+	printf("%s,%s,%s,%u,%u,%llu,%llu,%llu,%llu,%llu,%llu,%llu",
+	       name, UK_BENCH_CLOCK_NAME, UK_BENCH_CLOCK_UNIT,
+	       res->trials, res->kept, (unsigned long long) res->overhead,
+	       (unsigned long long) res->min, (unsigned long long) res->p50,
+	       (unsigned long long) res->p90, (unsigned long long) res->p99,
+	       (unsigned long long) res->max, (unsigned long long) res->mean);
+#if CONFIG_LIBUKBENCH_PMU
+	for (i = 0; i < res->nr_events; i++)
+		printf(",%llu", (unsigned long long) res->events[i]);
+#endif
+	printf("\n");
+}
+#endif /* CONFIG_LIBUKBENCH_FORMAT_CSV */
+
+#if CONFIG_LIBUKBENCH_CLOCK_CYCLES && CONFIG_ARCH_ARM_64
+/* PMCCNTR_EL0 only counts once it is enabled, and wraps after 2^32 cycles
+ * unless PMCR_EL0.LC is set
+ */
+static int uk_bench_init_clock(void)
+{
+	__u64 pmcr;
+
+	__asm__ __volatile__("mrs %0, pmcr_el0" : "=r"(pmcr));
+	pmcr |= (1UL << 0) | (1UL << 6); /* E, LC */
+	__asm__ __volatile__("msr pmcr_el0, %0\n"
+			     "msr pmcntenset_el0, %1\n"
+			     "isb\n"
+			     :: "r"(pmcr), "r"(1UL << 31));
+	return 0;
+}
+uk_lib_initcall(uk_bench_init_clock);
+#endif
@@ -0,0 +1,264 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __UK_BENCH_H__
+#define __UK_BENCH_H__
+
+#ifdef __Unikraft__
+#include <uk/config.h>
+#include <uk/arch/types.h>
+#include <uk/plat/time.h>
+#if CONFIG_LIBUKBENCH_PMU
+#include <uk/pmu.h>
+#endif
+#else
+/* Hosted build, e.g., the Linux baseline of the microbenchmarks: the
+ * harness is compiled into the program and times with clock_gettime()
+ */
+#include <linux/types.h>
+#include <time.h>
+#define CONFIG_LIBUKBENCH_CLOCK_MONOTONIC 1
+#define CONFIG_LIBUKBENCH_FORMAT_CSV 1
+#define CONFIG_LIBUKBENCH_OUTLIER_FENCE 3
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Clock. uk_bench_clock_begin() and uk_bench_clock_end() keep the timed
+ * code from being reordered around them; the difference of two readings
+ * is in UK_BENCH_CLOCK_UNIT.
+ */
+#if CONFIG_LIBUKBENCH_CLOCK_CYCLES && CONFIG_ARCH_X86_64
+#define UK_BENCH_CLOCK_NAME "tsc"
+#define UK_BENCH_CLOCK_UNIT "cycles"
+
+static inline __u64 uk_bench_clock_begin(void)
+{
+	__u32 lo, hi;
+
+	__asm__ __volatile__("lfence\n"
+			     "rdtsc\n"
+			     "lfence\n"
+			     : "=a"(lo), "=d"(hi) :: "memory");
+	return ((__u64) hi << 32) | lo;
+}
+
+static inline __u64 uk_bench_clock_end(void)
+{
+	__u32 lo, hi;
+
+	/* rdtscp waits for the timed code, lfence keeps what follows out */
+	__asm__ __volatile__("rdtscp\n"
+			     "lfence\n"
+			     : "=a"(lo), "=d"(hi) :: "rcx", "memory");
+	return ((__u64) hi << 32) | lo;
+}
+#elif CONFIG_LIBUKBENCH_CLOCK_CYCLES && CONFIG_ARCH_ARM_64
+#define UK_BENCH_CLOCK_NAME "pmccntr"
+#define UK_BENCH_CLOCK_UNIT "cycles"
+
+static inline __u64 uk_bench_clock_begin(void)
+{
+	__u64 val;
+
+	__asm__ __volatile__("isb\n"
+			     "mrs %0, pmccntr_el0\n"
+			     : "=r"(val) :: "memory");
+	return val;
+}
+
+#define uk_bench_clock_end() uk_bench_clock_begin()
+#elif CONFIG_LIBUKBENCH_CLOCK_CNTVCT
+#define UK_BENCH_CLOCK_NAME "cntvct"
+#define UK_BENCH_CLOCK_UNIT "ticks"
+
+static inline __u64 uk_bench_clock_begin(void)
+{
+	__u64 val;
+
+	__asm__ __volatile__("isb\n"
+			     "mrs %0, cntvct_el0\n"
+			     : "=r"(val) :: "memory");
+	return val;
+}
+
+#define uk_bench_clock_end() uk_bench_clock_begin()
+#elif defined(__Unikraft__)
+#define UK_BENCH_CLOCK_NAME "monotonic"
+#define UK_BENCH_CLOCK_UNIT "ns"
+
+static inline __u64 uk_bench_clock_begin(void)
+{
+	__u64 val = ukplat_monotonic_clock();
+
+	__asm__ __volatile__("" ::: "memory");
+	return val;
+}
+
+#define uk_bench_clock_end() uk_bench_clock_begin()
+#else
+#define UK_BENCH_CLOCK_NAME "monotonic"
+#define UK_BENCH_CLOCK_UNIT "ns"
+
+static inline __u64 uk_bench_clock_begin(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	__asm__ __volatile__("" ::: "memory");
+	return (__u64) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#define uk_bench_clock_end() uk_bench_clock_begin()
+#endif
+
+struct uk_bench_result {
+	/* Timed trials, and trials left after outlier rejection */
+	unsigned int trials;
+	unsigned int kept;
+	/* Cost of an empty trial, subtracted from every trial */
+	__u64 overhead;
+	/* Statistics of the kept trials */
+	__u64 min;
+	__u64 p50;
+	__u64 p90;
+	__u64 p99;
+	__u64 max;
+	__u64 mean;
+#if CONFIG_LIBUKBENCH_PMU
+	/* Mean event count per timed trial for each programmed counter */
+	unsigned int nr_events;
+	__u64 events[UK_PMU_MAX_COUNTERS];
+#endif
+};
+
+/* Keep all trials in the statistics */
+#define UK_BENCH_KEEP_OUTLIERS 0x1
+/* Do not print anything in uk_bench_finish() */
+#define UK_BENCH_QUIET         0x2
+
+struct uk_bench {
+	const char *name;
+	unsigned int warmup;
+	unsigned int trials;
+	int flags;
+
+	/* Loop state, see uk_bench_foreach() */
+	unsigned int iter;
+	__u64 t0;
+	__u64 *samples;
+#if CONFIG_LIBUKBENCH_PMU
+	__u64 ev0[UK_PMU_MAX_COUNTERS];
+	__u64 evsum[UK_PMU_MAX_COUNTERS];
+#endif
+	struct uk_bench_result res;
+};
+
+/*
+ * Prepares `b` for `warmup` untimed and `trials` timed runs. `name` ends
+ * up in the first column of the output and must not contain commas or
+ * quotes. Returns 0 or -ENOMEM.
+ *
+ *	struct uk_bench b;
+ *
+ *	uk_bench_init(&b, "gate", 100, 10000, 0);
+ *	uk_bench_foreach(&b) {
+ *		uk_bench_start(&b);
+ *		code_to_time();
+ *		uk_bench_stop(&b);
+ *	}
+ *	uk_bench_finish(&b);
+ */
+int uk_bench_init(struct uk_bench *b, const char *name,
+		  unsigned int warmup, unsigned int trials, int flags);
+
+#define uk_bench_foreach(b)						\
+	for ((b)->iter = 0; (b)->iter < (b)->warmup + (b)->trials;	\
+	     (b)->iter++)
+
+static inline void uk_bench_start(struct uk_bench *b)
+{
+#if CONFIG_LIBUKBENCH_PMU
+	uk_pmu_snapshot(b->ev0);
+#endif
+	b->t0 = uk_bench_clock_begin();
+}
+
+static inline void uk_bench_stop(struct uk_bench *b)
+{
+	__u64 t1 = uk_bench_clock_end();
+#if CONFIG_LIBUKBENCH_PMU
+	__u64 ev1[UK_PMU_MAX_COUNTERS];
+	unsigned int i;
+
+	uk_pmu_snapshot(ev1);
+#endif
+	if (b->iter < b->warmup)
+		return;
+	b->samples[b->iter - b->warmup] = t1 - b->t0;
+#if CONFIG_LIBUKBENCH_PMU
+	for (i = 0; i < uk_pmu_nr; i++)
+		b->evsum[i] += uk_pmu_delta(b->ev0[i], ev1[i]);
+#endif
+}
+
+/*
+ * Computes b->res from the trials, prints it with uk_bench_report()
+ * unless UK_BENCH_QUIET was given, and releases the samples. Returns 0,
+ * or -EINVAL if the loop was left before the last trial.
+ */
+int uk_bench_finish(struct uk_bench *b);
+
+/*
+ * Statistics of n samples that were taken some other way. Sorts the
+ * samples in place and does not subtract any overhead. Returns 0 or
+ * -EINVAL if n is 0.
+ */
+int uk_bench_stats(__u64 *samples, unsigned int n, int flags,
+		   struct uk_bench_result *res);
+
+/*
+ * Prints one line in the configured format (CSV or JSON). The CSV header
+ * is printed before the first line and whenever the set of PMU events
+ * changes.
+ */
+void uk_bench_report(const char *name, const struct uk_bench_result *res);
+
+/* Cost of an empty uk_bench_start()/uk_bench_stop() pair */
+__u64 uk_bench_overhead(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UK_BENCH_H__ */
@@ -0,0 +1,220 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __UK_PMU_H__
+#define __UK_PMU_H__
+
+#include <uk/config.h>
+#include <uk/arch/types.h>
+#include <uk/essentials.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Hardware event counters: arm64 PMUv3 event counters and the x86
+ * architectural performance monitoring counters (as exposed by KVM).
+ * Counters 0 to uk_pmu_nr - 1 are programmed with uk_pmu_select() and
+ * count in all exception levels/rings until the next selection.
+ */
+#define UK_PMU_MAX_COUNTERS CONFIG_LIBUKBENCH_PMU_COUNTERS
+
+/* Generic events, mapped to the architecture's event numbers by pmu.c */
+enum uk_pmu_event {
+	UK_PMU_EV_CYCLES,
+	UK_PMU_EV_INSTRUCTIONS,
+	UK_PMU_EV_BRANCHES,
+	UK_PMU_EV_BRANCH_MISSES,
+	UK_PMU_EV_L1D_ACCESS,
+	UK_PMU_EV_L1D_REFILL,
+	UK_PMU_EV_L1I_ACCESS,
+	UK_PMU_EV_L1I_REFILL,
+	UK_PMU_EV_LLC_ACCESS,
+	UK_PMU_EV_LLC_MISS,
+	UK_PMU_EV_MEM_ACCESS,
+	UK_PMU_EV_COUNT
+};
+
+/* Number of counters programmed by the last uk_pmu_select*() */
+extern unsigned int uk_pmu_nr;
+/* Counter width: deltas have to be taken modulo this mask */
+extern __u64 uk_pmu_mask;
+
+/*
+ * Returns the number of counters the hardware provides (at most
+ * UK_PMU_MAX_COUNTERS), or a negative error code if there is no usable
+ * PMU.
+ */
+int uk_pmu_probe(void);
+
+/*
+ * Programs counters 0 to n - 1 with the given events and resets them.
+ * n = 0 stops all event counters. Returns 0, -EINVAL if n exceeds the
+ * available counters, or -ENOTSUP if an event has no equivalent on this
+ * CPU. On error the previous selection is left in place.
+ */
+int uk_pmu_select(const enum uk_pmu_event *ev, unsigned int n);
+
+/*
+ * Same with architecture specific event codes: the PMUv3 event number on
+ * arm64, (umask << 8 | event select) on x86.
+ */
+int uk_pmu_select_raw(const __u32 *code, unsigned int n);
+
+/*
+ * Same with a comma-separated list of event names (see
+ * uk_pmu_event_name()) and hexadecimal raw codes, e.g.,
+ * "l1d_refill,branch_misses,0x51".
+ */
+int uk_pmu_select_names(const char *list);
+
+/* Short name of a generic event, e.g., "l1d_refill" */
+const char *uk_pmu_event_name(enum uk_pmu_event ev);
+
+/* Name of what counter idx currently counts */
+const char *uk_pmu_counter_name(unsigned int idx);
+
+static inline __u64 uk_pmu_read(unsigned int idx)
+{
+#if CONFIG_ARCH_ARM_64
+	__u64 val;
+
+	/* The counter number is part of the register name */
+	switch (idx) {
+	case 0:
+		__asm__ __volatile__("mrs %0, pmevcntr0_el0" : "=r"(val));
+		break;
+	case 1:
+		__asm__ __volatile__("mrs %0, pmevcntr1_el0" : "=r"(val));
+		break;
+	case 2:
+		__asm__ __volatile__("mrs %0, pmevcntr2_el0" : "=r"(val));
+		break;
+	case 3:
+		__asm__ __volatile__("mrs %0, pmevcntr3_el0" : "=r"(val));
+		break;
+	case 4:
+		__asm__ __volatile__("mrs %0, pmevcntr4_el0" : "=r"(val));
+		break;
+	default:
+		__asm__ __volatile__("mrs %0, pmevcntr5_el0" : "=r"(val));
+		break;
+	}
+	return val;
+#else
+	__u32 lo, hi;
+
+	__asm__ __volatile__("rdpmc" : "=a"(lo), "=d"(hi) : "c"(idx));
+	return ((__u64) hi << 32) | lo;
+#endif
+}
+
+/* Reads all programmed counters into val[0 .. uk_pmu_nr - 1] */
+static inline void uk_pmu_snapshot(__u64 *val)
+{
+	unsigned int i;
+
+	for (i = 0; i < uk_pmu_nr; i++)
+		val[i] = uk_pmu_read(i);
+}
+
+static inline __u64 uk_pmu_delta(__u64 start, __u64 end)
+{
+	return (end - start) & uk_pmu_mask;
+}
+
+#if CONFIG_LIBUKBENCH_PMU_COMPARTMENTS
+/*
+ * Per-compartment attribution. The FlexOS gates call uk_pmu_gate_enter()
+ * before and uk_pmu_gate_exit() after every cross-compartment call, so
+ * whatever the counters advanced by since the previous gate is charged to
+ * the compartment that was running in between. Gates are inlined into the
+ * calling compartment, which is why all of this lives in .data_shared.
+ * Threads of different compartments that are switched by the scheduler
+ * rather than by a gate are not told apart.
+ */
+#define UK_PMU_MAX_COMPARTMENTS 16
+
+struct uk_pmu_comp {
+	/* Gates that entered the compartment */
+	__u64 entries;
+	__u64 count[UK_PMU_MAX_COUNTERS];
+};
+
+extern struct uk_pmu_comp uk_pmu_comps[UK_PMU_MAX_COMPARTMENTS];
+extern __u64 uk_pmu_comp_last[UK_PMU_MAX_COUNTERS];
+
+static inline void uk_pmu_comp_charge(int comp)
+{
+	struct uk_pmu_comp *c = &uk_pmu_comps[comp];
+	__u64 now[UK_PMU_MAX_COUNTERS];
+	unsigned int i;
+
+	uk_pmu_snapshot(now);
+	for (i = 0; i < uk_pmu_nr; i++) {
+		c->count[i] += uk_pmu_delta(uk_pmu_comp_last[i], now[i]);
+		uk_pmu_comp_last[i] = now[i];
+	}
+}
+
+static inline void uk_pmu_gate_enter(int key_from, int key_to)
+{
+	uk_pmu_comp_charge(key_from);
+	uk_pmu_comps[key_to].entries++;
+}
+
+static inline void uk_pmu_gate_exit(int key_from __unused, int key_to)
+{
+	uk_pmu_comp_charge(key_to);
+}
+
+/* Zeroes the table and starts counting from now. uk_pmu_select*() does
+ * this as well.
+ */
+void uk_pmu_comp_reset(void);
+
+/*
+ * Charges what was counted since the last gate to `comp`, the compartment
+ * of the caller, and prints one line per compartment that was entered or
+ * charged anything, in the format of LIBUKBENCH_FORMAT:
+ *
+ *	comp,entries,l1d_refill,branch_misses
+ *	0,0,18230,5121
+ *	1,4096,90211,20877
+ */
+void uk_pmu_comp_report(int comp);
+#endif /* CONFIG_LIBUKBENCH_PMU_COMPARTMENTS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UK_PMU_H__ */
@@ -0,0 +1,334 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <uk/init.h>
+#include <uk/print.h>
+#include <uk/essentials.h>
+#include <uk/pmu.h>
+
+#define PMU_NONE ((__u32) ~0U)
+
+static const struct {
+	const char *name;
+	__u32 arm64; /* PMUv3 common event number */
+	__u32 x86;   /* umask << 8 | event select */
+} pmu_events[UK_PMU_EV_COUNT] = {
+	[UK_PMU_EV_CYCLES]        = { "cycles",        0x11, 0x003c },
+	[UK_PMU_EV_INSTRUCTIONS]  = { "instructions",  0x08, 0x00c0 },
+	[UK_PMU_EV_BRANCHES]      = { "branches",      0x21, 0x00c4 },
+	[UK_PMU_EV_BRANCH_MISSES] = { "branch_misses", 0x22, 0x00c5 },
+	[UK_PMU_EV_L1D_ACCESS]    = { "l1d_access",    0x04, PMU_NONE },
+	/* L1D.REPLACEMENT is not architectural, but the same on all Intel
+	 * cores since Sandy Bridge
+	 */
+	[UK_PMU_EV_L1D_REFILL]    = { "l1d_refill",    0x03, 0x0151 },
+	[UK_PMU_EV_L1I_ACCESS]    = { "l1i_access",    0x14, PMU_NONE },
+	[UK_PMU_EV_L1I_REFILL]    = { "l1i_refill",    0x01, PMU_NONE },
+	[UK_PMU_EV_LLC_ACCESS]    = { "llc_access",    0x36, 0x4f2e },
+	[UK_PMU_EV_LLC_MISS]      = { "llc_miss",      0x37, 0x412e },
+	[UK_PMU_EV_MEM_ACCESS]    = { "mem_access",    0x13, PMU_NONE },
+};
+
+#if CONFIG_LIBUKBENCH_PMU_COMPARTMENTS
+/* Read by the gates in every compartment, see uk/pmu.h */
+#define __pmu_shared __section(".data_shared")
+#else
+#define __pmu_shared
+#endif
+
+unsigned int uk_pmu_nr __pmu_shared = 0;
+__u64 uk_pmu_mask __pmu_shared = 0;
+
+/* Counters available, 0 before the first probe */
+static unsigned int pmu_avail;
+static const char *pmu_names[UK_PMU_MAX_COUNTERS];
+static char pmu_raw_names[UK_PMU_MAX_COUNTERS][11];
+
+#if CONFIG_ARCH_ARM_64
+static inline __u32 pmu_code(enum uk_pmu_event ev)
+{
+	return pmu_events[ev].arm64;
+}
+
+static int pmu_arch_probe(void)
+{
+	__u64 pmcr;
+
+	__asm__ __volatile__("mrs %0, pmcr_el0" : "=r"(pmcr));
+	/* Event counters are 32 bits wide before PMUv3p5 */
+	uk_pmu_mask = 0xffffffffUL;
+	return (pmcr >> 11) & 0x1f; /* PMCR_EL0.N */
+}
+
+/* PMEVTYPER<n>_EL0.NSH: also count at EL2, like plat/morello/start.S */
+#define PMEVTYPER_NSH (1UL << 27)
+
+static void pmu_arch_program(const __u32 *code, unsigned int n)
+{
+	__u64 pmcr;
+	unsigned int i;
+
+	/* Leaves the cycle counter (bit 31) alone */
+	__asm__ __volatile__("msr pmcntenclr_el0, %0"
+			     :: "r"((__u64) (1UL << pmu_avail) - 1));
+	for (i = 0; i < n; i++) {
+		__asm__ __volatile__("msr pmselr_el0, %0\n"
+				     "isb\n"
+				     "msr pmxevtyper_el0, %1\n"
+				     "msr pmxevcntr_el0, xzr\n"
+				     :: "r"((__u64) i),
+					"r"((__u64) code[i] | PMEVTYPER_NSH));
+	}
+	__asm__ __volatile__("isb\n"
+			     "msr pmcntenset_el0, %0\n"
+			     :: "r"((__u64) (1UL << n) - 1));
+	__asm__ __volatile__("mrs %0, pmcr_el0" : "=r"(pmcr));
+	pmcr |= 1; /* PMCR_EL0.E */
+	__asm__ __volatile__("msr pmcr_el0, %0\n"
+			     "isb\n" :: "r"(pmcr));
+}
+#else /* CONFIG_ARCH_X86_64 */
+#define MSR_IA32_PMC0             0x0c1
+#define MSR_IA32_PERFEVTSEL0      0x186
+#define MSR_IA32_PERF_GLOBAL_CTRL 0x38f
+
+#define PERFEVTSEL_USR (1UL << 16)
+#define PERFEVTSEL_OS  (1UL << 17)
+#define PERFEVTSEL_EN  (1UL << 22)
+
+static unsigned int pmu_version;
+
+static inline __u32 pmu_code(enum uk_pmu_event ev)
+{
+	return pmu_events[ev].x86;
+}
+
+static inline void pmu_wrmsr(__u32 msr, __u64 val)
+{
+	__asm__ __volatile__("wrmsr"
+			     :: "c"(msr), "a"((__u32) val),
+				"d"((__u32) (val >> 32)));
+}
+
+static inline __u64 pmu_rdmsr(__u32 msr)
+{
+	__u32 lo, hi;
+
+	__asm__ __volatile__("rdmsr" : "=a"(lo), "=d"(hi) : "c"(msr));
+	return ((__u64) hi << 32) | lo;
+}
+
+static int pmu_arch_probe(void)
+{
+	__u32 eax, ebx, ecx, edx;
+
+	/* Architectural performance monitoring leaf. Zero on AMD and when
+	 * KVM does not expose a vPMU.
+	 */
+	__asm__ __volatile__("cpuid"
+			     : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+			     : "a"(0xa), "c"(0));
+	pmu_version = eax & 0xff;
+	if (!pmu_version)
+		return 0;
+	uk_pmu_mask = (1UL << ((eax >> 16) & 0xff)) - 1;
+	return (eax >> 8) & 0xff;
+}
+
+static void pmu_arch_program(const __u32 *code, unsigned int n)
+{
+	unsigned int i;
+
+	for (i = 0; i < pmu_avail; i++)
+		pmu_wrmsr(MSR_IA32_PERFEVTSEL0 + i, 0);
+	for (i = 0; i < n; i++) {
+		pmu_wrmsr(MSR_IA32_PMC0 + i, 0);
+		pmu_wrmsr(MSR_IA32_PERFEVTSEL0 + i, code[i] | PERFEVTSEL_USR
+			  | PERFEVTSEL_OS | PERFEVTSEL_EN);
+	}
+	/* Since version 2 the counters also have to be enabled globally */
+	if (pmu_version >= 2 && n)
+		pmu_wrmsr(MSR_IA32_PERF_GLOBAL_CTRL,
+			  pmu_rdmsr(MSR_IA32_PERF_GLOBAL_CTRL)
+			  | ((1UL << n) - 1));
+}
+#endif /* CONFIG_ARCH_X86_64 */
+
+int uk_pmu_probe(void)
+{
+	int avail;
+
+	if (pmu_avail)
+		return pmu_avail;
+
+	avail = pmu_arch_probe();
+	if (avail <= 0)
+		return -ENODEV;
+	pmu_avail = MIN((unsigned int) avail, UK_PMU_MAX_COUNTERS);
+	return pmu_avail;
+}
+
+/* A NULL name stands for a raw event code */
+static int pmu_program(const __u32 *code, const char *const *name,
+		       unsigned int n)
+{
+	unsigned int i;
+	int rc;
+
+	rc = uk_pmu_probe();
+	if (rc < 0)
+		return rc;
+	if (n > pmu_avail)
+		return -EINVAL;
+
+	/* Nobody may read a counter while it is reprogrammed */
+	uk_pmu_nr = 0;
+	pmu_arch_program(code, n);
+	for (i = 0; i < n; i++) {
+		if (name[i]) {
+			pmu_names[i] = name[i];
+			continue;
+		}
+		/* Raw event code */
+		snprintf(pmu_raw_names[i], sizeof(pmu_raw_names[i]), "0x%x",
+			 (unsigned int) code[i]);
+		pmu_names[i] = pmu_raw_names[i];
+	}
+	uk_pmu_nr = n;
+#if CONFIG_LIBUKBENCH_PMU_COMPARTMENTS
+	/* Counts of the previous events are meaningless now */
+	uk_pmu_comp_reset();
+#endif
+	return 0;
+}
+
+int uk_pmu_select(const enum uk_pmu_event *ev, unsigned int n)
+{
+	__u32 code[UK_PMU_MAX_COUNTERS];
+	const char *name[UK_PMU_MAX_COUNTERS];
+	unsigned int i;
+
+	if (n > UK_PMU_MAX_COUNTERS)
+		return -EINVAL;
+	for (i = 0; i < n; i++) {
+		if ((unsigned int) ev[i] >= UK_PMU_EV_COUNT)
+			return -EINVAL;
+		code[i] = pmu_code(ev[i]);
+		if (code[i] == PMU_NONE)
+			return -ENOTSUP;
+		name[i] = pmu_events[ev[i]].name;
+	}
+	return pmu_program(code, name, n);
+}
+
+int uk_pmu_select_raw(const __u32 *code, unsigned int n)
+{
+	const char *name[UK_PMU_MAX_COUNTERS] = { NULL };
+
+	if (n > UK_PMU_MAX_COUNTERS)
+		return -EINVAL;
+	return pmu_program(code, name, n);
+}
+
+int uk_pmu_select_names(const char *list)
+{
+	__u32 code[UK_PMU_MAX_COUNTERS];
+	const char *name[UK_PMU_MAX_COUNTERS];
+	unsigned int n = 0;
+	const char *end;
+	size_t len;
+	int ev;
+
+	while (*list) {
+		while (*list == ',' || *list == ' ')
+			list++;
+		if (!*list)
+			break;
+		end = list;
+		while (*end && *end != ',' && *end != ' ')
+			end++;
+		len = end - list;
+
+		if (n == UK_PMU_MAX_COUNTERS)
+			return -EINVAL;
+		if (len > 2 && list[0] == '0' && list[1] == 'x') {
+			code[n] = strtoul(list, NULL, 16);
+			name[n] = NULL;
+		} else {
+			for (ev = 0; ev < UK_PMU_EV_COUNT; ev++)
+				if (strlen(pmu_events[ev].name) == len
+				    && !strncmp(pmu_events[ev].name, list, len))
+					break;
+			if (ev == UK_PMU_EV_COUNT)
+				return -EINVAL;
+			code[n] = pmu_code(ev);
+			if (code[n] == PMU_NONE)
+				return -ENOTSUP;
+			name[n] = pmu_events[ev].name;
+		}
+		n++;
+		list = end;
+	}
+	return pmu_program(code, name, n);
+}
+
+const char *uk_pmu_event_name(enum uk_pmu_event ev)
+{
+	if ((unsigned int) ev >= UK_PMU_EV_COUNT)
+		return NULL;
+	return pmu_events[ev].name;
+}
+
+const char *uk_pmu_counter_name(unsigned int idx)
+{
+	if (idx >= uk_pmu_nr)
+		return NULL;
+	return pmu_names[idx];
+}
+
+static int uk_pmu_init(void)
+{
+	int rc;
+
+	if (!*CONFIG_LIBUKBENCH_PMU_EVENTS)
+		return 0;
+
+	rc = uk_pmu_select_names(CONFIG_LIBUKBENCH_PMU_EVENTS);
+	if (rc < 0)
+		uk_pr_warn("Could not count PMU events \"%s\": %d\n",
+			   CONFIG_LIBUKBENCH_PMU_EVENTS, rc);
+	/* Benchmarks still run without the events */
+	return 0;
+}
+uk_lib_initcall(uk_pmu_init);
@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <uk/essentials.h>
+#include <uk/pmu.h>
+
+struct uk_pmu_comp uk_pmu_comps[UK_PMU_MAX_COMPARTMENTS]
+	__section(".data_shared");
+__u64 uk_pmu_comp_last[UK_PMU_MAX_COUNTERS] __section(".data_shared");
+
+void uk_pmu_comp_reset(void)
+{
+	memset(uk_pmu_comps, 0, sizeof(uk_pmu_comps));
+	uk_pmu_snapshot(uk_pmu_comp_last);
+}
+
+static int pmu_comp_used(const struct uk_pmu_comp *c)
+{
+	unsigned int i;
+
+	if (c->entries)
+		return 1;
+	for (i = 0; i < uk_pmu_nr; i++)
+		if (c->count[i])
+			return 1;
+	return 0;
+}
+
+#if CONFIG_LIBUKBENCH_FORMAT_JSON
+static void pmu_comp_header(void)
+{
+}
+
+static void pmu_comp_print(int comp, const struct uk_pmu_comp *c)
+{
+	unsigned int i;
+
+	printf("{\"comp\":%d,\"entries\":%llu,\"events\":{", comp,
+	       (unsigned long long) c->entries);
+	for (i = 0; i < uk_pmu_nr; i++)
+		printf("%s\"%s\":%llu", i ? "," : "", uk_pmu_counter_name(i),
+		       (unsigned long long) c->count[i]);
+	printf("}}\n");
+}
+#else /* CONFIG_LIBUKBENCH_FORMAT_CSV */
+static void pmu_comp_header(void)
+{
+	unsigned int i;
+
+	printf("comp,entries");
+	for (i = 0; i < uk_pmu_nr; i++)
+		printf(",%s", uk_pmu_counter_name(i));
+	printf("\n");
+}
+
+static void pmu_comp_print(int comp, const struct uk_pmu_comp *c)
+{
+	unsigned int i;
+
+	printf("%d,%llu", comp, (unsigned long long) c->entries);
+	for (i = 0; i < uk_pmu_nr; i++)
+		printf(",%llu", (unsigned long long) c->count[i]);
+	printf("\n");
+}
+#endif /* CONFIG_LIBUKBENCH_FORMAT_CSV */
+
+void uk_pmu_comp_report(int comp)
+{
+	int k;
+
+	uk_pmu_comp_charge(comp);
+
+	pmu_comp_header();
+	for (k = 0; k < UK_PMU_MAX_COMPARTMENTS; k++)
+		if (k == comp || pmu_comp_used(&uk_pmu_comps[k]))
+			pmu_comp_print(k, &uk_pmu_comps[k]);
+}
@@ -90,6 +90,8 @@ int uk_blkdev_drv_register(struct uk_blkdev *dev, struct uk_alloc *a,
 				dev->dev_ops->queue_intr_disable)
 			|| (!dev->dev_ops->queue_intr_enable
 				&& !dev->dev_ops->queue_intr_disable));
+	/* Batched submission without notification requires a kick */
+	UK_ASSERT(!dev->submit_batch || dev->dev_ops->queue_kick);
 
 	dev->_data = _alloc_data(a, blkdev_count,  drv_name);
 	if (!dev->_data)
@@ -411,6 +413,126 @@ int uk_blkdev_queue_finish_reqs(struct uk_blkdev *dev,
 	return dev->finish_reqs(dev, dev->_queue[queue_id]);
 }
 
+int uk_blkdev_queue_submit_batch(struct uk_blkdev *dev,
+		uint16_t queue_id,
+		struct uk_blkreq **reqs,
+		uint16_t cnt)
+{
+	struct uk_blkdev_plug *plug;
+	uint16_t i;
+	int rc;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(dev->submit_one);
+	UK_ASSERT(queue_id < CONFIG_LIBUKBLKDEV_MAXNBQUEUES);
+	UK_ASSERT(dev->_data->state == UK_BLKDEV_RUNNING);
+	UK_ASSERT(!PTRISERR(dev->_queue[queue_id]));
+	UK_ASSERT(reqs || !cnt);
+
+	if (unlikely(!cnt))
+		return 0;
+
+	plug = &dev->_data->queue_plug[queue_id];
+	if (likely(dev->submit_batch)) {
+		rc = dev->submit_batch(dev, dev->_queue[queue_id], reqs, cnt,
+				       !plug->depth);
+		if (rc > 0 && plug->depth)
+			plug->pending += rc;
+		return rc;
+	}
+
+	/* The driver cannot defer notifications: submit one by one */
+	for (i = 0; i < cnt; i++) {
+		rc = dev->submit_one(dev, dev->_queue[queue_id], reqs[i]);
+		if (unlikely(!uk_blkdev_status_successful(rc))) {
+			if (i)
+				return i;
+			return (rc < 0) ? rc : -ENOSPC;
+		}
+		if (!uk_blkdev_status_more(rc))
+			return i + 1;
+	}
+	return cnt;
+}
+
+void uk_blkdev_queue_plug(struct uk_blkdev *dev, uint16_t queue_id)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(queue_id < CONFIG_LIBUKBLKDEV_MAXNBQUEUES);
+	UK_ASSERT(!PTRISERR(dev->_queue[queue_id]));
+
+	dev->_data->queue_plug[queue_id].depth++;
+}
+
+static void _kick(struct uk_blkdev *dev, uint16_t queue_id)
+{
+	struct uk_blkdev_plug *plug = &dev->_data->queue_plug[queue_id];
+
+	if (!plug->pending)
+		return;
+
+	plug->pending = 0;
+	dev->dev_ops->queue_kick(dev, dev->_queue[queue_id]);
+}
+
+void uk_blkdev_queue_unplug(struct uk_blkdev *dev, uint16_t queue_id)
+{
+	struct uk_blkdev_plug *plug;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(queue_id < CONFIG_LIBUKBLKDEV_MAXNBQUEUES);
+	UK_ASSERT(!PTRISERR(dev->_queue[queue_id]));
+
+	plug = &dev->_data->queue_plug[queue_id];
+	UK_ASSERT(plug->depth > 0);
+
+	if (--plug->depth == 0)
+		_kick(dev, queue_id);
+}
+
+int uk_blkdev_queue_poll_reqs(struct uk_blkdev *dev,
+		uint16_t queue_id,
+		struct uk_blkreq **reqs,
+		uint16_t cnt)
+{
+	uint16_t i = 0;
+	int rc;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(dev->finish_reqs);
+	UK_ASSERT(queue_id < CONFIG_LIBUKBLKDEV_MAXNBQUEUES);
+	UK_ASSERT(dev->_data->state == UK_BLKDEV_RUNNING);
+	UK_ASSERT(!PTRISERR(dev->_queue[queue_id]));
+	UK_ASSERT(reqs || !cnt);
+	/* An event callback would race with us for the responses */
+	UK_ASSERT(!dev->_data->queue_handler[queue_id].callback);
+
+	/* Waiting on requests the device has not been told about would
+	 * never finish, so flush the plug first.
+	 */
+	_kick(dev, queue_id);
+
+	while (i < cnt) {
+		if (uk_blkreq_is_done(reqs[i])) {
+			i++;
+			continue;
+		}
+
+		rc = dev->finish_reqs(dev, dev->_queue[queue_id]);
+		if (unlikely(rc < 0)) {
+			uk_pr_err("blkdev%"PRIu16"-q%"PRIu16": Failed to poll responses: %d\n",
+					dev->_data->id, queue_id, rc);
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
 #if CONFIG_LIBUKBLKDEV_SYNC_IO_BLOCKED_WAITING
 /**
  * Used for sending a synchronous request.
@@ -424,6 +424,74 @@ int uk_blkdev_queue_submit_one(struct uk_blkdev *dev, uint16_t queue_id,
  */
 int uk_blkdev_queue_finish_reqs(struct uk_blkdev *dev, uint16_t queue_id);
 
+/**
+ * Make several aio requests to the device at once. Unless the queue is
+ * plugged, the device is notified a single time for the whole batch.
+ *
+ * @param dev
+ *	The Unikraft Block Device
+ * @param queue_id
+ *	The index of the queue to submit to.
+ *	The value must be in the range [0, nb_queue - 1] previously supplied
+ *	to uk_blkdev_configure().
+ * @param reqs
+ *	Array of `cnt` request structures
+ * @param cnt
+ *	Number of requests in `reqs`
+ * @return
+ *	- (>=0): Number of requests that were put to the queue, starting
+ *		with `reqs[0]`. It is less than `cnt` when the queue ran full.
+ *	- (<0): Negative value with error code from driver, no request was sent.
+ */
+int uk_blkdev_queue_submit_batch(struct uk_blkdev *dev, uint16_t queue_id,
+		struct uk_blkreq **reqs, uint16_t cnt);
+
+/**
+ * Plug a queue: requests handed to `uk_blkdev_queue_submit_batch()` are put
+ * to the queue but the device is not notified about them until the queue is
+ * unplugged. Plugging nests; only the outermost unplug notifies the device.
+ * Drivers that cannot defer notifications ignore plugging.
+ *
+ * @param dev
+ *	The Unikraft Block Device
+ * @param queue_id
+ *	queue id
+ */
+void uk_blkdev_queue_plug(struct uk_blkdev *dev, uint16_t queue_id);
+
+/**
+ * Unplug a queue and notify the device about all requests submitted while
+ * the queue was plugged.
+ *
+ * @param dev
+ *	The Unikraft Block Device
+ * @param queue_id
+ *	queue id
+ */
+void uk_blkdev_queue_unplug(struct uk_blkdev *dev, uint16_t queue_id);
+
+/**
+ * Wait for requests by polling the queue for responses from the caller's
+ * context. No interrupt or dispatcher thread is involved, so the queue must
+ * have been configured without an event callback. Request callbacks are
+ * still called for every response that is processed. Requests still held
+ * back by a plug are submitted to the device first.
+ *
+ * @param dev
+ *	The Unikraft Block Device
+ * @param queue_id
+ *	queue id
+ * @param reqs
+ *	Array of `cnt` requests to wait for
+ * @param cnt
+ *	Number of requests in `reqs`
+ * @return
+ *	- 0: All requests are finished
+ *	- (<0): on error returned by driver
+ */
+int uk_blkdev_queue_poll_reqs(struct uk_blkdev *dev, uint16_t queue_id,
+		struct uk_blkreq **reqs, uint16_t cnt);
+
 #if CONFIG_LIBUKBLKDEV_SYNC_IO_BLOCKED_WAITING
 /**
  * Make a sync io request on a specific queue.
@@ -194,6 +194,24 @@ typedef int (*uk_blkdev_queue_intr_disable_t)(struct uk_blkdev *dev,
 /** Driver callback type to submit a request to Unikraft block device. */
 typedef int (*uk_blkdev_queue_submit_one_t)(struct uk_blkdev *dev,
 		struct uk_blkdev_queue *queue, struct uk_blkreq *req);
+
+/**
+ * Driver callback type to submit a batch of requests to Unikraft block
+ * device. The device is notified at most once, and only if `notify` is set.
+ * Returns the number of requests that were put to the queue (which may be
+ * less than `cnt` when the queue ran full) or a negative error code if not
+ * even the first request could be enqueued.
+ **/
+typedef int (*uk_blkdev_queue_submit_batch_t)(struct uk_blkdev *dev,
+		struct uk_blkdev_queue *queue, struct uk_blkreq **reqs,
+		uint16_t cnt, int notify);
+
+/**
+ * Driver callback type to notify the device about requests that were
+ * enqueued earlier without notification.
+ **/
+typedef void (*uk_blkdev_queue_kick_t)(struct uk_blkdev *dev,
+		struct uk_blkdev_queue *queue);
 /**
  * Driver callback type to finish
  * a bunch of requests to Unikraft block device.
@@ -220,6 +238,7 @@ struct uk_blkdev_ops {
 	uk_blkdev_stop_t				dev_stop;
 	uk_blkdev_queue_intr_enable_t			queue_intr_enable;
 	uk_blkdev_queue_intr_disable_t			queue_intr_disable;
+	uk_blkdev_queue_kick_t				queue_kick;
 	uk_blkdev_queue_unconfigure_t			queue_unconfigure;
 	uk_blkdev_unconfigure_t				dev_unconfigure;
 };
@@ -266,6 +285,17 @@ struct uk_blkdev_event_handler {
 #endif
 };
 
+/**
+ * @internal
+ * Plugging state of a queue (internal to libukblkdev)
+ */
+struct uk_blkdev_plug {
+	/* Nesting level of uk_blkdev_queue_plug() calls */
+	unsigned int depth;
+	/* Requests enqueued without notifying the device */
+	unsigned int pending;
+};
+
 /**
  * @internal
  * libukblkdev internal data associated with each block device.
@@ -278,6 +308,8 @@ struct uk_blkdev_data {
 	/* Event handler for each queue */
 	struct uk_blkdev_event_handler
 		queue_handler[CONFIG_LIBUKBLKDEV_MAXNBQUEUES];
+	/* Plugging state for each queue */
+	struct uk_blkdev_plug queue_plug[CONFIG_LIBUKBLKDEV_MAXNBQUEUES];
 	/* Name of device*/
 	const char *drv_name;
 	/* Allocator */
@@ -287,6 +319,8 @@ struct uk_blkdev_data {
 struct uk_blkdev {
 	/* Pointer to submit request function */
 	uk_blkdev_queue_submit_one_t submit_one;
+	/* Pointer to submit batch function (optional) */
+	uk_blkdev_queue_submit_batch_t submit_batch;
 	/* Pointer to handle_responses function */
 	uk_blkdev_queue_finish_reqs_t finish_reqs;
 	/* Pointer to API-internal state data. */
@@ -55,6 +55,9 @@
 #elif CONFIG_LIBUKBOOT_INITTLSF
 #include <uk/tlsf.h>
 #endif
+#if CONFIG_LIBUKALLOCSLAB
+#include <uk/allocslab.h>
+#endif
 #if CONFIG_LIBUKSCHED
 #include <uk/sched.h>
 #endif
@@ -68,6 +71,7 @@
 #include <uk/print.h>
 #include <uk/ctors.h>
 #include <uk/init.h>
+#include <uk/initprof.h>
 #include <uk/page.h>
 #include <uk/argparse.h>
 #ifdef CONFIG_LIBUKLIBPARAM
@@ -115,6 +119,29 @@ extern char flexos_sd_alloc[];
 
 extern struct uk_alloc *flexos_shared_alloc;
 
+#if CONFIG_LIBUKALLOCSLAB
+/* Puts a slab allocator in front of `a`, keeps `a` if that fails */
+static struct uk_alloc *slab_front(struct uk_alloc *a)
+{
+	struct uk_alloc *s;
+
+	if (!a)
+		return NULL;
+	s = uk_allocslab_init(a);
+	return s ? s : a;
+}
+#endif /* CONFIG_LIBUKALLOCSLAB */
+
+#if CONFIG_LIBUKALLOC_STATS
+#define heap_set_name(a, name)					\
+	do {							\
+		if (a)						\
+			uk_alloc_stats_set_name((a), (name));	\
+	} while (0)
+#else
+#define heap_set_name(a, name) do { } while (0)
+#endif /* CONFIG_LIBUKALLOC_STATS */
+
 static void main_thread_func(void *arg)
 {
 #if CONFIG_LIBFLEXOS_INTELPKU
@@ -138,12 +165,25 @@ static void main_thread_func(void *arg)
 		flexos_vmept_init_rpc_ctrl(ctrl);
 		thread->ctrl = ctrl;
 
+		/* Post all create calls first so that the other compartments
+		 * set up their rpc threads in parallel, then collect the
+		 * replies. */
+		__nsec rpc_start = uk_initprof_start();
+
 		for (size_t i = 0; i < FLEXOS_VMEPT_COMP_COUNT; ++i) {
 			if (i == FLEXOS_VMEPT_COMP_ID)
 				continue;
 			printf("Creating rpc thread in compartment %d. Own compartment is %d.\n", i, FLEXOS_VMEPT_COMP_ID);
-			flexos_vmept_master_rpc_call_create(FLEXOS_VMEPT_COMP_ID, i, thread->tid);
+			flexos_vmept_master_rpc_send(FLEXOS_VMEPT_COMP_ID, i, thread->tid,
+				FLEXOS_VMEPT_MASTER_RPC_ACTION_CREATE);
+		}
+		for (size_t i = 0; i < FLEXOS_VMEPT_COMP_COUNT; ++i) {
+			if (i == FLEXOS_VMEPT_COMP_ID)
+				continue;
+			flexos_vmept_master_rpc_wait(i);
 		}
+		uk_initprof_record(UK_INITPROF_OTHER, NULL, "vmept rpc threads",
+				   rpc_start);
 
 		printf("Spawned rpc threads in other compartments (from main thread).\n");
 	}
@@ -154,6 +194,7 @@ static void main_thread_func(void *arg)
 	struct thread_main_arg *tma = arg;
 	uk_ctor_func_t *ctorfn;
 	uk_init_func_t *initfn;
+	__nsec start __maybe_unused;
 
 	/**
 	 * Run init table
@@ -163,7 +204,9 @@ static void main_thread_func(void *arg)
 	uk_inittab_foreach(initfn, uk_inittab_start, uk_inittab_end) {
 		UK_ASSERT(*initfn);
 		uk_pr_debug("Call init function: %p()...\n", *initfn);
+		start = uk_initprof_start();
 		ret = (*initfn)();
+		uk_initprof_record(UK_INITPROF_INITTAB, *initfn, NULL, start);
 		if (ret < 0) {
 			uk_pr_err("Init function at %p returned error %d\n",
 				  *initfn, ret);
@@ -195,7 +238,9 @@ static void main_thread_func(void *arg)
 			continue;
 
 		uk_pr_debug("Call pre-init constructor: %p()...\n", *ctorfn);
+		start = uk_initprof_start();
 		(*ctorfn)();
+		uk_initprof_record(UK_INITPROF_PREINIT, *ctorfn, NULL, start);
 	}
 
 	uk_pr_info("Constructor table at %p - %p\n",
@@ -205,9 +250,13 @@ static void main_thread_func(void *arg)
 			continue;
 
 		uk_pr_debug("Call constructor: %p()...\n", *ctorfn);
+		start = uk_initprof_start();
 		(*ctorfn)();
+		uk_initprof_record(UK_INITPROF_CTOR, *ctorfn, NULL, start);
 	}
 
+	uk_initprof_dump();
+
 	uk_pr_info("Calling main(%d, [", tma->argc);
 	for (i = 0; i < tma->argc; ++i) {
 		uk_pr_info("'%s'", tma->argv[i]);
@@ -222,6 +271,15 @@ static void main_thread_func(void *arg)
 	ret = main(tma->argc, tma->argv);
 #endif
 	uk_pr_info("main returned %d, halting system\n", ret);
+#if CONFIG_LIBUKALLOC_STATS_DUMP
+#if CONFIG_LIBFLEXOS_INTELPKU
+	/* we may only touch the default and the shared heap from here */
+	uk_alloc_stats_dump(_uk_alloc_head);
+	uk_alloc_stats_dump(flexos_shared_alloc);
+#else
+	uk_alloc_stats_dump(NULL);
+#endif /* CONFIG_LIBFLEXOS_INTELPKU */
+#endif /* CONFIG_LIBUKALLOC_STATS_DUMP */
 	ret = (ret != 0) ? UKPLAT_CRASH : UKPLAT_HALT;
 
 exit:
@@ -311,6 +369,7 @@ do {									\
 	(symalloc) = uk_tlsf_init(_buf, ((pages) - 1) * __PAGE_SIZE);	\
 	if (!(symalloc))						\
 		UK_CRASH("Failed to initialize heap for %s", (name));	\
+	heap_set_name((symalloc), (name));				\
 									\
 	uk_pr_info("Protecting %s's heap with key %d\n",		\
 			(name), (key));					\
@@ -402,6 +461,13 @@ do {									\
 			uk_alloc_addmem(a, md.base, md.len);
 		}
 	}
+#if CONFIG_LIBUKALLOCSLAB_DEFAULT
+	if (a) {
+		a = slab_front(a);
+		uk_alloc_set_default(a);
+	}
+#endif
+	heap_set_name(a, "heap");
 	if (unlikely(!a))
 		uk_pr_warn("No suitable memory region for memory allocator. Continue without heap\n");
 	else {
@@ -438,15 +504,16 @@ do {									\
 #endif /* CONFIG_LIBCPIO */
 #endif /* CONFIG_LIBVFSCORE */
 
-	/* TODO FLEXOS: the size of the heap should probably be a config variable. */
-	ASSIGN_HEAP("shared", 15 /* key */, 1000 /* size */, flexos_shared_alloc);
+	ASSIGN_HEAP("shared", 15 /* key */, CONFIG_LIBUKBOOT_HEAP_PAGES,
+		    flexos_shared_alloc);
 
 	/* The toolchain will insert section initializers here. */
 		PROTECT_SECTION("data_comp1", 1, (void *) __uk_image_symbol(_comp1),
 					 (void *) __uk_image_symbol(_ecomp1));
 	PROTECT_SECTION("bss_comp1", 1, (void *) __uk_image_symbol(_bss_comp1),
 					(void *) __uk_image_symbol(_ebss_comp1));
-	ASSIGN_HEAP("comp1", 1 /* key */, 1000 /* size */, flexos_comp1_alloc);
+	ASSIGN_HEAP("comp1", 1 /* key */, CONFIG_LIBUKBOOT_HEAP_PAGES,
+		    flexos_comp1_alloc);
 
 #elif CONFIG_LIBFLEXOS_VMEPT
 	unsigned long shmem_addr = FLEXOS_VMEPT_SHARED_MEM_ADDR;
@@ -471,6 +538,10 @@ do {									\
 	#else
 		#error "This only works for two compartments!"
 	#endif
+#if CONFIG_LIBUKALLOCSLAB_SHARED
+	flexos_shared_alloc = slab_front(flexos_shared_alloc);
+#endif
+	heap_set_name(flexos_shared_alloc, "shared");
 #endif /* CONFIG_LIBFLEXOS_VMEPT */
 
 #elif CONFIG_LIBFLEXOS_MORELLO
@@ -482,6 +553,22 @@ do {									\
 	flexos_shared_alloc = uk_allocbbuddy_init(flexos_sd_alloc, 1000 * __PAGE_SIZE);
 	comp1_allocator = uk_allocbbuddy_init(flexos_comp1_alloc, 1000 * __PAGE_SIZE);
 	comp2_allocator = uk_allocbbuddy_init(flexos_comp2_alloc, 1000 * __PAGE_SIZE);
+#if CONFIG_LIBUKALLOCSLAB_COMPARTMENTS
+	a = slab_front(a);
+	/* malloc() in compartment 0 goes to the default allocator */
+	uk_alloc_set_default(a);
+	allocators[0] = a;
+	comp0_allocator = a;
+	comp1_allocator = slab_front(comp1_allocator);
+	comp2_allocator = slab_front(comp2_allocator);
+#endif
+#if CONFIG_LIBUKALLOCSLAB_SHARED
+	flexos_shared_alloc = slab_front(flexos_shared_alloc);
+#endif
+	heap_set_name(comp0_allocator, "comp0");
+	heap_set_name(comp1_allocator, "comp1");
+	heap_set_name(comp2_allocator, "comp2");
+	heap_set_name(flexos_shared_alloc, "shared");
 	init_compartments();
 
 	//SQLite mutual distrust
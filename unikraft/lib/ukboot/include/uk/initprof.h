@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __UK_INITPROF_H__
+#define __UK_INITPROF_H__
+
+#include <uk/config.h>
+#include <uk/essentials.h>
+#include <uk/arch/time.h>
+#if CONFIG_LIBUKBOOT_INITPROF
+#include <uk/plat/time.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* What an init profile entry measured */
+enum uk_initprof_kind {
+	UK_INITPROF_INITTAB,	/* uk_inittab entry */
+	UK_INITPROF_PREINIT,	/* .preinit_array constructor */
+	UK_INITPROF_CTOR,	/* .init_array constructor */
+	UK_INITPROF_ASYNC,	/* asynchronous or lazy init function */
+	UK_INITPROF_JOIN,	/* time spent waiting for an async one */
+	UK_INITPROF_OTHER,	/* any other boot step */
+};
+
+#if CONFIG_LIBUKBOOT_INITPROF
+static inline __nsec uk_initprof_start(void)
+{
+	return ukplat_monotonic_clock();
+}
+
+/**
+ * Records the time elapsed since `start` (from uk_initprof_start()) for
+ * the init function `fn`. `name` may be NULL, in which case the dump
+ * shows the function address. Entries beyond
+ * CONFIG_LIBUKBOOT_INITPROF_MAX are only accounted in the totals.
+ */
+void uk_initprof_record(enum uk_initprof_kind kind, const void *fn,
+			const char *name, __nsec start);
+
+/**
+ * Records an already measured duration.
+ */
+void uk_initprof_add(enum uk_initprof_kind kind, const void *fn,
+		     const char *name, __nsec time);
+
+/**
+ * Prints all recorded entries, followed by per-kind totals.
+ */
+void uk_initprof_dump(void);
+#else
+static inline __nsec uk_initprof_start(void)
+{
+	return 0;
+}
+
+static inline void uk_initprof_record(enum uk_initprof_kind kind __unused,
+				      const void *fn __unused,
+				      const char *name __unused,
+				      __nsec start __unused)
+{
+}
+
+static inline void uk_initprof_add(enum uk_initprof_kind kind __unused,
+				   const void *fn __unused,
+				   const char *name __unused,
+				   __nsec time __unused)
+{
+}
+
+static inline void uk_initprof_dump(void)
+{
+}
+#endif /* CONFIG_LIBUKBOOT_INITPROF */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UK_INITPROF_H__ */
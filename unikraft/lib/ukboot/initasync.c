@@ -0,0 +1,126 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <uk/config.h>
+#include <uk/essentials.h>
+#include <uk/arch/lcpu.h>
+#include <uk/print.h>
+#include <uk/init.h>
+#include <uk/initprof.h>
+#include <uk/plat/time.h>
+#include <uk/assert.h>
+#if CONFIG_LIBUKSCHED
+#include <uk/sched.h>
+#endif
+#if CONFIG_LIBUKBOOT_INITASYNC
+#include <uk/thread.h>
+#endif
+
+static void init_async_run(struct uk_init_async *ia)
+{
+	__nsec start = ukplat_monotonic_clock();
+
+	uk_pr_debug("Call async init function: %s()...\n", ia->name);
+	ia->ret = ia->fn();
+	ia->time = ukplat_monotonic_clock() - start;
+	barrier();
+	ia->state = UK_INIT_ASYNC_DONE;
+}
+
+#if CONFIG_LIBUKBOOT_INITASYNC
+static void init_async_thread(void *arg)
+{
+	init_async_run((struct uk_init_async *) arg);
+}
+#endif
+
+int uk_init_async_start(struct uk_init_async *ia)
+{
+	UK_ASSERT(ia && ia->fn);
+
+	if (ia->state != UK_INIT_ASYNC_PENDING)
+		return 0;
+	ia->state = UK_INIT_ASYNC_RUNNING;
+
+#if CONFIG_LIBUKBOOT_INITASYNC
+	if (unlikely(!uk_thread_create(ia->name, init_async_thread, ia))) {
+		uk_pr_err("Failed to create thread for %s()\n", ia->name);
+		ia->state = UK_INIT_ASYNC_PENDING;
+		return -ENOMEM;
+	}
+#else
+	init_async_run(ia);
+#endif
+	return 0;
+}
+
+int uk_init_async_wait(struct uk_init_async *ia)
+{
+	__nsec start = uk_initprof_start();
+	int ran = 0;
+
+	UK_ASSERT(ia && ia->fn);
+
+	if (ia->state == UK_INIT_ASYNC_JOINED)
+		return ia->ret;
+
+	if (ia->state == UK_INIT_ASYNC_PENDING) {
+		/* Lazy, or its start point was not reached yet */
+		ia->state = UK_INIT_ASYNC_RUNNING;
+		init_async_run(ia);
+		ran = 1;
+	}
+	/*
+	 * Also without LIBUKBOOT_INITASYNC, another thread may be running the
+	 * function lazily from its own wait
+	 */
+	while (ia->state == UK_INIT_ASYNC_RUNNING) {
+#if CONFIG_LIBUKSCHED
+		uk_sched_yield();
+#else
+		/* With a single thread, only the function itself can be here */
+		UK_CRASH("%s() waits for itself to finish\n", ia->name);
+#endif
+	}
+	if (ia->state == UK_INIT_ASYNC_JOINED)
+		return ia->ret; /* Someone else joined while we yielded */
+	UK_ASSERT(ia->state == UK_INIT_ASYNC_DONE);
+	ia->state = UK_INIT_ASYNC_JOINED;
+
+	uk_initprof_add(UK_INITPROF_ASYNC, ia->fn, ia->name, ia->time);
+	if (!ran)
+		uk_initprof_record(UK_INITPROF_JOIN, ia->fn, ia->name, start);
+
+	if (ia->ret < 0)
+		uk_pr_err("Init function %s() returned error %d\n",
+			  ia->name, ia->ret);
+	return ia->ret;
+}
@@ -0,0 +1,103 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <uk/essentials.h>
+#include <uk/arch/lcpu.h>
+#include <uk/initprof.h>
+
+struct initprof_entry {
+	const void *fn;
+	const char *name;
+	enum uk_initprof_kind kind;
+	__nsec time;
+};
+
+static struct initprof_entry entries[CONFIG_LIBUKBOOT_INITPROF_MAX];
+static unsigned int nb_entries;
+static unsigned int nb_dropped;
+static __nsec totals[UK_INITPROF_OTHER + 1];
+
+static const char *kind_names[UK_INITPROF_OTHER + 1] = {
+	[UK_INITPROF_INITTAB] = "inittab",
+	[UK_INITPROF_PREINIT] = "preinit",
+	[UK_INITPROF_CTOR]    = "ctor",
+	[UK_INITPROF_ASYNC]   = "async",
+	[UK_INITPROF_JOIN]    = "join",
+	[UK_INITPROF_OTHER]   = "other",
+};
+
+void uk_initprof_add(enum uk_initprof_kind kind, const void *fn,
+		     const char *name, __nsec time)
+{
+	struct initprof_entry *e;
+
+	totals[kind] += time;
+	if (unlikely(nb_entries == ARRAY_SIZE(entries))) {
+		nb_dropped++;
+		return;
+	}
+
+	e = &entries[nb_entries++];
+	e->fn = fn;
+	e->name = name;
+	e->kind = kind;
+	e->time = time;
+}
+
+void uk_initprof_record(enum uk_initprof_kind kind, const void *fn,
+			const char *name, __nsec start)
+{
+	uk_initprof_add(kind, fn, name, ukplat_monotonic_clock() - start);
+}
+
+void uk_initprof_dump(void)
+{
+	struct initprof_entry *e;
+	unsigned int i;
+
+	printf("Init profile (us):\n");
+	for (i = 0; i < nb_entries; i++) {
+		e = &entries[i];
+		if (e->name)
+			printf("  %-8s %10llu  %s\n", kind_names[e->kind],
+			       (unsigned long long) e->time / 1000, e->name);
+		else
+			printf("  %-8s %10llu  %p\n", kind_names[e->kind],
+			       (unsigned long long) e->time / 1000, e->fn);
+	}
+	if (nb_dropped)
+		printf("  (%u more entries not shown)\n", nb_dropped);
+
+	printf("Init profile totals (us):\n");
+	for (i = 0; i < ARRAY_SIZE(totals); i++)
+		printf("  %-8s %10llu\n", kind_names[i],
+		       (unsigned long long) totals[i] / 1000);
+}
@@ -48,6 +48,7 @@
 #define __UK_TRACE_MAX_STRLEN 80
 #define UK_TP_HEADER_MAGIC 0x64685254 /* TRhd */
 #define UK_TP_DEF_MAGIC 0x65645054 /* TPde */
+#define UK_TP_WRAP_MAGIC 0x72775254 /* TRwr */
 
 enum __uk_trace_arg_type {
 	__UK_TRACE_ARG_INT = 0,
@@ -61,8 +62,32 @@ struct uk_tracepoint_header {
 	void *cookie;
 };
 
+#if CONFIG_LIBUKDEBUG_TRACE_RING
+#define __UK_TRACE_RING_SIZE CONFIG_LIBUKDEBUG_TRACE_BUFFER_SIZE
+
+/* Records are written by the owning CPU only, with interrupts
+ * disabled, so the rings need no lock. head and tail are byte
+ * positions that only grow; the offset in data is pos % size. The
+ * range [head, tail) holds complete records, oldest first. A record
+ * never crosses the end of data: the rest of the buffer is skipped
+ * instead, marked with UK_TP_WRAP_MAGIC if a header fits there.
+ */
+struct uk_trace_ring {
+	uint64_t head;
+	uint64_t tail;
+	/* Start of the record that is currently being written */
+	uint64_t rec;
+	/* Number of records overwritten so far */
+	uint64_t lost;
+	char data[__UK_TRACE_RING_SIZE];
+};
+
+extern struct uk_trace_ring
+	uk_trace_rings[CONFIG_LIBUKDEBUG_TRACE_NR_BUFFERS];
+#else
 extern size_t uk_trace_buffer_free;
 extern char *uk_trace_buffer_writep;
+#endif
 
 
 static inline void __uk_trace_save_arg(char **pbuff,
@@ -84,7 +109,9 @@ static inline void __uk_trace_save_arg(char **pbuff,
 	if (free < (size_t) size) {
 		/* Block the next invocations of trace points */
 		*pfree = 0;
+#if !CONFIG_LIBUKDEBUG_TRACE_RING
 		uk_trace_buffer_free = 0;
+#endif
 		return;
 	}
 
@@ -126,6 +153,22 @@ static inline void __uk_trace_save_arg(char **pbuff,
 #define __UK_TRACE_SAVE_ARGS6() __UK_TRACE_SAVE_ARGS5(); __UK_TRACE_SAVE_ONE(arg6)
 #define __UK_TRACE_SAVE_ARGS7() __UK_TRACE_SAVE_ARGS6(); __UK_TRACE_SAVE_ONE(arg7)
 
+/* Upper bound of the space needed by the arguments, used to reserve
+ * room in the ring before they are saved
+ */
+#define __UK_TRACE_MAXSZ_ONE(arg) (					\
+	__UK_TRACE_GET_TYPE(arg) == __UK_TRACE_ARG_STRING ?		\
+		__UK_TRACE_MAX_STRLEN + 1 : sizeof(arg))
+
+#define __UK_TRACE_MAXSZ_ARGS0() 0
+#define __UK_TRACE_MAXSZ_ARGS1() __UK_TRACE_MAXSZ_ONE(arg1)
+#define __UK_TRACE_MAXSZ_ARGS2() __UK_TRACE_MAXSZ_ARGS1() + __UK_TRACE_MAXSZ_ONE(arg2)
+#define __UK_TRACE_MAXSZ_ARGS3() __UK_TRACE_MAXSZ_ARGS2() + __UK_TRACE_MAXSZ_ONE(arg3)
+#define __UK_TRACE_MAXSZ_ARGS4() __UK_TRACE_MAXSZ_ARGS3() + __UK_TRACE_MAXSZ_ONE(arg4)
+#define __UK_TRACE_MAXSZ_ARGS5() __UK_TRACE_MAXSZ_ARGS4() + __UK_TRACE_MAXSZ_ONE(arg5)
+#define __UK_TRACE_MAXSZ_ARGS6() __UK_TRACE_MAXSZ_ARGS5() + __UK_TRACE_MAXSZ_ONE(arg6)
+#define __UK_TRACE_MAXSZ_ARGS7() __UK_TRACE_MAXSZ_ARGS6() + __UK_TRACE_MAXSZ_ONE(arg7)
+
 #define __UK_GET_ARG1(a1, ...) a1
 #define __UK_GET_ARG2(a1, a2, ...) a2
 #define __UK_GET_ARG3(a1, a2, a3, ...) a3
@@ -195,7 +238,105 @@ static inline void __uk_trace_save_arg(char **pbuff,
 		__UK_TRACE_ARG_TYPES(NR, __VA_ARGS__),		\
 		#trace_name, fmt }
 
-static inline char *__uk_trace_get_buff(size_t *free)
+#if CONFIG_LIBUKDEBUG_TRACE_RING
+static inline struct uk_trace_ring *__uk_trace_ring(void)
+{
+	/* CPUs sharing a ring would race on it, see
+	 * CONFIG_LIBUKDEBUG_TRACE_NR_BUFFERS
+	 */
+	return &uk_trace_rings[ukplat_lcpu_id()
+			       % CONFIG_LIBUKDEBUG_TRACE_NR_BUFFERS];
+}
+
+/* Drops the oldest records until the record ending at `end` fits. If
+ * everything written before `start` is gone, the skipped space
+ * between the old tail and `start` is dropped as well.
+ */
+static inline void __uk_trace_ring_evict(struct uk_trace_ring *r,
+					 uint64_t start, uint64_t end)
+{
+	struct uk_tracepoint_header *old;
+	uint64_t head = r->head;
+	size_t off;
+
+	if (likely(end - head <= __UK_TRACE_RING_SIZE))
+		return;
+
+	while (end - head > __UK_TRACE_RING_SIZE) {
+		if (head >= r->tail) {
+			head = start;
+			break;
+		}
+
+		off = head % __UK_TRACE_RING_SIZE;
+		old = (struct uk_tracepoint_header *) &r->data[off];
+		if (__UK_TRACE_RING_SIZE - off < sizeof(*old) ||
+		    old->magic == UK_TP_WRAP_MAGIC) {
+			head += __UK_TRACE_RING_SIZE - off;
+		} else {
+			head += sizeof(*old) + old->size;
+			r->lost++;
+		}
+	}
+
+	/* A concurrent uk_trace_drain() must see the new head before
+	 * the old records get overwritten
+	 */
+	__atomic_store_n(&r->head, head, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static inline char *__uk_trace_get_buff(size_t max, size_t *free)
+{
+	struct uk_trace_ring *r = __uk_trace_ring();
+	struct uk_tracepoint_header *ret;
+	size_t len = sizeof(*ret) + max;
+	uint64_t start = r->tail;
+	size_t off = start % __UK_TRACE_RING_SIZE;
+
+	if (unlikely(len > __UK_TRACE_RING_SIZE))
+		return 0;
+
+	if (off + len > __UK_TRACE_RING_SIZE) {
+		start += __UK_TRACE_RING_SIZE - off;
+		__uk_trace_ring_evict(r, start, start + len);
+		if (__UK_TRACE_RING_SIZE - off >= sizeof(*ret)) {
+			ret = (struct uk_tracepoint_header *) &r->data[off];
+			ret->magic = UK_TP_WRAP_MAGIC;
+		}
+		off = 0;
+	} else {
+		__uk_trace_ring_evict(r, start, start + len);
+	}
+
+	ret = (struct uk_tracepoint_header *) &r->data[off];
+	ret->magic = 0;
+	r->rec = start;
+	*free = max;
+	return (char *) (ret + 1);
+}
+
+static inline void __uk_trace_finalize_buff(char *new_buff_pos, void *cookie)
+{
+	struct uk_trace_ring *r = __uk_trace_ring();
+	struct uk_tracepoint_header *head =
+		(struct uk_tracepoint_header *)
+		&r->data[r->rec % __UK_TRACE_RING_SIZE];
+	uint32_t size;
+
+	size = new_buff_pos - (char *) head;
+
+	head->time = ukplat_monotonic_clock();
+	head->size = size - sizeof(*head);
+	head->cookie = cookie;
+	head->magic = UK_TP_HEADER_MAGIC;
+
+	/* Publish the record to uk_trace_drain() */
+	__atomic_store_n(&r->tail, r->rec + size, __ATOMIC_RELEASE);
+}
+#else
+static inline char *__uk_trace_get_buff(size_t max __unused,
+					size_t *free)
 {
 	struct uk_tracepoint_header *ret;
 
@@ -229,6 +370,29 @@ static inline void __uk_trace_finalize_buff(char *new_buff_pos, void *cookie)
 	head->magic = UK_TP_HEADER_MAGIC;
 }
 
+#endif /* CONFIG_LIBUKDEBUG_TRACE_RING */
+
+/* Sink for uk_trace_drain(). Returns 0 on success, a negative value
+ * aborts the drain.
+ */
+typedef int (*uk_trace_drain_func_t)(void *arg, const void *buf, size_t len);
+
+/* Writes the records that were not drained yet, oldest first, as one
+ * binary dump (see support/scripts/uk_trace). Rings keep being
+ * written while they are drained. Not reentrant.
+ */
+int uk_trace_drain(uk_trace_drain_func_t fn, void *arg);
+
+/* Drains as hex lines on the kernel console, for
+ * `trace.py decode --console`
+ */
+int uk_trace_drain_console(void);
+
+#if CONFIG_LIBVFSCORE
+/* Drains into an open file, e.g., on a 9pfs share */
+int uk_trace_drain_fd(int fd);
+#endif
+
 /* Makes from "const char*" "const char* arg1".
  */
 #define __UK_ARGS_MAP_FN(n, t) t UK_CONCAT(arg, n)
@@ -249,7 +413,8 @@ static inline void __uk_trace_finalize_buff(char *new_buff_pos, void *cookie)
 	{								\
 		unsigned long flags = ukplat_lcpu_save_irqf();		\
 		size_t free __maybe_unused;				\
-		char *buff = __uk_trace_get_buff(&free);		\
+		char *buff = __uk_trace_get_buff(			\
+			__UK_TRACE_MAXSZ_ARGS ## n(), &free);		\
 		if (buff) {						\
 			__UK_TRACE_SAVE_ARGS ## n();			\
 			__uk_trace_finalize_buff(			\
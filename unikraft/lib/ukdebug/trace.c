@@ -31,17 +31,243 @@
  */
 
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include <uk/essentials.h>
+#include <uk/trace.h>
+#include <uk/plat/console.h>
+#if CONFIG_LIBVFSCORE
+#include <unistd.h>
+#include <errno.h>
+#endif
 
+/* Tracepoints are inlined into every library, which may live in other
+ * compartments than ukdebug
+ */
+#if CONFIG_LIBFLEXOS_INTELPKU || CONFIG_LIBFLEXOS_MORELLO
+#define __trace_shared __section(".data_shared")
+#else
+#define __trace_shared
+#endif
+
+#if CONFIG_LIBUKDEBUG_TRACE_RING
+struct uk_trace_ring uk_trace_rings[CONFIG_LIBUKDEBUG_TRACE_NR_BUFFERS]
+	__trace_shared;
+
+/* Position up to which every ring was drained */
+static uint64_t trace_drained[CONFIG_LIBUKDEBUG_TRACE_NR_BUFFERS];
+#else
 /* If the buffer is full, tracing disables itself.
  * Using a circular buffer will not make it better: in any case, losing trace
  * data is undesired and we should keep this as simple as possible.
+ * CONFIG_LIBUKDEBUG_TRACE_RING trades this for tracepoints that can stay
+ * enabled during the whole run.
  */
-char uk_trace_buffer[CONFIG_LIBUKDEBUG_TRACE_BUFFER_SIZE];
+char uk_trace_buffer[CONFIG_LIBUKDEBUG_TRACE_BUFFER_SIZE] __trace_shared;
+
+size_t uk_trace_buffer_free __trace_shared =
+	CONFIG_LIBUKDEBUG_TRACE_BUFFER_SIZE;
+char *uk_trace_buffer_writep __trace_shared = uk_trace_buffer;
+
+static size_t trace_drained;
+#endif
+
+#define UK_TRACE_DUMP_MAGIC 0x70645254 /* TRdp */
+#define UK_TRACE_DUMP_BUF_MAGIC 0x66625254 /* TRbf */
+#define UK_TRACE_FORMAT_VERSION 2
+
+/* A dump is this header followed by nr_buffers buffers, each one a
+ * struct uk_trace_dump_buf and `size` bytes of records in the same
+ * layout as uk_trace_buffer
+ */
+struct uk_trace_dump_header {
+	uint32_t magic;
+	uint16_t version;
+	uint8_t ptr_size;
+	uint8_t nr_buffers;
+	uint64_t time;
+};
+
+struct uk_trace_dump_buf {
+	uint32_t magic;
+	uint32_t cpu;
+	uint32_t size;
+	uint32_t lost;
+};
+
+/* Records are linearized here before they are handed to the sink */
+static char trace_scratch[CONFIG_LIBUKDEBUG_TRACE_BUFFER_SIZE];
+
+#if CONFIG_LIBUKDEBUG_TRACE_RING
+/* Copies the records of ring r that were not drained yet into
+ * trace_scratch, without the space skipped at the end of the buffer.
+ * The writer is not stopped: after the copy we check which records
+ * got overwritten meanwhile and drop them.
+ */
+static size_t trace_ring_copy(unsigned int i)
+{
+	struct uk_trace_ring *r = &uk_trace_rings[i];
+	struct uk_tracepoint_header *hdr;
+	uint64_t head, tail, from, pos;
+	size_t off, len, out = 0;
+
+	tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+	head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+	from = MAX(head, trace_drained[i]);
+	if (from >= tail)
+		return 0;
+
+	/* Raw copy of [from, tail), in at most two pieces */
+	off = from % __UK_TRACE_RING_SIZE;
+	len = MIN(tail - from, __UK_TRACE_RING_SIZE - off);
+	memcpy(trace_scratch, &r->data[off], len);
+	memcpy(trace_scratch + len, r->data, (tail - from) - len);
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+	trace_drained[i] = tail;
+	if (head >= tail)
+		return 0;
+
+	/* Walk the records that survived and compact them in place */
+	for (pos = MAX(head, from); pos < tail; ) {
+		off = pos % __UK_TRACE_RING_SIZE;
+		hdr = (struct uk_tracepoint_header *)
+			&trace_scratch[pos - from];
+		if (__UK_TRACE_RING_SIZE - off < sizeof(*hdr) ||
+		    hdr->magic == UK_TP_WRAP_MAGIC) {
+			pos += __UK_TRACE_RING_SIZE - off;
+			continue;
+		}
+
+		len = sizeof(*hdr) + hdr->size;
+		memmove(&trace_scratch[out], hdr, len);
+		out += len;
+		pos += len;
+	}
+	return out;
+}
+
+#define trace_nr_buffers() CONFIG_LIBUKDEBUG_TRACE_NR_BUFFERS
+#define trace_lost(i) ((uint32_t) uk_trace_rings[i].lost)
+#else
+static size_t trace_ring_copy(unsigned int i __unused)
+{
+	size_t used = uk_trace_buffer_writep - uk_trace_buffer;
+	size_t len = used - trace_drained;
+
+	memcpy(trace_scratch, uk_trace_buffer + trace_drained, len);
+	trace_drained = used;
+	return len;
+}
+
+#define trace_nr_buffers() 1
+#define trace_lost(i) 0
+#endif /* CONFIG_LIBUKDEBUG_TRACE_RING */
+
+int uk_trace_drain(uk_trace_drain_func_t fn, void *arg)
+{
+	struct uk_trace_dump_header hdr = {
+		.magic = UK_TRACE_DUMP_MAGIC,
+		.version = UK_TRACE_FORMAT_VERSION,
+		.ptr_size = sizeof(void *),
+		.nr_buffers = trace_nr_buffers(),
+		.time = ukplat_monotonic_clock(),
+	};
+	struct uk_trace_dump_buf buf;
+	unsigned int i;
+	int ret;
+
+	ret = fn(arg, &hdr, sizeof(hdr));
+	if (ret < 0)
+		return ret;
+
+	for (i = 0; i < trace_nr_buffers(); i++) {
+		buf.magic = UK_TRACE_DUMP_BUF_MAGIC;
+		buf.cpu = i;
+		buf.size = trace_ring_copy(i);
+		buf.lost = trace_lost(i);
+
+		ret = fn(arg, &buf, sizeof(buf));
+		if (ret < 0)
+			return ret;
+		ret = fn(arg, trace_scratch, buf.size);
+		if (ret < 0)
+			return ret;
+	}
+	return 0;
+}
+
+/* The console cannot carry binary data: every line is the prefix and
+ * up to TRACE_LINE_BYTES bytes in hex
+ */
+#define TRACE_LINE_PREFIX "uktrace: "
+#define TRACE_LINE_BYTES 32
+
+struct trace_console {
+	char line[sizeof(TRACE_LINE_PREFIX) - 1 + 2 * TRACE_LINE_BYTES + 1];
+	size_t len;
+};
+
+static void trace_console_flush(struct trace_console *c)
+{
+	if (c->len == sizeof(TRACE_LINE_PREFIX) - 1)
+		return;
+	c->line[c->len++] = '\n';
+	ukplat_coutk(c->line, c->len);
+	c->len = sizeof(TRACE_LINE_PREFIX) - 1;
+}
+
+static int trace_console_write(void *arg, const void *buf, size_t len)
+{
+	static const char hex[] = "0123456789abcdef";
+	struct trace_console *c = arg;
+	const uint8_t *p = buf;
+
+	while (len--) {
+		c->line[c->len++] = hex[*p >> 4];
+		c->line[c->len++] = hex[*p++ & 0xf];
+		if (c->len == sizeof(c->line) - 1)
+			trace_console_flush(c);
+	}
+	return 0;
+}
+
+int uk_trace_drain_console(void)
+{
+	struct trace_console c = {
+		.line = TRACE_LINE_PREFIX,
+		.len = sizeof(TRACE_LINE_PREFIX) - 1,
+	};
+	int ret;
+
+	ret = uk_trace_drain(trace_console_write, &c);
+	trace_console_flush(&c);
+	return ret;
+}
+
+#if CONFIG_LIBVFSCORE
+static int trace_fd_write(void *arg, const void *buf, size_t len)
+{
+	int fd = *(int *) arg;
+	const char *p = buf;
+	ssize_t ret;
 
-size_t uk_trace_buffer_free = CONFIG_LIBUKDEBUG_TRACE_BUFFER_SIZE;
-char *uk_trace_buffer_writep = uk_trace_buffer;
+	while (len) {
+		ret = write(fd, p, len);
+		if (ret < 0)
+			return -errno;
+		p += ret;
+		len -= ret;
+	}
+	return 0;
+}
 
+int uk_trace_drain_fd(int fd)
+{
+	return uk_trace_drain(trace_fd_write, &fd);
+}
+#endif
 
 /* Store a string in format "key = value" in the section
  * .uk_trace_keyvals. This can be anything what you want trace.py
@@ -58,4 +284,4 @@ char *uk_trace_buffer_writep = uk_trace_buffer;
 	static const char key[] __used =		\
 		#key " = " #val
 
-TRACE_DEFINE_KEY(format_version, 1);
+TRACE_DEFINE_KEY(format_version, 2);
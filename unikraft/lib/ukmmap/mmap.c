@@ -170,8 +170,55 @@ UK_SYSCALL_DEFINE(int, munmap, void*, addr, size_t, len)
 	return 0;
 }
 
-void *mremap(void *old_address __unused, size_t old_size __unused,
-	     size_t new_size __unused, int flags __unused, ...)
+#ifndef MREMAP_MAYMOVE
+#define MREMAP_MAYMOVE 1
+#endif
+
+/*
+ * mremap resizes a memory block that has been allocated from mmap the way
+ * realloc would: shrinking keeps the block where it is, growing moves it to
+ * a new block if MREMAP_MAYMOVE allows it. MREMAP_FIXED is not supported.
+ */
+
+void *mremap(void *old_address, size_t old_size __unused, size_t new_size,
+	     int flags, ...)
 {
-	return NULL;
+	struct mmap_addr *tmp = mmap_addr;
+	size_t cur_size;
+	void *mem;
+
+	if (!new_size || (flags & ~MREMAP_MAYMOVE)) {
+		errno = EINVAL;
+		return (void *) -1;
+	}
+
+	while (tmp && tmp->begin != old_address)
+		tmp = tmp->next;
+	if (!tmp) {
+		errno = EFAULT;
+		return (void *) -1;
+	}
+
+	cur_size = tmp->end - tmp->begin;
+	if (new_size <= cur_size) {
+		tmp->end = tmp->begin + new_size;
+		return old_address;
+	}
+
+	if (!(flags & MREMAP_MAYMOVE)) {
+		errno = ENOMEM;
+		return (void *) -1;
+	}
+
+	mem = uk_malloc(uk_alloc_get_default(), new_size);
+	if (!mem) {
+		errno = ENOMEM;
+		return (void *) -1;
+	}
+	memcpy(mem, tmp->begin, cur_size);
+	memset(mem + cur_size, 0, new_size - cur_size);
+	uk_free(uk_alloc_get_default(), tmp->begin);
+	tmp->begin = mem;
+	tmp->end = mem + new_size;
+	return mem;
 }
@@ -37,6 +37,7 @@
 #include <stddef.h>
 #include <limits.h>
 #include <errno.h>
+#include <uk/config.h>
 #include <uk/assert.h>
 #include <uk/refcount.h>
 #include <uk/alloc.h>
@@ -47,6 +48,7 @@ extern "C" {
 #endif
 
 struct uk_netbuf;
+struct uk_netbuf_pool;
 
 typedef void (*uk_netbuf_dtor_t)(struct uk_netbuf *);
 
@@ -117,6 +119,7 @@ struct uk_netbuf {
 	uk_netbuf_dtor_t dtor; /**< Destructor callback */
 	struct uk_alloc *_a;   /**< @internal Allocator for free'ing */
 	void *_b;              /**< @internal Base address for free'ing */
+	struct uk_netbuf_pool *_p; /**< @internal Pool for recycling `_b` */
 };
 
 /*
@@ -449,6 +452,94 @@ void uk_netbuf_free(struct uk_netbuf *m);
  */
 void uk_netbuf_free_single(struct uk_netbuf *m);
 
+/**
+ * Releases an array of netbuf chains, like calling uk_netbuf_free() on each
+ * of them. Netbufs that go back to the same pool are returned with a single
+ * pool operation. Device drivers should use this on transmit completion.
+ * @param m
+ *   Array of heads of uk_netbuf chains to release
+ * @param count
+ *   Number of entries in `m`
+ */
+void uk_netbuf_free_batch(struct uk_netbuf *m[], unsigned int count);
+
+#if CONFIG_LIBUKNETDEV_NETBUFPOOL
+/**
+ * Allocates a pool of netbufs with equally sized data buffer areas. Each
+ * object is laid out like an allocation of uk_netbuf_alloc_buf(). When a
+ * pool netbuf is free'd, it is recycled to the pool instead of the allocator.
+ * A pool is not synchronized: netbufs must not be taken or free'd
+ * concurrently, e.g., from interrupt context and from a thread.
+ * @param a
+ *   Allocator on which the pool will be allocated
+ * @param count
+ *   Number of netbufs in the pool
+ * @param buflen
+ *   Size of the buffer area of each netbuf
+ * @param bufalign
+ *   Alignment for the buffer area (`m->buf` will be aligned to it)
+ * @param headroom
+ *   Number of bytes reserved as headroom from the buffer area
+ * @param privlen
+ *   Length for reserved memory to store private data in each netbuf
+ * @param dtor
+ *   Destructor that is called when a netbuf is returned to the pool (optional)
+ * @returns
+ *   - (NULL): Allocation failed
+ *   - netbuf pool
+ */
+struct uk_netbuf_pool *uk_netbuf_pool_alloc(struct uk_alloc *a,
+					    unsigned int count,
+					    size_t buflen, size_t bufalign,
+					    uint16_t headroom, size_t privlen,
+					    uk_netbuf_dtor_t dtor);
+
+/**
+ * Frees a netbuf pool. All netbufs have to be returned to the pool before.
+ * @param p
+ *   Netbuf pool to free
+ */
+void uk_netbuf_pool_free(struct uk_netbuf_pool *p);
+
+/**
+ * Takes and initializes multiple netbufs from a pool. Each netbuf is in the
+ * same state as one returned by uk_netbuf_alloc_buf().
+ * @param p
+ *   Netbuf pool
+ * @param m
+ *   Array that is filled with the taken netbufs
+ * @param count
+ *   Maximum number of netbufs to take
+ * @returns
+ *   Number of netbufs placed on `m`
+ */
+unsigned int uk_netbuf_pool_take_batch(struct uk_netbuf_pool *p,
+				       struct uk_netbuf *m[],
+				       unsigned int count);
+
+/**
+ * Takes and initializes one netbuf from a pool.
+ * @param p
+ *   Netbuf pool
+ * @returns
+ *   - (NULL): The pool is empty
+ *   - initialized uk_netbuf
+ */
+static inline struct uk_netbuf *uk_netbuf_pool_take(struct uk_netbuf_pool *p)
+{
+	struct uk_netbuf *m;
+
+	return uk_netbuf_pool_take_batch(p, &m, 1) ? m : NULL;
+}
+
+/**
+ * Returns the number of netbufs that are currently available in a pool.
+ * @param p
+ *   Netbuf pool
+ */
+unsigned int uk_netbuf_pool_availcount(struct uk_netbuf_pool *p);
+#endif /* CONFIG_LIBUKNETDEV_NETBUFPOOL */
+
 /**
  * Calculates the current available headroom bytes of a netbuf
  * @param m
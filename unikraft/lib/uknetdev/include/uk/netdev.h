@@ -198,6 +198,26 @@ int uk_netdev_configure(struct uk_netdev *dev,
 int uk_netdev_rxq_info_get(struct uk_netdev *dev, uint16_t queue_id,
 			   struct uk_netdev_queue_info *queue_info);
 
+/**
+ * Copies the statistics of a receive queue. The counters are updated without
+ * synchronization, so the snapshot may be slightly inconsistent while the
+ * queue is active. Polling rounds and the packets-per-poll histogram are only
+ * maintained with dispatcher threads (LIBUKNETDEV_DISPATCHERTHREADS).
+ *
+ * @param dev
+ *   The Unikraft Network Device.
+ * @param queue_id
+ *   The index of the receive queue.
+ *   The value must be in the range [0, nb_rx_queue - 1] previously supplied
+ *   to uk_netdev_configure().
+ * @param stats
+ *   A pointer to a structure of type *uk_netdev_rxq_stats* to be filled out
+ * @param reset
+ *   If non-zero, the counters of the queue are cleared after copying them.
+ */
+void uk_netdev_rxq_stats_get(struct uk_netdev *dev, uint16_t queue_id,
+			     struct uk_netdev_rxq_stats *stats, int reset);
+
 /**
  * Sets up one receive queue for an Unikraft network device.
  *
@@ -388,6 +408,10 @@ static inline int uk_netdev_rxq_intr_enable(struct uk_netdev *dev,
 
 	if (unlikely(!dev->ops->rxq_intr_enable))
 		return -ENOTSUP;
+#ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
+	/* The dispatcher re-enables interrupts after polling if requested */
+	dev->_data->rxq_handler[queue_id].intr_enabled = 1;
+#endif
 	return dev->ops->rxq_intr_enable(dev, dev->_rx_queue[queue_id]);
 }
 
@@ -416,6 +440,9 @@ static inline int uk_netdev_rxq_intr_disable(struct uk_netdev *dev,
 
 	if (unlikely(!dev->ops->rxq_intr_disable))
 		return -ENOTSUP;
+#ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
+	dev->_data->rxq_handler[queue_id].intr_enabled = 0;
+#endif
 	return dev->ops->rxq_intr_disable(dev, dev->_rx_queue[queue_id]);
 }
 
@@ -427,6 +454,10 @@ static inline int uk_netdev_rxq_intr_disable(struct uk_netdev *dev,
  * uk_netdev_rxq_intr_enable() indicated that packets are left on the queue.
  * In both cases, uk_netdev_rx_one() is going to enable interrupts again as soon
  * as the last packet was received from the queue.
+ * With dispatcher threads, the dispatcher keeps interrupts disabled while it
+ * polls the queue in rounds of at most LIBUKNETDEV_RXQ_BUDGET packets: once
+ * the budget of a round is used up, UK_NETDEV_STATUS_MORE is not reported so
+ * that the event callback returns to the dispatcher.
  * If this function is called from interrupt context (e.g., within receive event
  * handler when no dispatcher threads are configured) make sure that the
  * provided receive buffer allocator function is interrupt-context-safe
@@ -458,6 +489,9 @@ static inline int uk_netdev_rxq_intr_disable(struct uk_netdev *dev,
 static inline int uk_netdev_rx_one(struct uk_netdev *dev, uint16_t queue_id,
 				   struct uk_netbuf **pkt)
 {
+	struct uk_netdev_event_handler *rxq_handler;
+	int ret;
+
 	UK_ASSERT(dev);
 	UK_ASSERT(dev->rx_one);
 	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
@@ -465,7 +499,17 @@ static inline int uk_netdev_rx_one(struct uk_netdev *dev, uint16_t queue_id,
 	UK_ASSERT(!PTRISERR(dev->_rx_queue[queue_id]));
 	UK_ASSERT(pkt);
 
-	return dev->rx_one(dev, dev->_rx_queue[queue_id], pkt);
+	ret = dev->rx_one(dev, dev->_rx_queue[queue_id], pkt);
+	if (ret > 0 && (ret & UK_NETDEV_STATUS_SUCCESS)) {
+		rxq_handler = &dev->_data->rxq_handler[queue_id];
+		rxq_handler->stats.packets++;
+#ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
+		/* End of the polling round of the dispatcher */
+		if (rxq_handler->quota && --rxq_handler->quota == 0)
+			ret &= ~UK_NETDEV_STATUS_MORE;
+#endif
+	}
+	return ret;
 }
 
 /**
@@ -401,6 +401,29 @@ struct uk_netdev_ops {
 	uk_netdev_start_t               start;
 };
 
+/** Number of buckets of the packets-per-poll histogram */
+#define UK_NETDEV_RXQ_PPP_BUCKETS 8
+
+/**
+ * Receive queue statistics, see uk_netdev_rxq_stats_get().
+ */
+struct uk_netdev_rxq_stats {
+	/** Receive events (interrupts) signaled by the driver */
+	uint64_t interrupts;
+	/** Polling rounds of the dispatcher thread */
+	uint64_t polls;
+	/** Packets received */
+	uint64_t packets;
+	/** Polling rounds that used up the whole budget */
+	uint64_t budget_exhausted;
+	/**
+	 * Packets-per-poll histogram. Bucket 0 counts rounds without packets,
+	 * bucket i (i > 0) rounds with [2^(i-1), 2^i) packets; the last
+	 * bucket also counts all larger rounds.
+	 */
+	uint64_t ppp[UK_NETDEV_RXQ_PPP_BUCKETS];
+};
+
 /**
  * @internal
  * Event handler configuration (internal to libuknetdev)
@@ -409,6 +432,8 @@ struct uk_netdev_event_handler {
 	uk_netdev_queue_event_t callback;
 	void                    *cookie;
 
+	struct uk_netdev_rxq_stats stats; /**< queue statistics */
+
 #ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
 	struct uk_semaphore events;      /**< semaphore to trigger events */
 	struct uk_netdev    *dev;        /**< reference to net device */
@@ -416,6 +441,8 @@ struct uk_netdev_event_handler {
 	struct uk_thread    *dispatcher; /**< dispatcher thread */
 	char                *dispatcher_name; /**< reference to thread name */
 	struct uk_sched     *dispatcher_s;    /**< Scheduler for dispatcher. */
+	int                 intr_enabled; /**< interrupts requested by user */
+	uint16_t            quota;       /**< packets left in polling round */
 #endif
 };
 
@@ -84,6 +84,7 @@ static inline void uk_netdev_drv_rx_event(struct uk_netdev *dev,
 	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
 
 	rxq_handler = &dev->_data->rxq_handler[queue_id];
+	rxq_handler->stats.interrupts++;
 
 #ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
 	uk_semaphore_up(&rxq_handler->events);
@@ -32,6 +32,9 @@
 #include <uk/netbuf.h>
 #include <uk/essentials.h>
 #include <uk/print.h>
+#if CONFIG_LIBUKNETDEV_NETBUFPOOL
+#include <uk/allocpool.h>
+#endif /* CONFIG_LIBUKNETDEV_NETBUFPOOL */
 
 /* Used to align netbuf's priv and data areas to `long long` data type */
 #define NETBUF_ADDR_ALIGNMENT (sizeof(long long))
@@ -61,6 +64,7 @@ void uk_netbuf_init_indir(struct uk_netbuf *m,
 	m->dtor   = dtor;
 	m->_a     = NULL;
 	m->_b     = NULL;
+	m->_p     = NULL;
 }
 
 struct uk_netbuf *uk_netbuf_alloc_indir(struct uk_alloc *a,
@@ -217,41 +221,203 @@ void uk_netbuf_append(struct uk_netbuf *head,
 	tail->prev = headtail;
 }
 
-void uk_netbuf_free_single(struct uk_netbuf *m)
+#if CONFIG_LIBUKNETDEV_NETBUFPOOL
+struct uk_netbuf_pool {
+	struct uk_allocpool *p;
+	struct uk_alloc *a;
+	size_t objlen;
+	uint16_t headroom;
+	size_t privlen;
+	uk_netbuf_dtor_t dtor;
+};
+
+/* Maximum number of objects that are returned to a pool at once */
+#define NETBUF_POOL_BATCHLEN 32
+#endif /* CONFIG_LIBUKNETDEV_NETBUFPOOL */
+
+/*
+ * Drops a reference of a single netbuf. When the last one was released,
+ * the netbuf is disconnected from its chain and its destructor is called.
+ * Returns the pool the memory `*b` has to go back to, or NULL if it was
+ * free'd already or there is nothing to free.
+ */
+static struct uk_netbuf_pool *_netbuf_release(struct uk_netbuf *m, void **b)
 {
+	struct uk_netbuf_pool *p;
 	struct uk_alloc *a;
-	void *b;
 
 	UK_ASSERT(m);
+	UK_ASSERT(b);
+
+	*b = NULL;
 
 	/* Decrease refcount and call destructor and free up memory
 	 * when last reference was released.
 	 */
-	if (uk_refcount_release(&m->refcount) == 1) {
-		uk_pr_debug("Freeing netbuf %p (next: %p)\n", m, m->next);
-
-		/* Disconnect this netbuf from the chain. */
-		uk_netbuf_disconnect(m);
-
-		/* Copy the reference of the allocator and base address
-		 * in case the destructor is free'ing up our memory
-		 * (e.g., uk_netbuf_init_indir() used).
-		 * In such a case `a` and `b` should be (NULL),
-		 * however we need to access them for a check after
-		 * we have called the destructor.
-		 */
-		a = m->_a;
-		b = m->_b;
-
-		if (m->dtor)
-			m->dtor(m);
-		if (a && b)
-			uk_free(a, b);
-	} else {
+	if (uk_refcount_release(&m->refcount) != 1) {
 		uk_pr_debug("Not freeing netbuf %p (next: %p): refcount greater than 1",
 			    m, m->next);
+		return NULL;
+	}
+
+	uk_pr_debug("Freeing netbuf %p (next: %p)\n", m, m->next);
+
+	/* Disconnect this netbuf from the chain. */
+	uk_netbuf_disconnect(m);
+
+	/* Copy the reference of the allocator and base address
+	 * in case the destructor is free'ing up our memory
+	 * (e.g., uk_netbuf_init_indir() used).
+	 * In such a case `a` and `b` should be (NULL),
+	 * however we need to access them for a check after
+	 * we have called the destructor.
+	 */
+	a = m->_a;
+	p = m->_p;
+	*b = m->_b;
+
+	if (m->dtor)
+		m->dtor(m);
+	if (p && *b)
+		return p;
+	if (a && *b)
+		uk_free(a, *b);
+	return NULL;
+}
+
+void uk_netbuf_free_single(struct uk_netbuf *m)
+{
+	struct uk_netbuf_pool *p __maybe_unused;
+	void *b;
+
+	p = _netbuf_release(m, &b);
+#if CONFIG_LIBUKNETDEV_NETBUFPOOL
+	if (p)
+		uk_allocpool_return(p->p, b);
+#else /* !CONFIG_LIBUKNETDEV_NETBUFPOOL */
+	UK_ASSERT(!p);
+#endif /* !CONFIG_LIBUKNETDEV_NETBUFPOOL */
+}
+
+void uk_netbuf_free_batch(struct uk_netbuf *m[], unsigned int count)
+{
+	struct uk_netbuf *n, *next;
+	struct uk_netbuf_pool *p;
+	unsigned int i;
+	void *b;
+#if CONFIG_LIBUKNETDEV_NETBUFPOOL
+	struct uk_netbuf_pool *cur = NULL;
+	void *objs[NETBUF_POOL_BATCHLEN];
+	unsigned int nobjs = 0;
+#endif /* CONFIG_LIBUKNETDEV_NETBUFPOOL */
+
+	UK_ASSERT(m || count == 0);
+
+	for (i = 0; i < count; ++i) {
+		UK_ASSERT(m[i]);
+		UK_ASSERT(!m[i]->prev);
+
+		for (n = m[i]; n != NULL; n = next) {
+			next = n->next;
+			p = _netbuf_release(n, &b);
+			if (!p)
+				continue;
+#if CONFIG_LIBUKNETDEV_NETBUFPOOL
+			/* Collect consecutive objects of the same pool */
+			if (p != cur || nobjs == NETBUF_POOL_BATCHLEN) {
+				if (nobjs)
+					uk_allocpool_return_batch(cur->p, objs,
+								  nobjs);
+				cur = p;
+				nobjs = 0;
+			}
+			objs[nobjs++] = b;
+#else /* !CONFIG_LIBUKNETDEV_NETBUFPOOL */
+			UK_ASSERT(0);
+#endif /* !CONFIG_LIBUKNETDEV_NETBUFPOOL */
+		}
+	}
+
+#if CONFIG_LIBUKNETDEV_NETBUFPOOL
+	if (nobjs)
+		uk_allocpool_return_batch(cur->p, objs, nobjs);
+#endif /* CONFIG_LIBUKNETDEV_NETBUFPOOL */
+}
+
+#if CONFIG_LIBUKNETDEV_NETBUFPOOL
+struct uk_netbuf_pool *uk_netbuf_pool_alloc(struct uk_alloc *a,
+					    unsigned int count,
+					    size_t buflen, size_t bufalign,
+					    uint16_t headroom, size_t privlen,
+					    uk_netbuf_dtor_t dtor)
+{
+	struct uk_netbuf_pool *p;
+
+	UK_ASSERT(a);
+	UK_ASSERT(count > 0);
+	UK_ASSERT(buflen > 0);
+	UK_ASSERT(headroom <= buflen);
+
+	p = uk_malloc(a, sizeof(*p));
+	if (!p)
+		return NULL;
+
+	/* Same layout as uk_netbuf_alloc_buf() */
+	p->objlen = NETBUF_ADDR_ALIGN_UP(buflen)
+		    + NETBUF_ADDR_ALIGN_UP(sizeof(struct uk_netbuf) + privlen);
+	p->p = uk_allocpool_alloc(a, count, p->objlen,
+				  MAX(bufalign, NETBUF_ADDR_ALIGNMENT));
+	if (!p->p) {
+		uk_free(a, p);
+		return NULL;
+	}
+	p->a = a;
+	p->headroom = headroom;
+	p->privlen = privlen;
+	p->dtor = dtor;
+	return p;
+}
+
+void uk_netbuf_pool_free(struct uk_netbuf_pool *p)
+{
+	UK_ASSERT(p);
+
+	uk_allocpool_free(p->p);
+	uk_free(p->a, p);
+}
+
+unsigned int uk_netbuf_pool_take_batch(struct uk_netbuf_pool *p,
+				       struct uk_netbuf *m[],
+				       unsigned int count)
+{
+	unsigned int i, n;
+	void *mem;
+
+	UK_ASSERT(p);
+	UK_ASSERT(m || count == 0);
+
+	/* The array is filled with the objects first and then initialized
+	 * in place with the netbuf that is embedded in each of them
+	 */
+	n = uk_allocpool_take_batch(p->p, (void **) m, count);
+	for (i = 0; i < n; ++i) {
+		mem = (void *) m[i];
+		m[i] = uk_netbuf_prepare_buf(mem, p->objlen, p->headroom,
+					     p->privlen, p->dtor);
+		UK_ASSERT(m[i]);
+		m[i]->_b = mem;
+		m[i]->_p = p;
 	}
+	return n;
+}
+
+unsigned int uk_netbuf_pool_availcount(struct uk_netbuf_pool *p)
+{
+	UK_ASSERT(p);
+
+	return uk_allocpool_availcount(p->p);
 }
+#endif /* CONFIG_LIBUKNETDEV_NETBUFPOOL */
 
 void uk_netbuf_free(struct uk_netbuf *m)
 {
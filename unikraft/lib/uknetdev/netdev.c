@@ -335,21 +335,88 @@ int uk_netdev_configure(struct uk_netdev *dev,
 	return ret;
 }
 
+void uk_netdev_rxq_stats_get(struct uk_netdev *dev, uint16_t queue_id,
+			     struct uk_netdev_rxq_stats *stats, int reset)
+{
+	struct uk_netdev_event_handler *h;
+
+	UK_ASSERT(dev);
+	UK_ASSERT(dev->_data);
+	UK_ASSERT(queue_id < CONFIG_LIBUKNETDEV_MAXNBQUEUES);
+	UK_ASSERT(stats);
+
+	h = &dev->_data->rxq_handler[queue_id];
+	memcpy(stats, &h->stats, sizeof(*stats));
+	if (reset)
+		memset(&h->stats, 0, sizeof(h->stats));
+}
+
 #ifdef CONFIG_LIBUKNETDEV_DISPATCHERTHREADS
+/*
+ * One polling round: the event callback receives packets until the queue is
+ * drained or uk_netdev_rx_one() ends the round because the budget is used up.
+ * Returns non-zero if the budget was used up.
+ */
+static int _dispatcher_poll(struct uk_netdev_event_handler *handler)
+{
+	unsigned int pkts, bucket;
+	int exhausted;
+
+	handler->quota = CONFIG_LIBUKNETDEV_RXQ_BUDGET;
+	handler->callback(handler->dev,
+			  handler->queue_id,
+			  handler->cookie);
+	pkts = CONFIG_LIBUKNETDEV_RXQ_BUDGET - handler->quota;
+	exhausted = (handler->quota == 0);
+	handler->quota = 0;
+
+	for (bucket = 0; pkts && bucket < UK_NETDEV_RXQ_PPP_BUCKETS - 1;
+	     pkts >>= 1)
+		bucket++;
+	handler->stats.ppp[bucket]++;
+	handler->stats.polls++;
+	if (exhausted)
+		handler->stats.budget_exhausted++;
+	return exhausted;
+}
+
 __attribute__((libc_callback))
 static void _dispatcher(void *arg)
 {
 	struct uk_netdev_event_handler *handler =
 		(struct uk_netdev_event_handler *) arg;
+	struct uk_netdev *dev;
+	struct uk_netdev_rx_queue *rxq;
+	int rc;
 
 	UK_ASSERT(handler);
 	UK_ASSERT(handler->callback);
+	dev = handler->dev;
 
 	for (;;) {
 		uk_semaphore_down(&handler->events);
-		handler->callback(handler->dev,
-				  handler->queue_id,
-				  handler->cookie);
+		rxq = dev->_rx_queue[handler->queue_id];
+		UK_ASSERT(dev->ops->rxq_intr_disable);
+		UK_ASSERT(dev->ops->rxq_intr_enable);
+
+		/*
+		 * Interrupts stay disabled while we poll in rounds of
+		 * LIBUKNETDEV_RXQ_BUDGET packets, so that a busy queue does not
+		 * cause one interrupt per packet. Between rounds, we yield to
+		 * give the network stack the chance to process the packets.
+		 * We call the driver directly so that the interrupt setting
+		 * requested by the user is kept.
+		 */
+		do {
+			dev->ops->rxq_intr_disable(dev, rxq);
+			while (_dispatcher_poll(handler))
+				flexos_gate(libuksched, uk_sched_yield);
+
+			/* The queue drained, wait for the next interrupt */
+			if (!handler->intr_enabled)
+				break;
+			rc = dev->ops->rxq_intr_enable(dev, rxq);
+		} while (rc == 1);
 	}
 }
 
@@ -35,10 +35,29 @@
 #include <uk/print.h>
 #include <uk/assert.h>
 #include <uk/ctors.h>
+#include <uk/essentials.h>
 
+/* Blocks are generated CHACHA_BATCH at a time; with SSE2 or NEON the batch
+ * is computed with one block per vector lane.
+ */
+#define CHACHA_BATCH		4
+#define CHACHA_BLOCK_WORDS	16
+#define CHACHA_KEY_WORDS	8
+#define SWRAND_BUF_WORDS	(CHACHA_BATCH * CHACHA_BLOCK_WORDS)
+#define SWRAND_BUF_BYTES	(SWRAND_BUF_WORDS * sizeof(__u32))
+
+/*
+ * Fast key erasure: every batch that fills the buffer starts with the key
+ * for the next batch, and words are wiped from the buffer as they are
+ * handed out. Bulk requests are generated directly into the caller's
+ * buffer and followed by a refill, so the key they were produced with is
+ * gone as well. A later compromise of the state does not reveal earlier
+ * output.
+ */
 struct uk_swrand {
-	int k;
-	__u32 input[16], output[16];
+	unsigned int k;	/* next unread word in output */
+	__u32 input[16];
+	__u32 output[SWRAND_BUF_WORDS];
 };
 
 struct uk_swrand uk_swrand_def;
@@ -89,6 +108,100 @@ _uk_salsa20_wordtobyte(__u32 output[16], const __u32 input[16])
 		output[i] += input[i];
 }
 
+#if defined(__SSE2__) || defined(__ARM_NEON)
+typedef __u32 _uk_v4u32 __attribute__((vector_size(16)));
+
+#define _uk_vrotl32(v, c) (((v) << (c)) | ((v) >> (32 - (c))))
+
+#define _uk_vquarterround(x, a, b, c, d)			\
+	do {							\
+		x[a] += x[b]; x[d] = _uk_vrotl32(x[d] ^ x[a], 16); \
+		x[c] += x[d]; x[b] = _uk_vrotl32(x[b] ^ x[c], 12); \
+		x[a] += x[b]; x[d] = _uk_vrotl32(x[d] ^ x[a], 8);  \
+		x[c] += x[d]; x[b] = _uk_vrotl32(x[b] ^ x[c], 7);  \
+	} while (0)
+
+/* Computes the blocks for counters input[12,13] + 0..3, lane j of each
+ * state vector belonging to block j
+ */
+static void _uk_chacha_blocks(__u32 output[SWRAND_BUF_WORDS],
+			      const __u32 input[16])
+{
+	_uk_v4u32 x[16], in[16];
+	__u64 ctr;
+	__u32 i, j;
+
+	for (i = 0; i < 16; i++)
+		in[i] = (_uk_v4u32) { input[i], input[i], input[i], input[i] };
+
+	ctr = ((__u64) input[13] << 32) | input[12];
+	for (j = 0; j < CHACHA_BATCH; j++) {
+		in[12][j] = (__u32) (ctr + j);
+		in[13][j] = (__u32) ((ctr + j) >> 32);
+	}
+
+	for (i = 0; i < 16; i++)
+		x[i] = in[i];
+
+	for (i = 8; i > 0; i -= 2) {
+		_uk_vquarterround(x, 0, 4, 8, 12);
+		_uk_vquarterround(x, 1, 5, 9, 13);
+		_uk_vquarterround(x, 2, 6, 10, 14);
+		_uk_vquarterround(x, 3, 7, 11, 15);
+		_uk_vquarterround(x, 0, 5, 10, 15);
+		_uk_vquarterround(x, 1, 6, 11, 12);
+		_uk_vquarterround(x, 2, 7, 8, 13);
+		_uk_vquarterround(x, 3, 4, 9, 14);
+	}
+
+	for (i = 0; i < 16; i++)
+		x[i] += in[i];
+
+	for (j = 0; j < CHACHA_BATCH; j++)
+		for (i = 0; i < 16; i++)
+			output[j * CHACHA_BLOCK_WORDS + i] = x[i][j];
+}
+#else /* !(__SSE2__ || __ARM_NEON) */
+/* No SIMD registers available (e.g., arm64 without CONFIG_FPSIMD is built
+ * with -mgeneral-regs-only): compute the batch block by block
+ */
+static void _uk_chacha_blocks(__u32 output[SWRAND_BUF_WORDS],
+			      const __u32 input[16])
+{
+	__u32 in[16];
+	__u64 ctr;
+	__u32 j;
+
+	memcpy(in, input, sizeof(in));
+	ctr = ((__u64) input[13] << 32) | input[12];
+	for (j = 0; j < CHACHA_BATCH; j++) {
+		in[12] = (__u32) (ctr + j);
+		in[13] = (__u32) ((ctr + j) >> 32);
+		_uk_salsa20_wordtobyte(&output[j * CHACHA_BLOCK_WORDS], in);
+	}
+}
+#endif /* !(__SSE2__ || __ARM_NEON) */
+
+static inline void _uk_chacha_advance(struct uk_swrand *r)
+{
+	__u64 ctr = ((__u64) r->input[13] << 32) | r->input[12];
+
+	ctr += CHACHA_BATCH;
+	r->input[12] = (__u32) ctr;
+	r->input[13] = (__u32) (ctr >> 32);
+}
+
+/* Generate a new batch into the buffer and rekey from its first words */
+static void _uk_swrand_refill(struct uk_swrand *r)
+{
+	_uk_chacha_blocks(r->output, r->input);
+	_uk_chacha_advance(r);
+
+	memcpy(&r->input[4], r->output, CHACHA_KEY_WORDS * sizeof(__u32));
+	memset(r->output, 0, CHACHA_KEY_WORDS * sizeof(__u32));
+	r->k = CHACHA_KEY_WORDS;
+}
+
 static inline void _uk_key_setup(struct uk_swrand *r, __u32 k[8])
 {
 	int i;
@@ -126,7 +239,7 @@ void uk_swrand_init_r(struct uk_swrand *r, unsigned int seedc,
 	__u32 k[8], iv[2];
 
 	for (i = 0; i < 8; i++)
-		k[i] = _infvec_val(10, seedv, i);
+		k[i] = _infvec_val(seedc, seedv, i);
 
 	iv[0] = _infvec_val(seedc, seedv, i);
 	iv[1] = _infvec_val(seedc, seedv, i + 1);
@@ -134,25 +247,91 @@ void uk_swrand_init_r(struct uk_swrand *r, unsigned int seedc,
 	_uk_key_setup(r, k);
 	_uk_iv_setup(r, iv);
 
-	r->k = 16;
+	_uk_swrand_refill(r);
+}
+
+void uk_swrand_reseed_r(struct uk_swrand *r, unsigned int seedc,
+			const __u32 seedv[])
+{
+	__u32 i;
+
+	UK_ASSERT(r);
+
+	/* Mix the new seed into the key, the old key stays part of it */
+	for (i = 0; i < seedc; i++)
+		r->input[4 + (i % CHACHA_KEY_WORDS)] ^= seedv[i];
+
+	_uk_swrand_refill(r);
 }
 
 __u32 uk_swrand_randr_r(struct uk_swrand *r)
 {
 	__u32 res;
 
-	for (;;) {
-		_uk_salsa20_wordtobyte(r->output, r->input);
-		r->input[12] = r->input[12] + 1;
-		if (r->input[12] == 0)
-			r->input[13]++;
+	UK_ASSERT(r);
+
+	if (unlikely(r->k >= SWRAND_BUF_WORDS))
+		_uk_swrand_refill(r);
+
+	res = r->output[r->k];
+	r->output[r->k++] = 0;
+	return res;
+}
+
+/* Hands out buffered bytes; partially used words are discarded */
+static size_t _uk_swrand_drain(struct uk_swrand *r, __u8 *buf, size_t len)
+{
+	size_t avail = (SWRAND_BUF_WORDS - r->k) * sizeof(__u32);
+	size_t words;
+
+	len = MIN(len, avail);
+	if (!len)
+		return 0;
+
+	memcpy(buf, &r->output[r->k], len);
+	words = DIV_ROUND_UP(len, sizeof(__u32));
+	memset(&r->output[r->k], 0, words * sizeof(__u32));
+	r->k += words;
+	return len;
+}
 
-		if (r->k < 16) {
-			res = r->output[r->k];
-			r->k += 1;
-			return res;
+void uk_swrand_fill_r(struct uk_swrand *r, void *buf, size_t buflen)
+{
+	__u32 tmp[SWRAND_BUF_WORDS];
+	__u8 *p = buf;
+	size_t n;
+	int bulk = 0;
+
+	UK_ASSERT(r);
+	UK_ASSERT(buf || !buflen);
+
+	n = _uk_swrand_drain(r, p, buflen);
+	p += n;
+	buflen -= n;
+
+	/* Whole batches go straight to the caller */
+	while (buflen >= SWRAND_BUF_BYTES) {
+		if (((__uptr) p & (sizeof(__u32) - 1)) == 0) {
+			_uk_chacha_blocks((__u32 *) p, r->input);
+		} else {
+			_uk_chacha_blocks(tmp, r->input);
+			memcpy(p, tmp, SWRAND_BUF_BYTES);
 		}
+		_uk_chacha_advance(r);
+		p += SWRAND_BUF_BYTES;
+		buflen -= SWRAND_BUF_BYTES;
+		bulk = 1;
+	}
+	if (bulk) {
+		memset(tmp, 0, sizeof(tmp));
+		_uk_swrand_refill(r);
+	}
 
-		r->k = 0;
+	while (buflen) {
+		if (r->k >= SWRAND_BUF_WORDS)
+			_uk_swrand_refill(r);
+		n = _uk_swrand_drain(r, p, buflen);
+		p += n;
+		buflen -= n;
 	}
 }
@@ -52,6 +52,11 @@ extern struct uk_swrand uk_swrand_def;
 void uk_swrand_init_r(struct uk_swrand *r, unsigned int seedc,
 			const __u32 seedv[]);
 __u32 uk_swrand_randr_r(struct uk_swrand *r);
+/* Fills `buf` with `buflen` random bytes */
+void uk_swrand_fill_r(struct uk_swrand *r, void *buf, size_t buflen);
+/* Mixes additional seed material into the generator state */
+void uk_swrand_reseed_r(struct uk_swrand *r, unsigned int seedc,
+			const __u32 seedv[]);
 
 __u32 uk_swrandr_gen_seed32(void);
 /* Uses the pre-initialized default generator  */
@@ -69,6 +74,15 @@ static inline __u32 uk_swrand_randr(void)
 	return ret;
 }
 
+static inline void uk_swrand_reseed(unsigned int seedc, const __u32 seedv[])
+{
+	unsigned long iflags;
+
+	iflags = ukplat_lcpu_save_irqf();
+	uk_swrand_reseed_r(&uk_swrand_def, seedc, seedv);
+	ukplat_lcpu_restore_irqf(iflags);
+}
+
 ssize_t uk_swrand_fill_buffer(void *buf, size_t buflen);
 
 #ifdef __cplusplus
@@ -64,6 +64,17 @@ void uk_swrand_init_r(struct uk_swrand *r, unsigned int seedc,
 	r->i = 4095;
 }
 
+void uk_swrand_reseed_r(struct uk_swrand *r, unsigned int seedc,
+			const __u32 seedv[])
+{
+	__u32 i;
+
+	UK_ASSERT(r);
+
+	for (i = 0; i < seedc; i++)
+		r->Q[(r->i + 1 + i) & 4095] ^= seedv[i];
+}
+
 __u32 uk_swrand_randr_r(struct uk_swrand *r)
 {
 	__u64 t, a = 18782LL;
@@ -88,3 +99,21 @@ __u32 uk_swrand_randr_r(struct uk_swrand *r)
 	r->c = c;
 	return (r->Q[i] = y - x);
 }
+
+void uk_swrand_fill_r(struct uk_swrand *r, void *buf, size_t buflen)
+{
+	size_t step, chunk_size, i;
+	__u32 rd;
+
+	step = sizeof(__u32);
+	chunk_size = buflen % step;
+
+	for (i = 0; i < buflen - chunk_size; i += step)
+		*(__u32 *)((char *) buf + i) = uk_swrand_randr_r(r);
+
+	/* fill the remaining bytes of the buffer */
+	if (chunk_size > 0) {
+		rd = uk_swrand_randr_r(r);
+		memcpy((char *) buf + i, &rd, chunk_size);
+	}
+}
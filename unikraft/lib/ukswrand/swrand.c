@@ -32,6 +32,7 @@
 #include <uk/config.h>
 #include <uk/print.h>
 #include <uk/init.h>
+#include <uk/essentials.h>
 
 __u32 uk_swrandr_gen_seed32(void)
 {
@@ -53,21 +54,20 @@ __u32 uk_swrandr_gen_seed32(void)
 	return val;
 }
 
+/* Interrupts are only disabled for one chunk at a time */
+#define FILL_CHUNK 16384
+
 ssize_t uk_swrand_fill_buffer(void *buf, size_t buflen)
 {
-	size_t step, chunk_size, i;
-	__u32 rd;
-
-	step = sizeof(__u32);
-	chunk_size = buflen % step;
+	unsigned long iflags;
+	size_t off, len;
 
-	for (i = 0; i < buflen - chunk_size; i += step)
-		*(__u32 *)((char *) buf + i) = uk_swrand_randr();
+	for (off = 0; off < buflen; off += len) {
+		len = MIN(buflen - off, (size_t) FILL_CHUNK);
 
-	/* fill the remaining bytes of the buffer */
-	if (chunk_size > 0) {
-		rd = uk_swrand_randr();
-		memcpy(buf + i, &rd, chunk_size);
+		iflags = ukplat_lcpu_save_irqf();
+		uk_swrand_fill_r(&uk_swrand_def, (char *) buf + off, len);
+		ukplat_lcpu_restore_irqf(iflags);
 	}
 
 	return buflen;
@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __UKTIME_CLOCK_H__
+#define __UKTIME_CLOCK_H__
+
+#include <errno.h>
+#include <time.h>
+#include <flexos/isolation.h>
+#include <uk/plat/time.h>
+
+/* FIXME FLEXOS: Coccinelle doesn't want to do a gate transformation at several
+ * places in this library because of the UK_SYSCALL_DEFINE()... this is not
+ * recognized as a function and Coccinelle aborts. Get rid of these of these
+ * manual wrappers at some point or change it to something cleaner. */
+
+static inline __nsec ukplat_monotonic_clock_wrapper(void)
+{
+	__nsec now;
+	//flexos_nop_gate_r(0, 0, now, ukplat_monotonic_clock);
+	__flexos_morello_gate0_r(2, 0, now, ukplat_monotonic_clock);
+	return now;
+}
+
+static inline __nsec ukplat_wall_clock_wrapper(void)
+{
+	__nsec now;
+	//flexos_nop_gate_r(0, 0, now, ukplat_wall_clock);
+	__flexos_morello_gate0_r(2, 0, now, ukplat_wall_clock);
+	return now;
+}
+
+static inline int uktime_timespec_to_nsec(const struct timespec *ts,
+					  __nsec *nsec)
+{
+	if (ts->tv_sec < 0 || ts->tv_nsec < 0 || ts->tv_nsec > 999999999)
+		return -EINVAL;
+
+	*nsec = ukarch_time_sec_to_nsec((__nsec) ts->tv_sec)
+		+ (__nsec) ts->tv_nsec;
+	return 0;
+}
+
+static inline void uktime_nsec_to_timespec(__nsec nsec, struct timespec *ts)
+{
+	ts->tv_sec = ukarch_time_nsec_to_sec(nsec);
+	ts->tv_nsec = ukarch_time_subsec(nsec);
+}
+
+/*
+ * Converts a timer value of `clockid` into an absolute deadline on the
+ * monotonic clock, which is the only clock timers are queued on. Absolute
+ * wall-clock deadlines are translated once, at arm time. Returns 0 (disarm)
+ * for a zero value.
+ */
+static inline __snsec uktime_timer_deadline(clockid_t clockid, int abstime,
+					    __nsec value)
+{
+	__snsec expires;
+
+	if (!value)
+		return 0;
+
+	if (abstime) {
+		if (clockid == CLOCK_REALTIME)
+			value -= ukplat_wall_clock_wrapper()
+				 - ukplat_monotonic_clock_wrapper();
+		expires = (__snsec) value;
+	} else {
+		expires = (__snsec) (ukplat_monotonic_clock_wrapper() + value);
+	}
+
+	/* 0 means disarmed; an already elapsed deadline fires on the next
+	 * pass of the timer thread.
+	 */
+	return (expires > 0) ? expires : 1;
+}
+
+#endif /* __UKTIME_CLOCK_H__ */
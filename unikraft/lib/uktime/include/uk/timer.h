@@ -0,0 +1,100 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Kernel-side one-shot and interval timers
+ *
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __UK_TIMER_H__
+#define __UK_TIMER_H__
+
+#include <uk/arch/time.h>
+#include <uk/list.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct uk_timer;
+
+/**
+ * Expiration callback. Called from the timer thread, never from interrupt
+ * context. `expirations` is 1 plus the number of periods that elapsed
+ * unnoticed since the previous call (overruns are coalesced into a single
+ * callback instead of calling it repeatedly).
+ */
+typedef void (*uk_timer_func_t)(struct uk_timer *t,
+				unsigned long expirations, void *arg);
+
+struct uk_timer {
+	/* Absolute expiry on the monotonic clock; 0 when disarmed */
+	__snsec expires;
+	/* Reload period; 0 for one-shot timers */
+	__nsec interval;
+	uk_timer_func_t func;
+	void *arg;
+	/* Entry in the deadline-ordered list of armed timers */
+	UK_TAILQ_ENTRY(struct uk_timer) entry;
+};
+
+/**
+ * Initializes a timer. It starts disarmed.
+ */
+void uk_timer_init(struct uk_timer *t, uk_timer_func_t func, void *arg);
+
+/**
+ * Arms (or re-arms) a timer.
+ *
+ * @param t the timer
+ * @param expires absolute expiry on the monotonic clock; 0 disarms
+ * @param interval reload period in nanoseconds; 0 for a one-shot timer
+ * @return 0 on success, a negative errno value if the timer thread could
+ *	not be started
+ */
+int uk_timer_arm(struct uk_timer *t, __snsec expires, __nsec interval);
+
+/**
+ * Disarms a timer. Disarming a timer that is not armed is a no-op.
+ */
+void uk_timer_disarm(struct uk_timer *t);
+
+/**
+ * Returns the time left until the next expiry, 0 if the timer is disarmed.
+ */
+__nsec uk_timer_remaining(struct uk_timer *t);
+
+static inline int uk_timer_armed(struct uk_timer *t)
+{
+	return t->expires != 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __UK_TIMER_H__ */
@@ -50,27 +50,7 @@
 #include <uk/plat/lcpu.h>
 #endif
 #include <uk/essentials.h>
-
-/* FIXME FLEXOS: Coccinelle doesn't want to do a gate transformation at several
- * places in this file because of the UK_SYSCALL_DEFINE()... this is not
- * recognized as a function and Coccinelle aborts. Get rid of these of these
- * manual wrappers at some point or change it to something cleaner. */
-
-static inline __nsec ukplat_monotonic_clock_wrapper(void)
-{
-	__nsec now;
-	//flexos_nop_gate_r(0, 0, now, ukplat_monotonic_clock);
-	__flexos_morello_gate0_r(2, 0, now, ukplat_monotonic_clock);
-	return now;
-}
-
-static inline __nsec ukplat_wall_clock_wrapper(void)
-{
-	__nsec now;
-	//flexos_nop_gate_r(0, 0, now, ukplat_wall_clock);
-	__flexos_morello_gate0_r(2, 0, now, ukplat_wall_clock);
-	return now;
-}
+#include "clock.h"
 
 void ukplat_lcpu_halt_to(__snsec until);
 static inline void ukplat_lcpu_halt_to_wrapper(__snsec until)
@@ -31,10 +31,200 @@
  */
 
 #include <errno.h>
+#include <signal.h>
 #include <time.h>
+#include <unistd.h>
+#include <uk/config.h>
+#include <uk/alloc.h>
 #include <uk/essentials.h>
 #include <uk/print.h>
+#include <uk/timer.h>
+#include "clock.h"
 
+#if CONFIG_LIBUKTIME_TIMERS
+/* Not every libc glue header provides these; use the Linux values */
+#ifndef SIGEV_SIGNAL
+#define SIGEV_SIGNAL	0
+#endif
+#ifndef SIGEV_NONE
+#define SIGEV_NONE	1
+#endif
+
+/* Upper bound for the overrun count, see timer_getoverrun(2) */
+#define UKTIME_DELAYTIMER_MAX	0x7fffffff
+
+struct posix_timer {
+	struct uk_timer timer;
+	clockid_t clockid;
+	struct sigevent sev;
+	/* Overrun count of the last delivered expiration */
+	int overrun;
+};
+
+static void posix_timer_fire(struct uk_timer *t, unsigned long expirations,
+			     void *arg __unused)
+{
+	struct posix_timer *pt = __containerof(t, struct posix_timer, timer);
+
+	pt->overrun = (expirations - 1 > UKTIME_DELAYTIMER_MAX)
+		      ? UKTIME_DELAYTIMER_MAX : (int) (expirations - 1);
+
+#if CONFIG_LIBUKSIGNAL
+	if (pt->sev.sigev_notify == SIGEV_SIGNAL)
+		kill(getpid(), pt->sev.sigev_signo);
+#endif
+}
+
+int timer_create(clockid_t clockid, struct sigevent *__restrict sevp,
+		 timer_t *__restrict timerid)
+{
+	struct posix_timer *pt;
+
+	if (unlikely(!timerid)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	switch (clockid) {
+	case CLOCK_MONOTONIC:
+	case CLOCK_REALTIME:
+		break;
+	default:
+		errno = EINVAL;
+		return -1;
+	}
+
+#if !CONFIG_LIBUKSIGNAL
+	/* The default notification is SIGALRM */
+	if (!sevp) {
+		errno = EINVAL;
+		return -1;
+	}
+#endif
+
+	if (sevp) {
+		switch (sevp->sigev_notify) {
+		case SIGEV_NONE:
+			break;
+		case SIGEV_SIGNAL:
+#if CONFIG_LIBUKSIGNAL
+			if (sevp->sigev_signo <= 0 || sevp->sigev_signo >= NSIG) {
+				errno = EINVAL;
+				return -1;
+			}
+			break;
+#else
+			/* Signals cannot be delivered without uksignal */
+			errno = EINVAL;
+			return -1;
+#endif
+		default:
+			/* SIGEV_THREAD would need a thread per expiration,
+			 * which is what this interface is meant to avoid.
+			 */
+			errno = ENOTSUP;
+			return -1;
+		}
+	}
+
+	pt = uk_calloc(uk_alloc_get_default(), 1, sizeof(*pt));
+	if (unlikely(!pt)) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	pt->clockid = clockid;
+	if (sevp) {
+		pt->sev = *sevp;
+	} else {
+		pt->sev.sigev_notify = SIGEV_SIGNAL;
+		pt->sev.sigev_signo = SIGALRM;
+	}
+	uk_timer_init(&pt->timer, posix_timer_fire, NULL);
+
+	*timerid = (timer_t) pt;
+	return 0;
+}
+
+int timer_delete(timer_t timerid)
+{
+	struct posix_timer *pt = (struct posix_timer *) timerid;
+
+	if (unlikely(!pt)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	uk_timer_disarm(&pt->timer);
+	uk_free(uk_alloc_get_default(), pt);
+	return 0;
+}
+
+int timer_gettime(timer_t timerid, struct itimerspec *curr_value)
+{
+	struct posix_timer *pt = (struct posix_timer *) timerid;
+
+	if (unlikely(!pt || !curr_value)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	uktime_nsec_to_timespec(uk_timer_remaining(&pt->timer),
+				&curr_value->it_value);
+	uktime_nsec_to_timespec(pt->timer.interval, &curr_value->it_interval);
+	return 0;
+}
+
+int timer_settime(timer_t timerid, int flags,
+		  const struct itimerspec *__restrict new_value,
+		  struct itimerspec *__restrict old_value)
+{
+	struct posix_timer *pt = (struct posix_timer *) timerid;
+	__nsec value, interval;
+	__snsec expires;
+	int ret;
+
+	if (unlikely(!pt || !new_value)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	ret = uktime_timespec_to_nsec(&new_value->it_value, &value);
+	if (!ret)
+		ret = uktime_timespec_to_nsec(&new_value->it_interval,
+					      &interval);
+	if (unlikely(ret)) {
+		errno = -ret;
+		return -1;
+	}
+
+	if (old_value)
+		timer_gettime(timerid, old_value);
+
+	expires = uktime_timer_deadline(pt->clockid, flags & TIMER_ABSTIME,
+					value);
+	pt->overrun = 0;
+	ret = uk_timer_arm(&pt->timer, expires, interval);
+	if (unlikely(ret)) {
+		errno = -ret;
+		return -1;
+	}
+	return 0;
+}
+
+int timer_getoverrun(timer_t timerid)
+{
+	struct posix_timer *pt = (struct posix_timer *) timerid;
+
+	if (unlikely(!pt)) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	return pt->overrun;
+}
+
+#else /* !CONFIG_LIBUKTIME_TIMERS */
 
 int timer_create(clockid_t clockid __unused,
 		struct sigevent *__restrict sevp __unused,
@@ -76,3 +266,4 @@ int timer_getoverrun(timer_t timerid __unused)
 	errno = ENOTSUP;
 	return -1;
 }
+#endif /* CONFIG_LIBUKTIME_TIMERS */
@@ -0,0 +1,357 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * timerfd on top of the kernel timers
+ *
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/timerfd.h>
+#include <vfscore/file.h>
+#include <vfscore/fs.h>
+#include <vfscore/mount.h>
+#include <vfscore/vnode.h>
+#include <vfscore/dentry.h>
+#include <uk/alloc.h>
+#include <uk/essentials.h>
+#include <uk/syscall.h>
+#include <uk/timer.h>
+#include <uk/wait.h>
+#include "clock.h"
+
+struct timerfd {
+	struct uk_timer timer;
+	clockid_t clockid;
+	/* Expirations not yet consumed by read() */
+	uint64_t ticks;
+	/* Readers blocked until the timer expires */
+	struct uk_waitq wq;
+};
+
+static void timerfd_fire(struct uk_timer *t, unsigned long expirations,
+			 void *arg __unused)
+{
+	struct timerfd *tfd = __containerof(t, struct timerfd, timer);
+
+	tfd->ticks += expirations;
+	uk_waitq_wake_up(&tfd->wq);
+}
+
+static int timerfd_vfscore_read(struct vnode *vnode,
+				struct vfscore_file *fp,
+				struct uio *buf, int ioflag __unused)
+{
+	struct timerfd *tfd = vnode->v_data;
+	unsigned long flags;
+	uint64_t ticks;
+
+	if (unlikely(buf->uio_iovcnt != 1
+		     || buf->uio_iov[0].iov_len < sizeof(uint64_t)))
+		return EINVAL;
+
+	while (!tfd->ticks) {
+		DEFINE_WAIT(wait);
+
+		if (fp->f_flags & O_NONBLOCK)
+			return EAGAIN;
+
+		uk_waitq_add_waiter(&tfd->wq, wait);
+		uk_sched_yield();
+		uk_waitq_remove_waiter(&tfd->wq, wait);
+	}
+
+	flags = ukplat_lcpu_save_irqf();
+	ticks = tfd->ticks;
+	tfd->ticks = 0;
+	ukplat_lcpu_restore_irqf(flags);
+
+	*((uint64_t *) buf->uio_iov[0].iov_base) = ticks;
+	buf->uio_resid -= sizeof(uint64_t);
+	return 0;
+}
+
+static int timerfd_vfscore_close(struct vnode *vnode,
+				 struct vfscore_file *fp __unused)
+{
+	struct timerfd *tfd = vnode->v_data;
+
+	uk_timer_disarm(&tfd->timer);
+	uk_free(uk_alloc_get_default(), tfd);
+	vnode->v_data = NULL;
+	return 0;
+}
+
+static int timerfd_vfscore_seek(struct vnode *vnode __unused,
+				struct vfscore_file *fp __unused,
+				off_t off1 __unused, off_t off2 __unused)
+{
+	return ESPIPE;
+}
+
+#define timerfd_vfscore_open      ((vnop_open_t) vfscore_vop_einval)
+#define timerfd_vfscore_write     ((vnop_write_t) vfscore_vop_einval)
+#define timerfd_vfscore_ioctl     ((vnop_ioctl_t) vfscore_vop_einval)
+#define timerfd_vfscore_fsync     ((vnop_fsync_t) vfscore_vop_einval)
+#define timerfd_vfscore_readdir   ((vnop_readdir_t) vfscore_vop_einval)
+#define timerfd_vfscore_lookup    ((vnop_lookup_t) vfscore_vop_einval)
+#define timerfd_vfscore_create    ((vnop_create_t) vfscore_vop_einval)
+#define timerfd_vfscore_remove    ((vnop_remove_t) vfscore_vop_einval)
+#define timerfd_vfscore_rename    ((vnop_rename_t) vfscore_vop_einval)
+#define timerfd_vfscore_mkdir     ((vnop_mkdir_t) vfscore_vop_einval)
+#define timerfd_vfscore_rmdir     ((vnop_rmdir_t) vfscore_vop_einval)
+#define timerfd_vfscore_getattr   ((vnop_getattr_t) vfscore_vop_einval)
+#define timerfd_vfscore_setattr   ((vnop_setattr_t) vfscore_vop_nullop)
+#define timerfd_vfscore_inactive  ((vnop_inactive_t) vfscore_vop_nullop)
+#define timerfd_vfscore_truncate  ((vnop_truncate_t) vfscore_vop_einval)
+#define timerfd_vfscore_link      ((vnop_link_t) vfscore_vop_eperm)
+#define timerfd_vfscore_cache     ((vnop_cache_t) NULL)
+#define timerfd_vfscore_fallocate ((vnop_fallocate_t) vfscore_vop_einval)
+#define timerfd_vfscore_readlink  ((vnop_readlink_t) vfscore_vop_einval)
+#define timerfd_vfscore_symlink   ((vnop_symlink_t) vfscore_vop_eperm)
+
+static struct vnops timerfd_vnops __section(".data_shared") = {
+	.vop_open      = timerfd_vfscore_open,
+	.vop_close     = timerfd_vfscore_close,
+	.vop_read      = timerfd_vfscore_read,
+	.vop_write     = timerfd_vfscore_write,
+	.vop_seek      = timerfd_vfscore_seek,
+	.vop_ioctl     = timerfd_vfscore_ioctl,
+	.vop_fsync     = timerfd_vfscore_fsync,
+	.vop_readdir   = timerfd_vfscore_readdir,
+	.vop_lookup    = timerfd_vfscore_lookup,
+	.vop_create    = timerfd_vfscore_create,
+	.vop_remove    = timerfd_vfscore_remove,
+	.vop_rename    = timerfd_vfscore_rename,
+	.vop_mkdir     = timerfd_vfscore_mkdir,
+	.vop_rmdir     = timerfd_vfscore_rmdir,
+	.vop_getattr   = timerfd_vfscore_getattr,
+	.vop_setattr   = timerfd_vfscore_setattr,
+	.vop_inactive  = timerfd_vfscore_inactive,
+	.vop_truncate  = timerfd_vfscore_truncate,
+	.vop_link      = timerfd_vfscore_link,
+	.vop_cache     = timerfd_vfscore_cache,
+	.vop_fallocate = timerfd_vfscore_fallocate,
+	.vop_readlink  = timerfd_vfscore_readlink,
+	.vop_symlink   = timerfd_vfscore_symlink
+};
+
+#define timerfd_vget ((vfsop_vget_t) vfscore_vop_nullop)
+
+static struct vfsops timerfd_vfsops __section(".data_shared") = {
+	.vfs_vget = timerfd_vget,
+	.vfs_vnops = &timerfd_vnops
+};
+
+static uint64_t t_inode;
+
+/* Bogus mount point used by all timerfds */
+static struct mount timerfd_mount __section(".data_shared") = {
+	.m_op = &timerfd_vfsops
+};
+
+static int timerfd_get(int fd, struct vfscore_file **fpp,
+		       struct timerfd **tfdp)
+{
+	struct vfscore_file *fp;
+	struct vnode *vnode;
+
+	fp = vfscore_get_file(fd);
+	if (unlikely(!fp))
+		return -EBADF;
+
+	vnode = fp->f_dentry->d_vnode;
+	if (unlikely(vnode->v_op != &timerfd_vnops)) {
+		fdrop(fp);
+		return -EINVAL;
+	}
+
+	*fpp = fp;
+	*tfdp = vnode->v_data;
+	return 0;
+}
+
+static void timerfd_curr_value(struct timerfd *tfd, struct itimerspec *val)
+{
+	uktime_nsec_to_timespec(uk_timer_remaining(&tfd->timer),
+				&val->it_value);
+	uktime_nsec_to_timespec(tfd->timer.interval, &val->it_interval);
+}
+
+UK_SYSCALL_R_DEFINE(int, timerfd_create, int, clockid, int, flags)
+{
+	struct uk_alloc *a = uk_alloc_get_default();
+	struct vfscore_file *vfs_file;
+	struct dentry *t_dentry;
+	struct vnode *t_vnode;
+	struct timerfd *tfd;
+	int vfs_fd, ret;
+
+	if (unlikely(clockid != CLOCK_MONOTONIC && clockid != CLOCK_REALTIME))
+		return -EINVAL;
+	if (unlikely(flags & ~(TFD_NONBLOCK | TFD_CLOEXEC)))
+		return -EINVAL;
+
+	/* Reserve a file descriptor number */
+	vfs_fd = vfscore_alloc_fd();
+	if (unlikely(vfs_fd < 0)) {
+		ret = -ENFILE;
+		goto ERR_EXIT;
+	}
+
+	tfd = uk_calloc(a, 1, sizeof(*tfd));
+	if (unlikely(!tfd)) {
+		ret = -ENOMEM;
+		goto ERR_MALLOC_TFD;
+	}
+	tfd->clockid = clockid;
+	uk_waitq_init(&tfd->wq);
+	uk_timer_init(&tfd->timer, timerfd_fire, NULL);
+
+	vfs_file = uk_calloc(flexos_shared_alloc, 1, sizeof(*vfs_file));
+	if (unlikely(!vfs_file)) {
+		ret = -ENOMEM;
+		goto ERR_MALLOC_VFS_FILE;
+	}
+
+	ret = vfscore_vget(&timerfd_mount, t_inode++, &t_vnode);
+	UK_ASSERT(ret == 0); /* we should not find it in cache */
+	if (unlikely(!t_vnode)) {
+		ret = -ENOMEM;
+		goto ERR_ALLOC_VNODE;
+	}
+	uk_mutex_unlock(&t_vnode->v_lock);
+
+	/* All timerfd dentries share the same path; they are never looked
+	 * up.
+	 */
+	t_dentry = dentry_alloc(NULL, t_vnode, "/");
+	if (unlikely(!t_dentry)) {
+		ret = -ENOMEM;
+		goto ERR_ALLOC_DENTRY;
+	}
+
+	vfs_file->fd = vfs_fd;
+	vfs_file->f_flags = UK_FREAD | (flags & TFD_NONBLOCK);
+	vfs_file->f_count = 1;
+	vfs_file->f_data = tfd;
+	vfs_file->f_dentry = t_dentry;
+	vfs_file->f_vfs_flags = UK_VFSCORE_NOPOS;
+	uk_mutex_init(&vfs_file->f_lock);
+
+	t_vnode->v_data = tfd;
+	t_vnode->v_type = VCHR;
+
+	ret = vfscore_install_fd(vfs_fd, vfs_file);
+	if (unlikely(ret))
+		goto ERR_VFS_INSTALL;
+
+	/* Only the dentry should hold a reference; release ours */
+	vrele(t_vnode);
+
+	return vfs_fd;
+
+ERR_VFS_INSTALL:
+	drele(t_dentry);
+ERR_ALLOC_DENTRY:
+	vrele(t_vnode);
+ERR_ALLOC_VNODE:
+	uk_free(flexos_shared_alloc, vfs_file);
+ERR_MALLOC_VFS_FILE:
+	uk_free(a, tfd);
+ERR_MALLOC_TFD:
+	vfscore_put_fd(vfs_fd);
+ERR_EXIT:
+	UK_ASSERT(ret < 0);
+	return ret;
+}
+
+UK_SYSCALL_R_DEFINE(int, timerfd_settime, int, fd, int, flags,
+		    const struct itimerspec *, new_value,
+		    struct itimerspec *, old_value)
+{
+	struct vfscore_file *fp;
+	struct timerfd *tfd;
+	__nsec value, interval;
+	unsigned long irqf;
+	int ret;
+
+	if (unlikely(!new_value))
+		return -EFAULT;
+	if (unlikely(flags & ~(TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET)))
+		return -EINVAL;
+
+	ret = uktime_timespec_to_nsec(&new_value->it_value, &value);
+	if (!ret)
+		ret = uktime_timespec_to_nsec(&new_value->it_interval,
+					      &interval);
+	if (unlikely(ret))
+		return ret;
+
+	ret = timerfd_get(fd, &fp, &tfd);
+	if (unlikely(ret))
+		return ret;
+
+	if (old_value)
+		timerfd_curr_value(tfd, old_value);
+
+	/* Re-arming discards expirations that were not read yet */
+	irqf = ukplat_lcpu_save_irqf();
+	tfd->ticks = 0;
+	ukplat_lcpu_restore_irqf(irqf);
+
+	ret = uk_timer_arm(&tfd->timer,
+			   uktime_timer_deadline(tfd->clockid,
+						 flags & TFD_TIMER_ABSTIME,
+						 value),
+			   interval);
+
+	fdrop(fp);
+	return ret;
+}
+
+UK_SYSCALL_R_DEFINE(int, timerfd_gettime, int, fd,
+		    struct itimerspec *, curr_value)
+{
+	struct vfscore_file *fp;
+	struct timerfd *tfd;
+	int ret;
+
+	if (unlikely(!curr_value))
+		return -EFAULT;
+
+	ret = timerfd_get(fd, &fp, &tfd);
+	if (unlikely(ret))
+		return ret;
+
+	timerfd_curr_value(tfd, curr_value);
+
+	fdrop(fp);
+	return 0;
+}
@@ -0,0 +1,208 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Kernel-side one-shot and interval timers
+ *
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * All armed timers are kept in a single list ordered by expiry. One kernel
+ * thread ("uktimer") blocks with its wakeup time set to the earliest expiry,
+ * so it sits on the scheduler's sleeping queue like any other sleeper and
+ * the idle loop halts until exactly that deadline. Arming a timer that
+ * becomes the new head wakes the thread so that it can shorten its sleep.
+ */
+
+#include <errno.h>
+#include <uk/config.h>
+#include <uk/essentials.h>
+#include <uk/assert.h>
+#include <uk/print.h>
+#include <uk/plat/lcpu.h>
+#include <uk/thread.h>
+#include <uk/sched.h>
+#include <uk/timer.h>
+#include "clock.h"
+
+UK_TAILQ_HEAD(uk_timer_list, struct uk_timer);
+
+static struct uk_timer_list armed_timers =
+	UK_TAILQ_HEAD_INITIALIZER(armed_timers);
+static struct uk_thread *timer_thread;
+
+static inline __snsec uk_timer_now(void)
+{
+	return (__snsec) ukplat_monotonic_clock_wrapper();
+}
+
+/* Must be called with IRQs disabled */
+static int uk_timer_enqueue(struct uk_timer *t)
+{
+	struct uk_timer *itr;
+
+	UK_TAILQ_FOREACH(itr, &armed_timers, entry) {
+		if (t->expires < itr->expires) {
+			UK_TAILQ_INSERT_BEFORE(itr, t, entry);
+			return UK_TAILQ_FIRST(&armed_timers) == t;
+		}
+	}
+	UK_TAILQ_INSERT_TAIL(&armed_timers, t, entry);
+	return UK_TAILQ_FIRST(&armed_timers) == t;
+}
+
+/*
+ * Computes the number of expirations of `t` up to `now` and moves the timer
+ * to its next period. Periods missed while the timer thread could not run
+ * are folded into the returned count instead of being replayed one by one.
+ */
+static unsigned long uk_timer_advance(struct uk_timer *t, __snsec now)
+{
+	unsigned long missed;
+
+	if (!t->interval) {
+		t->expires = 0;
+		return 1;
+	}
+
+	missed = (unsigned long) (now - t->expires) / t->interval;
+	t->expires += (__snsec) ((missed + 1) * t->interval);
+	return missed + 1;
+}
+
+static void uk_timer_thread_fn(void *arg __unused)
+{
+	struct uk_timer *t;
+	unsigned long flags, expirations;
+	__snsec now;
+
+	for (;;) {
+		flags = ukplat_lcpu_save_irqf();
+		now = uk_timer_now();
+		t = UK_TAILQ_FIRST(&armed_timers);
+		if (t && t->expires <= now) {
+			UK_TAILQ_REMOVE(&armed_timers, t, entry);
+			expirations = uk_timer_advance(t, now);
+			if (t->expires)
+				uk_timer_enqueue(t);
+			ukplat_lcpu_restore_irqf(flags);
+
+			t->func(t, expirations, t->arg);
+			continue;
+		}
+
+		if (t)
+			uk_thread_block_timeout(uk_thread_current(),
+						(__nsec) (t->expires - now));
+		else
+			uk_thread_block(uk_thread_current());
+		ukplat_lcpu_restore_irqf(flags);
+
+		uk_sched_yield();
+	}
+}
+
+static int uk_timer_thread_start(void)
+{
+	if (likely(timer_thread))
+		return 0;
+
+	timer_thread = uk_thread_create("uktimer", uk_timer_thread_fn, NULL);
+	if (unlikely(!timer_thread)) {
+		uk_pr_err("Failed to create timer thread\n");
+		return -ENOMEM;
+	}
+	return 0;
+}
+
+void uk_timer_init(struct uk_timer *t, uk_timer_func_t func, void *arg)
+{
+	UK_ASSERT(t);
+	UK_ASSERT(func);
+
+	t->expires = 0;
+	t->interval = 0;
+	t->func = func;
+	t->arg = arg;
+}
+
+int uk_timer_arm(struct uk_timer *t, __snsec expires, __nsec interval)
+{
+	unsigned long flags;
+	int ret, first;
+
+	UK_ASSERT(t);
+
+	uk_timer_disarm(t);
+	if (!expires)
+		return 0;
+
+	ret = uk_timer_thread_start();
+	if (unlikely(ret))
+		return ret;
+
+	flags = ukplat_lcpu_save_irqf();
+	t->expires = expires;
+	t->interval = interval;
+	first = uk_timer_enqueue(t);
+	ukplat_lcpu_restore_irqf(flags);
+
+	/* The timer thread sleeps until the old head expires; have it
+	 * recompute its deadline.
+	 */
+	if (first)
+		uk_thread_wake(timer_thread);
+
+	return 0;
+}
+
+void uk_timer_disarm(struct uk_timer *t)
+{
+	unsigned long flags;
+
+	UK_ASSERT(t);
+
+	flags = ukplat_lcpu_save_irqf();
+	if (t->expires) {
+		UK_TAILQ_REMOVE(&armed_timers, t, entry);
+		t->expires = 0;
+	}
+	t->interval = 0;
+	ukplat_lcpu_restore_irqf(flags);
+}
+
+__nsec uk_timer_remaining(struct uk_timer *t)
+{
+	__snsec expires = t->expires;
+	__snsec now;
+
+	if (!expires)
+		return 0;
+
+	now = uk_timer_now();
+	return (expires > now) ? (__nsec) (expires - now) : 1;
+}
@@ -0,0 +1,104 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _VFSCORE_PAGECACHE_H_
+#define _VFSCORE_PAGECACHE_H_
+
+#include <vfscore/vnode.h>
+#include <vfscore/uio.h>
+
+/*
+ * Page cache for filesystems that are backed by a block device. Pages are
+ * keyed by (vnode, page-aligned file offset) and shared by all files of all
+ * mounts; the least recently used clean page is recycled when the cache is
+ * full. Writes only dirty cached pages, which reach the backing store on
+ * vfscore_pcache_sync() or when they are evicted.
+ *
+ * All functions return 0 or a positive errno value, like vnode operations,
+ * and must be called with the vnode locked.
+ */
+
+/*
+ * Filesystem callbacks through which the cache moves pages from and to the
+ * backing store. Offsets are page-aligned file offsets.
+ */
+struct vfscore_pcache_ops {
+	/*
+	 * Fills `cnt` pages for consecutive offsets starting at `off`. Parts
+	 * of the file that were never written must read as zeros.
+	 */
+	int (*readpages)(struct vnode *vp, off_t off, void **pages, int cnt);
+	/*
+	 * Writes back `cnt` whole pages at the given offsets, which are
+	 * sorted in ascending order.
+	 */
+	int (*writepages)(struct vnode *vp, const off_t *offs, void **pages,
+			  int cnt);
+};
+
+/**
+ * Routes a vnode's data through the page cache. Must be called before any
+ * other function of this API is used on the vnode, typically from vfs_vget.
+ */
+void vfscore_pcache_attach(struct vnode *vp,
+			   const struct vfscore_pcache_ops *ops);
+
+/**
+ * Reads from the file into `uio`, up to the file size. Sequential reads
+ * grow a readahead window that is filled with one call to readpages().
+ */
+int vfscore_pcache_read(struct vnode *vp, struct uio *uio);
+
+/**
+ * Writes `uio` to the cached pages of the file and extends `v_size` if the
+ * write goes past the end of the file. With IO_SYNC in `ioflag` the written
+ * pages are written back before returning.
+ */
+int vfscore_pcache_write(struct vnode *vp, struct uio *uio, int ioflag);
+
+/**
+ * Writes back all dirty pages of a file.
+ */
+int vfscore_pcache_sync(struct vnode *vp);
+
+/**
+ * Drops the cached pages beyond `length` and zeroes the tail of the page
+ * that contains the new end of file. Does not change `v_size`.
+ */
+int vfscore_pcache_truncate(struct vnode *vp, off_t length);
+
+/**
+ * Drops all pages of a file without writing them back. Must be called before
+ * the vnode is freed, after a final vfscore_pcache_sync() if the data is to
+ * be kept.
+ */
+void vfscore_pcache_release(struct vnode *vp);
+
+#endif /* !_VFSCORE_PAGECACHE_H_ */
@@ -46,6 +46,8 @@ struct vfsops;
 struct vnops;
 struct vnode;
 struct vfscore_file;
+struct vfscore_pcache_ops;
+struct vfscore_mapping;
 
 /*
  * Vnode types.
@@ -79,6 +81,13 @@ struct vnode {
 	struct uk_mutex	v_lock;		/* lock for this vnode */
 	struct uk_list_head v_names;	/* directory entries pointing at this */
 	void		*v_data;	/* private data for fs */
+	struct uk_list_head v_mappings;	/* memory mappings, see VOP_MAP */
+#if CONFIG_LIBVFSCORE_PAGECACHE
+	struct uk_list_head v_pages;	/* pages in the page cache */
+	const struct vfscore_pcache_ops *v_pcops; /* page cache backend */
+	off_t		v_ra_next;	/* offset a sequential read goes on at */
+	unsigned int	v_ra_win;	/* readahead window in pages */
+#endif
 };
 
 /* flags for vnode */
@@ -171,6 +180,26 @@ typedef int (*vnop_cache_t) (struct vnode *, struct vfscore_file *, struct uio *
 typedef int (*vnop_fallocate_t) (struct vnode *, int, off_t, off_t);
 typedef int (*vnop_readlink_t)  (struct vnode *, struct uio *);
 typedef int (*vnop_symlink_t)   (struct vnode *, char *, char *);
+typedef int (*vnop_map_t)	(struct vnode *, struct vfscore_mapping *,
+				 void **);
+typedef int (*vnop_unmap_t)	(struct vnode *, struct vfscore_mapping *);
+
+/*
+ * A range of a file that is mapped into memory. VOP_MAP returns the
+ * page-aligned memory that holds [vm_off, vm_off + vm_len) of the file so
+ * that the caller can map it directly, and links the mapping on
+ * v_mappings. The file system keeps that memory in place until VOP_UNMAP;
+ * if it has to move it anyway (e.g., to grow the file), it calls
+ * vn_mappings_moved() so that every mapping is pointed at the new memory.
+ * msync() and the last munmap() of a shared mapping call VOP_FSYNC with a
+ * NULL file.
+ */
+struct vfscore_mapping {
+	struct uk_list_head vm_link;	/* link on v_mappings */
+	off_t		vm_off;		/* file offset, page-aligned */
+	size_t		vm_len;		/* length, page-aligned */
+	void		(*vm_moved)(struct vfscore_mapping *vm, void *addr);
+};
 
 /*
  * vnode operations
@@ -199,6 +228,9 @@ struct vnops {
 	vnop_fallocate_t	vop_fallocate;
 	vnop_readlink_t		vop_readlink;
 	vnop_symlink_t		vop_symlink;
+	vnop_fsync_t		vop_fdatasync;	/* optional, else vop_fsync */
+	vnop_map_t		vop_map;	/* optional */
+	vnop_unmap_t		vop_unmap;	/* required with vop_map */
 };
 
 /*
@@ -212,6 +244,7 @@ struct vnops {
 #define VOP_SEEK(VP, FP, OLD, NEW) ((VP)->v_op->vop_seek)(VP, FP, OLD, NEW)
 #define VOP_IOCTL(VP, FP, C, A)	   ((VP)->v_op->vop_ioctl)(VP, FP, C, A)
 #define VOP_FSYNC(VP, FP)	   ((VP)->v_op->vop_fsync)(VP, FP)
+#define VOP_FDATASYNC(VP, FP)	   ((VP)->v_op->vop_fdatasync)(VP, FP)
 #define VOP_READDIR(VP, FP, DIR)   ((VP)->v_op->vop_readdir)(VP, FP, DIR)
 #define VOP_LOOKUP(DVP, N, VP)	   ((DVP)->v_op->vop_lookup)(DVP, N, VP)
 #define VOP_CREATE(DVP, N, M)	   ((DVP)->v_op->vop_create)(DVP, N, M)
@@ -228,6 +261,8 @@ struct vnops {
 #define VOP_FALLOCATE(VP, M, OFF, LEN) ((VP)->v_op->vop_fallocate)(VP, M, OFF, LEN)
 #define VOP_READLINK(VP, U)        ((VP)->v_op->vop_readlink)(VP, U)
 #define VOP_SYMLINK(DVP, OP, NP)   ((DVP)->v_op->vop_symlink)(DVP, OP, NP)
+#define VOP_MAP(VP, VM, A)	   ((VP)->v_op->vop_map)(VP, VM, A)
+#define VOP_UNMAP(VP, VM)	   ((VP)->v_op->vop_unmap)(VP, VM)
 
 int	 vfscore_vop_nullop(void);
 int	 vfscore_vop_einval(void);
@@ -243,10 +278,12 @@ int	 vn_access(struct vnode *, int);
 int	 vfscore_vget(struct mount *, uint64_t ino, struct vnode **vpp);
 void	 vput(struct vnode *);
 void	 vref(struct vnode *);
+int	 vtryref(struct vnode *);
 void	 vrele(struct vnode *);
 void	 vflush(struct mount *);
 void vn_add_name(struct vnode *, struct dentry *);
 void vn_del_name(struct vnode *, struct dentry *);
+void vn_mappings_moved(struct vnode *, char *);
 
 extern enum vtype iftovt_tab[];
 extern int vttoif_tab[];
@@ -719,10 +719,31 @@ UK_SYSCALL_R_DEFINE(int, fsync, int, fd)
 	return -error;
 }
 
+UK_TRACEPOINT(trace_vfs_fdatasync, "%d", int);
+UK_TRACEPOINT(trace_vfs_fdatasync_ret, "");
+UK_TRACEPOINT(trace_vfs_fdatasync_err, "%d", int);
+
 UK_SYSCALL_R_DEFINE(int, fdatasync, int, fd)
 {
-	// TODO: See if we can do less than fsync().
-	return fsync(fd);
+	struct vfscore_file *fp;
+	int error;
+
+	trace_vfs_fdatasync(fd);
+	error = fget(fd, &fp);
+	if (error)
+		goto out_error;
+
+	error = sys_fdatasync(fp);
+	fdrop(fp);
+
+	if (error)
+		goto out_error;
+	trace_vfs_fdatasync_ret();
+	return 0;
+
+	out_error:
+	trace_vfs_fdatasync_err(error);
+	return -error;
 }
 
 UK_TRACEPOINT(trace_vfs_fstat, "%d %p", int, struct stat*);
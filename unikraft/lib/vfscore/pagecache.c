@@ -0,0 +1,494 @@
+/* SPDX-License-Identifier: BSD-3-Clause */
+/*
+ * Copyright (c) 2026, The FlexOS Authors. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the copyright holder nor the names of its
+ *    contributors may be used to endorse or promote products derived from
+ *    this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * pagecache.c - shared page cache for block-backed filesystems
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <uk/config.h>
+#include <uk/essentials.h>
+#include <uk/assert.h>
+#include <uk/page.h>
+#include <uk/alloc.h>
+#include <uk/mutex.h>
+#include <flexos/isolation.h>
+
+#include <vfscore/vnode.h>
+#include <vfscore/pagecache.h>
+
+#define PCACHE_BUCKETS		256
+#define PCACHE_MAX_PAGES	CONFIG_LIBVFSCORE_PAGECACHE_PAGES
+#define PCACHE_RA_MAX		CONFIG_LIBVFSCORE_PAGECACHE_READAHEAD
+/* Maximum number of pages handed to writepages() at once */
+#define PCACHE_WB_BATCH		32
+
+#define PCACHE_PAGE_DIRTY	0x1
+
+struct vfscore_page {
+	struct vnode *pg_vnode;
+	off_t pg_off;
+	void *pg_data;
+	int pg_flags;
+	struct uk_hlist_node pg_hash;	/* (vnode, offset) lookup */
+	struct uk_list_head pg_lru;	/* least recently used first */
+	struct uk_list_head pg_link;	/* pages of the same vnode */
+};
+
+static struct uk_hlist_head pcache_hash[PCACHE_BUCKETS];
+static UK_LIST_HEAD(pcache_lru);
+static unsigned long pcache_nr_pages;
+static struct uk_mutex pcache_lock = UK_MUTEX_INITIALIZER(pcache_lock);
+
+#define PCACHE_LOCK()	flexos_nop_gate(0, 0, uk_mutex_lock, &pcache_lock)
+#define PCACHE_UNLOCK()	flexos_nop_gate(0, 0, uk_mutex_unlock, &pcache_lock)
+
+static inline struct uk_hlist_head *pcache_bucket(struct vnode *vp, off_t off)
+{
+	uintptr_t h = ((uintptr_t) vp >> 4) + (off >> __PAGE_SHIFT);
+
+	return &pcache_hash[h % PCACHE_BUCKETS];
+}
+
+static struct vfscore_page *pcache_lookup(struct vnode *vp, off_t off)
+{
+	struct vfscore_page *pg;
+
+	uk_hlist_for_each_entry(pg, pcache_bucket(vp, off), pg_hash) {
+		if (pg->pg_vnode == vp && pg->pg_off == off) {
+			/* Move to the most recently used end */
+			uk_list_del(&pg->pg_lru);
+			uk_list_add_tail(&pg->pg_lru, &pcache_lru);
+			return pg;
+		}
+	}
+	return NULL;
+}
+
+static void pcache_insert(struct vfscore_page *pg)
+{
+	uk_hlist_add_head(&pg->pg_hash,
+			  pcache_bucket(pg->pg_vnode, pg->pg_off));
+	uk_list_add_tail(&pg->pg_lru, &pcache_lru);
+	uk_list_add_tail(&pg->pg_link, &pg->pg_vnode->v_pages);
+}
+
+static void pcache_free(struct vfscore_page *pg)
+{
+	uk_hlist_del(&pg->pg_hash);
+	uk_list_del(&pg->pg_lru);
+	uk_list_del(&pg->pg_link);
+	uk_pfree(flexos_shared_alloc, pg->pg_data, 1);
+	uk_free(flexos_shared_alloc, pg);
+	pcache_nr_pages--;
+}
+
+static int pcache_writeback(struct vnode *vp, struct vfscore_page **pages,
+			    int cnt)
+{
+	off_t offs[PCACHE_WB_BATCH];
+	void *data[PCACHE_WB_BATCH];
+	int i, error;
+
+	UK_ASSERT(cnt <= PCACHE_WB_BATCH);
+
+	for (i = 0; i < cnt; i++) {
+		offs[i] = pages[i]->pg_off;
+		data[i] = pages[i]->pg_data;
+	}
+
+	error = vp->v_pcops->writepages(vp, offs, data, cnt);
+	if (error)
+		return error;
+
+	for (i = 0; i < cnt; i++)
+		pages[i]->pg_flags &= ~PCACHE_PAGE_DIRTY;
+	return 0;
+}
+
+/*
+ * Recycles the least recently used page. Clean pages are preferred; if all
+ * pages are dirty, the oldest one is written back first. The write-back
+ * runs without pcache_lock but with the lock of the page's vnode held, like
+ * any other I/O on that vnode. Waiting for that lock while the caller holds
+ * its own vnode lock could deadlock with an evictor on the other vnode, so
+ * pages of busy vnodes are skipped. Returns EBUSY if no page could be
+ * recycled for that reason. Must be called with pcache_lock held.
+ */
+static int pcache_evict(void)
+{
+	struct vfscore_page *pg;
+	struct vnode *vp = NULL;
+	int error;
+
+	uk_list_for_each_entry(pg, &pcache_lru, pg_lru) {
+		if (!(pg->pg_flags & PCACHE_PAGE_DIRTY)) {
+			pcache_free(pg);
+			return 0;
+		}
+	}
+
+	if (uk_list_empty(&pcache_lru))
+		return ENOMEM;
+
+	uk_list_for_each_entry(pg, &pcache_lru, pg_lru) {
+		vp = pg->pg_vnode;
+		/* The vnode cannot go away while we hold pcache_lock, it
+		 * releases its pages first
+		 */
+		if (!uk_mutex_trylock(&vp->v_lock))
+			continue;
+		if (vtryref(vp))
+			break;
+		uk_mutex_unlock(&vp->v_lock);
+	}
+	if (&pg->pg_lru == &pcache_lru)
+		return EBUSY;
+
+	/* With the vnode locked, nothing else looks this page up */
+	uk_list_del_init(&pg->pg_lru);
+	PCACHE_UNLOCK();
+
+	error = pcache_writeback(vp, &pg, 1);
+
+	PCACHE_LOCK();
+	if (error)
+		uk_list_add_tail(&pg->pg_lru, &pcache_lru);
+	else
+		pcache_free(pg);
+	PCACHE_UNLOCK();
+
+	vn_unlock(vp);
+	vrele(vp);
+
+	PCACHE_LOCK();
+	return error;
+}
+
+static struct vfscore_page *pcache_alloc(struct vnode *vp, off_t off)
+{
+	struct vfscore_page *pg;
+	int error;
+
+	/* pcache_evict() may drop pcache_lock, so other threads can fill
+	 * the cache again meanwhile. If all dirty pages belong to busy
+	 * vnodes, the cache grows past its limit for now.
+	 */
+	while (pcache_nr_pages >= PCACHE_MAX_PAGES) {
+		error = pcache_evict();
+		if (error == EBUSY)
+			break;
+		if (error)
+			return NULL;
+	}
+
+	pg = uk_malloc(flexos_shared_alloc, sizeof(*pg));
+	if (!pg)
+		return NULL;
+
+	pg->pg_data = uk_palloc(flexos_shared_alloc, 1);
+	if (!pg->pg_data) {
+		uk_free(flexos_shared_alloc, pg);
+		return NULL;
+	}
+
+	pg->pg_vnode = vp;
+	pg->pg_off = off;
+	pg->pg_flags = 0;
+	pcache_nr_pages++;
+	return pg;
+}
+
+static void pcache_discard(struct vfscore_page *pg)
+{
+	uk_pfree(flexos_shared_alloc, pg->pg_data, 1);
+	uk_free(flexos_shared_alloc, pg);
+	pcache_nr_pages--;
+}
+
+/*
+ * Brings up to `cnt` pages starting at `off` into the cache with a single
+ * readpages() call. Stops early at the first page that is already cached.
+ * Returns the page at `off`.
+ */
+static int pcache_fill(struct vnode *vp, off_t off, unsigned int cnt,
+		       struct vfscore_page **first)
+{
+	struct vfscore_page *pages[PCACHE_RA_MAX];
+	void *data[PCACHE_RA_MAX];
+	unsigned int i, n;
+	int error;
+
+	UK_ASSERT(cnt > 0 && cnt <= PCACHE_RA_MAX);
+
+	for (n = 0; n < cnt; n++) {
+		off_t pgoff = off + ((off_t) n << __PAGE_SHIFT);
+
+		if (n > 0 && pcache_lookup(vp, pgoff))
+			break;
+		pages[n] = pcache_alloc(vp, pgoff);
+		if (!pages[n]) {
+			if (n > 0)
+				break;
+			return ENOMEM;
+		}
+		data[n] = pages[n]->pg_data;
+	}
+
+	error = vp->v_pcops->readpages(vp, off, data, n);
+	if (error) {
+		for (i = 0; i < n; i++)
+			pcache_discard(pages[i]);
+		return error;
+	}
+
+	for (i = 0; i < n; i++)
+		pcache_insert(pages[i]);
+
+	*first = pages[0];
+	return 0;
+}
+
+void vfscore_pcache_attach(struct vnode *vp,
+			   const struct vfscore_pcache_ops *ops)
+{
+	UK_ASSERT(vp);
+	UK_ASSERT(ops && ops->readpages && ops->writepages);
+
+	vp->v_pcops = ops;
+	vp->v_ra_next = 0;
+	vp->v_ra_win = 0;
+}
+
+int vfscore_pcache_read(struct vnode *vp, struct uio *uio)
+{
+	struct vfscore_page *pg;
+	off_t pgoff, end, last;
+	size_t pos, len;
+	unsigned int cnt, want;
+	int error = 0;
+
+	UK_ASSERT(vp->v_pcops);
+
+	if (uio->uio_offset < 0)
+		return EINVAL;
+	if (uio->uio_resid == 0 || uio->uio_offset >= vp->v_size)
+		return 0;
+
+	end = MIN(vp->v_size, uio->uio_offset + uio->uio_resid);
+	last = round_pgup(end);
+
+	/* Sequential access doubles the readahead window, a seek resets it */
+	if (uio->uio_offset == vp->v_ra_next && vp->v_ra_win)
+		vp->v_ra_win = MIN(vp->v_ra_win * 2, PCACHE_RA_MAX);
+	else
+		vp->v_ra_win = 1;
+
+	PCACHE_LOCK();
+	while (uio->uio_offset < end) {
+		pgoff = round_pgdown(uio->uio_offset);
+		pos = uio->uio_offset - pgoff;
+		len = MIN((off_t) (__PAGE_SIZE - pos), end - uio->uio_offset);
+
+		pg = pcache_lookup(vp, pgoff);
+		if (!pg) {
+			/* At least what this read still needs */
+			want = (last - pgoff) >> __PAGE_SHIFT;
+			cnt = MAX(want, vp->v_ra_win);
+			cnt = MIN(cnt, (unsigned int) PCACHE_RA_MAX);
+			/* ... but not past the end of the file */
+			cnt = MIN(cnt, (unsigned int)
+				  ((round_pgup(vp->v_size) - pgoff)
+				   >> __PAGE_SHIFT));
+			error = pcache_fill(vp, pgoff, cnt, &pg);
+			if (error)
+				break;
+		}
+
+		error = vfscore_uiomove((char *) pg->pg_data + pos, len, uio);
+		if (error)
+			break;
+	}
+	PCACHE_UNLOCK();
+
+	vp->v_ra_next = uio->uio_offset;
+	return error;
+}
+
+int vfscore_pcache_write(struct vnode *vp, struct uio *uio, int ioflag)
+{
+	struct vfscore_page *pg;
+	off_t pgoff, end;
+	size_t pos, len;
+	int error = 0;
+
+	UK_ASSERT(vp->v_pcops);
+
+	if (uio->uio_offset < 0)
+		return EINVAL;
+	if (uio->uio_resid == 0)
+		return 0;
+
+	end = uio->uio_offset + uio->uio_resid;
+
+	PCACHE_LOCK();
+	while (uio->uio_offset < end) {
+		pgoff = round_pgdown(uio->uio_offset);
+		pos = uio->uio_offset - pgoff;
+		len = MIN((off_t) (__PAGE_SIZE - pos), end - uio->uio_offset);
+
+		pg = pcache_lookup(vp, pgoff);
+		if (!pg && (len == __PAGE_SIZE || pgoff >= vp->v_size)) {
+			/* Nothing to preserve from the backing store */
+			pg = pcache_alloc(vp, pgoff);
+			if (!pg) {
+				error = ENOMEM;
+				break;
+			}
+			memset(pg->pg_data, 0, __PAGE_SIZE);
+			pcache_insert(pg);
+		} else if (!pg) {
+			error = pcache_fill(vp, pgoff, 1, &pg);
+			if (error)
+				break;
+		}
+
+		error = vfscore_uiomove((char *) pg->pg_data + pos, len, uio);
+		pg->pg_flags |= PCACHE_PAGE_DIRTY;
+		if (uio->uio_offset > vp->v_size)
+			vp->v_size = uio->uio_offset;
+		if (error)
+			break;
+	}
+	PCACHE_UNLOCK();
+
+	if (!error && (ioflag & IO_SYNC))
+		error = vfscore_pcache_sync(vp);
+	return error;
+}
+
+static int pcache_cmp_off(const void *a, const void *b)
+{
+	const struct vfscore_page *pa = *(struct vfscore_page * const *) a;
+	const struct vfscore_page *pb = *(struct vfscore_page * const *) b;
+
+	return (pa->pg_off > pb->pg_off) - (pa->pg_off < pb->pg_off);
+}
+
+int vfscore_pcache_sync(struct vnode *vp)
+{
+	struct vfscore_page **dirty, *pg;
+	unsigned long nr_dirty = 0, i, cnt;
+	int error = 0;
+
+	if (!vp->v_pcops)
+		return 0;
+
+	PCACHE_LOCK();
+	uk_list_for_each_entry(pg, &vp->v_pages, pg_link)
+		if (pg->pg_flags & PCACHE_PAGE_DIRTY)
+			nr_dirty++;
+	if (!nr_dirty)
+		goto out;
+
+	dirty = uk_malloc(flexos_shared_alloc, nr_dirty * sizeof(*dirty));
+	if (!dirty) {
+		error = ENOMEM;
+		goto out;
+	}
+
+	i = 0;
+	uk_list_for_each_entry(pg, &vp->v_pages, pg_link)
+		if (pg->pg_flags & PCACHE_PAGE_DIRTY)
+			dirty[i++] = pg;
+
+	/* Ascending offsets let the filesystem allocate contiguously */
+	qsort(dirty, nr_dirty, sizeof(*dirty), pcache_cmp_off);
+
+	for (i = 0; i < nr_dirty; i += cnt) {
+		cnt = MIN(nr_dirty - i, (unsigned long) PCACHE_WB_BATCH);
+		error = pcache_writeback(vp, &dirty[i], cnt);
+		if (error)
+			break;
+	}
+	uk_free(flexos_shared_alloc, dirty);
+
+out:
+	PCACHE_UNLOCK();
+	return error;
+}
+
+int vfscore_pcache_truncate(struct vnode *vp, off_t length)
+{
+	struct vfscore_page *pg, *tmp;
+	off_t tail = round_pgdown(length);
+	size_t pos = length - tail;
+	int error = 0;
+
+	if (!vp->v_pcops)
+		return 0;
+
+	PCACHE_LOCK();
+	uk_list_for_each_entry_safe(pg, tmp, &vp->v_pages, pg_link)
+		if (pg->pg_off >= (off_t) round_pgup(length))
+			pcache_free(pg);
+
+	/* The backing store may still hold stale data past the new end of
+	 * file, which would reappear if the file grows again.
+	 */
+	if (pos && length < vp->v_size) {
+		pg = pcache_lookup(vp, tail);
+		if (!pg)
+			error = pcache_fill(vp, tail, 1, &pg);
+		if (!error) {
+			memset((char *) pg->pg_data + pos, 0,
+			       __PAGE_SIZE - pos);
+			pg->pg_flags |= PCACHE_PAGE_DIRTY;
+		}
+	}
+	PCACHE_UNLOCK();
+
+	return error;
+}
+
+void vfscore_pcache_release(struct vnode *vp)
+{
+	struct vfscore_page *pg, *tmp;
+
+	if (!vp->v_pcops)
+		return;
+
+	PCACHE_LOCK();
+	uk_list_for_each_entry_safe(pg, tmp, &vp->v_pages, pg_link)
+		pcache_free(pg);
+	PCACHE_UNLOCK();
+}
@@ -427,6 +427,27 @@ sys_fsync(struct vfscore_file *fp)
 	return error;
 }
 
+int
+sys_fdatasync(struct vfscore_file *fp)
+{
+	struct vnode *vp;
+	int error;
+
+	DPRINTF(VFSDB_SYSCALL, ("sys_fdatasync: fp=%p\n", fp));
+
+	if (!fp->f_dentry)
+		return EINVAL;
+
+	vp = fp->f_dentry->d_vnode;
+	vn_lock(vp);
+	if (vp->v_op->vop_fdatasync)
+		error = VOP_FDATASYNC(vp, fp);
+	else
+		error = VOP_FSYNC(vp, fp);
+	vn_unlock(vp);
+	return error;
+}
+
 int
 sys_fstat(struct vfscore_file *fp, struct stat *st)
 {
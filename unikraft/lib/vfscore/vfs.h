@@ -83,6 +83,7 @@ int	 sys_ioctl(struct vfscore_file *fp, unsigned long request, void *buf);
 int	 sys_fstat(struct vfscore_file *fp, struct stat *st);
 int	 sys_fstatfs(struct vfscore_file *fp, struct statfs *buf);
 int	 sys_fsync(struct vfscore_file *fp);
+int	 sys_fdatasync(struct vfscore_file *fp);
 int	 sys_ftruncate(struct vfscore_file *fp, off_t length);
 
 int	 sys_readdir(struct vfscore_file *fp, struct dirent *dirent);
@@ -48,6 +48,9 @@
 #include <vfscore/prex.h>
 #include <vfscore/dentry.h>
 #include <vfscore/vnode.h>
+#if CONFIG_LIBVFSCORE_PAGECACHE
+#include <vfscore/pagecache.h>
+#endif
 #include "vfs.h"
 
 #define __UK_S_BLKSIZE 512
@@ -220,6 +223,10 @@ vfscore_vget(struct mount *mp, uint64_t ino, struct vnode **vpp)
 	}
 
 	UK_INIT_LIST_HEAD(&vp->v_names);
+	UK_INIT_LIST_HEAD(&vp->v_mappings);
+#if CONFIG_LIBVFSCORE_PAGECACHE
+	UK_INIT_LIST_HEAD(&vp->v_pages);
+#endif
 	vp->v_ino = ino;
 	vp->v_mount = mp;
 	vp->v_refcnt = 1;
@@ -273,6 +280,9 @@ vput(struct vnode *vp)
 	 */
 	if (vp->v_op->vop_inactive)
 		VOP_INACTIVE(vp);
+#if CONFIG_LIBVFSCORE_PAGECACHE
+	vfscore_pcache_release(vp);
+#endif
 	vfs_unbusy(vp->v_mount);
 	flexos_nop_gate(0, 0, uk_mutex_unlock, &vp->v_lock);
 	//__flexos_morello_gate1_i(1, 0, uk_mutex_unlock, &vp->v_lock);
@@ -297,6 +307,27 @@ vref(struct vnode *vp)
 	//__flexos_morello_gate1_i(1, 0, uk_mutex_unlock, &vnode_lock);
 }
 
+/*
+ * Increment the reference count of a vnode that may already be on its
+ * way out. Returns 0, without taking a reference, if the count already
+ * dropped to zero.
+ */
+int
+vtryref(struct vnode *vp)
+{
+	int ret = 0;
+
+	UK_ASSERT(vp);
+
+	VNODE_LOCK();
+	if (vp->v_refcnt > 0) {
+		vp->v_refcnt++;
+		ret = 1;
+	}
+	VNODE_UNLOCK();
+	return ret;
+}
+
 /*
  * Decrement the reference count of the vnode.
  * Any code in the system which is using vnode should call vrele()
@@ -323,6 +354,9 @@ vrele(struct vnode *vp)
 	 * Deallocate fs specific vnode data
 	 */
 	VOP_INACTIVE(vp);
+#if CONFIG_LIBVFSCORE_PAGECACHE
+	vfscore_pcache_release(vp);
+#endif
 	vfs_unbusy(vp->v_mount);
 	uk_free(flexos_shared_alloc, vp);
 }
@@ -628,3 +662,15 @@ void vn_del_name(struct vnode *vp __unused, struct dentry *dp)
 	uk_list_del(&dp->d_names_link);
 }
 
+
+/*
+ * Called by a file system with the vnode locked after it moved the memory
+ * that backs the file to `base`.
+ */
+void vn_mappings_moved(struct vnode *vp, char *base)
+{
+	struct vfscore_mapping *vm;
+
+	uk_list_for_each_entry(vm, &vp->v_mappings, vm_link)
+		vm->vm_moved(vm, base + vm->vm_off);
+}
@@ -152,6 +152,56 @@ struct pci_device {
 	unsigned long irq;
 };
 
+/**
+ * Registers of the configuration space header and capabilities used by
+ * device drivers, see the PCI Local Bus Specification 3.0, chapter 6.
+ */
+#define PCI_CFG_COMMAND             (0x04)
+#define PCI_CFG_COMMAND_IO          (0x0001)
+#define PCI_CFG_COMMAND_MEMORY      (0x0002)
+#define PCI_CFG_COMMAND_MASTER      (0x0004)
+#define PCI_CFG_STATUS              (0x06)
+#define PCI_CFG_STATUS_CAP_LIST     (0x0010)
+#define PCI_CFG_BAR(n)              (0x10 + 4 * (n))
+#define PCI_CFG_BAR_IO              (0x1)
+#define PCI_CFG_BAR_MEM_TYPE_MASK   (0x6)
+#define PCI_CFG_BAR_MEM_TYPE_64     (0x4)
+#define PCI_CFG_BAR_MEM_MASK        (~0xfUL)
+#define PCI_CFG_CAP_PTR             (0x34)
+
+#define PCI_CAP_ID_VNDR             (0x09)
+#define PCI_CAP_ID                  (0x00)
+#define PCI_CAP_NEXT                (0x01)
+
+/**
+ * Read and write the configuration space of a PCI device. The accesses
+ * are not serialized with each other, drivers should only use them while
+ * setting up the device.
+ */
+uint32_t pci_conf_read32(struct pci_device *dev, uint8_t offset);
+void pci_conf_write32(struct pci_device *dev, uint8_t offset, uint32_t val);
+
+static inline uint16_t pci_conf_read16(struct pci_device *dev, uint8_t offset)
+{
+	return pci_conf_read32(dev, offset) >> ((offset & 0x2) * 8);
+}
+
+static inline uint8_t pci_conf_read8(struct pci_device *dev, uint8_t offset)
+{
+	return pci_conf_read32(dev, offset) >> ((offset & 0x3) * 8);
+}
+
+static inline void pci_conf_write16(struct pci_device *dev, uint8_t offset,
+				    uint16_t val)
+{
+	uint32_t shift = (offset & 0x2) * 8;
+	uint32_t data = pci_conf_read32(dev, offset);
+
+	data &= ~(0xffffu << shift);
+	data |= (uint32_t) val << shift;
+	pci_conf_write32(dev, offset, data);
+}
+
 
 #define PCI_REGISTER_DRIVER(b)                  \
 	_PCI_REGISTER_DRIVER(__LIBNAME__, b)
@@ -955,6 +955,12 @@ int uk_heap_map(unsigned long vaddr, unsigned long len)
 	return 0;
 }
 
+int __weak uk_page_fault_handle(unsigned long vaddr __unused,
+				int write __unused)
+{
+	return -1;
+}
+
 void dump_pt(unsigned long pt, unsigned long vaddr)
 {
 	unsigned long pt_entry;
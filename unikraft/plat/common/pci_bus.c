@@ -232,6 +232,31 @@ static inline int pci_driver_add_device(struct pci_driver *drv,
 	return 0;
 }
 
+static inline uint32_t pci_conf_addr(struct pci_device *dev, uint8_t offset)
+{
+	return (PCI_ENABLE_BIT)
+		| (dev->addr.bus << PCI_BUS_SHIFT)
+		| (dev->addr.devid << PCI_DEVICE_SHIFT)
+		| (dev->addr.function << PCI_FUNCTION_SHIFT)
+		| (offset & ~0x3);
+}
+
+uint32_t pci_conf_read32(struct pci_device *dev, uint8_t offset)
+{
+	UK_ASSERT(dev);
+
+	outl(PCI_CONFIG_ADDR, pci_conf_addr(dev, offset));
+	return inl(PCI_CONFIG_DATA);
+}
+
+void pci_conf_write32(struct pci_device *dev, uint8_t offset, uint32_t val)
+{
+	UK_ASSERT(dev);
+
+	outl(PCI_CONFIG_ADDR, pci_conf_addr(dev, offset));
+	outl(PCI_CONFIG_DATA, val);
+}
+
 static void probe_bus(uint32_t);
 
 /* Probe a function. Return 1 if the function does not exist in the device, 0
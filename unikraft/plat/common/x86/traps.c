@@ -45,6 +45,10 @@
 #include <flexos/impl/intelpku.h>
 #endif
 
+#if CONFIG_PT_API
+#include <uk/plat/mm.h>
+#endif
+
 /* A general word of caution when writing trap handlers. The platform trap
  * entry code is set up to properly save general-purpose registers (e.g., rsi,
  * rdi, rax, r8, ...), but it does NOT save any floating-point or SSE/AVX
@@ -127,6 +131,35 @@ void do_gp_fault(struct __regs *regs, long error_code)
 	UK_CRASH("Crashing\n");
 }
 
+#if CONFIG_PT_API
+#define PF_EC_PROT	(1 << 0)	/* fault on a present page */
+#define PF_EC_WRITE	(1 << 1)	/* fault on a write access */
+
+/* Extended registers of the faulting context, uk_page_fault_handle() is
+ * regular C code that is free to use SSE/AVX.
+ */
+static __u8 pf_extregs[4096] __attribute__((aligned(64)));
+
+static int page_fault_resolve(unsigned long addr, unsigned long error_code)
+{
+	struct sw_ctx ctx;
+	int rc;
+
+	/* Only writes to write-protected pages can be resolved for now */
+	if ((error_code & (PF_EC_PROT | PF_EC_WRITE))
+	    != (PF_EC_PROT | PF_EC_WRITE))
+		return -1;
+	if (x86_cpu_features.extregs_size > sizeof(pf_extregs))
+		return -1;
+
+	ctx.extregs = (uintptr_t) pf_extregs;
+	save_extregs(&ctx);
+	rc = uk_page_fault_handle(addr, 1);
+	restore_extregs(&ctx);
+	return rc;
+}
+#endif /* CONFIG_PT_API */
+
 void do_page_fault(struct __regs *regs, unsigned long error_code)
 {
 #if CONFIG_LIBFLEXOS_INTELPKU
@@ -137,6 +170,15 @@ void do_page_fault(struct __regs *regs, unsigned long error_code)
 #endif
 	unsigned long addr = read_cr2();
 
+#if CONFIG_PT_API
+	if (page_fault_resolve(addr, error_code) == 0) {
+#if CONFIG_LIBFLEXOS_INTELPKU
+		wrpkru(pku);
+#endif
+		return;
+	}
+#endif /* CONFIG_PT_API */
+
 	fault_prologue();
 	uk_pr_crit("Page fault at linear address %lx, rip %lx, "
 		   "regs %p, sp %lx, our_sp %p, code %lx\n",
@@ -80,8 +80,8 @@ struct virtio_dev_id {
  * The structure define a list of configuration operation on a virtio device.
  */
 struct virtio_config_ops {
-	/** Resetting the device */
-	void (*device_reset)(struct virtio_dev *vdev);
+	/** Resetting the device, returns a negative errno on failure */
+	int (*device_reset)(struct virtio_dev *vdev);
 	/** Set configuration option */
 	int (*config_set)(struct virtio_dev *vdev, __u16 offset,
 			  const void *buf, __u32 len);
@@ -153,6 +153,7 @@ void _virtio_bus_register_driver(struct virtio_driver *vdrv);
  * @return
  *	0 on successful updating the status.
  *	-ENOTSUP, if the operation is not supported on the virtio device.
+ *	-ETIMEDOUT, if the device does not complete the reset.
  */
 static inline int virtio_dev_reset(struct virtio_dev *vdev)
 {
@@ -160,10 +161,8 @@ static inline int virtio_dev_reset(struct virtio_dev *vdev)
 
 	UK_ASSERT(vdev);
 
-	if (likely(vdev->cops->device_reset)) {
-		vdev->cops->device_reset(vdev);
-		rc = 0;
-	}
+	if (likely(vdev->cops->device_reset))
+		rc = vdev->cops->device_reset(vdev);
 
 	return rc;
 }
@@ -46,6 +46,7 @@ extern "C" {
 #define VIRTIO_CONFIG_STATUS_ACK           0x1  /* recognize device as virtio */
 #define VIRTIO_CONFIG_STATUS_DRIVER        0x2  /* driver for the device found*/
 #define VIRTIO_CONFIG_STATUS_DRIVER_OK     0x4  /* initialization is complete */
+#define VIRTIO_CONFIG_STATUS_FEATURES_OK   0x8  /* features accepted (1.0) */
 #define VIRTIO_CONFIG_STATUS_NEEDS_RESET   0x40 /* device needs reset */
 #define VIRTIO_CONFIG_STATUS_FAIL          0x80 /* device something's wrong*/
 
@@ -34,8 +34,7 @@
 extern "C" {
 #endif /* __cplusplus __ */
 
-/* virtio config space layout */
-/* TODO we currently support only the legacy interface */
+/* virtio config space layout (legacy interface) */
 #define VIRTIO_PCI_HOST_FEATURES        0    /* 32-bit r/o */
 #define VIRTIO_PCI_GUEST_FEATURES       4    /* 32-bit r/w */
 #define VIRTIO_PCI_QUEUE_PFN            8    /* 32-bit r/w */
@@ -67,6 +66,47 @@ extern "C" {
 #define VIRTIO_PCI_CONFIG_OFF           20
 #define VIRTIO_PCI_VRING_ALIGN          4096
 
+/*
+ * Modern interface (virtio 1.0, section 4.1.4): the device describes the
+ * location of its configuration structures in memory BARs with vendor
+ * specific PCI capabilities.
+ */
+#define VIRTIO_PCI_CAP_COMMON_CFG       1    /* Common configuration */
+#define VIRTIO_PCI_CAP_NOTIFY_CFG       2    /* Notifications */
+#define VIRTIO_PCI_CAP_ISR_CFG          3    /* ISR status */
+#define VIRTIO_PCI_CAP_DEVICE_CFG       4    /* Device specific config */
+#define VIRTIO_PCI_CAP_PCI_CFG          5    /* PCI config access */
+
+/* Offsets into struct virtio_pci_cap, from the start of the capability */
+#define VIRTIO_PCI_CAP_CFG_TYPE         3    /* 8-bit */
+#define VIRTIO_PCI_CAP_BAR              4    /* 8-bit */
+#define VIRTIO_PCI_CAP_OFFSET           8    /* 32-bit */
+#define VIRTIO_PCI_CAP_LENGTH           12   /* 32-bit */
+/* Only in the notification capability */
+#define VIRTIO_PCI_NOTIFY_CAP_MULT      16   /* 32-bit */
+
+/* Offsets into the common configuration structure */
+#define VIRTIO_PCI_COMMON_DFSELECT      0    /* 32-bit r/w */
+#define VIRTIO_PCI_COMMON_DF            4    /* 32-bit r/o */
+#define VIRTIO_PCI_COMMON_GFSELECT      8    /* 32-bit r/w */
+#define VIRTIO_PCI_COMMON_GF            12   /* 32-bit r/w */
+#define VIRTIO_PCI_COMMON_MSIX          16   /* 16-bit r/w */
+#define VIRTIO_PCI_COMMON_NUMQ          18   /* 16-bit r/o */
+#define VIRTIO_PCI_COMMON_STATUS        20   /* 8-bit r/w */
+#define VIRTIO_PCI_COMMON_CFGGENERATION 21   /* 8-bit r/o */
+#define VIRTIO_PCI_COMMON_Q_SELECT      22   /* 16-bit r/w */
+#define VIRTIO_PCI_COMMON_Q_SIZE        24   /* 16-bit r/w */
+#define VIRTIO_PCI_COMMON_Q_MSIX        26   /* 16-bit r/w */
+#define VIRTIO_PCI_COMMON_Q_ENABLE      28   /* 16-bit r/w */
+#define VIRTIO_PCI_COMMON_Q_NOFF        30   /* 16-bit r/o */
+#define VIRTIO_PCI_COMMON_Q_DESCLO      32   /* 32-bit r/w */
+#define VIRTIO_PCI_COMMON_Q_DESCHI      36   /* 32-bit r/w */
+#define VIRTIO_PCI_COMMON_Q_AVAILLO     40   /* 32-bit r/w */
+#define VIRTIO_PCI_COMMON_Q_AVAILHI     44   /* 32-bit r/w */
+#define VIRTIO_PCI_COMMON_Q_USEDLO      48   /* 32-bit r/w */
+#define VIRTIO_PCI_COMMON_Q_USEDHI      52   /* 32-bit r/w */
+#define VIRTIO_PCI_COMMON_CFG_LEN       56
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus __ */
@@ -81,6 +81,12 @@ extern "C" {
 /* Arbitrary descriptor layouts. */
 #define VIRTIO_F_ANY_LAYOUT       27
 
+/* The device complies with the virtio 1.0 specification (modern device) */
+#define VIRTIO_F_VERSION_1        32
+
+/* Support for the packed virtqueue layout (virtio 1.1) */
+#define VIRTIO_F_RING_PACKED      34
+
 /**
  * Virtqueue descriptors: 16 bytes.
  * These can chain together via "next".
@@ -157,7 +163,7 @@ struct vring {
  * versa. They are at the end for backwards compatibility.
  */
 #define vring_used_event(vr) ((vr)->avail->ring[(vr)->num])
-#define vring_avail_event(vr) (*(__virtio16 *)&(vr)->used->ring[(vr)->num])
+#define vring_avail_event(vr) (*(__virtio_le16 *)&(vr)->used->ring[(vr)->num])
 
 static inline void vring_init(struct vring *vr, unsigned int num, uint8_t *p,
 			      unsigned long align)
@@ -189,6 +195,81 @@ static inline int vring_need_event(__u16 event_idx, __u16 new_idx,
 	return (new_idx - event_idx - 1) < (new_idx - old_idx);
 }
 
+/*
+ * Packed virtqueue layout (virtio 1.1, section 2.7). A single descriptor
+ * ring is shared by the driver and the device: the driver makes a
+ * descriptor available by flipping its AVAIL flag to the driver's wrap
+ * counter, the device marks it used by setting the USED flag to the same
+ * value. The device writes used descriptors back in place, in the order
+ * it completes the buffers, with the buffer id of the first descriptor.
+ *
+ * struct vring_packed {
+ *      // The descriptor ring (16 bytes each)
+ *      struct vring_packed_desc desc[num];
+ *
+ *      // Event suppression, written by the driver
+ *      struct vring_packed_desc_event driver;
+ *
+ *      // Event suppression, written by the device
+ *      struct vring_packed_desc_event device;
+ * };
+ *
+ * The queue size does not need to be a power of 2.
+ */
+#define VRING_PACKED_DESC_F_AVAIL	7
+#define VRING_PACKED_DESC_F_USED	15
+
+/* Enable events */
+#define VRING_PACKED_EVENT_FLAG_ENABLE	0x0
+/* Disable events */
+#define VRING_PACKED_EVENT_FLAG_DISABLE	0x1
+/* Enable events for a specific descriptor (VIRTIO_F_EVENT_IDX) */
+#define VRING_PACKED_EVENT_FLAG_DESC	0x2
+/* Wrap counter bit in the off_wrap field of the event suppression */
+#define VRING_PACKED_EVENT_F_WRAP_CTR	15
+
+struct vring_packed_desc {
+	/* Buffer address (guest-physical). */
+	__virtio_le64 addr;
+	/* Buffer length. */
+	__virtio_le32 len;
+	/* Buffer id. */
+	__virtio_le16 id;
+	/* The flags depending on descriptor type. */
+	__virtio_le16 flags;
+};
+
+struct vring_packed_desc_event {
+	/* Descriptor ring change event offset and wrap counter */
+	__virtio_le16 off_wrap;
+	/* Descriptor ring change event flags */
+	__virtio_le16 flags;
+};
+
+struct vring_packed {
+	unsigned int num;
+
+	struct vring_packed_desc *desc;
+	struct vring_packed_desc_event *driver;
+	struct vring_packed_desc_event *device;
+};
+
+static inline void vring_packed_init(struct vring_packed *vr, unsigned int num,
+				     uint8_t *p)
+{
+	vr->num = num;
+	vr->desc = (struct vring_packed_desc *) p;
+	vr->driver = (struct vring_packed_desc_event *) (p +
+			num * sizeof(struct vring_packed_desc));
+	vr->device = vr->driver + 1;
+}
+
+static inline unsigned int vring_packed_size(unsigned int num)
+{
+	return num * sizeof(struct vring_packed_desc) +
+		2 * sizeof(struct vring_packed_desc_event);
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus __ */
@@ -44,6 +44,19 @@
 extern "C" {
 #endif /* __cplusplus */
 
+/**
+ * Ring features implemented by the virtqueue. Device drivers offer them in
+ * addition to their device specific features.
+ */
+#define VIRTQUEUE_RING_FEATURES_SPLIT			\
+	((1ULL << VIRTIO_F_INDIRECT_DESC) | (1ULL << VIRTIO_F_EVENT_IDX))
+#ifdef CONFIG_VIRTIO_RING_PACKED
+#define VIRTQUEUE_RING_FEATURES				\
+	(VIRTQUEUE_RING_FEATURES_SPLIT | (1ULL << VIRTIO_F_RING_PACKED))
+#else
+#define VIRTQUEUE_RING_FEATURES VIRTQUEUE_RING_FEATURES_SPLIT
+#endif /* CONFIG_VIRTIO_RING_PACKED */
+
 /**
  * Type declarations
  */
@@ -80,6 +93,23 @@ struct virtqueue {
  */
 __phys_addr virtqueue_physaddr(struct virtqueue *vq);
 
+/**
+ * Fetch the physical addresses of the three parts of the ring, as the
+ * modern transports program them separately.
+ * @param vq
+ *	Reference to the virtqueue.
+ * @param desc
+ *	Filled with the address of the descriptor ring.
+ * @param driver
+ *	Filled with the address of the available ring (split ring) or of the
+ *	driver event suppression structure (packed ring).
+ * @param device
+ *	Filled with the address of the used ring (split ring) or of the
+ *	device event suppression structure (packed ring).
+ */
+void virtqueue_ring_addr(struct virtqueue *vq, __phys_addr *desc,
+			 __phys_addr *driver, __phys_addr *device);
+
 /**
  * Ring interrupt handler. This function is invoked from the interrupt handler
  * in the virtio device for interrupt specific to the ring.
@@ -104,7 +134,10 @@ int virtqueue_ring_interrupt(void *obj);
 __u64 virtqueue_feature_negotiate(__u64 feature_set);
 
 /**
- * Check if host notification is enabled.
+ * Check if host notification is enabled. With VIRTIO_F_EVENT_IDX, this
+ * checks whether the host needs a notification for the descriptors made
+ * available since the previous call and must only be called right before
+ * notifying the host.
  *
  * @param vq
  *	Reference to the virtqueue.
@@ -166,7 +199,8 @@ int virtqueue_buffer_enqueue(struct virtqueue *vq, void *cookie,
  * @param nr_descs
  *	The number of descriptor for the queue.
  * @param align
- *	The memory alignment for the ring memory.
+ *	The memory alignment for the ring memory. Unused for the packed ring,
+ *	which is used if VIRTIO_F_RING_PACKED was negotiated with the device.
  * @param callback
  *	A reference to callback to the virtio-dev.
  * @param notify
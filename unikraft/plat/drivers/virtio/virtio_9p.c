@@ -382,6 +382,7 @@ static inline void virtio_9p_feature_set(struct virtio_9p_device *d)
 {
 	d->vdev->features = 0;
 	VIRTIO_FEATURES_UPDATE(d->vdev->features, VIRTIO_9P_F_MOUNT_TAG);
+	d->vdev->features |= VIRTQUEUE_RING_FEATURES;
 }
 
 static int virtio_9p_configure(struct virtio_9p_device *d)
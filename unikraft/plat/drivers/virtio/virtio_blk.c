@@ -286,15 +286,20 @@ static int virtio_blkdev_queue_enqueue(struct uk_blkdev_queue *queue,
 		rc = virtio_blkdev_request_flush(queue, virtio_blk_req,
 				&read_segs, &write_segs);
 	else
-		return -EINVAL;
+		rc = -EINVAL;
 
 	if (rc)
-		goto out;
+		goto err_free;
 
 	rc = virtqueue_buffer_enqueue(queue->vq, virtio_blk_req, &queue->sg,
 				      read_segs, write_segs);
+	if (unlikely(rc < 0))
+		goto err_free;
 
-out:
+	return rc;
+
+err_free:
+	uk_free(a, virtio_blk_req);
 	return rc;
 }
 
@@ -337,6 +342,50 @@ err:
 	return rc;
 }
 
+static int virtio_blkdev_submit_batch(struct uk_blkdev *dev,
+		struct uk_blkdev_queue *queue,
+		struct uk_blkreq **reqs,
+		uint16_t cnt,
+		int notify)
+{
+	uint16_t i;
+	int rc = 0;
+
+	UK_ASSERT(reqs);
+	UK_ASSERT(queue);
+	UK_ASSERT(dev);
+
+	for (i = 0; i < cnt; i++) {
+		rc = virtio_blkdev_queue_enqueue(queue, reqs[i]);
+		if (unlikely(rc < 0))
+			break;
+	}
+
+	if (unlikely(i == 0)) {
+		if (rc != -ENOSPC)
+			uk_pr_err("Failed to enqueue descriptors into the ring: %d\n",
+				  rc);
+		return rc;
+	}
+
+	/**
+	 * Notify the host once for all the buffers of the batch.
+	 */
+	if (notify)
+		virtqueue_host_notify(queue->vq);
+
+	return i;
+}
+
+static void virtio_blkdev_queue_kick(struct uk_blkdev *dev,
+		struct uk_blkdev_queue *queue)
+{
+	UK_ASSERT(dev);
+	UK_ASSERT(queue);
+
+	virtqueue_host_notify(queue->vq);
+}
+
 static int virtio_blkdev_queue_dequeue(struct uk_blkdev_queue *queue,
 		struct uk_blkreq **req)
 {
@@ -855,6 +904,7 @@ static inline void virtio_blkdev_feature_set(struct virtio_blk_device *vbdev)
 
 	/* Setting the feature the driver support */
 	VIRTIO_BLK_DRV_FEATURES(vbdev->vdev->features);
+	vbdev->vdev->features |= VIRTQUEUE_RING_FEATURES;
 }
 
 static const struct uk_blkdev_ops virtio_blkdev_ops = {
@@ -866,6 +916,7 @@ static const struct uk_blkdev_ops virtio_blkdev_ops = {
 		.dev_start = virtio_blkdev_start,
 		.dev_stop = virtio_blkdev_stop,
 		.queue_intr_disable = virtio_blkdev_queue_intr_disable,
+		.queue_kick = virtio_blkdev_queue_kick,
 		.queue_unconfigure = virtio_blkdev_queue_release,
 		.dev_unconfigure = virtio_blkdev_unconfigure,
 };
@@ -884,6 +935,7 @@ static int virtio_blk_add_dev(struct virtio_dev *vdev)
 	vbdev->vdev = vdev;
 	vbdev->blkdev.finish_reqs = virtio_blkdev_complete_reqs;
 	vbdev->blkdev.submit_one = virtio_blkdev_submit_request;
+	vbdev->blkdev.submit_batch = virtio_blkdev_submit_batch;
 	vbdev->blkdev.dev_ops = &virtio_blkdev_ops;
 
 	rc = uk_blkdev_drv_register(&vbdev->blkdev, a, drv_name);
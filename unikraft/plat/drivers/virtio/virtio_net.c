@@ -34,6 +34,8 @@
 #include <uk/sglist.h>
 #include <uk/arch/types.h>
 #include <uk/arch/limits.h>
+#include <uk/arch/time.h>
+#include <uk/plat/time.h>
 #include <uk/netbuf.h>
 #include <uk/netdev.h>
 #include <uk/netdev_core.h>
@@ -66,6 +68,9 @@
  */
 #define NET_MAX_FRAGMENTS    ((__U16_MAX >> __PAGE_SHIFT) + 2)
 
+/* How long to wait for the device to answer a control command */
+#define VTNET_CTRL_TIMEOUT_MS 1000
+
 #define to_virtionetdev(ndev) \
 	__containerof(ndev, struct virtio_net_device, netdev)
 
@@ -145,6 +150,19 @@ struct virtio_net_device {
 	struct uk_netdev netdev;
 	/* Count of the number of the virtqueues */
 	__u16 max_vqueue_pairs;
+	/**
+	 * Queue pairs of the device (VIRTIO_NET_F_MQ), the control queue
+	 * follows the last of them
+	 */
+	__u16 dev_vqueue_pairs;
+	/* Queue pairs in use */
+	__u16 nb_vqueue_pairs;
+	/* Control queue (VIRTIO_NET_F_CTRL_VQ), NULL without multiqueue */
+	struct virtqueue *ctrlq;
+	struct uk_sglist ctrl_sg;
+	struct uk_sglist_seg ctrl_sgsegs[3];
+	struct virtio_net_ctrl_hdr ctrl_hdr;
+	virtio_net_ctrl_ack ctrl_ack;
 	/* List of the Rx/Tx queue */
 	__u16    rx_vqueue_cnt;
 	struct   uk_netdev_rx_queue *rxqs;
@@ -164,6 +182,8 @@ struct virtio_net_device {
 	__u8 state;
 	/* RX promiscuous mode. */
 	__u8 promisc : 1;
+	/* Length of the virtio-net header exchanged with the device */
+	__u8 hdr_len;
 };
 
 /**
@@ -243,27 +263,36 @@ static int virtio_netdev_recv_done(struct virtqueue *vq, void *priv)
 	return 1;
 }
 
+#define TX_FREE_BATCHLEN 32
+
 static void virtio_netdev_xmit_free(struct uk_netdev_tx_queue *txq)
 {
-	struct uk_netbuf *pkt = NULL;
+	struct uk_netbuf *pkt[TX_FREE_BATCHLEN];
 	int cnt = 0;
+	int n = 0;
 	int rc;
 
 	for (;;) {
-		rc = virtqueue_buffer_dequeue(txq->vq, (void **) &pkt, NULL);
+		rc = virtqueue_buffer_dequeue(txq->vq, (void **) &pkt[n], NULL);
 		if (rc < 0)
 			break;
 
-		UK_ASSERT(pkt);
+		UK_ASSERT(pkt[n]);
+		cnt++;
+		if (++n < TX_FREE_BATCHLEN)
+			continue;
 
 		/**
-		 * Releasing the free buffer back to netbuf. The netbuf could
+		 * Releasing the free buffers back to netbuf. Pool netbufs
+		 * are recycled with a single pool operation. The netbuf could
 		 * use the destructor to inform the stack regarding the free up
 		 * of memory.
 		 */
-		uk_netbuf_free(pkt);
-		cnt++;
+		uk_netbuf_free_batch(pkt, n);
+		n = 0;
 	}
+	if (n)
+		uk_netbuf_free_batch(pkt, n);
 	uk_pr_debug("Free %"__PRIu16" descriptors\n", cnt);
 }
 
@@ -338,7 +367,7 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 			      struct uk_netdev_tx_queue *queue,
 			      struct uk_netbuf *pkt)
 {
-	struct virtio_net_device *vndev __unused;
+	struct virtio_net_device *vndev;
 	struct virtio_net_hdr *vhdr;
 	struct virtio_net_hdr_padded *padded_hdr;
 	int16_t header_sz = sizeof(*padded_hdr);
@@ -352,6 +381,9 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	UK_ASSERT(pkt && queue);
 
 	vndev = to_virtionetdev(dev);
+	/* Multiqueue could not be enabled at start */
+	if (unlikely(queue->lqueue_id >= vndev->nb_vqueue_pairs))
+		queue = &vndev->txqs[0];
 	/**
 	 * We are reclaiming the free descriptors from buffers. The function is
 	 * not protected by means of locks. We need to be careful if there are
@@ -376,7 +408,7 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	 * Fill the virtio-net-header with the necessary information.
 	 * Zero explicitly set.
 	 */
-	memset(vhdr, 0, sizeof(*vhdr));
+	memset(vhdr, 0, vndev->hdr_len);
 	vhdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
 
 	/**
@@ -392,7 +424,7 @@ static int virtio_netdev_xmit(struct uk_netdev *dev,
 	 * 1 for the virtio header and the other for the actual network packet.
 	 */
 	/* Appending the data to the list. */
-	rc = uk_sglist_append(&queue->sg, vhdr, sizeof(*vhdr));
+	rc = uk_sglist_append(&queue->sg, vhdr, vndev->hdr_len);
 	if (unlikely(rc != 0)) {
 		uk_pr_err("Failed to append to the sg list\n");
 		goto err_remove_vhdr;
@@ -489,7 +521,7 @@ static int virtio_netdev_rxq_enqueue(struct uk_netdev_rx_queue *rxq,
 	uk_sglist_reset(sg);
 
 	/* Appending the header buffer to the sglist */
-	uk_sglist_append(sg, rxhdr, sizeof(struct virtio_net_hdr));
+	uk_sglist_append(sg, rxhdr, to_virtionetdev(rxq->ndev)->hdr_len);
 
 	/* Appending the data buffer to the sglist */
 	uk_sglist_append(sg, buf_start, buf_len);
@@ -526,7 +558,8 @@ static int virtio_netdev_rxq_dequeue(struct uk_netdev_rx_queue *rxq,
 	 * alignment of the packet data. We compensate for this, by adding the
 	 *  padding to the length on dequeue.
 	 */
-	buf->len = len + VTNET_RX_HEADER_PAD;
+	buf->len = len + sizeof(struct virtio_net_hdr_padded) -
+		   to_virtionetdev(rxq->ndev)->hdr_len;
 	rc = uk_netbuf_header(buf,
 			      -((int16_t)sizeof(struct virtio_net_hdr_padded)));
 	UK_ASSERT(rc == 1);
@@ -882,6 +915,11 @@ static int virtio_netdev_feature_negotiate(struct virtio_net_device *vndev)
 	 */
 	vndev->vdev->features &= host_features;
 	virtio_feature_set(vndev->vdev, vndev->vdev->features);
+	/* Modern devices always use the header with num_buffers */
+	vndev->hdr_len = virtio_has_features(vndev->vdev->features,
+					     VIRTIO_F_VERSION_1) ?
+			 sizeof(struct virtio_net_hdr_mrg_rxbuf) :
+			 sizeof(struct virtio_net_hdr);
 exit:
 	return rc;
 }
@@ -892,10 +930,18 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 	int rc = 0;
 	int i = 0;
 	int vq_avail = 0;
-	int total_vqs = conf->nb_rx_queues + conf->nb_tx_queues;
-	__u16 qdesc_size[total_vqs];
+	int mq = virtio_has_features(vndev->vdev->features, VIRTIO_NET_F_MQ);
+	/*
+	 * With multiqueue, the control queue follows all queue pairs of the
+	 * device, including the ones we do not use
+	 */
+	int total_vqs = mq ? 2 * vndev->dev_vqueue_pairs + 1 : 2;
+	__u16 *qdesc_size = NULL;
 
-	if (conf->nb_rx_queues != 1 || conf->nb_tx_queues != 1) {
+	/* Queues are used in pairs, steering relies on it */
+	if (conf->nb_rx_queues != conf->nb_tx_queues ||
+	    conf->nb_rx_queues < 1 ||
+	    conf->nb_rx_queues > vndev->max_vqueue_pairs) {
 		uk_pr_err("Queue combination not supported: %"__PRIu16"/%"__PRIu16" rx/tx\n",
 			  conf->nb_rx_queues, conf->nb_tx_queues);
 
@@ -917,6 +963,13 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 		goto err_free_txrx;
 	}
 
+	qdesc_size = uk_malloc(a, sizeof(*qdesc_size) * total_vqs);
+	if (unlikely(!qdesc_size)) {
+		uk_pr_err("Failed to allocate memory for queue sizes\n");
+		rc = -ENOMEM;
+		goto err_free_txrx;
+	}
+
 	vq_avail = virtio_find_vqs(vndev->vdev, total_vqs, qdesc_size);
 	if (unlikely(vq_avail != total_vqs)) {
 		uk_pr_err("Expected: %d queues, Found: %d queues\n",
@@ -934,7 +987,7 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 	 * ...
 	 * Virtqueue-ctrlq
 	 */
-	for (i = 0; i < vndev->max_vqueue_pairs; i++) {
+	for (i = 0; i < conf->nb_rx_queues; i++) {
 		/**
 		 * Initialize the received queue with the information received
 		 * from the device.
@@ -957,7 +1010,28 @@ static int virtio_netdev_rxtx_alloc(struct virtio_net_device *vndev,
 				sizeof(vndev->txqs[i].sgsegs[0])),
 			       &vndev->txqs[i].sgsegs[0]);
 	}
+	vndev->nb_vqueue_pairs = conf->nb_rx_queues;
+
+	if (mq) {
+		i = 2 * vndev->dev_vqueue_pairs;
+		/* The control queue is polled, it does not need a callback */
+		vndev->ctrlq = virtio_vqueue_setup(vndev->vdev, i,
+						   qdesc_size[i], NULL, a);
+		if (unlikely(PTRISERR(vndev->ctrlq))) {
+			uk_pr_err("Failed to set up the control queue\n");
+			rc = PTR2ERR(vndev->ctrlq);
+			vndev->ctrlq = NULL;
+			goto err_free_txrx;
+		}
+		virtqueue_intr_disable(vndev->ctrlq);
+		uk_sglist_init(&vndev->ctrl_sg,
+			       (sizeof(vndev->ctrl_sgsegs) /
+				sizeof(vndev->ctrl_sgsegs[0])),
+			       &vndev->ctrl_sgsegs[0]);
+	}
 exit:
+	if (qdesc_size)
+		uk_free(a, qdesc_size);
 	return rc;
 
 err_free_txrx:
@@ -994,8 +1068,9 @@ static int virtio_netdev_configure(struct uk_netdev *n,
 	vndev->rx_vqueue_cnt = 0;
 	vndev->tx_vqueue_cnt = 0;
 
-	uk_pr_info("Configured: features=0x%lx max_virtqueue_pairs=%"__PRIu16"\n",
-		   vndev->vdev->features, vndev->max_vqueue_pairs);
+	uk_pr_info("Configured: features=0x%lx virtqueue_pairs=%"__PRIu16"/%"__PRIu16"\n",
+		   vndev->vdev->features, vndev->nb_vqueue_pairs,
+		   vndev->max_vqueue_pairs);
 exit:
 	return rc;
 
@@ -1058,6 +1133,55 @@ static void virtio_net_info_get(struct uk_netdev *dev,
 	dev_info->features = UK_FEATURE_RXQ_INTR_AVAILABLE;
 }
 
+/**
+ * Sends a command on the control queue and waits for the device to
+ * acknowledge it. The control queue is only used during start, so it is
+ * polled instead of waiting for an interrupt. Returns -ETIMEDOUT if the
+ * device does not answer within VTNET_CTRL_TIMEOUT_MS.
+ */
+static int virtio_netdev_ctrl_send(struct virtio_net_device *vndev,
+				   __u8 class, __u8 cmd,
+				   void *data, __u16 len)
+{
+	void *cookie;
+	__u32 dlen;
+	__nsec deadline;
+	int rc;
+
+	UK_ASSERT(vndev->ctrlq);
+
+	vndev->ctrl_hdr.class = class;
+	vndev->ctrl_hdr.cmd = cmd;
+	vndev->ctrl_ack = VIRTIO_NET_ERR;
+
+	uk_sglist_reset(&vndev->ctrl_sg);
+	rc = uk_sglist_append(&vndev->ctrl_sg, &vndev->ctrl_hdr,
+			      sizeof(vndev->ctrl_hdr));
+	if (likely(rc == 0))
+		rc = uk_sglist_append(&vndev->ctrl_sg, data, len);
+	if (likely(rc == 0))
+		rc = uk_sglist_append(&vndev->ctrl_sg, &vndev->ctrl_ack,
+				      sizeof(vndev->ctrl_ack));
+	if (unlikely(rc != 0))
+		return rc;
+
+	rc = virtqueue_buffer_enqueue(vndev->ctrlq, vndev, &vndev->ctrl_sg,
+				      2, 1);
+	if (unlikely(rc < 0))
+		return rc;
+	virtqueue_host_notify(vndev->ctrlq);
+
+	deadline = ukplat_monotonic_clock()
+		   + ukarch_time_msec_to_nsec(VTNET_CTRL_TIMEOUT_MS);
+	while (virtqueue_buffer_dequeue(vndev->ctrlq, &cookie, &dlen) < 0) {
+		if (ukplat_monotonic_clock() >= deadline)
+			return -ETIMEDOUT;
+	}
+	UK_ASSERT(cookie == vndev);
+
+	return (vndev->ctrl_ack == VIRTIO_NET_OK) ? 0 : -EIO;
+}
+
 static int virtio_net_start(struct uk_netdev *n)
 {
 	struct virtio_net_device *d;
@@ -1085,6 +1209,31 @@ static int virtio_net_start(struct uk_netdev *n)
 	 * Set the DRIVER_OK status bit. At this point the device is "live".
 	 */
 	virtio_dev_drv_up(d->vdev);
+
+	/*
+	 * The device only uses the first queue pair until we tell it
+	 * otherwise. Received flows are then steered to the queue pair on
+	 * which the flow was last transmitted.
+	 */
+	if (d->nb_vqueue_pairs > 1) {
+		struct virtio_net_ctrl_mq mq;
+		int rc;
+
+		mq.virtqueue_pairs = d->nb_vqueue_pairs;
+		rc = virtio_netdev_ctrl_send(d, VIRTIO_NET_CTRL_MQ,
+					     VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET,
+					     &mq, sizeof(mq));
+		if (unlikely(rc != 0)) {
+			/*
+			 * The device keeps using the first queue pair only.
+			 * Transmissions on the other queues are redirected
+			 * to it in virtio_netdev_xmit().
+			 */
+			uk_pr_warn(DRIVER_NAME": %"__PRIu16" failed to enable %"__PRIu16" queue pairs (%d), using a single queue pair\n",
+				   d->uid, d->nb_vqueue_pairs, rc);
+			d->nb_vqueue_pairs = 1;
+		}
+	}
 	uk_pr_info(DRIVER_NAME": %"__PRIu16" started\n", d->uid);
 
 	return 0;
@@ -1092,14 +1241,48 @@ static int virtio_net_start(struct uk_netdev *n)
 
 static inline void virtio_netdev_feature_set(struct virtio_net_device *vndev)
 {
+	__u64 host_features;
+	__u16 pairs = 0;
+	int rc;
+
 	vndev->vdev->features = 0;
 	/* Setting the feature the driver support */
 	VIRTIO_NET_DRV_FEATURES(vndev->vdev->features);
+	vndev->vdev->features |= VIRTQUEUE_RING_FEATURES;
+	vndev->dev_vqueue_pairs = 1;
+	vndev->max_vqueue_pairs = 1;
+
 	/**
-	 * TODO:
-	 * Adding multiqueue support for the virtio net driver.
+	 * Multiqueue needs the control queue to select the number of queue
+	 * pairs. The driver MAY read the device configuration before
+	 * accepting the features.
 	 */
-	vndev->max_vqueue_pairs = 1;
+	host_features = virtio_feature_get(vndev->vdev);
+	if (!virtio_has_features(host_features, VIRTIO_NET_F_CTRL_VQ) ||
+	    !virtio_has_features(host_features, VIRTIO_NET_F_MQ))
+		return;
+
+	rc = virtio_config_get(vndev->vdev,
+			       __offsetof(struct virtio_net_config,
+					  max_virtqueue_pairs),
+			       &pairs, sizeof(pairs), 1);
+	if (unlikely(rc != sizeof(pairs) ||
+		     pairs < VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MIN ||
+		     pairs > VIRTIO_NET_CTRL_MQ_VQ_PAIRS_MAX)) {
+		uk_pr_warn("Invalid max_virtqueue_pairs, using a single queue pair\n");
+		return;
+	}
+
+	VIRTIO_FEATURES_UPDATE(vndev->vdev->features, VIRTIO_NET_F_CTRL_VQ);
+	VIRTIO_FEATURES_UPDATE(vndev->vdev->features, VIRTIO_NET_F_MQ);
+	/*
+	 * The control queue comes after all queue pairs of the device. Only
+	 * the first LIBUKNETDEV_MAXNBQUEUES of them are offered to the
+	 * application, virtio_net_start() enables those.
+	 */
+	vndev->dev_vqueue_pairs = pairs;
+	vndev->max_vqueue_pairs = MIN(pairs,
+				      (__u16) CONFIG_LIBUKNETDEV_MAXNBQUEUES);
 }
 
 static const struct uk_netdev_ops virtio_netdev_ops = {
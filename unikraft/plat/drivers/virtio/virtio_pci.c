@@ -42,10 +42,28 @@
 #include <virtio/virtio_bus.h>
 #include <virtio/virtqueue.h>
 #include <virtio/virtio_pci.h>
+#ifdef CONFIG_PT_API
+#include <uk/plat/mm.h>
+#endif /* CONFIG_PT_API */
 
 #define VENDOR_QUMRANET_VIRTIO           (0x1AF4)
 #define VIRTIO_PCI_MODERN_DEVICEID_START (0x1040)
 
+/**
+ * Without the page table API, only the 32-bit PCI memory hole is mapped by
+ * the boot page tables (see plat/kvm/x86/pagetable.S).
+ */
+#define VIRTIO_PCI_MMIO_HOLE_START       (0xc0000000ULL)
+#define VIRTIO_PCI_MMIO_HOLE_END         (0x100000000ULL)
+
+/* Bound on the capability list walk, a config space has 48 capabilities */
+#define VIRTIO_PCI_CAP_MAX               (48)
+
+/* Status reads after which a device that did not finish its reset is
+ * given up on
+ */
+#define VIRTIO_PCI_RESET_POLLS           (1000000)
+
 static struct uk_alloc *a;
 
 /**
@@ -60,6 +78,16 @@ struct virtio_pci_dev {
 	__u16 pci_isr_addr;
 	/* Pci device information */
 	struct pci_device *pdev;
+	/* Modern interface: mapped configuration structures */
+	void *common;
+	void *notify_base;
+	void *isr;
+	void *device;
+	__u32 device_len;
+	__u32 notify_off_mult;
+	/* Notification offsets of the virtqueues, in notify_off_mult units */
+	__u16 *notify_off;
+	__u16 num_notify_off;
 };
 
 /**
@@ -73,7 +101,7 @@ struct virtio_pci_dev {
 /**
  * Static function declaration.
  */
-static void vpci_legacy_pci_dev_reset(struct virtio_dev *vdev);
+static int vpci_legacy_pci_dev_reset(struct virtio_dev *vdev);
 static int vpci_legacy_pci_config_set(struct virtio_dev *vdev, __u16 offset,
 				      const void *buf, __u32 len);
 static int vpci_legacy_pci_config_get(struct virtio_dev *vdev, __u16 offset,
@@ -96,6 +124,30 @@ static int virtio_pci_handle(void *arg);
 static int vpci_legacy_notify(struct virtio_dev *vdev, __u16 queue_id);
 static int virtio_pci_legacy_add_dev(struct pci_device *pci_dev,
 				     struct virtio_pci_dev *vpci_dev);
+#ifdef CONFIG_VIRTIO_PCI_MODERN
+static int vpci_modern_pci_dev_reset(struct virtio_dev *vdev);
+static int vpci_modern_pci_config_set(struct virtio_dev *vdev, __u16 offset,
+				      const void *buf, __u32 len);
+static int vpci_modern_pci_config_get(struct virtio_dev *vdev, __u16 offset,
+				      void *buf, __u32 len, __u8 type_len);
+static __u64 vpci_modern_pci_features_get(struct virtio_dev *vdev);
+static void vpci_modern_pci_features_set(struct virtio_dev *vdev,
+					 __u64 features);
+static int vpci_modern_pci_vq_find(struct virtio_dev *vdev, __u16 num_vq,
+				   __u16 *qdesc_size);
+static void vpci_modern_pci_status_set(struct virtio_dev *vdev, __u8 status);
+static __u8 vpci_modern_pci_status_get(struct virtio_dev *vdev);
+static struct virtqueue *vpci_modern_vq_setup(struct virtio_dev *vdev,
+					      __u16 queue_id,
+					      __u16 num_desc,
+					      virtqueue_callback_t callback,
+					      struct uk_alloc *a);
+static void vpci_modern_vq_release(struct virtio_dev *vdev,
+		struct virtqueue *vq, struct uk_alloc *a);
+static int vpci_modern_notify(struct virtio_dev *vdev, __u16 queue_id);
+static int virtio_pci_modern_add_dev(struct pci_device *pci_dev,
+				     struct virtio_pci_dev *vpci_dev);
+#endif /* CONFIG_VIRTIO_PCI_MODERN */
 
 /**
  * Configuration operations legacy PCI device.
@@ -113,6 +165,64 @@ static struct virtio_config_ops vpci_legacy_ops = {
 	.vq_release   = vpci_legacy_vq_release,
 };
 
+#ifdef CONFIG_VIRTIO_PCI_MODERN
+/**
+ * Configuration operations modern PCI device.
+ */
+static struct virtio_config_ops vpci_modern_ops = {
+	.device_reset = vpci_modern_pci_dev_reset,
+	.config_get   = vpci_modern_pci_config_get,
+	.config_set   = vpci_modern_pci_config_set,
+	.features_get = vpci_modern_pci_features_get,
+	.features_set = vpci_modern_pci_features_set,
+	.status_get   = vpci_modern_pci_status_get,
+	.status_set   = vpci_modern_pci_status_set,
+	.vqs_find     = vpci_modern_pci_vq_find,
+	.vq_setup     = vpci_modern_vq_setup,
+	.vq_release   = vpci_modern_vq_release,
+};
+
+/**
+ * Accessors of the memory mapped configuration structures.
+ */
+static inline __u8 vpci_mmio_read8(void *base, __u32 off)
+{
+	return *(volatile __u8 *)((__u8 *) base + off);
+}
+
+static inline __u16 vpci_mmio_read16(void *base, __u32 off)
+{
+	return *(volatile __u16 *)((__u8 *) base + off);
+}
+
+static inline __u32 vpci_mmio_read32(void *base, __u32 off)
+{
+	return *(volatile __u32 *)((__u8 *) base + off);
+}
+
+static inline void vpci_mmio_write8(void *base, __u32 off, __u8 val)
+{
+	*(volatile __u8 *)((__u8 *) base + off) = val;
+}
+
+static inline void vpci_mmio_write16(void *base, __u32 off, __u16 val)
+{
+	*(volatile __u16 *)((__u8 *) base + off) = val;
+}
+
+static inline void vpci_mmio_write32(void *base, __u32 off, __u32 val)
+{
+	*(volatile __u32 *)((__u8 *) base + off) = val;
+}
+
+static inline void vpci_mmio_write64(void *base, __u32 off_lo, __u32 off_hi,
+				     __u64 val)
+{
+	vpci_mmio_write32(base, off_lo, (__u32) val);
+	vpci_mmio_write32(base, off_hi, (__u32) (val >> 32));
+}
+#endif /* CONFIG_VIRTIO_PCI_MODERN */
+
 static int vpci_legacy_notify(struct virtio_dev *vdev, __u16 queue_id)
 {
 	struct virtio_pci_dev *vpdev;
@@ -135,7 +245,13 @@ static int virtio_pci_handle(void *arg)
 	UK_ASSERT(arg);
 
 	/* Reading the isr status is used to acknowledge the interrupt */
-	isr_status = virtio_cread8((void *)(unsigned long)d->pci_isr_addr, 0);
+#ifdef CONFIG_VIRTIO_PCI_MODERN
+	if (d->isr)
+		isr_status = vpci_mmio_read8(d->isr, 0);
+	else
+#endif /* CONFIG_VIRTIO_PCI_MODERN */
+		isr_status = virtio_cread8(
+				(void *)(unsigned long)d->pci_isr_addr, 0);
 	/* We don't support configuration interrupt on the device */
 	if (isr_status & VIRTIO_PCI_ISR_CONFIG) {
 		uk_pr_warn("Unsupported config change interrupt received on virtio-pci device %p\n",
@@ -305,9 +421,10 @@ static void vpci_legacy_pci_status_set(struct virtio_dev *vdev, __u8 status)
 		       VIRTIO_PCI_STATUS, status);
 }
 
-static void vpci_legacy_pci_dev_reset(struct virtio_dev *vdev)
+static int vpci_legacy_pci_dev_reset(struct virtio_dev *vdev)
 {
 	struct virtio_pci_dev *vpdev = NULL;
+	unsigned long polls = 0;
 	__u8 status;
 
 	UK_ASSERT(vdev);
@@ -326,10 +443,16 @@ static void vpci_legacy_pci_dev_reset(struct virtio_dev *vdev)
 	 * Need to check if we have to wait for the reset to happen.
 	 */
 	do {
+		if (unlikely(polls++ == VIRTIO_PCI_RESET_POLLS)) {
+			uk_pr_err("Virtio device %p does not finish its reset\n",
+				  vdev);
+			return -ETIMEDOUT;
+		}
 		status = virtio_cread8(
 				(void *)(unsigned long)vpdev->pci_base_addr,
 				VIRTIO_PCI_STATUS);
 	} while (status != VIRTIO_CONFIG_STATUS_RESET);
+	return 0;
 }
 
 static __u64 vpci_legacy_pci_features_get(struct virtio_dev *vdev)
@@ -381,6 +504,432 @@ static int virtio_pci_legacy_add_dev(struct pci_device *pci_dev,
 	return 0;
 }
 
+#ifdef CONFIG_VIRTIO_PCI_MODERN
+static int vpci_modern_notify(struct virtio_dev *vdev, __u16 queue_id)
+{
+	struct virtio_pci_dev *vpdev;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+	UK_ASSERT(queue_id < vpdev->num_notify_off);
+	vpci_mmio_write16(vpdev->notify_base,
+			  vpdev->notify_off[queue_id] * vpdev->notify_off_mult,
+			  queue_id);
+	return 0;
+}
+
+static struct virtqueue *vpci_modern_vq_setup(struct virtio_dev *vdev,
+					      __u16 queue_id,
+					      __u16 num_desc,
+					      virtqueue_callback_t callback,
+					      struct uk_alloc *a)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	struct virtqueue *vq;
+	__phys_addr desc, driver, device;
+	long flags;
+
+	UK_ASSERT(vdev != NULL);
+
+	vpdev = to_virtiopcidev(vdev);
+	vq = virtqueue_create(queue_id, num_desc, VIRTIO_PCI_VRING_ALIGN,
+			      callback, vpci_modern_notify, vdev, a);
+	if (PTRISERR(vq)) {
+		uk_pr_err("Failed to create the virtqueue: %d\n",
+			  PTR2ERR(vq));
+		goto err_exit;
+	}
+
+	/* The rings are placed separately, the queue size may be reduced */
+	virtqueue_ring_addr(vq, &desc, &driver, &device);
+	vpci_mmio_write16(vpdev->common, VIRTIO_PCI_COMMON_Q_SELECT, queue_id);
+	vpci_mmio_write16(vpdev->common, VIRTIO_PCI_COMMON_Q_SIZE, num_desc);
+	vpci_mmio_write64(vpdev->common, VIRTIO_PCI_COMMON_Q_DESCLO,
+			  VIRTIO_PCI_COMMON_Q_DESCHI, desc);
+	vpci_mmio_write64(vpdev->common, VIRTIO_PCI_COMMON_Q_AVAILLO,
+			  VIRTIO_PCI_COMMON_Q_AVAILHI, driver);
+	vpci_mmio_write64(vpdev->common, VIRTIO_PCI_COMMON_Q_USEDLO,
+			  VIRTIO_PCI_COMMON_Q_USEDHI, device);
+	vpci_mmio_write16(vpdev->common, VIRTIO_PCI_COMMON_Q_ENABLE, 1);
+
+	flags = ukplat_lcpu_save_irqf();
+	UK_TAILQ_INSERT_TAIL(&vpdev->vdev.vqs, vq, next);
+	ukplat_lcpu_restore_irqf(flags);
+
+err_exit:
+	return vq;
+}
+
+static void vpci_modern_vq_release(struct virtio_dev *vdev,
+		struct virtqueue *vq, struct uk_alloc *a)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	long flags;
+
+	UK_ASSERT(vq != NULL);
+	UK_ASSERT(a != NULL);
+	vpdev = to_virtiopcidev(vdev);
+
+	/**
+	 * NOTE! Spec (4.1.4.3.2)
+	 * An enabled queue cannot be disabled again, only by a device reset.
+	 * The queue is released on device teardown, when the device no longer
+	 * accesses the ring.
+	 */
+	flags = ukplat_lcpu_save_irqf();
+	UK_TAILQ_REMOVE(&vpdev->vdev.vqs, vq, next);
+	ukplat_lcpu_restore_irqf(flags);
+
+	virtqueue_destroy(vq, a);
+}
+
+static int vpci_modern_pci_vq_find(struct virtio_dev *vdev, __u16 num_vqs,
+				   __u16 *qdesc_size)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	int vq_cnt = 0, i = 0, rc = 0;
+	__u16 num_queues;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+
+	if (vpdev->num_notify_off < num_vqs) {
+		uk_free(a, vpdev->notify_off);
+		vpdev->num_notify_off = 0;
+		vpdev->notify_off = uk_calloc(a, num_vqs,
+					      sizeof(*vpdev->notify_off));
+		if (!vpdev->notify_off)
+			return -ENOMEM;
+		vpdev->num_notify_off = num_vqs;
+	}
+
+	/* Registering the interrupt for the queue */
+	rc = ukplat_irq_register(vpdev->pdev->irq, virtio_pci_handle, vpdev);
+	if (rc != 0) {
+		uk_pr_err("Failed to register the interrupt\n");
+		return rc;
+	}
+
+	num_queues = vpci_mmio_read16(vpdev->common, VIRTIO_PCI_COMMON_NUMQ);
+	for (i = 0; i < num_vqs; i++) {
+		qdesc_size[i] = 0;
+		if (i < num_queues) {
+			vpci_mmio_write16(vpdev->common,
+					  VIRTIO_PCI_COMMON_Q_SELECT, i);
+			qdesc_size[i] = vpci_mmio_read16(vpdev->common,
+						VIRTIO_PCI_COMMON_Q_SIZE);
+			vpdev->notify_off[i] = vpci_mmio_read16(vpdev->common,
+						VIRTIO_PCI_COMMON_Q_NOFF);
+		}
+		if (unlikely(!qdesc_size[i])) {
+			uk_pr_err("Virtqueue %d not available\n", i);
+			continue;
+		}
+		vq_cnt++;
+	}
+	return vq_cnt;
+}
+
+static int vpci_modern_pci_config_set(struct virtio_dev *vdev, __u16 offset,
+				      const void *buf, __u32 len)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	__u32 i;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+	if (unlikely(offset + len > vpdev->device_len))
+		return -EINVAL;
+
+	for (i = 0; i < len; i++)
+		vpci_mmio_write8(vpdev->device, offset + i,
+				 ((const __u8 *) buf)[i]);
+	return 0;
+}
+
+static int vpci_modern_pci_config_get(struct virtio_dev *vdev, __u16 offset,
+				      void *buf, __u32 len, __u8 type_len)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	__u8 generation;
+	__u32 i;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+	if (unlikely(offset + len > vpdev->device_len))
+		return -EINVAL;
+	if (type_len != 1 && type_len != 2 && type_len != 4)
+		type_len = 1;
+	if (len % type_len)
+		type_len = 1;
+
+	/**
+	 * Fields are read with their natural width. The device changes the
+	 * generation if the configuration changes while we are reading it.
+	 */
+	do {
+		generation = vpci_mmio_read8(vpdev->common,
+					     VIRTIO_PCI_COMMON_CFGGENERATION);
+		for (i = 0; i < len; i += type_len) {
+			switch (type_len) {
+			case 1:
+				((__u8 *) buf)[i] = vpci_mmio_read8(
+						vpdev->device, offset + i);
+				break;
+			case 2:
+				((__u16 *) buf)[i / 2] = vpci_mmio_read16(
+						vpdev->device, offset + i);
+				break;
+			default:
+				((__u32 *) buf)[i / 4] = vpci_mmio_read32(
+						vpdev->device, offset + i);
+				break;
+			}
+		}
+	} while (generation != vpci_mmio_read8(vpdev->common,
+					VIRTIO_PCI_COMMON_CFGGENERATION));
+	/* Like the legacy interface, report the bytes read */
+	return len;
+}
+
+static __u8 vpci_modern_pci_status_get(struct virtio_dev *vdev)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+	return vpci_mmio_read8(vpdev->common, VIRTIO_PCI_COMMON_STATUS);
+}
+
+static void vpci_modern_pci_status_set(struct virtio_dev *vdev, __u8 status)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+
+	/* Reset should be performed using the reset interface */
+	UK_ASSERT(vdev || status != VIRTIO_CONFIG_STATUS_RESET);
+
+	vpdev = to_virtiopcidev(vdev);
+	status |= vpci_modern_pci_status_get(vdev);
+	vpci_mmio_write8(vpdev->common, VIRTIO_PCI_COMMON_STATUS, status);
+}
+
+static int vpci_modern_pci_dev_reset(struct virtio_dev *vdev)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	unsigned long polls;
+
+	UK_ASSERT(vdev);
+
+	vpdev = to_virtiopcidev(vdev);
+	vpci_mmio_write8(vpdev->common, VIRTIO_PCI_COMMON_STATUS,
+			 VIRTIO_CONFIG_STATUS_RESET);
+	/* The device has completed the reset when the status reads back 0 */
+	for (polls = 0; polls < VIRTIO_PCI_RESET_POLLS; polls++) {
+		if (vpci_mmio_read8(vpdev->common, VIRTIO_PCI_COMMON_STATUS)
+		    == VIRTIO_CONFIG_STATUS_RESET)
+			return 0;
+	}
+	uk_pr_err("Virtio device %p does not finish its reset\n", vdev);
+	return -ETIMEDOUT;
+}
+
+static __u64 vpci_modern_pci_features_get(struct virtio_dev *vdev)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+	__u64 features;
+
+	UK_ASSERT(vdev);
+
+	vpdev = to_virtiopcidev(vdev);
+	vpci_mmio_write32(vpdev->common, VIRTIO_PCI_COMMON_DFSELECT, 0);
+	features = vpci_mmio_read32(vpdev->common, VIRTIO_PCI_COMMON_DF);
+	vpci_mmio_write32(vpdev->common, VIRTIO_PCI_COMMON_DFSELECT, 1);
+	features |= (__u64) vpci_mmio_read32(vpdev->common,
+					     VIRTIO_PCI_COMMON_DF) << 32;
+	return features;
+}
+
+static void vpci_modern_pci_features_set(struct virtio_dev *vdev,
+					 __u64 features)
+{
+	struct virtio_pci_dev *vpdev = NULL;
+
+	UK_ASSERT(vdev);
+	vpdev = to_virtiopcidev(vdev);
+	/**
+	 * Mask out features not supported by the virtqueue driver. We drive
+	 * the device through the modern interface, so we must accept
+	 * VIRTIO_F_VERSION_1. The drivers learn about it from vdev->features.
+	 */
+	features = virtqueue_feature_negotiate(features);
+	features |= (1ULL << VIRTIO_F_VERSION_1);
+	vdev->features = features;
+
+	vpci_mmio_write32(vpdev->common, VIRTIO_PCI_COMMON_GFSELECT, 0);
+	vpci_mmio_write32(vpdev->common, VIRTIO_PCI_COMMON_GF,
+			  (__u32) features);
+	vpci_mmio_write32(vpdev->common, VIRTIO_PCI_COMMON_GFSELECT, 1);
+	vpci_mmio_write32(vpdev->common, VIRTIO_PCI_COMMON_GF,
+			  (__u32) (features >> 32));
+
+	vpci_modern_pci_status_set(vdev, VIRTIO_CONFIG_STATUS_FEATURES_OK);
+	if (!(vpci_modern_pci_status_get(vdev) &
+	      VIRTIO_CONFIG_STATUS_FEATURES_OK))
+		uk_pr_err("Virtio-pci device rejected features 0x%"__PRIx64"\n",
+			  features);
+}
+
+/**
+ * Make the memory range of a configuration structure accessible.
+ */
+static int vpci_modern_map(__u64 addr, __u32 len)
+{
+#ifdef CONFIG_PT_API
+	unsigned long start = PAGE_ALIGN_DOWN(addr);
+	unsigned long pages = DIV_ROUND_UP(addr + len - start, PAGE_SIZE);
+
+	if (uk_map_region(start, start, pages,
+			  PAGE_PROT_READ | PAGE_PROT_WRITE, 0))
+		return -ENOMEM;
+	return 0;
+#else
+	if (addr < VIRTIO_PCI_MMIO_HOLE_START ||
+	    addr + len > VIRTIO_PCI_MMIO_HOLE_END)
+		return -ENOTSUP;
+	return 0;
+#endif /* CONFIG_PT_API */
+}
+
+/**
+ * Locate the structure described by the virtio capability at `pos`.
+ *
+ * @return
+ *	The address of the structure, NULL if it is not accessible.
+ */
+static void *vpci_modern_map_cap(struct pci_device *pci_dev, __u8 pos,
+				 __u32 min_len, __u32 *len)
+{
+	__u8 bar;
+	__u32 bar_lo, offset;
+	__u64 addr;
+
+	bar = pci_conf_read8(pci_dev, pos + VIRTIO_PCI_CAP_BAR);
+	offset = pci_conf_read32(pci_dev, pos + VIRTIO_PCI_CAP_OFFSET);
+	*len = pci_conf_read32(pci_dev, pos + VIRTIO_PCI_CAP_LENGTH);
+	if (bar > 5 || *len < min_len)
+		return NULL;
+
+	/* The structures are only supported in memory BARs */
+	bar_lo = pci_conf_read32(pci_dev, PCI_CFG_BAR(bar));
+	if (bar_lo & PCI_CFG_BAR_IO)
+		return NULL;
+	addr = bar_lo & PCI_CFG_BAR_MEM_MASK;
+	if ((bar_lo & PCI_CFG_BAR_MEM_TYPE_MASK) == PCI_CFG_BAR_MEM_TYPE_64
+	    && bar < 5)
+		addr |= (__u64) pci_conf_read32(pci_dev,
+						PCI_CFG_BAR(bar + 1)) << 32;
+	if (!addr)
+		return NULL;
+
+	addr += offset;
+	if (vpci_modern_map(addr, *len) < 0) {
+		uk_pr_warn("Virtio-pci structure at 0x%"__PRIx64" is not mapped\n",
+			   addr);
+		return NULL;
+	}
+	return (void *) (unsigned long) addr;
+}
+
+static int virtio_pci_modern_add_dev(struct pci_device *pci_dev,
+				     struct virtio_pci_dev *vpci_dev)
+{
+	__u8 pos, cfg_type;
+	__u16 cmd;
+	__u32 len;
+	int i;
+
+	if (!(pci_conf_read16(pci_dev, PCI_CFG_STATUS) &
+	      PCI_CFG_STATUS_CAP_LIST))
+		return -ENODEV;
+
+	/**
+	 * We use the first capability of each type that we can access, as
+	 * recommended by the specification (4.1.4.1).
+	 */
+	pos = pci_conf_read8(pci_dev, PCI_CFG_CAP_PTR) & ~0x3;
+	for (i = 0; pos && i < VIRTIO_PCI_CAP_MAX; i++) {
+		if (pci_conf_read8(pci_dev, pos + PCI_CAP_ID) !=
+		    PCI_CAP_ID_VNDR)
+			goto next;
+
+		cfg_type = pci_conf_read8(pci_dev,
+					  pos + VIRTIO_PCI_CAP_CFG_TYPE);
+		switch (cfg_type) {
+		case VIRTIO_PCI_CAP_COMMON_CFG:
+			if (!vpci_dev->common)
+				vpci_dev->common = vpci_modern_map_cap(pci_dev,
+					pos, VIRTIO_PCI_COMMON_CFG_LEN, &len);
+			break;
+		case VIRTIO_PCI_CAP_NOTIFY_CFG:
+			if (!vpci_dev->notify_base) {
+				vpci_dev->notify_base = vpci_modern_map_cap(
+						pci_dev, pos, 2, &len);
+				vpci_dev->notify_off_mult = pci_conf_read32(
+					pci_dev,
+					pos + VIRTIO_PCI_NOTIFY_CAP_MULT);
+			}
+			break;
+		case VIRTIO_PCI_CAP_ISR_CFG:
+			if (!vpci_dev->isr)
+				vpci_dev->isr = vpci_modern_map_cap(pci_dev,
+								pos, 1, &len);
+			break;
+		case VIRTIO_PCI_CAP_DEVICE_CFG:
+			if (!vpci_dev->device) {
+				vpci_dev->device = vpci_modern_map_cap(pci_dev,
+								pos, 0, &len);
+				vpci_dev->device_len = vpci_dev->device ?
+						       len : 0;
+			}
+			break;
+		default:
+			break;
+		}
+next:
+		pos = pci_conf_read8(pci_dev, pos + PCI_CAP_NEXT) & ~0x3;
+	}
+
+	/* The device specific configuration is optional */
+	if (!vpci_dev->common || !vpci_dev->notify_base || !vpci_dev->isr) {
+		vpci_dev->common = NULL;
+		vpci_dev->notify_base = NULL;
+		vpci_dev->isr = NULL;
+		vpci_dev->device = NULL;
+		vpci_dev->device_len = 0;
+		return -ENODEV;
+	}
+
+	/* The device accesses the rings by DMA */
+	cmd = pci_conf_read16(pci_dev, PCI_CFG_COMMAND);
+	cmd |= PCI_CFG_COMMAND_MEMORY | PCI_CFG_COMMAND_MASTER;
+	pci_conf_write16(pci_dev, PCI_CFG_COMMAND, cmd);
+
+	/* Setting the configuration operation */
+	vpci_dev->vdev.cops = &vpci_modern_ops;
+
+	uk_pr_info("Added virtio-pci device %04x (modern)\n",
+		   pci_dev->id.device_id);
+
+	/* Mapping the virtio device identifier */
+	if (pci_dev->id.device_id >= VIRTIO_PCI_MODERN_DEVICEID_START)
+		vpci_dev->vdev.id.virtio_device_id = pci_dev->id.device_id -
+			VIRTIO_PCI_MODERN_DEVICEID_START;
+	else
+		vpci_dev->vdev.id.virtio_device_id =
+			pci_dev->id.subsystem_device_id;
+	return 0;
+}
+#endif /* CONFIG_VIRTIO_PCI_MODERN */
 
 static int virtio_pci_add_dev(struct pci_device *pci_dev)
 {
@@ -389,7 +938,7 @@ static int virtio_pci_add_dev(struct pci_device *pci_dev)
 
 	UK_ASSERT(pci_dev != NULL);
 
-	vpci_dev = uk_malloc(a, sizeof(*vpci_dev));
+	vpci_dev = uk_calloc(a, 1, sizeof(*vpci_dev));
 	if (!vpci_dev) {
 		uk_pr_err("Failed to allocate virtio-pci device\n");
 		return -ENOMEM;
@@ -400,16 +949,26 @@ static int virtio_pci_add_dev(struct pci_device *pci_dev)
 	vpci_dev->pci_base_addr = pci_dev->base;
 
 	/**
-	 * Probing for the legacy virtio device. We separate the legacy probing
-	 * with the possibility of supporting the modern PCI device in the
-	 * future.
+	 * Transitional devices implement both interfaces. We prefer the
+	 * modern interface and fall back to the legacy one if the device does
+	 * not provide it or we cannot access it.
 	 */
+#ifdef CONFIG_VIRTIO_PCI_MODERN
+	rc = virtio_pci_modern_add_dev(pci_dev, vpci_dev);
+	if (rc == 0)
+		goto register_dev;
+	uk_pr_debug("No modern interface on pci device %04x: %d\n",
+		    pci_dev->id.device_id, rc);
+#endif /* CONFIG_VIRTIO_PCI_MODERN */
 	rc = virtio_pci_legacy_add_dev(pci_dev, vpci_dev);
 	if (rc != 0) {
 		uk_pr_err("Failed to probe (legacy) pci device: %d\n", rc);
 		goto free_pci_dev;
 	}
 
+#ifdef CONFIG_VIRTIO_PCI_MODERN
+register_dev:
+#endif /* CONFIG_VIRTIO_PCI_MODERN */
 	rc = virtio_bus_register_device(&vpci_dev->vdev);
 	if (rc != 0) {
 		uk_pr_err("Failed to register the virtio device: %d\n", rc);
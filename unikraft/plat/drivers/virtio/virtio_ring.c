@@ -43,28 +43,58 @@
 #include <uk/plat/io.h>
 #include <virtio/virtio_ring.h>
 #include <virtio/virtqueue.h>
+#include <virtio/virtio_bus.h>
 
 #define VIRTQUEUE_MAX_SIZE  32768
+/**
+ * Maximum number of segments of a buffer that is put into an indirect
+ * descriptor table. Larger buffers are chained in the ring.
+ */
+#define VIRTQUEUE_INDIRECT_MAX	16
 #define to_virtqueue_vring(vq)			\
 	__containerof(vq, struct virtqueue_vring, vq)
 
 struct virtqueue_desc_info {
 	void *cookie;
 	__u16 desc_count;
+	/* Next free buffer id (packed ring) */
+	__u16 next;
 };
 
 struct virtqueue_vring {
 	struct virtqueue vq;
 	/* Descriptor Ring */
 	struct vring vring;
+	/* Packed descriptor ring, used instead of vring if `packed` is set */
+	struct vring_packed pring;
+	__u8 packed;
 	/* Reference to the vring */
 	void   *vring_mem;
 	/* Keep track of available descriptors */
 	__u16 desc_avail;
-	/* Index of the next available slot */
+	/* Index of the next available slot (packed ring: next free id) */
 	__u16 head_free_desc;
 	/* Index of the last used descriptor by the host */
 	__u16 last_used_desc_idx;
+	/* Index of the next descriptor to make available (packed ring) */
+	__u16 next_avail_idx;
+	/* Descriptors made available since the last notification (packed) */
+	__u16 num_added;
+	/* Wrap counters of the driver and of the device (packed ring) */
+	__u8 avail_wrap;
+	__u8 used_wrap;
+	/* Available index at the last host notification (EVENT_IDX) */
+	__u16 last_notify_idx;
+	/* VIRTIO_F_EVENT_IDX was negotiated */
+	__u8 event_idx;
+	/* Interrupts are enabled (EVENT_IDX) */
+	__u8 intr_enabled;
+	/**
+	 * Indirect descriptor tables, VIRTQUEUE_INDIRECT_MAX entries for each
+	 * descriptor of the ring (packed ring: for each buffer id). NULL
+	 * without VIRTIO_F_INDIRECT_DESC.
+	 */
+	struct vring_desc *indirect;
 	/* Cookie to identify driver buffer */
 	struct virtqueue_desc_info vq_info[];
 };
@@ -82,8 +112,26 @@ static inline int virtqueue_buffer_enqueue_segments(
 						    struct uk_sglist *sg,
 						    __u16 read_bufs,
 						    __u16 write_bufs);
+static inline int virtqueue_buffer_enqueue_indirect(
+						    struct virtqueue_vring *vrq,
+						    __u16 head,
+						    struct uk_sglist *sg,
+						    __u16 read_bufs,
+						    __u16 write_bufs);
 static void virtqueue_vring_init(struct virtqueue_vring *vrq, __u16 nr_desc,
 				 __u16 align);
+static inline int virtqueue_packed_hasdata(struct virtqueue_vring *vrq);
+static void virtqueue_packed_intr_disable(struct virtqueue_vring *vrq);
+static int virtqueue_packed_intr_enable(struct virtqueue_vring *vrq);
+static int virtqueue_packed_notify_enabled(struct virtqueue_vring *vrq);
+static int virtqueue_packed_dequeue(struct virtqueue_vring *vrq,
+				    void **cookie, __u32 *len);
+static void virtqueue_packed_enqueue(struct virtqueue_vring *vrq,
+				     void *cookie, struct uk_sglist *sg,
+				     __u16 read_bufs, __u16 write_bufs,
+				     int indirect);
+static void virtqueue_packed_init(struct virtqueue_vring *vrq,
+				  __u16 nr_desc);
 
 /**
  * Driver implementation
@@ -95,6 +143,20 @@ void virtqueue_intr_disable(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
+	if (vrq->packed) {
+		virtqueue_packed_intr_disable(vrq);
+		return;
+	}
+	if (vrq->event_idx) {
+		/**
+		 * The device ignores the flags with EVENT_IDX. Move the used
+		 * event behind the last used index so that it is not crossed
+		 * until the index wraps around.
+		 */
+		vrq->intr_enabled = 0;
+		vring_used_event(&vrq->vring) = vrq->last_used_desc_idx - 1;
+		return;
+	}
 	vrq->vring.avail->flags |= (VRING_AVAIL_F_NO_INTERRUPT);
 }
 
@@ -106,6 +168,20 @@ int virtqueue_intr_enable(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
+	if (vrq->packed)
+		return virtqueue_packed_intr_enable(vrq);
+	if (vrq->event_idx) {
+		/* Request an interrupt for the next used descriptor */
+		vrq->intr_enabled = 1;
+		vring_used_event(&vrq->vring) = vrq->last_used_desc_idx;
+		mb();
+		if (virtqueue_hasdata(vq)) {
+			virtqueue_intr_disable(vq);
+			rc = 1;
+		}
+		return rc;
+	}
+
 	/* Check if there are no more packets enabled */
 	if (!virtqueue_hasdata(vq)) {
 		if (vrq->vring.avail->flags | VRING_AVAIL_F_NO_INTERRUPT) {
@@ -180,10 +256,25 @@ static inline void virtqueue_detach_desc(struct virtqueue_vring *vrq,
 int virtqueue_notify_enabled(struct virtqueue *vq)
 {
 	struct virtqueue_vring *vrq;
+	__u16 old_idx, new_idx;
 
 	UK_ASSERT(vq);
 	vrq = to_virtqueue_vring(vq);
 
+	if (vrq->packed)
+		return virtqueue_packed_notify_enabled(vrq);
+	if (vrq->event_idx) {
+		/**
+		 * Notify only if the host asked for an event at an available
+		 * index that we passed since the last notification.
+		 */
+		old_idx = vrq->last_notify_idx;
+		new_idx = vrq->vring.avail->idx;
+		vrq->last_notify_idx = new_idx;
+		return vring_need_event(vring_avail_event(&vrq->vring),
+					new_idx, old_idx);
+	}
+
 	return ((vrq->vring.used->flags & VRING_USED_F_NO_NOTIFY) == 0);
 }
 
@@ -213,6 +304,40 @@ static inline int virtqueue_buffer_enqueue_segments(
 	return idx;
 }
 
+/**
+ * Put the segments into the indirect table of the head descriptor, so that
+ * the whole buffer takes a single descriptor of the ring.
+ */
+static inline int virtqueue_buffer_enqueue_indirect(
+		struct virtqueue_vring *vrq,
+		__u16 head, struct uk_sglist *sg, __u16 read_bufs,
+		__u16 write_bufs)
+{
+	int i = 0, total_desc = 0;
+	struct uk_sglist_seg *segs;
+	struct vring_desc *table;
+
+	total_desc = read_bufs + write_bufs;
+	table = &vrq->indirect[head * VIRTQUEUE_INDIRECT_MAX];
+
+	for (i = 0; i < total_desc; i++) {
+		segs = &sg->sg_segs[i];
+		table[i].addr = segs->ss_paddr;
+		table[i].len = segs->ss_len;
+		table[i].flags = 0;
+		table[i].next = i + 1;
+		if (i >= read_bufs)
+			table[i].flags |= VRING_DESC_F_WRITE;
+		if (i < total_desc - 1)
+			table[i].flags |= VRING_DESC_F_NEXT;
+	}
+
+	vrq->vring.desc[head].addr = ukplat_virt_to_phys(table);
+	vrq->vring.desc[head].len = total_desc * sizeof(*table);
+	vrq->vring.desc[head].flags = VRING_DESC_F_INDIRECT;
+	return vrq->vring.desc[head].next;
+}
+
 int virtqueue_hasdata(struct virtqueue *vq)
 {
 	struct virtqueue_vring *vring;
@@ -220,6 +345,8 @@ int virtqueue_hasdata(struct virtqueue *vq)
 	UK_ASSERT(vq);
 
 	vring = to_virtqueue_vring(vq);
+	if (vring->packed)
+		return virtqueue_packed_hasdata(vring);
 	return (vring->last_used_desc_idx != vring->vring.used->idx);
 }
 
@@ -228,9 +355,10 @@ __u64 virtqueue_feature_negotiate(__u64 feature_set)
 	__u64 feature = (1ULL << VIRTIO_TRANSPORT_F_START) - 1;
 
 	/**
-	 * Currently out vring driver does not support any ring feature. We will
-	 * add support to transport feature in the future.
+	 * Of the transport features, our vring driver only supports the ring
+	 * features it implements.
 	 */
+	feature |= VIRTQUEUE_RING_FEATURES;
 	feature &= feature_set;
 	return feature;
 }
@@ -260,6 +388,25 @@ __phys_addr virtqueue_physaddr(struct virtqueue *vq)
 	return ukplat_virt_to_phys(vrq->vring_mem);
 }
 
+void virtqueue_ring_addr(struct virtqueue *vq, __phys_addr *desc,
+			 __phys_addr *driver, __phys_addr *device)
+{
+	struct virtqueue_vring *vrq;
+
+	UK_ASSERT(vq && desc && driver && device);
+
+	vrq = to_virtqueue_vring(vq);
+	if (vrq->packed) {
+		*desc = ukplat_virt_to_phys(vrq->pring.desc);
+		*driver = ukplat_virt_to_phys(vrq->pring.driver);
+		*device = ukplat_virt_to_phys(vrq->pring.device);
+	} else {
+		*desc = ukplat_virt_to_phys(vrq->vring.desc);
+		*driver = ukplat_virt_to_phys(vrq->vring.avail);
+		*device = ukplat_virt_to_phys(vrq->vring.used);
+	}
+}
+
 int virtqueue_buffer_dequeue(struct virtqueue *vq, void **cookie, __u32 *len)
 {
 	struct virtqueue_vring *vrq = NULL;
@@ -270,6 +417,9 @@ int virtqueue_buffer_dequeue(struct virtqueue *vq, void **cookie, __u32 *len)
 	UK_ASSERT(cookie);
 	vrq = to_virtqueue_vring(vq);
 
+	if (vrq->packed)
+		return virtqueue_packed_dequeue(vrq, cookie, len);
+
 	/* No new descriptor since last dequeue operation */
 	if (!virtqueue_hasdata(vq))
 		return -ENOMSG;
@@ -286,6 +436,9 @@ int virtqueue_buffer_dequeue(struct virtqueue *vq, void **cookie, __u32 *len)
 	*cookie = vrq->vq_info[head_idx].cookie;
 	virtqueue_detach_desc(vrq, head_idx);
 	vrq->vq_info[head_idx].cookie = NULL;
+	/* Keep the interrupt armed for the next used descriptor */
+	if (vrq->event_idx && vrq->intr_enabled)
+		vring_used_event(&vrq->vring) = vrq->last_used_desc_idx;
 	return (vrq->vring.num - vrq->desc_avail);
 }
 
@@ -293,41 +446,58 @@ int virtqueue_buffer_enqueue(struct virtqueue *vq, void *cookie,
 			     struct uk_sglist *sg, __u16 read_bufs,
 			     __u16 write_bufs)
 {
-	__u32 total_desc = 0;
+	__u32 total_desc = 0, ring_desc = 0;
 	__u16 head_idx = 0, idx = 0;
 	struct virtqueue_vring *vrq = NULL;
+	int indirect;
 
 	UK_ASSERT(vq);
 
 	vrq = to_virtqueue_vring(vq);
 	total_desc = read_bufs + write_bufs;
-	if (unlikely(total_desc < 1 || total_desc > vrq->vring.num)) {
+	/* A single segment is cheaper to put directly into the ring */
+	indirect = vrq->indirect && total_desc > 1 &&
+		   total_desc <= VIRTQUEUE_INDIRECT_MAX;
+	ring_desc = indirect ? 1 : total_desc;
+	if (unlikely(total_desc < 1 ||
+		     ring_desc > (vrq->packed ? vrq->pring.num
+					      : vrq->vring.num))) {
 		uk_pr_err("%"__PRIu32" invalid number of descriptor\n",
 			  total_desc);
 		return -EINVAL;
-	} else if (vrq->desc_avail < total_desc) {
+	} else if (vrq->desc_avail < ring_desc) {
 		uk_pr_err("Available descriptor:%"__PRIu16", Requested descriptor:%"__PRIu32"\n",
-			  vrq->desc_avail, total_desc);
+			  vrq->desc_avail, ring_desc);
 		return -ENOSPC;
 	}
+	UK_ASSERT(cookie);
+	if (vrq->packed) {
+		virtqueue_packed_enqueue(vrq, cookie, sg, read_bufs,
+					 write_bufs, indirect);
+		return vrq->desc_avail;
+	}
+
 	/* Get the head of free descriptor */
 	head_idx = vrq->head_free_desc;
-	UK_ASSERT(cookie);
 	/* Additional information to reconstruct the data buffer */
 	vrq->vq_info[head_idx].cookie = cookie;
-	vrq->vq_info[head_idx].desc_count = total_desc;
+	vrq->vq_info[head_idx].desc_count = ring_desc;
 
 	/**
 	 * We separate the descriptor management to enqueue segment(s).
 	 */
-	idx = virtqueue_buffer_enqueue_segments(vrq, head_idx, sg,
-			read_bufs, write_bufs);
+	if (indirect)
+		idx = virtqueue_buffer_enqueue_indirect(vrq, head_idx, sg,
+				read_bufs, write_bufs);
+	else
+		idx = virtqueue_buffer_enqueue_segments(vrq, head_idx, sg,
+				read_bufs, write_bufs);
 	/* Metadata maintenance for the virtqueue */
 	vrq->head_free_desc = idx;
-	vrq->desc_avail -= total_desc;
+	vrq->desc_avail -= ring_desc;
 
-	uk_pr_debug("Old head:%d, new head:%d, total_desc:%d\n",
-		    head_idx, idx, total_desc);
+	uk_pr_debug("Old head:%d, new head:%d, total_desc:%d%s\n",
+		    head_idx, idx, total_desc, indirect ? " (indirect)" : "");
 
 	virtqueue_ring_update_avail(vrq, head_idx);
 	return vrq->desc_avail;
@@ -343,6 +513,8 @@ static void virtqueue_vring_init(struct virtqueue_vring *vrq, __u16 nr_desc,
 	vrq->desc_avail = vrq->vring.num;
 	vrq->head_free_desc = 0;
 	vrq->last_used_desc_idx = 0;
+	vrq->last_notify_idx = 0;
+	vrq->intr_enabled = 1;
 	for (i = 0; i < nr_desc - 1; i++)
 		vrq->vring.desc[i].next = i + 1;
 	/**
@@ -352,6 +524,217 @@ static void virtqueue_vring_init(struct virtqueue_vring *vrq, __u16 nr_desc,
 	vrq->vring.desc[nr_desc - 1].next = VIRTQUEUE_MAX_SIZE;
 }
 
+/**
+ * Packed ring implementation
+ */
+
+/* AVAIL and USED flags of a descriptor made available at wrap counter `wrap` */
+static inline __u16 virtqueue_packed_avail_flags(__u8 wrap)
+{
+	return wrap ? (1 << VRING_PACKED_DESC_F_AVAIL)
+		    : (1 << VRING_PACKED_DESC_F_USED);
+}
+
+static inline __u16 virtqueue_packed_off_wrap(struct virtqueue_vring *vrq)
+{
+	return vrq->last_used_desc_idx |
+		(vrq->used_wrap << VRING_PACKED_EVENT_F_WRAP_CTR);
+}
+
+static inline int virtqueue_packed_hasdata(struct virtqueue_vring *vrq)
+{
+	__u16 flags = vrq->pring.desc[vrq->last_used_desc_idx].flags;
+	__u8 avail = !!(flags & (1 << VRING_PACKED_DESC_F_AVAIL));
+	__u8 used = !!(flags & (1 << VRING_PACKED_DESC_F_USED));
+
+	/* The device flips USED to match AVAIL, both at the used wrap */
+	return (avail == used && used == vrq->used_wrap);
+}
+
+static void virtqueue_packed_intr_disable(struct virtqueue_vring *vrq)
+{
+	vrq->intr_enabled = 0;
+	vrq->pring.driver->flags = VRING_PACKED_EVENT_FLAG_DISABLE;
+}
+
+static int virtqueue_packed_intr_enable(struct virtqueue_vring *vrq)
+{
+	vrq->intr_enabled = 1;
+	if (vrq->event_idx) {
+		/* Request an interrupt for the next used descriptor */
+		vrq->pring.driver->off_wrap = virtqueue_packed_off_wrap(vrq);
+		wmb();
+		vrq->pring.driver->flags = VRING_PACKED_EVENT_FLAG_DESC;
+	} else {
+		vrq->pring.driver->flags = VRING_PACKED_EVENT_FLAG_ENABLE;
+	}
+	/* See virtqueue_intr_enable() */
+	mb();
+	if (virtqueue_packed_hasdata(vrq)) {
+		virtqueue_packed_intr_disable(vrq);
+		return 1;
+	}
+	return 0;
+}
+
+static int virtqueue_packed_notify_enabled(struct virtqueue_vring *vrq)
+{
+	__u16 flags, off_wrap, event_idx, old_idx, new_idx;
+
+	new_idx = vrq->next_avail_idx;
+	old_idx = new_idx - vrq->num_added;
+	vrq->num_added = 0;
+
+	/* Make the descriptors visible before reading the device's event */
+	mb();
+	flags = vrq->pring.device->flags;
+	if (flags != VRING_PACKED_EVENT_FLAG_DESC)
+		return (flags != VRING_PACKED_EVENT_FLAG_DISABLE);
+
+	/**
+	 * The event index refers to the ring lap given by its wrap counter.
+	 * Move an event of the previous lap one ring size back, so that it
+	 * compares to the free running indexes.
+	 */
+	off_wrap = vrq->pring.device->off_wrap;
+	event_idx = off_wrap & ~(1 << VRING_PACKED_EVENT_F_WRAP_CTR);
+	if ((off_wrap >> VRING_PACKED_EVENT_F_WRAP_CTR) != vrq->avail_wrap)
+		event_idx -= vrq->pring.num;
+	return vring_need_event(event_idx, new_idx, old_idx);
+}
+
+static int virtqueue_packed_dequeue(struct virtqueue_vring *vrq,
+				    void **cookie, __u32 *len)
+{
+	struct vring_packed_desc *desc;
+	struct virtqueue_desc_info *vq_info;
+	__u16 id;
+
+	if (!virtqueue_packed_hasdata(vrq))
+		return -ENOMSG;
+	/**
+	 * We are reading the used descriptor written by the host after its
+	 * flags.
+	 */
+	rmb();
+	desc = &vrq->pring.desc[vrq->last_used_desc_idx];
+	id = desc->id;
+	UK_ASSERT(id < vrq->pring.num);
+	if (len)
+		*len = desc->len;
+
+	vq_info = &vrq->vq_info[id];
+	*cookie = vq_info->cookie;
+	vq_info->cookie = NULL;
+
+	/* The used descriptor replaces all descriptors of the buffer */
+	vrq->desc_avail += vq_info->desc_count;
+	vrq->last_used_desc_idx += vq_info->desc_count;
+	if (vrq->last_used_desc_idx >= vrq->pring.num) {
+		vrq->last_used_desc_idx -= vrq->pring.num;
+		vrq->used_wrap ^= 1;
+	}
+	vq_info->next = vrq->head_free_desc;
+	vrq->head_free_desc = id;
+
+	/* Keep the interrupt armed for the next used descriptor */
+	if (vrq->event_idx && vrq->intr_enabled)
+		vrq->pring.driver->off_wrap = virtqueue_packed_off_wrap(vrq);
+	return (vrq->pring.num - vrq->desc_avail);
+}
+
+/**
+ * Write the descriptors of a buffer to the ring. The flags of the first
+ * descriptor are written last, as they make the whole buffer available to
+ * the device.
+ */
+static void virtqueue_packed_enqueue(struct virtqueue_vring *vrq,
+				     void *cookie, struct uk_sglist *sg,
+				     __u16 read_bufs, __u16 write_bufs,
+				     int indirect)
+{
+	struct vring_packed_desc *desc, *table = NULL;
+	struct uk_sglist_seg *segs;
+	__u16 id, idx, head_idx, head_flags = 0, flags;
+	int i, total_desc;
+
+	total_desc = read_bufs + write_bufs;
+	id = vrq->head_free_desc;
+	head_idx = idx = vrq->next_avail_idx;
+
+	if (indirect) {
+		/* The tables have the same layout as the split ring's */
+		table = (struct vring_packed_desc *)
+			&vrq->indirect[id * VIRTQUEUE_INDIRECT_MAX];
+		for (i = 0; i < total_desc; i++) {
+			segs = &sg->sg_segs[i];
+			table[i].addr = segs->ss_paddr;
+			table[i].len = segs->ss_len;
+			table[i].id = 0;
+			table[i].flags = (i >= read_bufs) ?
+					 VRING_DESC_F_WRITE : 0;
+		}
+	}
+
+	for (i = 0; i < (indirect ? 1 : total_desc); i++) {
+		desc = &vrq->pring.desc[idx];
+		if (indirect) {
+			desc->addr = ukplat_virt_to_phys(table);
+			desc->len = total_desc * sizeof(*table);
+			flags = VRING_DESC_F_INDIRECT;
+		} else {
+			segs = &sg->sg_segs[i];
+			desc->addr = segs->ss_paddr;
+			desc->len = segs->ss_len;
+			flags = 0;
+			if (i >= read_bufs)
+				flags |= VRING_DESC_F_WRITE;
+			if (i < total_desc - 1)
+				flags |= VRING_DESC_F_NEXT;
+		}
+		desc->id = id;
+		flags |= virtqueue_packed_avail_flags(vrq->avail_wrap);
+		if (i == 0)
+			head_flags = flags;
+		else
+			desc->flags = flags;
+
+		if (++idx >= vrq->pring.num) {
+			idx = 0;
+			vrq->avail_wrap ^= 1;
+		}
+	}
+
+	vrq->vq_info[id].cookie = cookie;
+	vrq->vq_info[id].desc_count = indirect ? 1 : total_desc;
+	vrq->head_free_desc = vrq->vq_info[id].next;
+	vrq->desc_avail -= vrq->vq_info[id].desc_count;
+	vrq->num_added += vrq->vq_info[id].desc_count;
+	vrq->next_avail_idx = idx;
+
+	/* Publish the descriptors before making the buffer available */
+	wmb();
+	vrq->pring.desc[head_idx].flags = head_flags;
+}
+
+static void virtqueue_packed_init(struct virtqueue_vring *vrq, __u16 nr_desc)
+{
+	int i;
+
+	vring_packed_init(&vrq->pring, nr_desc, vrq->vring_mem);
+
+	vrq->desc_avail = nr_desc;
+	vrq->head_free_desc = 0;
+	vrq->last_used_desc_idx = 0;
+	vrq->next_avail_idx = 0;
+	vrq->num_added = 0;
+	vrq->avail_wrap = 1;
+	vrq->used_wrap = 1;
+	vrq->intr_enabled = 1;
+	for (i = 0; i < nr_desc; i++)
+		vrq->vq_info[i].next = i + 1;
+}
+
 struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 				   virtqueue_callback_t callback,
 				   virtqueue_notify_host_t notify,
@@ -377,8 +760,28 @@ struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 	 * allocation.
 	 */
 	vrq->vring_mem = NULL;
+	vrq->indirect = NULL;
+	vrq->event_idx = vdev && virtio_has_features(vdev->features,
+						    VIRTIO_F_EVENT_IDX);
+	vrq->packed = vdev && virtio_has_features(vdev->features,
+						  VIRTIO_F_RING_PACKED);
+
+	if (vdev && virtio_has_features(vdev->features,
+					VIRTIO_F_INDIRECT_DESC)) {
+		vrq->indirect = uk_memalign(a, 16, nr_descs *
+					    VIRTQUEUE_INDIRECT_MAX *
+					    sizeof(struct vring_desc));
+		if (!vrq->indirect) {
+			uk_pr_err("Allocation of indirect descriptors failed\n");
+			rc = -ENOMEM;
+			goto err_freevq;
+		}
+	}
 
-	ring_size = vring_size(nr_descs, align);
+	if (vrq->packed)
+		ring_size = vring_packed_size(nr_descs);
+	else
+		ring_size = vring_size(nr_descs, align);
 	if (uk_posix_memalign(a, &vrq->vring_mem,
 			      __PAGE_SIZE, ring_size) != 0) {
 		uk_pr_err("Allocation of vring failed\n");
@@ -386,7 +789,10 @@ struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 		goto err_freevq;
 	}
 	memset(vrq->vring_mem, 0, ring_size);
-	virtqueue_vring_init(vrq, nr_descs, align);
+	if (vrq->packed)
+		virtqueue_packed_init(vrq, nr_descs);
+	else
+		virtqueue_vring_init(vrq, nr_descs, align);
 
 	vq = &vrq->vq;
 	vq->queue_id = queue_id;
@@ -396,6 +802,8 @@ struct virtqueue *virtqueue_create(__u16 queue_id, __u16 nr_descs, __u16 align,
 	return vq;
 
 err_freevq:
+	if (vrq->indirect)
+		uk_free(a, vrq->indirect);
 	uk_free(a, vrq);
 err_exit:
 	return ERR2PTR(rc);
@@ -411,6 +819,8 @@ void virtqueue_destroy(struct virtqueue *vq, struct uk_alloc *a)
 
 	/* Free the ring */
 	uk_free(a, vrq->vring_mem);
+	if (vrq->indirect)
+		uk_free(a, vrq->indirect);
 
 	/* Free the virtqueue metadata */
 	uk_free(a, vrq);
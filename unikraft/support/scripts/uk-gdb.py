@@ -45,9 +45,30 @@ type_void = gdb.lookup_type('void')
 
 PTR_SIZE = type_void.pointer().sizeof
 
+def get_trace_rings():
+    inf = gdb.selected_inferior()
+
+    rings = gdb.parse_and_eval('uk_trace_rings')
+    nr = rings.type.range()[1] + 1
+    buffers = []
+    for i in range(nr):
+        ring = rings[i]
+        data = ring['data']
+        raw = bytes(inf.read_memory(int(data.address), data.type.sizeof))
+        buffers += [parse.linearize_ring(raw, int(ring['head']),
+                                         int(ring['tail']), PTR_SIZE)]
+
+    return parse.merge_buffers(buffers, PTR_SIZE)
+
 def get_trace_buffer():
     inf = gdb.selected_inferior()
 
+    try:
+        # Ring mode (CONFIG_LIBUKDEBUG_TRACE_RING)
+        return get_trace_rings()
+    except gdb.error:
+        pass
+
     try:
         trace_buff = gdb.parse_and_eval('uk_trace_buffer')
         trace_buff_size = trace_buff.type.sizeof
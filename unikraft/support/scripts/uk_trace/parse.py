@@ -37,12 +37,18 @@ import tempfile
 
 TP_HEADER_MAGIC = 'TRhd'
 TP_DEF_MAGIC = 'TPde'
+TP_WRAP_MAGIC = 'TRwr'
+TRACE_DUMP_MAGIC = 'TRdp'
+TRACE_DUMP_BUF_MAGIC = 'TRbf'
+TRACE_DUMP_FMT = '<4sHBBQ'
+TRACE_DUMP_BUF_FMT = '<4sIII'
+TRACE_CONSOLE_PREFIX = 'uktrace: '
 UK_TRACE_ARG_INT = 0
 UK_TRACE_ARG_STRING = 1
 # Not sure why gcc aligns data on 32 bytes
 __STRUCT_ALIGNMENT = 32
 
-FORMAT_VERSION = 1
+FORMAT_VERSION = 2
 
 def align_down(v, alignment):
     return v & ~(alignment - 1)
@@ -50,6 +56,11 @@ def align_down(v, alignment):
 def align_up(v, alignment):
     return align_down(v + alignment - 1, alignment)
 
+# struct uk_tracepoint_header: magic, size, time and the cookie, which
+# is a pointer
+def tp_header_fmt(ptr_size):
+    return '<4sLQ' + ('Q' if ptr_size == 8 else 'I')
+
 class tp_sample:
     def __init__(self, tp, time, args):
         self.tp = tp
@@ -83,14 +94,13 @@ class sample_parser:
                   file=sys.stderr)
         self.data = unpacker(trace_buff)
         self.tps = get_tp_definitions(tp_defs_data, ptr_size)
+        self.header_fmt = tp_header_fmt(ptr_size)[1:]
     def __iter__(self):
         self.data.pos = 0
         return self
     def __next__(self):
         try:
-            # TODO: generate format. Cookie can be 4 bytes long on other
-            # platforms
-            magic,size,time,cookie = self.data.unpack('4sLQQ')
+            magic,size,time,cookie = self.data.unpack(self.header_fmt)
         except EndOfBuffer:
             raise StopIteration
 
@@ -151,6 +161,87 @@ class tp_definition:
     def __str__(self):
         return '%s %s' % (self.name,  self.fmt)
 
+# In ring mode (CONFIG_LIBUKDEBUG_TRACE_RING) every CPU has a buffer in
+# which [head, tail) holds the records. Positions only grow, offsets
+# are positions modulo the buffer size. Records never cross the end of
+# the buffer, the space left there is skipped.
+def linearize_ring(data, head, tail, ptr_size):
+    header_size = struct.calcsize(tp_header_fmt(ptr_size))
+    size = len(data)
+    ret = bytearray()
+    pos = max(head, tail - size)
+    while pos < tail:
+        off = pos % size
+        if size - off < header_size:
+            pos += size - off
+            continue
+        magic, rsize = struct.unpack_from('<4sL', data, off)
+        if magic.decode() == TP_WRAP_MAGIC:
+            pos += size - off
+            continue
+        if magic.decode() != TP_HEADER_MAGIC:
+            break
+        rsize += header_size
+        ret += data[off:off + rsize]
+        pos += rsize
+    return bytes(ret)
+
+# Merges linear buffers of several CPUs into one, ordered by time
+def merge_buffers(buffers, ptr_size):
+    header_fmt = tp_header_fmt(ptr_size)
+    header_size = struct.calcsize(header_fmt)
+    records = []
+    for buff in buffers:
+        pos = 0
+        while pos + header_size <= len(buff):
+            magic, size, time, _ = struct.unpack_from(header_fmt, buff, pos)
+            if magic.decode() != TP_HEADER_MAGIC:
+                break
+            size += header_size
+            records += [(time, buff[pos:pos + size])]
+            pos += size
+    records.sort(key=lambda r: r[0])
+    return b''.join([r[1] for r in records])
+
+# Parses the output of uk_trace_drain(). A file can hold several
+# consecutive dumps. Returns the pointer size and the merged records.
+def parse_dump(data):
+    buffers = []
+    ptr_size = None
+    pos = 0
+    while pos < len(data):
+        magic, version, ptr_size, nr, _ = \
+            struct.unpack_from(TRACE_DUMP_FMT, data, pos)
+        if magic.decode() != TRACE_DUMP_MAGIC:
+            raise Exception("Wrong trace dump magic")
+        if version > FORMAT_VERSION:
+            print("Warning: Version of trace dump is more recent",
+                  file=sys.stderr)
+        pos += struct.calcsize(TRACE_DUMP_FMT)
+        for i in range(nr):
+            magic, cpu, size, lost = \
+                struct.unpack_from(TRACE_DUMP_BUF_FMT, data, pos)
+            if magic.decode() != TRACE_DUMP_BUF_MAGIC:
+                raise Exception("Wrong trace dump buffer magic")
+            pos += struct.calcsize(TRACE_DUMP_BUF_FMT)
+            if lost:
+                print("CPU %d: %d records were overwritten" % (cpu, lost),
+                      file=sys.stderr)
+            buffers += [data[pos:pos + size]]
+            pos += size
+    return ptr_size, merge_buffers(buffers, ptr_size)
+
+# Extracts the dumps printed by uk_trace_drain_console() from a
+# console log
+def decode_console(text):
+    ret = bytearray()
+    for line in text.splitlines():
+        idx = line.find(TRACE_CONSOLE_PREFIX)
+        if idx < 0:
+            continue
+        ret += bytes.fromhex(line[idx + len(TRACE_CONSOLE_PREFIX):].strip())
+    return bytes(ret)
+
 def get_tp_definitions(tp_data, ptr_size):
     ptr_fmt = '0x%0' + '%dx' % (ptr_size * 2)
     data = unpacker(tp_data)
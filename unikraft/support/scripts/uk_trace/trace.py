@@ -74,6 +74,48 @@ def list(trace_file, no_tabulate):
         for i in parse_tf(trace_file):
             print(i)
 
+@cli.command()
+@click.argument('uk_img', type=click.Path(exists=True))
+@click.argument('dump', type=click.Path(exists=True))
+@click.option('--out', '-o', type=click.Path(),
+              default='tracefile', show_default=True,
+              help='Output binary file')
+@click.option('--console', is_flag=True, default=False,
+              help='DUMP is a console log of uk_trace_drain_console()')
+@click.option('--list', 'do_list', is_flag=True,
+              default=False,
+              help='Parse the decoded tracefile and list events')
+def decode(uk_img, dump, out, console, do_list):
+    """Convert the output of uk_trace_drain*() into a trace file
+
+    UK_IMG has to be the unstripped image (usually *.dbg)"""
+
+    if console:
+        with open(dump, 'r', errors='replace') as f:
+            data = parse.decode_console(f.read())
+    else:
+        with open(dump, 'rb') as f:
+            data = f.read()
+
+    ptr_size, trace_buff = parse.parse_dump(data)
+    if ptr_size is None:
+        print("No trace dump found in %s" % dump, file=sys.stderr)
+        sys.exit(1)
+
+    elf = click.format_filename(uk_img)
+    with open(out, 'wb') as tf:
+        pickler = pickle.Pickler(tf)
+        # Same layout as the one written by 'uk trace save' in gdb
+        pickler.dump(parse.get_keyvals(elf))
+        pickler.dump(elf)
+        pickler.dump(ptr_size)
+        pickler.dump(parse.get_tp_sections(elf))
+        pickler.dump(trace_buff)
+
+    if do_list:
+        for i in parse_tf(out):
+            print(i)
+
 @cli.command()
 @click.argument('uk_img', type=click.Path(exists=True))
 @click.option('--out', '-o', type=click.Path(),